@@ -17,7 +17,7 @@ import sys
 import re
 import json
 import argparse
-from typing import List, Dict, Optional, Tuple
+from typing import List, Dict, Optional, Set, Tuple
 from dataclasses import dataclass, field
 from enum import Enum
 
@@ -47,11 +47,14 @@ class IDLTokenType(Enum):
     EOF = "eof"
     MODULE = "module"           # OMG IDL
     SEQUENCE = "sequence"       # OMG IDL
+    MAP = "map"                 # OMG IDL 4
     BOOLEAN = "boolean"         # OMG IDL
     CALLBACK = "callback"       # 回调方法关键字
     LESS = "<"                  # 用于 sequence<>
     GREATER = ">"               # 用于 sequence<>
     COLON = ":"                 # 用于作用域
+    AT = "@"                    # 注解，例如 @batch(onBatchChanged)
+    DOT = "."                   # 注解参数中的字段路径，例如 event.key
 
 
 @dataclass
@@ -78,8 +81,8 @@ class IDLParameter:
     name: str
     type_name: str
     direction: str  # "in", "out", "inout"
-    is_array: bool = False
-    array_size: Optional[int] = None
+    is_array: bool = False  # T name[]：动态数组（vector）；T name[N] 解析为类型 array<T,N>
+    is_stream: bool = False  # 客户端流式参数（in stream<T>），type_name 为元素类型 T
     line: int = 0
 
 
@@ -90,6 +93,8 @@ class IDLMethod:
     return_type: str
     parameters: List[IDLParameter]
     is_callback: bool = False  # 标识是否为回调方法
+    is_stream: bool = False  # 服务端流式返回（stream<T>），return_type 为元素类型 T
+    annotations: Dict[str, List[str]] = field(default_factory=dict)  # 注解名 -> 参数列表
     line: int = 0
 
 
@@ -98,6 +103,8 @@ class IDLStruct:
     """IDL结构体定义"""
     name: str
     fields: List[Tuple[str, str]]  # (type, name)
+    field_annotations: Dict[str, Dict[str, List[str]]] = field(default_factory=dict)  # 字段名 -> 注解
+    annotations: Dict[str, List[str]] = field(default_factory=dict)  # 例如 @lazy
     line: int = 0
 
 
@@ -114,6 +121,7 @@ class IDLTypedef:
     """IDL类型定义"""
     name: str
     base_type: str  # 例如 "sequence<string>"
+    annotations: Dict[str, List[str]] = field(default_factory=dict)  # 例如 @columnar
     line: int = 0
 
 
@@ -146,7 +154,7 @@ class IDLLexer:
         'in', 'out', 'inout', 'void',
         'bool', 'char', 'short', 'int', 'long',
         'float', 'double', 'string', 'byte',
-        'module', 'sequence', 'boolean',  # OMG IDL 关键字
+        'module', 'sequence', 'map', 'boolean',  # OMG IDL 关键字
         'callback'  # 回调方法关键字
     }
     
@@ -274,6 +282,12 @@ class IDLLexer:
             elif ch == ':':
                 self.tokens.append(IDLToken(IDLTokenType.COLON, ch, line, col))
                 self.advance()
+            elif ch == '@':
+                self.tokens.append(IDLToken(IDLTokenType.AT, ch, line, col))
+                self.advance()
+            elif ch == '.':
+                self.tokens.append(IDLToken(IDLTokenType.DOT, ch, line, col))
+                self.advance()
             elif ch.isalpha() or ch == '_':
                 # 标识符或关键字
                 ident = self.read_identifier()
@@ -289,6 +303,7 @@ class IDLLexer:
                     'typedef': IDLTokenType.TYPEDEF,
                     'module': IDLTokenType.MODULE,
                     'sequence': IDLTokenType.SEQUENCE,
+                    'map': IDLTokenType.MAP,
                     'boolean': IDLTokenType.BOOLEAN,
                     'callback': IDLTokenType.CALLBACK
                 }
@@ -374,6 +389,9 @@ class IDLParser:
                 self.error(f"期望 'module' 或 'interface' 关键字，但得到 '{self.current().value}'")
                 self.advance()
         
+        if not self.errors:
+            self.validate_annotations()
+        
         return self.interfaces
     
     def parse_interface(self) -> Optional[IDLInterface]:
@@ -408,9 +426,11 @@ class IDLParser:
                 if enum:
                     interface.enums.append(enum)
             else:
-                # 解析方法
+                # 解析方法（可带注解）
+                annotations = self.parse_annotations()
                 method = self.parse_method()
                 if method:
+                    method.annotations = annotations
                     interface.methods.append(method)
         
         if not self.expect(IDLTokenType.RBRACE):
@@ -422,6 +442,210 @@ class IDLParser:
         
         return interface
     
+    def parse_annotations(self) -> Dict[str, List[str]]:
+        """解析注解列表，例如 @batch(onBatchChanged)"""
+        annotations = {}
+        while self.current().type == IDLTokenType.AT:
+            self.advance()
+            name_token = self.current()
+            if name_token.type != IDLTokenType.IDENTIFIER:
+                self.error("期望注解名称", name_token)
+                break
+            self.advance()
+            
+            args = []
+            if self.current().type == IDLTokenType.LPAREN:
+                self.advance()
+                while self.current().type not in [IDLTokenType.RPAREN, IDLTokenType.EOF]:
+                    arg_token = self.current()
+                    if arg_token.type not in [IDLTokenType.IDENTIFIER, IDLTokenType.NUMBER]:
+                        self.error(f"注解 @{name_token.value} 的参数无效: '{arg_token.value}'", arg_token)
+                        break
+                    arg = arg_token.value
+                    self.advance()
+                    # 字段路径: ident.ident...
+                    while self.current().type == IDLTokenType.DOT and self.peek(1).type == IDLTokenType.IDENTIFIER:
+                        self.advance()
+                        arg += "." + self.current().value
+                        self.advance()
+                    args.append(arg)
+                    if self.current().type == IDLTokenType.COMMA:
+                        self.advance()
+                if not self.expect(IDLTokenType.RPAREN):
+                    break
+            
+            if name_token.value in annotations:
+                self.error(f"重复的注解 @{name_token.value}", name_token)
+            annotations[name_token.value] = args
+        return annotations
+    
+    def validate_annotations(self):
+        """校验注解语义（在整个文件解析完成后调用）"""
+        for module in self.modules:
+            typedefs = {t.name: t.base_type for t in module.typedefs}
+            self._validate_columnar_annotations(module)
+            self._validate_delta_annotations(module)
+            self._validate_lazy_annotations(module)
+            self._validate_map_types(module.interfaces, module.typedefs, {e.name for e in module.enums})
+            for interface in module.interfaces:
+                structs = {st.name: st for st in module.structs + interface.structs}
+                self._validate_batch_annotations(interface, typedefs)
+                enums = {e.name for e in module.enums + interface.enums}
+                self._validate_partition_annotations(interface, structs, enums, typedefs)
+        for interface in self.interfaces:
+            if not any(interface in m.interfaces for m in self.modules):
+                self._validate_map_types([interface], [], set())
+                self._validate_batch_annotations(interface, {})
+                self._validate_partition_annotations(interface, {st.name: st for st in interface.structs},
+                                                     {e.name for e in interface.enums}, {})
+    
+    def _validate_columnar_annotations(self, module: 'IDLModule'):
+        """@columnar: sequence<Struct> 按字段分列编码，结构体字段只能是基本类型、字符串或枚举"""
+        structs = {st.name: st for st in module.structs}
+        typedefs = {t.name for t in module.typedefs}
+        for typedef in module.typedefs:
+            token = IDLToken(IDLTokenType.AT, '@', typedef.line, 1)
+            for name in typedef.annotations:
+                if name != 'columnar':
+                    self.error(f"typedef 不支持注解 @{name}: {typedef.name}", token)
+            if 'columnar' not in typedef.annotations:
+                continue
+            if typedef.annotations['columnar']:
+                self.error(f"@columnar 不接受参数: {typedef.name}", token)
+            base = typedef.base_type
+            struct = structs.get(base[9:-1]) if base.startswith('sequence<') else None
+            if not struct:
+                self.error(f"@columnar 只能用于 sequence<结构体> 类型定义: {typedef.name}", token)
+                continue
+            for field_type, field_name in struct.fields:
+                if field_type in structs or field_type in typedefs or field_type.startswith(('sequence<', 'array<', 'map<')):
+                    self.error(f"@columnar 要求 {struct.name} 的字段为基本类型、字符串或枚举: {field_name}", token)
+    
+    # @delta 可用的整数类型
+    DELTA_TYPES = {'short', 'unsigned short', 'int', 'unsigned int', 'long', 'unsigned long',
+                   'long long', 'unsigned long long', 'int16_t', 'uint16_t', 'int32_t', 'uint32_t',
+                   'int64_t', 'uint64_t'}
+    
+    def _validate_delta_annotations(self, module: 'IDLModule'):
+        """@delta: 结构体序列中该整数字段按与前一元素的差值（zigzag varint）编码"""
+        for struct in module.structs:
+            token = IDLToken(IDLTokenType.AT, '@', struct.line, 1)
+            types = dict((n, t) for t, n in struct.fields)
+            for field_name, annotations in struct.field_annotations.items():
+                for name in annotations:
+                    if name != 'delta':
+                        self.error(f"结构体字段不支持注解 @{name}: {struct.name}.{field_name}", token)
+                if 'delta' not in annotations:
+                    continue
+                if annotations['delta']:
+                    self.error(f"@delta 不接受参数: {struct.name}.{field_name}", token)
+                if types[field_name] not in self.DELTA_TYPES:
+                    self.error(f"@delta 只能用于整数字段: {struct.name}.{field_name}", token)
+    
+    # map 键和 @partition 字段可用的类型（另外允许枚举）：需要 std::hash 且相等比较精确
+    MAP_KEY_TYPES = DELTA_TYPES | {'int8_t', 'uint8_t', 'char', 'byte', 'bool', 'boolean', 'string'}
+    
+    def _is_key_type(self, type_name: str, enums: Set[str], typedefs: Dict[str, str]) -> bool:
+        """解析 typedef 别名后，类型是否为整数、字符、布尔、字符串或枚举"""
+        seen = set()
+        while type_name in typedefs and type_name not in seen:
+            seen.add(type_name)
+            type_name = typedefs[type_name]
+        return type_name in self.MAP_KEY_TYPES or type_name in enums
+    
+    def _validate_map_types(self, interfaces: List['IDLInterface'], typedef_list: List['IDLTypedef'],
+                            enums: Set[str]):
+        """map<key, value>: 键只能是整数、字符、布尔、字符串或枚举（含接口内枚举和 typedef 别名）"""
+        typedefs = {t.name: t.base_type for t in typedef_list}
+        enums = enums | {e.name for interface in interfaces for e in interface.enums}
+        types = [(t.base_type, t.line) for t in typedef_list]
+        for interface in interfaces:
+            for method in interface.methods:
+                types.append((method.return_type, method.line))
+                types.extend((p.type_name, p.line) for p in method.parameters)
+        for type_name, line in types:
+            while type_name.startswith(('map<', 'sequence<')):
+                inner = type_name[type_name.index('<') + 1:-1]
+                if type_name.startswith('sequence<'):
+                    type_name = inner.split(',')[0] if not inner.startswith(('map<', 'sequence<')) else inner
+                    continue
+                key_type, _, type_name = inner.partition(',')
+                if not self._is_key_type(key_type, enums, typedefs):
+                    self.error(f"map 的键类型必须是整数、字符、布尔、字符串或枚举: {key_type}",
+                               IDLToken(IDLTokenType.MAP, 'map', line, 1))
+    
+    def _validate_lazy_annotations(self, module: 'IDLModule'):
+        """@lazy: 结构体前置字段偏移表，可生成按需解码的访问类型（字段数不超过 64）"""
+        for struct in module.structs:
+            token = IDLToken(IDLTokenType.AT, '@', struct.line, 1)
+            for name in struct.annotations:
+                if name != 'lazy':
+                    self.error(f"结构体不支持注解 @{name}: {struct.name}", token)
+            if 'lazy' not in struct.annotations:
+                continue
+            if struct.annotations['lazy']:
+                self.error(f"@lazy 不接受参数: {struct.name}", token)
+            if not struct.fields or len(struct.fields) > 64:
+                self.error(f"@lazy 结构体需要 1~64 个字段: {struct.name}", token)
+    
+    def _validate_partition_annotations(self, interface: 'IDLInterface', structs: Dict[str, 'IDLStruct'],
+                                        enums: Set[str], typedefs: Dict[str, str]):
+        """@partition(param.field): 回调分发时按该字段保证同键有序，字段须可哈希（整数、字符、布尔、字符串或枚举）"""
+        for method in interface.methods:
+            if 'partition' not in method.annotations:
+                continue
+            args = method.annotations['partition']
+            token = IDLToken(IDLTokenType.AT, '@', method.line, 1)
+            if not method.is_callback:
+                self.error(f"@partition 只能用于 callback 方法: {method.name}", token)
+                continue
+            if len(args) != 1:
+                self.error(f"@partition 需要一个参数（参数名或字段路径）: {method.name}", token)
+                continue
+            path = args[0].split('.')
+            param = next((p for p in method.parameters if p.name == path[0]), None)
+            if not param:
+                self.error(f"@partition 引用的参数不存在: {path[0]}", token)
+                continue
+            type_name = param.type_name
+            for field_name in path[1:]:
+                struct = structs.get(type_name)
+                field_type = next((t for t, n in struct.fields if n == field_name), None) if struct else None
+                if not field_type:
+                    self.error(f"@partition 引用的字段不存在: {type_name}.{field_name}", token)
+                    break
+                type_name = field_type
+            else:
+                if (len(path) == 1 and param.is_array) or not self._is_key_type(type_name, enums, typedefs):
+                    self.error(f"@partition 的字段必须是整数、字符、布尔、字符串或枚举: {args[0]}", token)
+    
+    def _validate_batch_annotations(self, interface: 'IDLInterface', typedefs: Dict[str, str]):
+        """@batch(target): 单项回调的事件累积后以 target 批量回调发送"""
+        methods = {m.name: m for m in interface.methods}
+        for method in interface.methods:
+            if 'batch' not in method.annotations:
+                continue
+            args = method.annotations['batch']
+            token = IDLToken(IDLTokenType.AT, '@', method.line, 1)
+            if not method.is_callback:
+                self.error(f"@batch 只能用于 callback 方法: {method.name}", token)
+                continue
+            if len(args) != 1:
+                self.error(f"@batch 需要一个参数（批量回调名称）: {method.name}", token)
+                continue
+            target = methods.get(args[0])
+            if not target or not target.is_callback:
+                self.error(f"@batch 引用的批量回调不存在: {args[0]}", token)
+                continue
+            if len(method.parameters) != 1 or len(target.parameters) != 1:
+                self.error(f"@batch 要求 {method.name} 与 {target.name} 都只有一个参数", token)
+                continue
+            target_type = target.parameters[0].type_name
+            while target_type in typedefs:
+                target_type = typedefs[target_type]
+            if target_type != f"sequence<{method.parameters[0].type_name}>":
+                self.error(f"@batch 要求 {target.name} 的参数类型为 sequence<{method.parameters[0].type_name}>", token)
+    
     def parse_struct(self) -> Optional[IDLStruct]:
         """解析结构体定义"""
         struct_token = self.expect(IDLTokenType.STRUCT)
@@ -438,7 +662,10 @@ class IDLParser:
             return None
         
         fields = []
+        field_annotations = {}
         while self.current().type != IDLTokenType.RBRACE and self.current().type != IDLTokenType.EOF:
+            # 字段注解，例如 @delta long timestamp;
+            annotations = self.parse_annotations()
             # 解析字段: type name;
             type_token = self.current()
             if type_token.type != IDLTokenType.IDENTIFIER:
@@ -452,7 +679,19 @@ class IDLParser:
                 break
             self.advance()
             
-            fields.append((type_token.value, field_name_token.value))
+            # 定长数组字段 T name[N]
+            field_type = type_token.value
+            if self.current().type == IDLTokenType.LBRACKET:
+                size = self.parse_array_size()
+                if not size:
+                    if size == 0:
+                        self.error("结构体数组字段必须指定长度", field_name_token)
+                    break
+                field_type = f"array<{field_type},{size}>"
+            
+            fields.append((field_type, field_name_token.value))
+            if annotations:
+                field_annotations[field_name_token.value] = annotations
             
             if not self.expect(IDLTokenType.SEMICOLON):
                 break
@@ -463,7 +702,8 @@ class IDLParser:
         if self.current().type == IDLTokenType.SEMICOLON:
             self.advance()
         
-        return IDLStruct(name=name_token.value, fields=fields, line=struct_token.line)
+        return IDLStruct(name=name_token.value, fields=fields, field_annotations=field_annotations,
+                         line=struct_token.line)
     
     def parse_enum(self) -> Optional[IDLEnum]:
         """解析枚举定义"""
@@ -510,11 +750,28 @@ class IDLParser:
             is_callback = True
             self.advance()
         
+        # 检查 stream<T> 返回修饰符（服务端流式返回）
+        is_stream = False
+        if (self.current().type == IDLTokenType.IDENTIFIER and self.current().value == 'stream'
+                and self.peek(1).type == IDLTokenType.LESS):
+            is_stream = True
+            stream_token = self.current()
+            self.advance()
+            self.advance()
+            if is_callback:
+                self.error("callback 方法不能使用 stream 返回", stream_token)
+        
         # 解析返回类型（使用 parse_type_spec 支持复杂类型）
         return_type = self.parse_type_spec()
         if not return_type:
             return None
         
+        if is_stream:
+            if return_type == 'void':
+                self.error("stream<void> 无效，stream 需要元素类型")
+            if not self.expect(IDLTokenType.GREATER):
+                return None
+        
         method_name_token = self.current()
         if method_name_token.type != IDLTokenType.IDENTIFIER:
             self.error(f"期望方法名称，但得到 '{method_name_token.value}'", method_name_token)
@@ -542,14 +799,36 @@ class IDLParser:
         if not self.expect(IDLTokenType.SEMICOLON):
             return None
         
+        if is_stream and any(p.direction != 'in' for p in parameters):
+            self.error(f"stream 方法 '{method_name_token.value}' 只能有 in 参数", method_name_token)
+        stream_params = [p for p in parameters if p.is_stream]
+        if stream_params and (is_stream or is_callback or len(stream_params) > 1):
+            self.error(f"方法 '{method_name_token.value}' 最多只能有一个 stream 参数，且不能与 stream 返回或 callback 同时使用",
+                       method_name_token)
+        
         return IDLMethod(
             name=method_name_token.value,
             return_type=return_type,
             parameters=parameters,
             is_callback=is_callback,
+            is_stream=is_stream,
             line=line
         )
     
+    def parse_array_size(self) -> Optional[int]:
+        """解析 [N] 或 []，返回 N（[] 返回 0），出错返回 None"""
+        self.advance()
+        size = 0
+        if self.current().type == IDLTokenType.NUMBER:
+            size = int(self.current().value)
+            if size == 0:
+                self.error("数组长度必须是正整数", self.current())
+                return None
+            self.advance()
+        if not self.expect(IDLTokenType.RBRACKET):
+            return None
+        return size
+    
     def parse_parameter(self) -> Optional[IDLParameter]:
         """解析方法参数"""
         line = self.current().line
@@ -560,10 +839,22 @@ class IDLParser:
             direction = self.current().value
             self.advance()
         
+        # 客户端流式参数 stream<type>
+        is_stream = False
+        if (self.current().type == IDLTokenType.IDENTIFIER and self.current().value == 'stream'
+                and self.peek(1).type == IDLTokenType.LESS):
+            is_stream = True
+            if direction != 'in':
+                self.error("stream 参数只能是 in 方向", self.current())
+            self.advance()
+            self.advance()
+        
         # 参数类型（可能是 sequence<type> 或普通类型）
         type_name = self.parse_type_spec()
         if not type_name:
             return None
+        if is_stream and not self.expect(IDLTokenType.GREATER):
+            return None
         
         # 参数名称
         param_name_token = self.current()
@@ -572,31 +863,30 @@ class IDLParser:
             return None
         self.advance()
         
-        # 检查数组
+        # 检查数组：T name[] 为动态数组，T name[N] 为定长数组
         is_array = False
-        array_size = None
         if self.current().type == IDLTokenType.LBRACKET:
-            is_array = True
-            self.advance()
-            if self.current().type == IDLTokenType.NUMBER:
-                array_size = int(self.current().value)
-                self.advance()
-            if not self.expect(IDLTokenType.RBRACKET):
+            size = self.parse_array_size()
+            if size is None:
                 return None
+            if size:
+                type_name = f"array<{type_name},{size}>"
+            else:
+                is_array = True
         
         return IDLParameter(
             name=param_name_token.value,
             type_name=type_name,
             direction=direction,
             is_array=is_array,
-            array_size=array_size,
+            is_stream=is_stream,
             line=line
         )
     
     def parse_type_spec(self) -> Optional[str]:
-        """解析类型规范（支持 sequence<type>）"""
+        """解析类型规范（支持 sequence<type>、有界序列 sequence<type, N> 和 map<key, value>）"""
         if self.current().type == IDLTokenType.SEQUENCE:
-            # sequence<type>
+            # sequence<type> 或 sequence<type, N>
             self.advance()
             if not self.expect(IDLTokenType.LESS):
                 return None
@@ -607,10 +897,41 @@ class IDLParser:
                 return None
             self.advance()
             
+            bound = ""
+            if self.current().type == IDLTokenType.COMMA:
+                self.advance()
+                bound_token = self.current()
+                if bound_token.type != IDLTokenType.NUMBER or int(bound_token.value) == 0:
+                    self.error("序列上限必须是正整数", bound_token)
+                    return None
+                self.advance()
+                bound = f",{int(bound_token.value)}"
+            
             if not self.expect(IDLTokenType.GREATER):
                 return None
             
-            return f"sequence<{inner_type.value}>"
+            return f"sequence<{inner_type.value}{bound}>"
+        elif self.current().type == IDLTokenType.MAP:
+            # map<key, value>，值类型可以是 sequence<> 或另一个 map<>
+            self.advance()
+            if not self.expect(IDLTokenType.LESS):
+                return None
+            key_type = self.current()
+            if key_type.type not in [IDLTokenType.IDENTIFIER, IDLTokenType.BOOLEAN]:
+                self.error("期望键类型名称", key_type)
+                return None
+            self.advance()
+            if not self.expect(IDLTokenType.COMMA):
+                return None
+            value_type = self.parse_type_spec()
+            if not value_type:
+                return None
+            if value_type == 'void':
+                self.error("map 的值类型不能是 void")
+                return None
+            if not self.expect(IDLTokenType.GREATER):
+                return None
+            return f"map<{key_type.value},{value_type}>"
         else:
             # 普通类型
             type_token = self.current()
@@ -655,6 +976,22 @@ class IDLParser:
                 typedef = self.parse_typedef()
                 if typedef:
                     module.typedefs.append(typedef)
+            elif self.current().type == IDLTokenType.AT:
+                # typedef / 结构体注解，例如 @columnar typedef sequence<Grade> GradeSeq;
+                annotations = self.parse_annotations()
+                if self.current().type == IDLTokenType.STRUCT:
+                    struct = self.parse_struct()
+                    if struct:
+                        struct.annotations = annotations
+                        module.structs.append(struct)
+                    continue
+                if self.current().type != IDLTokenType.TYPEDEF:
+                    self.error(f"模块中的注解只能用于 typedef 或 struct，但得到 '{self.current().value}'")
+                    continue
+                typedef = self.parse_typedef()
+                if typedef:
+                    typedef.annotations = annotations
+                    module.typedefs.append(typedef)
             else:
                 self.error(f"模块中遇到未知元素: {self.current().value}")
                 self.advance()
@@ -692,9 +1029,9 @@ class IDLParser:
         return IDLTypedef(name=name_token.value, base_type=base_type, line=typedef_token.line)
     
     def parse_type_spec(self) -> Optional[str]:
-        """解析类型规范（支持 sequence<type>）"""
+        """解析类型规范（支持 sequence<type>、有界序列 sequence<type, N> 和 map<key, value>）"""
         if self.current().type == IDLTokenType.SEQUENCE:
-            # sequence<type>
+            # sequence<type> 或 sequence<type, N>
             self.advance()
             if not self.expect(IDLTokenType.LESS):
                 return None
@@ -705,10 +1042,41 @@ class IDLParser:
                 return None
             self.advance()
             
+            bound = ""
+            if self.current().type == IDLTokenType.COMMA:
+                self.advance()
+                bound_token = self.current()
+                if bound_token.type != IDLTokenType.NUMBER or int(bound_token.value) == 0:
+                    self.error("序列上限必须是正整数", bound_token)
+                    return None
+                self.advance()
+                bound = f",{int(bound_token.value)}"
+            
             if not self.expect(IDLTokenType.GREATER):
                 return None
             
-            return f"sequence<{inner_type.value}>"
+            return f"sequence<{inner_type.value}{bound}>"
+        elif self.current().type == IDLTokenType.MAP:
+            # map<key, value>，值类型可以是 sequence<> 或另一个 map<>
+            self.advance()
+            if not self.expect(IDLTokenType.LESS):
+                return None
+            key_type = self.current()
+            if key_type.type not in [IDLTokenType.IDENTIFIER, IDLTokenType.BOOLEAN]:
+                self.error("期望键类型名称", key_type)
+                return None
+            self.advance()
+            if not self.expect(IDLTokenType.COMMA):
+                return None
+            value_type = self.parse_type_spec()
+            if not value_type:
+                return None
+            if value_type == 'void':
+                self.error("map 的值类型不能是 void")
+                return None
+            if not self.expect(IDLTokenType.GREATER):
+                return None
+            return f"map<{key_type.value},{value_type}>"
         else:
             # 普通类型
             type_token = self.current()
@@ -753,9 +1121,29 @@ class CppSocketCodeGenerator:
         'uint64_t': 'uint64_t'
     }
     
+    # 基本类型对应的 ByteBuffer 写方法（读方法把 write 换成 read）
+    WRITE_METHODS = {
+        'int32_t': 'writeInt32', 'uint32_t': 'writeUint32',
+        'int64_t': 'writeInt64', 'uint64_t': 'writeUint64',
+        'int16_t': 'writeInt16', 'uint16_t': 'writeUint16',
+        'int8_t': 'writeInt8', 'uint8_t': 'writeUint8',
+        'char': 'writeChar', 'bool': 'writeBool',
+        'float': 'writeFloat', 'double': 'writeDouble',
+        'std::string': 'writeString'
+    }
+    
+    # 可整体编码的数值元素类型（writeArray / readArrayInto）；vector<bool> 没有连续存储，按位打包（writeBoolArray）
+    BULK_TYPES = {'int8_t', 'uint8_t', 'char', 'int16_t', 'uint16_t', 'int32_t', 'uint32_t',
+                  'int64_t', 'uint64_t', 'float', 'double'}
+    
     def __init__(self, interface: IDLInterface, module: Optional[IDLModule] = None, namespace: str = "ipc", 
-                 all_interfaces: Optional[list] = None, observer_interfaces: Optional[list] = None):
+                 all_interfaces: Optional[list] = None, observer_interfaces: Optional[list] = None,
+                 view_decode: bool = False, pmr_arena: bool = False):
         self.interface = interface
+        # 视图解码模式（C++17）：字符串字段解码为指向接收缓冲区的 std::string_view
+        self.view_decode = view_decode
+        # arena 模式（C++17）：结构体使用 std::pmr 容器，服务端请求在每次处理后复位的 arena 上解码
+        self.pmr_arena = pmr_arena
         self.module = module  # OMG IDL module
         self.namespace = namespace
         self.message_id = 1000
@@ -765,9 +1153,13 @@ class CppSocketCodeGenerator:
         self.observer_interfaces = observer_interfaces or []
         # 构建类型别名字典
         self.typedefs = {}
+        # @columnar 类型定义：生成为独立的容器类型（按列编码），typedef 名 -> 元素结构体
+        self.columnar = {}
         if module and module.typedefs:
             for typedef in module.typedefs:
                 self.typedefs[typedef.name] = typedef.base_type
+                if 'columnar' in typedef.annotations:
+                    self.columnar[typedef.name] = typedef.base_type[9:-1]
         # 检测是否是观察者接口（所有方法都是 void 返回类型，且只有 in 参数）
         self.is_observer_interface = self._is_observer_interface()
     
@@ -789,10 +1181,27 @@ class CppSocketCodeGenerator:
         """映射IDL类型到C++类型，支持 OMG IDL sequence<> 和 typedef"""
         # 处理 sequence<type>
         if idl_type.startswith('sequence<') and idl_type.endswith('>'):
-            elem_type = idl_type[9:-1]  # 提取 sequence<type> 中的 type
+            elem_type, _, bound = idl_type[9:-1].partition(',')  # sequence<type> 或 sequence<type,N>
             cpp_elem_type = self.map_type(elem_type)  # 递归映射元素类型
+            if bound:
+                # 有界序列：元素内联存储，解码时校验上限
+                return f"BoundedSequence<{cpp_elem_type}, {bound}>"
             return f"std::vector<{cpp_elem_type}>"
         
+        # map<key,value>：键是简单类型，值类型可以再嵌套 sequence<>/map<>
+        if idl_type.startswith('map<') and idl_type.endswith('>'):
+            key_type, _, value_type = idl_type[4:-1].partition(',')
+            return f"std::unordered_map<{self.map_type(key_type)}, {self.map_type(value_type)}>"
+        
+        # 定长数组 array<type,N>（IDL 中写作 T name[N]）
+        if idl_type.startswith('array<') and idl_type.endswith('>'):
+            elem_type, _, size = idl_type[6:-1].rpartition(',')
+            return f"std::array<{self.map_type(elem_type)}, {size}>"
+        
+        # @columnar 类型定义映射为生成的同名容器（派生自 std::vector）
+        if idl_type in self.columnar:
+            return idl_type
+        
         # 检查是否是 typedef 别名
         if idl_type in self.typedefs:
             actual_type = self.typedefs[idl_type]
@@ -816,26 +1225,50 @@ class CppSocketCodeGenerator:
         code.append(f"#ifndef {guard_name}")
         code.append(f"#define {guard_name}")
         code.append("")
+        code.append("#include <array>")
         code.append("#include <string>")
         code.append("#include <vector>")
         code.append("#include <map>")
+        code.append("#include <unordered_map>")
         code.append("#include <cstdint>")
         code.append("#include <cstring>")
+        code.append("#include <stdexcept>")
+        code.append("#include <type_traits>")
         code.append("#include <memory>")
         code.append("#include <functional>")
         code.append("#include <thread>")
         code.append("#include <mutex>")
+        code.append("#include <atomic>")
+        code.append("#include <random>")
         code.append("#include <chrono>")
         code.append("#include <condition_variable>")
         code.append("#include <queue>")
         code.append("#include <algorithm>")
         code.append("#include <iostream>")
         code.append("#include <sys/socket.h>")
+        code.append("#include <sys/eventfd.h>")
+        code.append("#include <poll.h>")
+        code.append("#include <pthread.h>")
+        code.append("#include <sched.h>")
         code.append("#include <netinet/in.h>")
         code.append("#include <arpa/inet.h>")
         code.append("#include <unistd.h>")
         code.append("#include <errno.h>")
+        code.append("#if __cplusplus >= 201703L")
+        code.append("#include <string_view>")
+        code.append("#include <memory_resource>")
+        code.append("#endif")
         code.append("")
+        if self.view_decode:
+            code.append("#if __cplusplus < 201703L")
+            code.append('#error "This header was generated with --view-decode and requires C++17"')
+            code.append("#endif")
+            code.append("")
+        if self.pmr_arena:
+            code.append("#if __cplusplus < 201703L")
+            code.append('#error "This header was generated with --pmr-arena and requires C++17"')
+            code.append("#endif")
+            code.append("")
         code.append(f"namespace {self.namespace} {{")
         code.append("")
         
@@ -858,9 +1291,13 @@ class CppSocketCodeGenerator:
                 code.append(f"const uint32_t MSG_{method.name.upper()}_REQ = {self.message_id};")
                 self.message_id += 1
                 # 如果有返回值或输出参数，也需要 RESP
-                if method.return_type != 'void' or any(p.direction in ['out', 'inout'] for p in method.parameters):
+                if self._has_response(method):
                     code.append(f"const uint32_t MSG_{method.name.upper()}_RESP = {self.message_id};")
                     self.message_id += 1
+                # 客户端流式参数的数据分块
+                if self._stream_param(method):
+                    code.append(f"const uint32_t MSG_{method.name.upper()}_CHUNK = {self.message_id};")
+                    self.message_id += 1
         
         # 为关联的观察者接口生成消息ID
         if self.observer_interfaces:
@@ -902,6 +1339,9 @@ class CppSocketCodeGenerator:
         for method in self.interface.methods:
             code.extend(self._generate_message_structs(method))
             code.append("")
+            if self._is_lazy_callback(method):
+                code.extend(self._generate_lazy_request(method))
+                code.append("")
         
         # 为关联的观察者接口生成消息结构
         if self.observer_interfaces:
@@ -932,6 +1372,106 @@ class CppSocketCodeGenerator:
         
         return "\n".join(code)
     
+    # 定长字段的字节数（枚举按 int32_t 编码）
+    FIXED_SIZES = {'int8_t': 1, 'uint8_t': 1, 'char': 1, 'bool': 1, 'int16_t': 2, 'uint16_t': 2,
+                   'int32_t': 4, 'uint32_t': 4, 'float': 4, 'int64_t': 8, 'uint64_t': 8, 'double': 8}
+    
+    def _fixed_struct_fields(self, name: str) -> Optional[List[Tuple[str, str, str, int]]]:
+        """若结构体只含定长基本类型/枚举字段（或基本类型的定长数组），
+        返回 (C++类型, 打包类型, 字段名, 元素个数) 列表（非数组字段个数为 0），否则返回 None"""
+        structs = (self.module.structs if self.module else []) + self.interface.structs
+        struct = next((s for s in structs if s.name == name), None)
+        if struct is None or not struct.fields or self._delta_fields(name) or 'lazy' in struct.annotations:
+            return None
+        fields = []
+        for field_type, field_name in struct.fields:
+            cpp_type = self.map_type(field_type)
+            if cpp_type in self.FIXED_SIZES:
+                fields.append((cpp_type, cpp_type, field_name, 0))
+            elif self._is_enum(field_type) or self._is_enum(cpp_type):
+                fields.append((cpp_type, 'int32_t', field_name, 0))
+            elif cpp_type.startswith('std::array<') and self._array_elem(cpp_type) in self.FIXED_SIZES:
+                fields.append((cpp_type, self._array_elem(cpp_type), field_name, int(cpp_type.rpartition(', ')[2][:-1])))
+            else:
+                return None
+        return fields
+    
+    def _delta_fields(self, name: str) -> List[str]:
+        """结构体中标注 @delta 的字段名"""
+        structs = (self.module.structs if self.module else []) + self.interface.structs
+        struct = next((s for s in structs if s.name == name), None)
+        if struct is None:
+            return []
+        return [n for _, n in struct.fields if 'delta' in struct.field_annotations.get(n, {})]
+    
+    def _uses_lazy_result(self, method: IDLMethod) -> bool:
+        """返回 @lazy 结构体且没有输出参数的普通 RPC：额外生成以 XxxLazy 回调交付结果的版本"""
+        return (not method.is_callback and not method.is_stream and self._stream_param(method) is None
+                and self._is_lazy_struct(method.return_type)
+                and all(p.direction == 'in' for p in method.parameters))
+    
+    def _is_lazy_callback(self, method: IDLMethod) -> bool:
+        """参数全部是 @lazy 结构体的 callback：客户端可选择按需解码交付"""
+        return (method.is_callback and bool(method.parameters)
+                and all(not p.is_array and self._is_lazy_struct(p.type_name) for p in method.parameters))
+    
+    def _is_lazy_struct(self, name: str) -> bool:
+        """结构体是否标注 @lazy（带字段偏移表编码）"""
+        structs = (self.module.structs if self.module else []) + self.interface.structs
+        return any(s.name == name and 'lazy' in s.annotations for s in structs)
+    
+    def _is_fixed_struct(self, name: str) -> bool:
+        """结构体是否有打包记录布局（writeRecords / readRecordsInto）"""
+        return self._fixed_struct_fields(name) is not None
+    
+    def _generate_packed_record(self, struct: IDLStruct) -> List[str]:
+        """定长结构体：生成 1 字节对齐的 Packed 记录及 pack/unpack，原生小端模式下整条 memcpy"""
+        fields = self._fixed_struct_fields(struct.name)
+        if fields is None:
+            return []
+        wire_size = sum(self.FIXED_SIZES[packed] * max(count, 1) for _, packed, _, count in fields)
+        lines = [""]
+        lines.append("    // Fixed-size fields only: in native little-endian mode the wire record is")
+        lines.append("    // this packed layout, written and read with memcpy")
+        lines.append("#pragma pack(push, 1)")
+        lines.append("    struct Packed {")
+        for _, packed, field_name, count in fields:
+            lines.append(f"        {packed} {field_name}{f'[{count}]' if count else ''};")
+        lines.append("    };")
+        lines.append("#pragma pack(pop)")
+        lines.append(f"    static_assert(sizeof(Packed) == {wire_size}, \"{struct.name} record must be {wire_size} bytes on the wire\");")
+        lines.append("")
+        lines.append("    void pack(Packed& record) const {")
+        for cpp_type, packed, field_name, count in fields:
+            if count:
+                lines.append(f"        std::memcpy(record.{field_name}, {field_name}.data(), sizeof(record.{field_name}));")
+                continue
+            value = field_name if cpp_type == packed else f"static_cast<int32_t>({field_name})"
+            lines.append(f"        record.{field_name} = {value};")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    void unpack(const Packed& record) {")
+        for cpp_type, packed, field_name, count in fields:
+            if count:
+                lines.append(f"        std::memcpy({field_name}.data(), record.{field_name}, sizeof(record.{field_name}));")
+                continue
+            value = f"record.{field_name}" if cpp_type == packed else f"static_cast<{cpp_type}>(record.{field_name})"
+            lines.append(f"        {field_name} = {value};")
+        lines.append("    }")
+        return lines
+    
+    def _sparse_presence(self, field_type: str, cpp_type: str, field_name: str) -> Optional[Tuple[str, str]]:
+        """WIRE_SPARSE 下字段的 (非默认值判断, 恢复默认值语句)；None 表示该字段总是编码"""
+        if (cpp_type == 'std::string' or cpp_type.startswith(('std::vector<', 'BoundedSequence<', 'std::unordered_map<'))
+                or cpp_type in self.columnar):
+            return f"!{field_name}.empty()", f"{field_name}.clear();"
+        if cpp_type in self.FIXED_SIZES:
+            return f"ByteBuffer::nonZero({field_name})", f"{field_name} = {cpp_type}();"
+        if field_type in [e.name for e in (self.module.enums if self.module else [])]:
+            return f"static_cast<int32_t>({field_name}) != 0", f"{field_name} = {cpp_type}();"
+        # 嵌套 struct 和定长数组无廉价的默认值判断，总是编码
+        return None
+
     def _generate_struct(self, struct: IDLStruct) -> str:
         """生成C++结构体（带序列化方法）"""
         lines = [f"struct {struct.name} {{"]
@@ -939,14 +1479,70 @@ class CppSocketCodeGenerator:
         # 生成字段
         for field_type, field_name in struct.fields:
             cpp_type = self.map_type(field_type)
-            lines.append(f"    {cpp_type} {field_name};")
+            lines.append(f"    {self._arena_type(cpp_type)} {field_name};")
+        lines.extend(self._generate_allocator_ctors(
+            struct.name, [(self.map_type(t), n) for t, n in struct.fields], copyable=True))
+        fixed = self._is_fixed_struct(struct.name)
+        lines.extend(self._generate_packed_record(struct))
+        delta_fields = self._delta_fields(struct.name)
+        if delta_fields:
+            lines.append("")
+            lines.append("    // Previous element's @delta fields while a sequence is encoded or decoded")
+            lines.append("    struct DeltaState {")
+            for field_type, field_name in struct.fields:
+                if field_name in delta_fields:
+                    lines.append(f"        {self.map_type(field_type)} {field_name} = 0;")
+            lines.append("    };")
         
         # 生成序列化方法
         lines.append("")
-        lines.append("    void serialize(ByteBuffer& buffer) const {")
-        for field_type, field_name in struct.fields:
+        if delta_fields:
+            lines.append("    void serialize(ByteBuffer& buffer, DeltaState* delta = nullptr) const {")
+        else:
+            lines.append("    void serialize(ByteBuffer& buffer) const {")
+        if fixed:
+            lines.append("        if (buffer.nativeRecords()) {")
+            lines.append("            Packed record;")
+            lines.append("            pack(record);")
+            lines.append("            buffer.writeBytes(reinterpret_cast<const uint8_t*>(&record), sizeof(record));")
+            lines.append("            return;")
+            lines.append("        }")
+        lazy = 'lazy' in struct.annotations
+        # WIRE_SPARSE：位图 + 省略默认值字段；@lazy 的偏移表需要每个字段都在，故不参与
+        sparse = {}
+        if not lazy and len(struct.fields) <= 64:
+            for field_type, field_name in struct.fields:
+                if field_name not in delta_fields:
+                    presence = self._sparse_presence(field_type, self.map_type(field_type), field_name)
+                    if presence:
+                        sparse[field_name] = presence
+        always = sum(1 << i for i, (_, n) in enumerate(struct.fields) if n not in sparse)
+        if sparse:
+            lines.append("        // WIRE_SPARSE: presence bitmap, then only the fields that differ from their default")
+            lines.append("        uint64_t present = ~uint64_t(0);")
+            lines.append("        if (buffer.wireFlags() & WIRE_SPARSE) {")
+            lines.append(f"            present = {f'uint64_t(0x{always:x})' if always else '0'};")
+            for field_index, (field_type, field_name) in enumerate(struct.fields):
+                if field_name in sparse:
+                    lines.append(f"            if ({sparse[field_name][0]}) present |= uint64_t(1) << {field_index};")
+            lines.append(f"            buffer.writePresence(present, {len(struct.fields)});")
+            lines.append("        }")
+        if lazy:
+            lines.append("        // @lazy: table of field end offsets (relative to the body), then the body.")
+            lines.append("        // Fields must decode on their own, so the string dictionary is paused.")
+            lines.append("        uint8_t wire_flags = buffer.wireFlags();")
+            lines.append("        buffer.setWireFlags(wire_flags & ~WIRE_STRING_DICT);")
+            lines.append(f"        size_t table = buffer.reserveFixed32({len(struct.fields)});")
+            lines.append("        size_t body = buffer.size();")
+        for field_index, (field_type, field_name) in enumerate(struct.fields):
+            if lazy and field_index > 0:
+                lines.append(f"        buffer.patchFixed32(table + {4 * (field_index - 1)}, static_cast<uint32_t>(buffer.size() - body));")
             cpp_type = self.map_type(field_type)
-            if cpp_type == 'std::string':
+            start = len(lines)
+            if field_name in delta_fields:
+                lines.append(f"        if (delta) buffer.writeDelta({field_name}, delta->{field_name});")
+                lines.append(f"        else buffer.{self.WRITE_METHODS[cpp_type]}({field_name});")
+            elif cpp_type == 'std::string':
                 lines.append(f"        buffer.writeString({field_name});")
             elif cpp_type == 'int32_t':
                 lines.append(f"        buffer.writeInt32({field_name});")
@@ -972,6 +1568,19 @@ class CppSocketCodeGenerator:
                 lines.append(f"        buffer.writeDouble({field_name});")
             elif cpp_type == 'float':
                 lines.append(f"        buffer.writeFloat({field_name});")
+            elif cpp_type.startswith('std::array<'):
+                lines.extend(self._encode_array_lines(cpp_type, field_name, "        "))
+            elif cpp_type.startswith('std::unordered_map<'):
+                lines.append(f"        buffer.writeMap({field_name});")
+            elif cpp_type.startswith('std::vector<') and cpp_type[12:-1] in self.BULK_TYPES:
+                # 数值元素：整体写入（原生小端模式下为一次 memcpy）
+                lines.append(f"        buffer.writeArray({field_name}.data(), {field_name}.size());")
+            elif cpp_type == 'std::vector<bool>':
+                lines.append(f"        buffer.writeBoolArray({field_name});")
+            elif cpp_type.startswith('std::vector<') and self._delta_fields(cpp_type[12:-1]):
+                lines.append(f"        buffer.writeDeltaSequence({field_name});")
+            elif cpp_type.startswith('std::vector<') and self._is_fixed_struct(cpp_type[12:-1]):
+                lines.append(f"        buffer.writeRecords({field_name});")
             elif cpp_type.startswith('std::vector<'):
                 # 处理 vector 类型 - 需要提取元素类型并正确序列化
                 elem_type = cpp_type[12:-1]  # 提取 std::vector<Type> 中的 Type
@@ -1008,15 +1617,44 @@ class CppSocketCodeGenerator:
                 else:
                     # 假设是 struct，调用其 serialize 方法
                     lines.append(f"        {field_name}.serialize(buffer);")
+            if field_name in sparse:
+                lines[start:] = ([f"        if (present & (uint64_t(1) << {field_index})) {{"] +
+                                 ["    " + line for line in lines[start:]] + ["        }"])
+        if lazy:
+            lines.append(f"        buffer.patchFixed32(table + {4 * (len(struct.fields) - 1)}, static_cast<uint32_t>(buffer.size() - body));")
+            lines.append("        buffer.setWireFlags(wire_flags);")
         lines.append("    }")
         
         # 生成反序列化方法
         lines.append("")
-        lines.append("    void deserialize(ByteReader& reader) {")
-        for field_type, field_name in struct.fields:
+        if delta_fields:
+            lines.append("    void deserialize(ByteReader& reader, DeltaState* delta = nullptr) {")
+        else:
+            lines.append("    void deserialize(ByteReader& reader) {")
+        if fixed:
+            lines.append("        if (reader.nativeRecords()) {")
+            lines.append("            Packed record;")
+            lines.append("            reader.readBytes(&record, sizeof(record));")
+            lines.append("            unpack(record);")
+            lines.append("            return;")
+            lines.append("        }")
+        if lazy:
+            lines.append("        uint8_t wire_flags = reader.wireFlags();")
+            lines.append("        reader.setWireFlags(wire_flags & ~WIRE_STRING_DICT);")
+            lines.append(f"        reader.skip({4 * len(struct.fields)});  // Offset table: only {struct.name}Lazy needs it")
+        if sparse:
+            lines.append("        // WIRE_SPARSE: fields the sender left out are reset to their default")
+            lines.append("        uint64_t present = ~uint64_t(0);")
+            lines.append(f"        if (reader.wireFlags() & WIRE_SPARSE) present = reader.readPresence({len(struct.fields)});")
+        for field_index, (field_type, field_name) in enumerate(struct.fields):
             cpp_type = self.map_type(field_type)
-            if cpp_type == 'std::string':
-                lines.append(f"        {field_name} = reader.readString();")
+            start = len(lines)
+            if field_name in delta_fields:
+                read_method = 'read' + self.WRITE_METHODS[cpp_type][len('write'):]
+                lines.append(f"        if (delta) {field_name} = reader.readDelta(delta->{field_name});")
+                lines.append(f"        else {field_name} = reader.{read_method}();")
+            elif cpp_type == 'std::string':
+                lines.append(f"        reader.readStringInto({field_name});")
             elif cpp_type == 'int32_t':
                 lines.append(f"        {field_name} = reader.readInt32();")
             elif cpp_type == 'uint32_t':
@@ -1041,16 +1679,28 @@ class CppSocketCodeGenerator:
                 lines.append(f"        {field_name} = reader.readDouble();")
             elif cpp_type == 'float':
                 lines.append(f"        {field_name} = reader.readFloat();")
+            elif cpp_type.startswith('std::array<'):
+                lines.extend(self._decode_array_lines(cpp_type, field_name, "        "))
+            elif cpp_type.startswith('std::unordered_map<'):
+                lines.append(f"        reader.readMapInto({field_name});")
+            elif cpp_type.startswith('std::vector<') and cpp_type[12:-1] in self.BULK_TYPES:
+                lines.append(f"        reader.readArrayInto({field_name});")
+            elif cpp_type == 'std::vector<bool>':
+                lines.append(f"        reader.readBoolArrayInto({field_name});")
+            elif cpp_type.startswith('std::vector<') and self._delta_fields(cpp_type[12:-1]):
+                lines.append(f"        reader.readDeltaSequenceInto({field_name});")
+            elif cpp_type.startswith('std::vector<') and self._is_fixed_struct(cpp_type[12:-1]):
+                lines.append(f"        reader.readRecordsInto({field_name});")
             elif cpp_type.startswith('std::vector<'):
                 # 处理 vector 类型 - 需要提取元素类型并正确反序列化
                 elem_type = cpp_type[12:-1]  # 提取 std::vector<Type> 中的 Type
                 lines.append(f"        {{")
-                lines.append(f"            uint32_t count = reader.readUint32();")
+                lines.append(f"            uint32_t count = reader.readCount();")
                 lines.append(f"            {field_name}.resize(count);")
                 lines.append(f"            for (uint32_t i = 0; i < count; i++) {{")
                 # 根据元素类型选择反序列化方法
                 if elem_type == 'std::string':
-                    lines.append(f"                {field_name}[i] = reader.readString();")
+                    lines.append(f"                reader.readStringInto({field_name}[i]);")
                 elif elem_type in ['int32_t', 'uint32_t', 'int64_t', 'uint64_t', 'int16_t', 'uint16_t',
                                   'int8_t', 'uint8_t', 'char', 'bool', 'float', 'double']:
                     read_method = {
@@ -1078,45 +1728,415 @@ class CppSocketCodeGenerator:
                     lines.append(f"        {field_name} = static_cast<{cpp_type}>(reader.readInt32());")
                 else:
                     lines.append(f"        {field_name}.deserialize(reader);")
+            if field_name in sparse:
+                lines[start:] = ([f"        if (present & (uint64_t(1) << {field_index})) {{"] +
+                                 ["    " + line for line in lines[start:]] +
+                                 ["        } else {", f"            {sparse[field_name][1]}", "        }"])
+        if lazy:
+            lines.append("        reader.setWireFlags(wire_flags);")
         lines.append("    }")
         
         lines.append("};")
+        if lazy:
+            lines.append("")
+            lines.extend(self._generate_lazy_struct(struct))
+        for seq_name, elem_name in self.columnar.items():
+            if elem_name == struct.name:
+                lines.append("")
+                lines.extend(self._generate_columnar_seq(seq_name, struct))
         return "\n".join(lines)
     
+    def _generate_lazy_struct(self, struct: IDLStruct) -> List[str]:
+        """@lazy：生成按需解码的访问类型，字段在首次访问时才从接收缓冲区解码"""
+        name = struct.name
+        count = len(struct.fields)
+        lines = []
+        lines.append(f"// {name} decoded on demand: deserialize() only reads the offset table, and each")
+        lines.append("// field is decoded on first access. The buffer being read must outlive this object.")
+        lines.append(f"class {name}Lazy {{")
+        lines.append("public:")
+        lines.append(f"    {name}Lazy() : body_(nullptr), wire_flags_(0), loaded_(0) {{}}")
+        lines.append("")
+        lines.append("    void deserialize(ByteReader& reader) {")
+        lines.append("        wire_flags_ = reader.wireFlags() & ~WIRE_STRING_DICT;")
+        lines.append("        uint32_t begin = 0;")
+        lines.append(f"        for (size_t i = 0; i < {count}; i++) {{")
+        lines.append("            ends_[i] = reader.readFixed32();")
+        lines.append(f"            if (ends_[i] < begin) throw std::runtime_error(\"{name}: bad offset table\");")
+        lines.append("            begin = ends_[i];")
+        lines.append("        }")
+        lines.append("        body_ = reader.cursor();")
+        lines.append(f"        reader.skip(ends_[{count - 1}]);")
+        lines.append("        loaded_ = 0;")
+        lines.append("    }")
+        for index, (field_type, field_name) in enumerate(struct.fields):
+            cpp_type = self.map_type(field_type)
+            lines.append("")
+            lines.append(f"    const {cpp_type}& {field_name}() const {{")
+            lines.append(f"        if (!(loaded_ & (static_cast<uint64_t>(1) << {index}))) {{")
+            lines.append(f"            ByteReader reader = fieldReader({index});")
+            lines.extend(self._decode_field_lines(cpp_type, f"{field_name}_", "            "))
+            lines.append(f"            loaded_ |= static_cast<uint64_t>(1) << {index};")
+            lines.append("        }")
+            lines.append(f"        return {field_name}_;")
+            lines.append("    }")
+        lines.append("")
+        lines.append("private:")
+        lines.append("    ByteReader fieldReader(size_t index) const {")
+        lines.append("        uint32_t begin = index ? ends_[index - 1] : 0;")
+        lines.append("        return ByteReader(body_ + begin, ends_[index] - begin, wire_flags_);")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    const uint8_t* body_;")
+        lines.append("    uint8_t wire_flags_;")
+        lines.append(f"    uint32_t ends_[{count}];")
+        lines.append("    mutable uint64_t loaded_;  // Bit i: field i decoded")
+        for field_type, field_name in struct.fields:
+            lines.append(f"    mutable {self.map_type(field_type)} {field_name}_;")
+        lines.append("};")
+        return lines
+    
+    def _generate_lazy_request(self, method: IDLMethod) -> List[str]:
+        """@lazy 参数的 callback：消息副本 + 按需解码的参数，供 setLazyCallbacks 交付"""
+        name = f"{method.name}RequestLazy"
+        lines = []
+        lines.append(f"// {method.name} callback with its @lazy parameters decoded on demand. The")
+        lines.append("// parameters point into message, so this object is neither copied nor moved.")
+        lines.append(f"struct {name} {{")
+        lines.append("    std::vector<uint8_t> message;")
+        for param in method.parameters:
+            lines.append(f"    {param.type_name}Lazy {param.name};")
+        lines.append("")
+        lines.append(f"    {name}(const uint8_t* bytes, size_t length, uint8_t wire_flags) : message(bytes, bytes + length) {{")
+        lines.append("        ByteReader reader(message.data(), message.size(), wire_flags);")
+        lines.append("        reader.readMsgId();")
+        for param in method.parameters:
+            lines.append(f"        {param.name}.deserialize(reader);")
+        lines.append("    }")
+        lines.append(f"    {name}(const {name}&) = delete;")
+        lines.append(f"    {name}& operator=(const {name}&) = delete;")
+        lines.append("};")
+        return lines
+    
+    def _generate_columnar_seq(self, seq_name: str, struct: IDLStruct) -> List[str]:
+        """@columnar：生成行容器 SeqName（按列编码）和列容器 SeqNameColumns（同一线路格式，每字段一个 vector）"""
+        fields = []
+        for field_type, field_name in struct.fields:
+            cpp_type = self.map_type(field_type)
+            fields.append((cpp_type, field_name, self._is_enum(field_type) or self._is_enum(cpp_type)))
+        delta_fields = self._delta_fields(struct.name)
+        elem = struct.name
+        lines = []
+        lines.append(f"// @columnar sequence<{elem}>: encoded as one block per field (all {fields[0][1]} values,")
+        lines.append("// then the next field, ...), each block laid out like a sequence of that field")
+        lines.append(f"struct {seq_name} : std::vector<{elem}> {{")
+        lines.append(f"    {seq_name}() {{}}")
+        lines.append(f"    {seq_name}(const std::vector<{elem}>& rows) : std::vector<{elem}>(rows) {{}}")
+        lines.append(f"    {seq_name}(std::vector<{elem}>&& rows) : std::vector<{elem}>(std::move(rows)) {{}}")
+        lines.append(f"    {seq_name}(std::initializer_list<{elem}> rows) : std::vector<{elem}>(rows) {{}}")
+        lines.append("")
+        lines.append("    void serialize(ByteBuffer& buffer) const {")
+        for cpp_type, name, is_enum in fields:
+            if cpp_type == 'bool':
+                lines.append("        {")
+                lines.append("            std::vector<bool> column(size());")
+                lines.append("            for (size_t i = 0; i < size(); i++) {")
+                lines.append(f"                column[i] = (*this)[i].{name};")
+                lines.append("            }")
+                lines.append("            buffer.writeBoolArray(column);")
+                lines.append("        }")
+                continue
+            lines.append("        buffer.writeUint32(static_cast<uint32_t>(size()));")
+            if name in delta_fields:
+                lines.append("        {")
+                lines.append(f"            {cpp_type} previous = 0;")
+                lines.append("            for (const auto& row : *this) {")
+                lines.append(f"                buffer.writeDelta(row.{name}, previous);")
+                lines.append("            }")
+                lines.append("        }")
+                continue
+            lines.append("        for (const auto& row : *this) {")
+            if is_enum:
+                lines.append(f"            buffer.writeInt32(static_cast<int32_t>(row.{name}));")
+            else:
+                lines.append(f"            buffer.{self.WRITE_METHODS[cpp_type]}(row.{name});")
+            lines.append("        }")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    void deserialize(ByteReader& reader) {")
+        for index, (cpp_type, name, is_enum) in enumerate(fields):
+            if cpp_type == 'bool':
+                lines.append("        {")
+                lines.append("            std::vector<bool> column;")
+                lines.append("            reader.readBoolArrayInto(column);")
+                lines.append("            " + ("resize(column.size());" if index == 0 else "checkColumn(column.size());"))
+                lines.append("            for (size_t i = 0; i < size(); i++) {")
+                lines.append(f"                (*this)[i].{name} = column[i];")
+                lines.append("            }")
+                lines.append("        }")
+                continue
+            lines.append("        " + ("resize(reader.readCount());" if index == 0 else "checkColumn(reader.readUint32());"))
+            if name in delta_fields:
+                lines.append("        {")
+                lines.append(f"            {cpp_type} previous = 0;")
+                lines.append("            for (auto& row : *this) {")
+                lines.append(f"                row.{name} = reader.readDelta(previous);")
+                lines.append("            }")
+                lines.append("        }")
+                continue
+            lines.append("        for (auto& row : *this) {")
+            if cpp_type == 'std::string':
+                lines.append(f"            reader.readStringInto(row.{name});")
+            elif is_enum:
+                lines.append(f"            row.{name} = static_cast<{cpp_type}>(reader.readInt32());")
+            else:
+                read_method = 'read' + self.WRITE_METHODS[cpp_type][len('write'):]
+                lines.append(f"            row.{name} = reader.{read_method}();")
+            lines.append("        }")
+        lines.append("    }")
+        lines.append("")
+        lines.append("private:")
+        lines.append("    void checkColumn(size_t count) const {")
+        lines.append(f"        if (count != size()) throw std::runtime_error(\"{seq_name}: column length mismatch\");")
+        lines.append("    }")
+        lines.append("};")
+        # 列容器：分析型消费者直接按列扫描，不物化结构体
+        lines.append("")
+        lines.append(f"// Structure-of-arrays form of {seq_name}; reads and writes the same blocks, so")
+        lines.append("// a payload can be scanned column by column without building structs")
+        lines.append(f"struct {seq_name}Columns {{")
+        for cpp_type, name, _ in fields:
+            lines.append(f"    std::vector<{cpp_type}> {name};")
+        lines.append("")
+        lines.append(f"    size_t size() const {{ return {fields[0][1]}.size(); }}")
+        lines.append("")
+        lines.append("    void serialize(ByteBuffer& buffer) const {")
+        for cpp_type, name, is_enum in fields:
+            if name in delta_fields:
+                lines.append(f"        buffer.writeUint32(static_cast<uint32_t>({name}.size()));")
+                lines.append("        {")
+                lines.append(f"            {cpp_type} previous = 0;")
+                lines.append(f"            for (const auto& value : {name}) {{")
+                lines.append("                buffer.writeDelta(value, previous);")
+                lines.append("            }")
+                lines.append("        }")
+            elif cpp_type == 'std::string':
+                lines.append(f"        buffer.writeStringVector({name});")
+            elif cpp_type == 'bool':
+                lines.append(f"        buffer.writeBoolArray({name});")
+            elif cpp_type in self.BULK_TYPES:
+                lines.append(f"        buffer.writeArray({name}.data(), {name}.size());")
+            else:
+                lines.append(f"        buffer.writeUint32(static_cast<uint32_t>({name}.size()));")
+                lines.append(f"        for (const auto& value : {name}) {{")
+                lines.append("            buffer.writeInt32(static_cast<int32_t>(value));")
+                lines.append("        }")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    void deserialize(ByteReader& reader) {")
+        for cpp_type, name, is_enum in fields:
+            if name in delta_fields:
+                lines.append(f"        {name}.resize(reader.readCount());")
+                lines.append("        {")
+                lines.append(f"            {cpp_type} previous = 0;")
+                lines.append(f"            for (auto& value : {name}) {{")
+                lines.append("                value = reader.readDelta(previous);")
+                lines.append("            }")
+                lines.append("        }")
+            elif cpp_type == 'std::string':
+                lines.append(f"        reader.readStringVectorInto({name});")
+            elif cpp_type == 'bool':
+                lines.append(f"        reader.readBoolArrayInto({name});")
+            elif cpp_type in self.BULK_TYPES:
+                lines.append(f"        reader.readArrayInto({name});")
+            else:
+                lines.append(f"        {name}.resize(reader.readCount());")
+                lines.append(f"        for (auto& value : {name}) {{")
+                lines.append(f"            value = static_cast<{cpp_type}>(reader.readInt32());")
+                lines.append("        }")
+        if len(fields) > 1:
+            mismatch = " || ".join(f"{name}.size() != size()" for _, name, _ in fields[1:])
+            lines.append(f"        if ({mismatch}) {{")
+            lines.append(f"            throw std::runtime_error(\"{seq_name}Columns: column length mismatch\");")
+            lines.append("        }")
+        lines.append("    }")
+        lines.append("};")
+        return lines
+    
     def _generate_serialization_helpers(self) -> str:
         """生成序列化辅助类"""
-        return """// Serialization helpers
+        return """// Wire encodings. The sender's choice travels in the top byte of each frame's
+// size prefix (frames never exceed 24 bits), so every frame decodes on its own;
+// a client only uses an encoding the server accepted (MSG_CTRL_HELLO), and the
+// server answers and pushes callbacks to it in that encoding.
+enum WireFlag : uint8_t {
+    WIRE_COMPACT = 0x01,     // LEB128 varints for integers and lengths, zigzag for signed
+    WIRE_NATIVE_LE = 0x02,   // Fixed-width values in little-endian order, copied with memcpy
+    WIRE_STRING_DICT = 0x04, // Repeated strings within a message are sent once, then by index
+    WIRE_LZ = 0x08,          // Large payloads may be LZ-compressed (FRAME_COMPRESSED frames)
+    WIRE_SPARSE = 0x10       // Structs carry a presence bitmap; default-valued fields are left out
+};
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+const uint8_t WIRE_SUPPORTED = WIRE_COMPACT | WIRE_NATIVE_LE | WIRE_STRING_DICT | WIRE_LZ | WIRE_SPARSE;
+#else
+const uint8_t WIRE_SUPPORTED = WIRE_COMPACT | WIRE_STRING_DICT | WIRE_LZ | WIRE_SPARSE;  // Native mode needs a little-endian host
+#endif
+// In WIRE_STRING_DICT mode a string's length prefix is (length << 1) for a literal,
+// or (index << 1) | 1 for a reference to an earlier literal of the same message.
+// Only literals of at least this many bytes enter the dictionary.
+const uint32_t WIRE_DICT_MIN_LENGTH = 4;
+
+// Serialization helpers
 class ByteBuffer {
 private:
     std::vector<uint8_t> data_;
+    uint8_t wire_flags_ = 0;
+    // WIRE_STRING_DICT: first occurrence (offset in data_, length) of each dictionary
+    // string, indexed by an open-addressing table of entry index + 1 (0 = empty)
+    std::vector<std::pair<uint32_t, uint32_t>> dict_entries_;
+    std::vector<uint32_t> dict_slots_;
 
-public:
-    void writeUint32(uint32_t value) {
+    void putFixed32(uint32_t value) {
         data_.push_back((value >> 24) & 0xFF);
         data_.push_back((value >> 16) & 0xFF);
         data_.push_back((value >> 8) & 0xFF);
         data_.push_back(value & 0xFF);
     }
 
+    void putVarint(uint64_t value) {
+        while (value >= 0x80) {
+            data_.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        data_.push_back(static_cast<uint8_t>(value));
+    }
+
+    template <typename T>
+    void putNative(T value) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        data_.insert(data_.end(), bytes, bytes + sizeof(T));
+    }
+
+    static uint32_t hashBytes(const char* bytes, size_t size) {
+        uint32_t hash = 2166136261u;  // FNV-1a
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ static_cast<uint8_t>(bytes[i])) * 16777619u;
+        }
+        return hash;
+    }
+
+    // Slot holding str, or the empty slot where it belongs
+    size_t dictSlot(const char* str, size_t len, uint32_t hash) const {
+        size_t mask = dict_slots_.size() - 1;
+        for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+            uint32_t entry = dict_slots_[slot];
+            if (entry == 0) return slot;
+            const std::pair<uint32_t, uint32_t>& known = dict_entries_[entry - 1];
+            if (known.second == len && std::memcmp(&data_[known.first], str, len) == 0) return slot;
+        }
+    }
+
+    void dictGrow() {
+        std::vector<uint32_t> slots(dict_slots_.empty() ? 64 : dict_slots_.size() * 2, 0);
+        dict_slots_.swap(slots);
+        for (size_t i = 0; i < dict_entries_.size(); i++) {
+            const char* known = reinterpret_cast<const char*>(&data_[dict_entries_[i].first]);
+            size_t len = dict_entries_[i].second;
+            dict_slots_[dictSlot(known, len, hashBytes(known, len))] = static_cast<uint32_t>(i + 1);
+        }
+    }
+
+    void putString(const char* str, size_t len) {
+        if (!(wire_flags_ & WIRE_STRING_DICT)) {
+            writeUint32(static_cast<uint32_t>(len));
+            data_.insert(data_.end(), str, str + len);
+            return;
+        }
+        size_t slot = 0;
+        if (len >= WIRE_DICT_MIN_LENGTH) {
+            if ((dict_entries_.size() + 1) * 2 > dict_slots_.size()) dictGrow();
+            slot = dictSlot(str, len, hashBytes(str, len));
+            if (dict_slots_[slot] != 0) {
+                writeUint32(((dict_slots_[slot] - 1) << 1) | 1);
+                return;
+            }
+        }
+        writeUint32(static_cast<uint32_t>(len) << 1);
+        size_t offset = data_.size();
+        data_.insert(data_.end(), str, str + len);
+        if (len >= WIRE_DICT_MIN_LENGTH) {
+            dict_entries_.push_back(std::make_pair(static_cast<uint32_t>(offset), static_cast<uint32_t>(len)));
+            dict_slots_[slot] = static_cast<uint32_t>(dict_entries_.size());
+        }
+    }
+
+    static uint64_t zigzag(int64_t value) {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    // Whether a numeric sequence can be copied as raw bytes in the current encoding
+    template <typename T>
+    bool bulkCopy() const {
+        if (sizeof(T) == 1) return true;
+        if (!(wire_flags_ & WIRE_NATIVE_LE)) return false;
+        return !((wire_flags_ & WIRE_COMPACT) && std::is_integral<T>::value);
+    }
+
+    void writeValue(int8_t value) { writeInt8(value); }
+    void writeValue(uint8_t value) { writeUint8(value); }
+    void writeValue(char value) { writeChar(value); }
+    void writeValue(int16_t value) { writeInt16(value); }
+    void writeValue(uint16_t value) { writeUint16(value); }
+    void writeValue(int32_t value) { writeInt32(value); }
+    void writeValue(uint32_t value) { writeUint32(value); }
+    void writeValue(int64_t value) { writeInt64(value); }
+    void writeValue(uint64_t value) { writeUint64(value); }
+    void writeValue(float value) { writeFloat(value); }
+    void writeValue(double value) { writeDouble(value); }
+
+public:
+    void setWireFlags(uint8_t flags) { wire_flags_ = flags; }
+    uint8_t wireFlags() const { return wire_flags_; }
+
+    // Message IDs stay 4-byte big-endian in every encoding so that frames can
+    // be routed before they are decoded
+    void writeMsgId(uint32_t id) {
+        putFixed32(id);
+    }
+
+    void writeUint32(uint32_t value) {
+        if (wire_flags_ & WIRE_COMPACT) return putVarint(value);
+        if (wire_flags_ & WIRE_NATIVE_LE) return putNative(value);
+        putFixed32(value);
+    }
+
     void writeInt32(int32_t value) {
-        writeUint32(static_cast<uint32_t>(value));
+        if (wire_flags_ & WIRE_COMPACT) return putVarint(zigzag(value));
+        if (wire_flags_ & WIRE_NATIVE_LE) return putNative(value);
+        putFixed32(static_cast<uint32_t>(value));
     }
     
     void writeUint64(uint64_t value) {
-        writeUint32(static_cast<uint32_t>(value >> 32));
-        writeUint32(static_cast<uint32_t>(value & 0xFFFFFFFF));
+        if (wire_flags_ & WIRE_COMPACT) return putVarint(value);
+        if (wire_flags_ & WIRE_NATIVE_LE) return putNative(value);
+        putFixed32(static_cast<uint32_t>(value >> 32));
+        putFixed32(static_cast<uint32_t>(value & 0xFFFFFFFF));
     }
     
     void writeInt64(int64_t value) {
+        if (wire_flags_ & WIRE_COMPACT) return putVarint(zigzag(value));
         writeUint64(static_cast<uint64_t>(value));
     }
     
     void writeUint16(uint16_t value) {
+        if (wire_flags_ & WIRE_COMPACT) return putVarint(value);
+        if (wire_flags_ & WIRE_NATIVE_LE) return putNative(value);
         data_.push_back((value >> 8) & 0xFF);
         data_.push_back(value & 0xFF);
     }
     
     void writeInt16(int16_t value) {
+        if (wire_flags_ & WIRE_COMPACT) return putVarint(zigzag(value));
         writeUint16(static_cast<uint16_t>(value));
     }
     
@@ -1137,21 +2157,22 @@ public:
     }
     
     void writeDouble(double value) {
+        if (wire_flags_ & WIRE_NATIVE_LE) return putNative(value);
         uint64_t bits;
         std::memcpy(&bits, &value, sizeof(double));
-        writeUint32(static_cast<uint32_t>(bits >> 32));
-        writeUint32(static_cast<uint32_t>(bits & 0xFFFFFFFF));
+        putFixed32(static_cast<uint32_t>(bits >> 32));
+        putFixed32(static_cast<uint32_t>(bits & 0xFFFFFFFF));
     }
     
     void writeFloat(float value) {
+        if (wire_flags_ & WIRE_NATIVE_LE) return putNative(value);
         uint32_t bits;
         std::memcpy(&bits, &value, sizeof(float));
-        writeUint32(bits);
+        putFixed32(bits);
     }
 
     void writeString(const std::string& str) {
-        writeUint32(str.size());
-        data_.insert(data_.end(), str.begin(), str.end());
+        putString(str.data(), str.size());
     }
 
     void writeStringVector(const std::vector<std::string>& vec) {
@@ -1161,25 +2182,254 @@ public:
         }
     }
 
-    const uint8_t* data() const { return data_.data(); }
-    size_t size() const { return data_.size(); }
-    void clear() { data_.clear(); }
-};
-
-class ByteReader {
-private:
-    const uint8_t* data_;
-    size_t size_;
-    size_t pos_;
+#if __cplusplus >= 201703L
+    // std::pmr containers used by --pmr-arena headers
+    void writeString(const std::pmr::string& str) {
+        putString(str.data(), str.size());
+    }
 
-public:
-    ByteReader(const uint8_t* data, size_t size) : data_(data), size_(size), pos_(0) {}
+    void writeStringVector(const std::pmr::vector<std::pmr::string>& vec) {
+        writeUint32(vec.size());
+        for (const auto& item : vec) {
+            writeString(item);
+        }
+    }
+#endif
 
-    bool canRead(size_t bytes) const {
-        return pos_ + bytes <= size_;
+    void writeBytes(const uint8_t* bytes, size_t size) {
+        data_.insert(data_.end(), bytes, bytes + size);
     }
 
-    uint32_t readUint32() {
+    // Room for count 4-byte big-endian values filled in later (@lazy offset tables)
+    size_t reserveFixed32(size_t count) {
+        size_t pos = data_.size();
+        data_.resize(pos + 4 * count);
+        return pos;
+    }
+
+    void patchFixed32(size_t pos, uint32_t value) {
+        data_[pos] = (value >> 24) & 0xFF;
+        data_[pos + 1] = (value >> 16) & 0xFF;
+        data_[pos + 2] = (value >> 8) & 0xFF;
+        data_[pos + 3] = value & 0xFF;
+    }
+
+    // WIRE_SPARSE presence bitmap: one bit per struct field, LSB-first, (count + 7) / 8 bytes
+    void writePresence(uint64_t bits, size_t count) {
+        for (size_t i = 0; i < count; i += 8) {
+            data_.push_back(static_cast<uint8_t>(bits >> i));
+        }
+    }
+
+    // Whether a scalar differs from its default; bitwise, so -0.0 is still sent
+    template <typename T>
+    static bool nonZero(T value) {
+        T zero = T();
+        return std::memcmp(&value, &zero, sizeof(T)) != 0;
+    }
+
+    // sequence<bool>: count, then the bits packed LSB-first, 64 per little-endian
+    // word (the last word is truncated to the bytes it needs)
+    template <typename Vector>
+    void writeBoolArray(const Vector& bits) {
+        size_t count = bits.size();
+        writeUint32(static_cast<uint32_t>(count));
+        size_t pos = data_.size();
+        data_.resize(pos + (count + 7) / 8);
+        for (size_t base = 0; base < count; base += 64) {
+            size_t n = count - base < 64 ? count - base : 64;
+            uint64_t word = 0;
+            for (size_t i = 0; i < n; i++) {
+                word |= static_cast<uint64_t>(bits[base + i] ? 1 : 0) << i;
+            }
+            for (size_t b = 0; b < (n + 7) / 8; b++) {
+                data_[pos + base / 8 + b] = static_cast<uint8_t>(word >> (8 * b));
+            }
+        }
+    }
+
+    // @delta field inside a sequence: zigzag varint of the difference to the
+    // previous element (wrapping), independent of the wire encoding
+    template <typename T>
+    void writeDelta(T value, T& previous) {
+        putVarint(zigzag(static_cast<int64_t>(static_cast<uint64_t>(value) - static_cast<uint64_t>(previous))));
+        previous = value;
+    }
+
+    // Sequence of structs with @delta fields; T::DeltaState carries the previous element
+    template <typename Vector>
+    void writeDeltaSequence(const Vector& items) {
+        typename Vector::value_type::DeltaState delta;
+        writeUint32(static_cast<uint32_t>(items.size()));
+        for (const auto& item : items) {
+            item.serialize(*this, &delta);
+        }
+    }
+
+    // Fixed-size structs travel as their packed record (T::Packed)
+    bool nativeRecords() const {
+        return (wire_flags_ & (WIRE_NATIVE_LE | WIRE_COMPACT)) == WIRE_NATIVE_LE;
+    }
+
+    // Sequence of fixed-size structs: count, then the records. In native mode the
+    // buffer grows once; a struct without padding is laid out exactly like its
+    // record, so the whole sequence is a single memcpy.
+    template <typename Vector>
+    void writeRecords(const Vector& items) {
+        typedef typename Vector::value_type T;
+        typedef typename T::Packed Packed;
+        writeUint32(static_cast<uint32_t>(items.size()));
+        if (!nativeRecords()) {
+            for (const auto& item : items) {
+                item.serialize(*this);
+            }
+            return;
+        }
+        size_t pos = data_.size();
+        data_.resize(pos + items.size() * sizeof(Packed));
+        if (items.empty()) return;
+        if (sizeof(T) == sizeof(Packed) && std::is_trivially_copyable<T>::value) {
+            std::memcpy(&data_[pos], &items[0], items.size() * sizeof(T));
+            return;
+        }
+        for (size_t i = 0; i < items.size(); i++) {
+            Packed record;
+            items[i].pack(record);
+            std::memcpy(&data_[pos + i * sizeof(Packed)], &record, sizeof(Packed));
+        }
+    }
+
+    // Numeric sequence: count, then the elements. Byte-sized elements, and all
+    // fixed-width elements in native little-endian mode, are a single memcpy.
+    template <typename T>
+    void writeArray(const T* items, size_t count) {
+        writeUint32(static_cast<uint32_t>(count));
+        writeFixedArray(items, count);
+    }
+
+    // Fixed-size array (IDL T name[N]): the elements only, both sides know N
+    template <typename T>
+    void writeFixedArray(const T* items, size_t count) {
+        if (bulkCopy<T>()) {
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(items);
+            data_.insert(data_.end(), bytes, bytes + count * sizeof(T));
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            writeValue(items[i]);
+        }
+    }
+
+    // One map key/value or BoundedSequence element, encoded like a message field of
+    // that type (sequences inside a map are written element by element)
+    void writeItem(bool value) { writeBool(value); }
+    void writeItem(const std::string& value) { writeString(value); }
+
+    template <typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value>::type writeItem(T value) { writeValue(value); }
+
+    template <typename T>
+    typename std::enable_if<std::is_enum<T>::value>::type writeItem(T value) {
+        writeInt32(static_cast<int32_t>(value));
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_class<T>::value>::type writeItem(const T& value) { value.serialize(*this); }
+
+    template <typename T, typename A>
+    void writeItem(const std::vector<T, A>& vec) {
+        writeUint32(static_cast<uint32_t>(vec.size()));
+        for (const auto& item : vec) writeItem(item);
+    }
+
+    template <typename K, typename V, typename H, typename E, typename A>
+    void writeItem(const std::unordered_map<K, V, H, E, A>& map) { writeMap(map); }
+
+    // map<K, V>: count, then key, value for each entry in the table's iteration order
+    template <typename Map>
+    void writeMap(const Map& map) {
+        writeUint32(static_cast<uint32_t>(map.size()));
+        for (const auto& entry : map) {
+            writeItem(entry.first);
+            writeItem(entry.second);
+        }
+    }
+
+    const uint8_t* data() const { return data_.data(); }
+    size_t size() const { return data_.size(); }
+    size_t capacity() const { return data_.capacity(); }
+    void reserve(size_t bytes) { data_.reserve(bytes); }
+    void clear() {
+        data_.clear();
+        if (!dict_entries_.empty()) {
+            dict_entries_.clear();
+            std::fill(dict_slots_.begin(), dict_slots_.end(), 0);
+        }
+    }
+};
+
+// Per-thread pool of serialization buffers. Buffers keep their grown capacity
+// when they come back, so steady-state calls serialize without allocating;
+// a buffer that grew past kTrimCapacity is freed instead of pooled.
+class ByteBufferPool {
+public:
+    static const size_t kInitialCapacity = 4096;
+    static const size_t kTrimCapacity = 256 * 1024;
+    static const size_t kMaxPooled = 8;
+
+    static std::unique_ptr<ByteBuffer> acquire() {
+        std::vector<std::unique_ptr<ByteBuffer>>& pool = threadPool();
+        if (pool.empty()) {
+            std::unique_ptr<ByteBuffer> buffer(new ByteBuffer());
+            buffer->reserve(kInitialCapacity);
+            return buffer;
+        }
+        std::unique_ptr<ByteBuffer> buffer = std::move(pool.back());
+        pool.pop_back();
+        return buffer;
+    }
+
+    static void release(std::unique_ptr<ByteBuffer> buffer) {
+        std::vector<std::unique_ptr<ByteBuffer>>& pool = threadPool();
+        if (!buffer || buffer->capacity() > kTrimCapacity || pool.size() >= kMaxPooled) return;
+        buffer->clear();
+        buffer->setWireFlags(0);
+        pool.push_back(std::move(buffer));
+    }
+
+private:
+    static std::vector<std::unique_ptr<ByteBuffer>>& threadPool() {
+        static thread_local std::vector<std::unique_ptr<ByteBuffer>> pool;
+        if (pool.capacity() < kMaxPooled) pool.reserve(kMaxPooled);
+        return pool;
+    }
+};
+
+// Scoped lease on a pooled buffer; returns it to the pool on destruction
+class PooledByteBuffer {
+public:
+    PooledByteBuffer() : buffer_(ByteBufferPool::acquire()) {}
+    ~PooledByteBuffer() { ByteBufferPool::release(std::move(buffer_)); }
+
+    ByteBuffer& operator*() { return *buffer_; }
+    ByteBuffer* operator->() { return buffer_.get(); }
+
+private:
+    PooledByteBuffer(const PooledByteBuffer&);
+    PooledByteBuffer& operator=(const PooledByteBuffer&);
+
+    std::unique_ptr<ByteBuffer> buffer_;
+};
+
+class ByteReader {
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_;
+    uint8_t wire_flags_;
+    std::vector<std::pair<uint32_t, uint32_t>> dict_;  // WIRE_STRING_DICT literals (offset, length)
+
+    uint32_t getFixed32() {
         if (!canRead(4)) throw std::runtime_error("Buffer underflow");
         uint32_t value = (static_cast<uint32_t>(data_[pos_]) << 24) | 
                          (static_cast<uint32_t>(data_[pos_+1]) << 16) |
@@ -1189,21 +2439,144 @@ public:
         return value;
     }
 
+    uint64_t getVarint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (!canRead(1)) throw std::runtime_error("Buffer underflow");
+            uint8_t byte = data_[pos_++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw std::runtime_error("Malformed varint");
+    }
+
+    template <typename T>
+    T getNative() {
+        if (!canRead(sizeof(T))) throw std::runtime_error("Buffer underflow");
+        T value;
+        std::memcpy(&value, data_ + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return value;
+    }
+
+    // Locate the next string's bytes, resolving dictionary references
+    const char* getString(uint32_t& len) {
+        uint32_t prefix = readUint32();
+        if (!(wire_flags_ & WIRE_STRING_DICT)) {
+            len = prefix;
+        } else if (prefix & 1) {
+            uint32_t index = prefix >> 1;
+            if (index >= dict_.size()) throw std::runtime_error("Bad string reference");
+            len = dict_[index].second;
+            return reinterpret_cast<const char*>(data_ + dict_[index].first);
+        } else {
+            len = prefix >> 1;
+            if (len >= WIRE_DICT_MIN_LENGTH && canRead(len)) {
+                dict_.push_back(std::make_pair(static_cast<uint32_t>(pos_), len));
+            }
+        }
+        if (!canRead(len)) throw std::runtime_error("Buffer underflow");
+        const char* str = reinterpret_cast<const char*>(data_ + pos_);
+        pos_ += len;
+        return str;
+    }
+
+    static int64_t unzigzag(uint64_t value) {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    template <typename T>
+    bool bulkCopy() const {
+        if (sizeof(T) == 1) return true;
+        if (!(wire_flags_ & WIRE_NATIVE_LE)) return false;
+        return !((wire_flags_ & WIRE_COMPACT) && std::is_integral<T>::value);
+    }
+
+    void readValue(int8_t& value) { value = readInt8(); }
+    void readValue(uint8_t& value) { value = readUint8(); }
+    void readValue(char& value) { value = readChar(); }
+    void readValue(int16_t& value) { value = readInt16(); }
+    void readValue(uint16_t& value) { value = readUint16(); }
+    void readValue(int32_t& value) { value = readInt32(); }
+    void readValue(uint32_t& value) { value = readUint32(); }
+    void readValue(int64_t& value) { value = readInt64(); }
+    void readValue(uint64_t& value) { value = readUint64(); }
+    void readValue(float& value) { value = readFloat(); }
+    void readValue(double& value) { value = readDouble(); }
+
+public:
+    ByteReader(const uint8_t* data, size_t size, uint8_t wire_flags = 0)
+        : data_(data), size_(size), pos_(0), wire_flags_(wire_flags) {}
+
+    uint8_t wireFlags() const { return wire_flags_; }
+    void setWireFlags(uint8_t flags) { wire_flags_ = flags; }
+
+    bool canRead(size_t bytes) const {
+        return pos_ + bytes <= size_;
+    }
+
+    // Element count of a container whose entries take at least one byte each, checked
+    // against the remaining input before anything is reserved for it
+    uint32_t readCount() {
+        uint32_t count = readUint32();
+        if (!canRead(count)) throw std::runtime_error("Buffer underflow");
+        return count;
+    }
+
+    void skip(size_t bytes) {
+        if (!canRead(bytes)) throw std::runtime_error("Buffer underflow");
+        pos_ += bytes;
+    }
+
+    const uint8_t* cursor() const { return data_ + pos_; }
+
+    uint32_t readFixed32() {
+        return getFixed32();
+    }
+
+    uint64_t readPresence(size_t count) {
+        size_t bytes = (count + 7) / 8;
+        if (!canRead(bytes)) throw std::runtime_error("Buffer underflow");
+        uint64_t bits = 0;
+        for (size_t i = 0; i < bytes; i++) {
+            bits |= static_cast<uint64_t>(data_[pos_ + i]) << (8 * i);
+        }
+        pos_ += bytes;
+        return bits;
+    }
+
+    uint32_t readMsgId() {
+        return getFixed32();
+    }
+
+    uint32_t readUint32() {
+        if (wire_flags_ & WIRE_COMPACT) return static_cast<uint32_t>(getVarint());
+        if (wire_flags_ & WIRE_NATIVE_LE) return getNative<uint32_t>();
+        return getFixed32();
+    }
+
     int32_t readInt32() {
-        return static_cast<int32_t>(readUint32());
+        if (wire_flags_ & WIRE_COMPACT) return static_cast<int32_t>(unzigzag(getVarint()));
+        if (wire_flags_ & WIRE_NATIVE_LE) return getNative<int32_t>();
+        return static_cast<int32_t>(getFixed32());
     }
     
     uint64_t readUint64() {
-        uint32_t high = readUint32();
-        uint32_t low = readUint32();
+        if (wire_flags_ & WIRE_COMPACT) return getVarint();
+        if (wire_flags_ & WIRE_NATIVE_LE) return getNative<uint64_t>();
+        uint32_t high = getFixed32();
+        uint32_t low = getFixed32();
         return (static_cast<uint64_t>(high) << 32) | low;
     }
     
     int64_t readInt64() {
+        if (wire_flags_ & WIRE_COMPACT) return unzigzag(getVarint());
         return static_cast<int64_t>(readUint64());
     }
     
     uint16_t readUint16() {
+        if (wire_flags_ & WIRE_COMPACT) return static_cast<uint16_t>(getVarint());
+        if (wire_flags_ & WIRE_NATIVE_LE) return getNative<uint16_t>();
         if (!canRead(2)) throw std::runtime_error("Buffer underflow");
         uint16_t value = (static_cast<uint16_t>(data_[pos_]) << 8) | 
                          static_cast<uint16_t>(data_[pos_+1]);
@@ -1212,6 +2585,7 @@ public:
     }
     
     int16_t readInt16() {
+        if (wire_flags_ & WIRE_COMPACT) return static_cast<int16_t>(unzigzag(getVarint()));
         return static_cast<int16_t>(readUint16());
     }
     
@@ -1235,29 +2609,30 @@ public:
     }
     
     double readDouble() {
-        uint64_t bits = (static_cast<uint64_t>(readUint32()) << 32) | readUint32();
+        if (wire_flags_ & WIRE_NATIVE_LE) return getNative<double>();
+        uint64_t high = getFixed32();
+        uint64_t bits = (high << 32) | getFixed32();
         double value;
         std::memcpy(&value, &bits, sizeof(double));
         return value;
     }
     
     float readFloat() {
-        uint32_t bits = readUint32();
+        if (wire_flags_ & WIRE_NATIVE_LE) return getNative<float>();
+        uint32_t bits = getFixed32();
         float value;
         std::memcpy(&value, &bits, sizeof(float));
         return value;
     }
 
     std::string readString() {
-        uint32_t len = readUint32();
-        if (!canRead(len)) throw std::runtime_error("Buffer underflow");
-        std::string str(reinterpret_cast<const char*>(data_ + pos_), len);
-        pos_ += len;
-        return str;
+        uint32_t len;
+        const char* str = getString(len);
+        return std::string(str, len);
     }
 
     std::vector<std::string> readStringVector() {
-        uint32_t count = readUint32();
+        uint32_t count = readCount();
         std::vector<std::string> vec;
         vec.reserve(count);
         for (uint32_t i = 0; i < count; i++) {
@@ -1266,8 +2641,441 @@ public:
         return vec;
     }
 
+    // Numeric sequence written by ByteBuffer::writeArray
+    template <typename Vector>
+    void readArrayInto(Vector& vec) {
+        typedef typename Vector::value_type T;
+        uint32_t count = readCount();
+        if (bulkCopy<T>() && !canRead(static_cast<size_t>(count) * sizeof(T))) {
+            throw std::runtime_error("Buffer underflow");
+        }
+        vec.resize(count);
+        if (count > 0) readFixedArray(&vec[0], count);
+    }
+
+    // Fixed-size array written by ByteBuffer::writeFixedArray
+    template <typename T>
+    void readFixedArray(T* items, size_t count) {
+        if (bulkCopy<T>()) {
+            readBytes(items, count * sizeof(T));
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            readValue(items[i]);
+        }
+    }
+
+    bool nativeRecords() const {
+        return (wire_flags_ & (WIRE_NATIVE_LE | WIRE_COMPACT)) == WIRE_NATIVE_LE;
+    }
+
+    void readBytes(void* out, size_t size) {
+        if (!canRead(size)) throw std::runtime_error("Buffer underflow");
+        if (size > 0) std::memcpy(out, data_ + pos_, size);
+        pos_ += size;
+    }
+
+    // Sequence written by ByteBuffer::writeBoolArray
+    template <typename Vector>
+    void readBoolArrayInto(Vector& bits) {
+        uint32_t count = readUint32();
+        size_t bytes = (static_cast<size_t>(count) + 7) / 8;
+        if (!canRead(bytes)) throw std::runtime_error("Buffer underflow");
+        bits.resize(count);
+        for (size_t base = 0; base < count; base += 64) {
+            size_t n = count - base < 64 ? count - base : 64;
+            uint64_t word = 0;
+            for (size_t b = 0; b < (n + 7) / 8; b++) {
+                word |= static_cast<uint64_t>(data_[pos_ + base / 8 + b]) << (8 * b);
+            }
+            for (size_t i = 0; i < n; i++) {
+                bits[base + i] = (word >> i) & 1;
+            }
+        }
+        pos_ += bytes;
+    }
+
+    template <typename T>
+    T readDelta(T& previous) {
+        previous = static_cast<T>(static_cast<uint64_t>(previous) + static_cast<uint64_t>(unzigzag(getVarint())));
+        return previous;
+    }
+
+    // Sequence written by ByteBuffer::writeDeltaSequence
+    template <typename Vector>
+    void readDeltaSequenceInto(Vector& vec) {
+        typename Vector::value_type::DeltaState delta;
+        vec.resize(readCount());
+        for (auto& item : vec) {
+            item.deserialize(*this, &delta);
+        }
+    }
+
+    // Sequence written by ByteBuffer::writeRecords
+    template <typename Vector>
+    void readRecordsInto(Vector& vec) {
+        typedef typename Vector::value_type T;
+        typedef typename T::Packed Packed;
+        uint32_t count = readCount();
+        if (!nativeRecords()) {
+            vec.resize(count);
+            for (auto& item : vec) {
+                item.deserialize(*this);
+            }
+            return;
+        }
+        size_t bytes = static_cast<size_t>(count) * sizeof(Packed);
+        if (!canRead(bytes)) throw std::runtime_error("Buffer underflow");
+        vec.resize(count);
+        if (count == 0) return;
+        if (sizeof(T) == sizeof(Packed) && std::is_trivially_copyable<T>::value) {
+            std::memcpy(&vec[0], data_ + pos_, bytes);
+        } else {
+            for (uint32_t i = 0; i < count; i++) {
+                Packed record;
+                std::memcpy(&record, data_ + pos_ + i * sizeof(Packed), sizeof(Packed));
+                vec[i].unpack(record);
+            }
+        }
+        pos_ += bytes;
+    }
+
+    // Decode into an existing string or vector, reusing its capacity and allocator
+    template <typename String>
+    void readStringInto(String& str) {
+        uint32_t len;
+        const char* bytes = getString(len);
+        str.assign(bytes, len);
+    }
+
+    template <typename Vector>
+    void readStringVectorInto(Vector& vec) {
+        uint32_t count = readCount();
+        vec.resize(count);
+        for (auto& str : vec) {
+            readStringInto(str);
+        }
+    }
+
+    // Counterparts of ByteBuffer::writeItem
+    void readItem(bool& value) { value = readBool(); }
+    void readItem(std::string& value) { readStringInto(value); }
+
+    template <typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value>::type readItem(T& value) { readValue(value); }
+
+    template <typename T>
+    typename std::enable_if<std::is_enum<T>::value>::type readItem(T& value) {
+        value = static_cast<T>(readInt32());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_class<T>::value>::type readItem(T& value) { value.deserialize(*this); }
+
+    template <typename T, typename A>
+    void readItem(std::vector<T, A>& vec) {
+        vec.resize(readCount());
+        for (auto& item : vec) readItem(item);
+    }
+
+    template <typename A>
+    void readItem(std::vector<bool, A>& vec) {
+        vec.resize(readCount());
+        for (size_t i = 0; i < vec.size(); i++) vec[i] = readBool();
+    }
+
+    template <typename K, typename V, typename H, typename E, typename A>
+    void readItem(std::unordered_map<K, V, H, E, A>& map) { readMapInto(map); }
+
+    // map<K, V> written by ByteBuffer::writeMap: the table is reserved once and
+    // each value is decoded in place in its node, with no intermediate vectors
+    template <typename Map>
+    void readMapInto(Map& map) {
+        uint32_t count = readCount();
+        map.clear();
+        map.reserve(count);
+        for (uint32_t i = 0; i < count; i++) {
+            typename Map::key_type key;
+            readItem(key);
+            readItem(map[std::move(key)]);
+        }
+    }
+
+#if __cplusplus >= 201703L
+    // Zero-copy variants: the views point into the buffer being read
+    std::string_view readStringView() {
+        uint32_t len;
+        const char* str = getString(len);
+        return std::string_view(str, len);
+    }
+
+    std::vector<std::string_view> readStringViewVector() {
+        uint32_t count = readCount();
+        std::vector<std::string_view> vec;
+        vec.reserve(count);
+        for (uint32_t i = 0; i < count; i++) {
+            vec.push_back(readStringView());
+        }
+        return vec;
+    }
+#endif
+
     size_t position() const { return pos_; }
-};"""
+};
+
+// sequence<T, N>: at most N elements stored inline, so filling or decoding one never
+// touches the allocator. Encoded like sequence<T> (count, then the elements); growing
+// past N, including decoding a longer sequence, throws std::length_error.
+template <typename T, size_t N>
+class BoundedSequence {
+public:
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    BoundedSequence() : size_(0) {}
+
+    explicit BoundedSequence(size_t count) : size_(0) {
+        resize(count);
+    }
+
+    BoundedSequence(std::initializer_list<T> items) : size_(0) {
+        assign(items.begin(), items.end());
+    }
+
+    static size_t capacity() { return N; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    T* data() { return items_; }
+    const T* data() const { return items_; }
+    iterator begin() { return items_; }
+    iterator end() { return items_ + size_; }
+    const_iterator begin() const { return items_; }
+    const_iterator end() const { return items_ + size_; }
+    T& operator[](size_t i) { return items_[i]; }
+    const T& operator[](size_t i) const { return items_[i]; }
+
+    void push_back(const T& item) {
+        if (size_ == N) throw std::length_error("BoundedSequence: bound exceeded");
+        items_[size_++] = item;
+    }
+
+    void resize(size_t count) {
+        if (count > N) throw std::length_error("BoundedSequence: bound exceeded");
+        for (size_t i = size_; i < count; i++) items_[i] = T();
+        size_ = count;
+    }
+
+    void reserve(size_t count) {
+        if (count > N) throw std::length_error("BoundedSequence: bound exceeded");
+    }
+
+    void clear() { size_ = 0; }
+
+    template <typename Iterator>
+    void assign(Iterator first, Iterator last) {
+        clear();
+        for (; first != last; ++first) push_back(*first);
+    }
+
+    bool operator==(const BoundedSequence& other) const {
+        return size_ == other.size_ && std::equal(begin(), end(), other.begin());
+    }
+    bool operator!=(const BoundedSequence& other) const { return !(*this == other); }
+
+    void serialize(ByteBuffer& buffer) const { serializeItems(buffer, Encoding()); }
+    void deserialize(ByteReader& reader) { deserializeItems(reader, Encoding()); }
+
+private:
+    // 0: bits (writeBoolArray), 1: numeric block (writeArray), 2: element by element
+    typedef std::integral_constant<int, std::is_same<T, bool>::value ? 0 :
+                                        std::is_arithmetic<T>::value ? 1 : 2> Encoding;
+
+    void serializeItems(ByteBuffer& buffer, std::integral_constant<int, 0>) const { buffer.writeBoolArray(*this); }
+    void serializeItems(ByteBuffer& buffer, std::integral_constant<int, 1>) const { buffer.writeArray(items_, size_); }
+    void serializeItems(ByteBuffer& buffer, std::integral_constant<int, 2>) const {
+        buffer.writeUint32(static_cast<uint32_t>(size_));
+        for (size_t i = 0; i < size_; i++) buffer.writeItem(items_[i]);
+    }
+
+    void deserializeItems(ByteReader& reader, std::integral_constant<int, 0>) { reader.readBoolArrayInto(*this); }
+    void deserializeItems(ByteReader& reader, std::integral_constant<int, 1>) { reader.readArrayInto(*this); }
+    void deserializeItems(ByteReader& reader, std::integral_constant<int, 2>) {
+        resize(reader.readUint32());
+        for (size_t i = 0; i < size_; i++) reader.readItem(items_[i]);
+    }
+
+    T items_[N];
+    size_t size_;
+};
+
+// Byte-oriented LZ77 in the LZ4 block layout: per sequence a token (literal
+// count << 4 | match length - 4, 15 = more length bytes follow), the literals,
+// then a 2-byte little-endian match offset. The last sequence has no match.
+class LzCodec {
+public:
+    // Returns the compressed size, or 0 if the output would exceed capacity
+    static size_t compress(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity) {
+        static thread_local uint32_t table[kHashSize];  // Position + 1 of the last 4-byte sequence per hash
+        std::memset(table, 0, sizeof(table));
+        size_t out = 0;
+        size_t anchor = 0;
+        size_t pos = 0;
+        while (pos + kMinMatch <= size) {
+            uint32_t sequence = load32(src + pos);
+            uint32_t hash = (sequence * 2654435761u) >> (32 - kHashBits);
+            size_t candidate = table[hash];
+            table[hash] = static_cast<uint32_t>(pos + 1);
+            if (candidate == 0 || pos + 1 - candidate > 0xFFFF || load32(src + candidate - 1) != sequence) {
+                pos++;
+                continue;
+            }
+            size_t match = candidate - 1;
+            size_t length = kMinMatch;
+            while (pos + length < size && src[match + length] == src[pos + length]) length++;
+            if (!putSequence(src + anchor, pos - anchor, pos - match, length, dst, capacity, out)) return 0;
+            pos += length;
+            anchor = pos;
+        }
+        if (!putSequence(src + anchor, size - anchor, 0, 0, dst, capacity, out)) return 0;
+        return out;
+    }
+
+    // Expands to exactly size bytes; false if the input is malformed
+    static bool decompress(const uint8_t* src, size_t src_size, uint8_t* dst, size_t size) {
+        size_t in = 0;
+        size_t out = 0;
+        while (in < src_size) {
+            uint8_t token = src[in++];
+            size_t literals = token >> 4;
+            if (literals == 15 && !getLength(src, src_size, in, literals)) return false;
+            if (literals > src_size - in || literals > size - out) return false;
+            std::memcpy(dst + out, src + in, literals);
+            in += literals;
+            out += literals;
+            if (in == src_size) break;
+            if (src_size - in < 2) return false;
+            size_t offset = static_cast<size_t>(src[in]) | (static_cast<size_t>(src[in + 1]) << 8);
+            in += 2;
+            if (offset == 0 || offset > out) return false;
+            size_t length = token & 0x0F;
+            if (length == 15 && !getLength(src, src_size, in, length)) return false;
+            length += kMinMatch;
+            if (length > size - out) return false;
+            for (size_t i = 0; i < length; i++, out++) {
+                dst[out] = dst[out - offset];  // Byte by byte: the match may overlap its output
+            }
+        }
+        return out == size;
+    }
+
+private:
+    static const int kHashBits = 12;
+    static const size_t kHashSize = static_cast<size_t>(1) << kHashBits;
+    static const size_t kMinMatch = 4;
+
+    static uint32_t load32(const uint8_t* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static bool putLength(size_t length, uint8_t* dst, size_t capacity, size_t& out) {
+        for (; length >= 255; length -= 255) {
+            if (out >= capacity) return false;
+            dst[out++] = 255;
+        }
+        if (out >= capacity) return false;
+        dst[out++] = static_cast<uint8_t>(length);
+        return true;
+    }
+
+    static bool putSequence(const uint8_t* literals, size_t count, size_t offset, size_t length,
+                            uint8_t* dst, size_t capacity, size_t& out) {
+        size_t match = length ? length - kMinMatch : 0;
+        if (out >= capacity) return false;
+        dst[out++] = static_cast<uint8_t>(((count < 15 ? count : 15) << 4) | (match < 15 ? match : 15));
+        if (count >= 15 && !putLength(count - 15, dst, capacity, out)) return false;
+        if (count > capacity - out) return false;
+        if (count > 0) std::memcpy(dst + out, literals, count);
+        out += count;
+        if (length == 0) return true;
+        if (capacity - out < 2) return false;
+        dst[out++] = static_cast<uint8_t>(offset & 0xFF);
+        dst[out++] = static_cast<uint8_t>(offset >> 8);
+        return match < 15 || putLength(match - 15, dst, capacity, out);
+    }
+
+    static bool getLength(const uint8_t* src, size_t src_size, size_t& in, size_t& length) {
+        uint8_t byte;
+        do {
+            if (in >= src_size) return false;
+            byte = src[in++];
+            length += byte;
+        } while (byte == 255);
+        return true;
+    }
+};
+
+// Set in a frame's flags byte when the body after the msg_id is raw length(4) +
+// LZ block; only sent to peers that negotiated WIRE_LZ
+const uint8_t FRAME_COMPRESSED = 0x80;
+const size_t FRAME_MAX_BYTES = 65536;             // flags/size(4) + payload, one datagram
+const size_t UDP_MAX_PAYLOAD = 65507;             // Largest datagram sendto() accepts over IPv4
+const size_t FRAME_MAX_INFLATED = 16 * 1024 * 1024;
+const size_t WIRE_LZ_THRESHOLD = 1024;            // Default: smaller payloads are sent as is
+
+// Frame a serialized message as flags(1) + size(3) + payload, compressing it when
+// the encoding allows, it exceeds threshold and it shrinks. Returns the frame
+// length, or 0 if it does not fit in FRAME_MAX_BYTES.
+inline size_t encodeFrame(const ByteBuffer& buffer, size_t threshold, uint8_t* frame) {
+    uint8_t flags = buffer.wireFlags();
+    size_t size = buffer.size();
+    const uint8_t* payload = buffer.data();
+    if ((flags & WIRE_LZ) && size > threshold && size > 16) {
+        size_t body = size - 4;
+        size_t capacity = body - 8 < FRAME_MAX_BYTES - 12 ? body - 8 : FRAME_MAX_BYTES - 12;
+        size_t packed = LzCodec::compress(payload + 4, body, frame + 12, capacity);
+        if (packed > 0) {
+            std::memcpy(frame + 4, payload, 4);  // msg_id stays readable for routing
+            frame[8] = (body >> 24) & 0xFF;
+            frame[9] = (body >> 16) & 0xFF;
+            frame[10] = (body >> 8) & 0xFF;
+            frame[11] = body & 0xFF;
+            flags |= FRAME_COMPRESSED;
+            size = 8 + packed;
+        } else {
+            if (size > FRAME_MAX_BYTES - 4) return 0;
+            std::memcpy(frame + 4, payload, size);
+        }
+    } else {
+        if (size > FRAME_MAX_BYTES - 4) return 0;
+        std::memcpy(frame + 4, payload, size);
+    }
+    frame[0] = flags;
+    frame[1] = (size >> 16) & 0xFF;
+    frame[2] = (size >> 8) & 0xFF;
+    frame[3] = size & 0xFF;
+    return size + 4;
+}
+
+// Undo encodeFrame's compression: a FRAME_COMPRESSED payload is expanded into
+// inflated and data/size are pointed at it. False if the payload is malformed.
+inline bool inflateFrame(uint8_t& flags, const uint8_t*& data, uint32_t& size, std::vector<uint8_t>& inflated) {
+    if (!(flags & FRAME_COMPRESSED)) return true;
+    flags &= ~FRAME_COMPRESSED;
+    if (size < 8) return false;
+    uint32_t body = (static_cast<uint32_t>(data[4]) << 24) | (static_cast<uint32_t>(data[5]) << 16) |
+                    (static_cast<uint32_t>(data[6]) << 8) | static_cast<uint32_t>(data[7]);
+    if (body > FRAME_MAX_INFLATED) return false;
+    inflated.resize(4 + body);
+    std::memcpy(inflated.data(), data, 4);
+    if (!LzCodec::decompress(data + 8, size - 8, inflated.data() + 4, body)) return false;
+    data = inflated.data();
+    size = 4 + body;
+    return true;
+}"""
     
     def _generate_enum(self, enum: IDLEnum) -> str:
         """生成C++枚举"""
@@ -1286,26 +3094,25 @@ public:
         lines.append(f"struct {method.name}Request {{")
         lines.append(f"    uint32_t msg_id = MSG_{method.name.upper()}_REQ;")
         
-        # 收集字段信息
+        # 收集字段信息（arena 模式下服务端解码的请求使用 std::pmr 容器）
+        decl = self._arena_type if self._uses_arena(method) else (lambda t: t)
         req_fields = []
         for param in method.parameters:
+            if param.is_stream:
+                continue  # 流式参数的元素通过 _CHUNK 消息单独发送
             if param.direction in ['in', 'inout']:
                 cpp_type = self.map_type(param.type_name)
-                if param.is_array and not param.array_size:
+                if param.is_array:
                     # 动态数组：使用vector
                     if cpp_type == 'std::string':
-                        lines.append(f"    std::vector<std::string> {param.name};")
+                        lines.append(f"    {decl('std::vector<std::string>')} {param.name};")
                         req_fields.append(('vector<string>', param.name))
                     else:
-                        lines.append(f"    std::vector<{cpp_type}> {param.name};")
+                        lines.append(f"    {decl(f'std::vector<{cpp_type}>')} {param.name};")
                         req_fields.append(('vector', param.name, cpp_type))
-                elif param.is_array and param.array_size:
-                    # 固定数组暂不改变
-                    lines.append(f"    {cpp_type} {param.name}[{param.array_size}];")
-                    req_fields.append(('array', param.name, cpp_type, param.array_size))
                 elif cpp_type.startswith('std::vector<'):
                     # 已经是vector类型（通过typedef或sequence映射）
-                    lines.append(f"    {cpp_type} {param.name};")
+                    lines.append(f"    {decl(cpp_type)} {param.name};")
                     # 提取vector中的元素类型
                     elem_type = cpp_type[12:-1]  # 去掉 "std::vector<" 和 ">"
                     if elem_type == 'std::string':
@@ -1313,16 +3120,36 @@ public:
                     else:
                         req_fields.append(('vector', param.name, elem_type))
                 else:
-                    lines.append(f"    {cpp_type} {param.name};")
+                    lines.append(f"    {decl(cpp_type)} {param.name};")
                     req_fields.append((cpp_type, param.name))
+        if self._uses_arena(method):
+            lines.extend(self._generate_allocator_ctors(f"{method.name}Request", self._request_arena_fields(method),
+                                                        copyable=False))
+        
+        # 流式方法：请求携带流 ID 和初始信用（写端不等待即可发送的分块数）
+        if method.is_stream or self._stream_param(method):
+            lines.append("    uint32_t stream_id = 0;  // Chosen by the client, echoed in every chunk")
+            lines.append("    uint32_t credit = 0;     // Chunks the writer may send before waiting for more")
+            req_fields.append(('uint32_t', 'stream_id'))
+            req_fields.append(('uint32_t', 'credit'))
+        if method.is_stream:
+            lines.append("    uint32_t max_delay_ms = 0;  // Longest the server holds an item in a partial chunk")
+            req_fields.append(('uint32_t', 'max_delay_ms'))
         
         # 生成serialize方法
         lines.append("")
-        lines.append("    void serialize(ByteBuffer& buffer) const {")
-        lines.append("        buffer.writeUint32(msg_id);")
+        body_start = len(lines)
         for field_info in req_fields:
             if field_info[0] == 'vector<string>':
                 lines.append(f"        buffer.writeStringVector({field_info[1]});")
+            elif field_info[0] == 'vector' and field_info[2] in self.BULK_TYPES:
+                lines.append(f"        buffer.writeArray({field_info[1]}.data(), {field_info[1]}.size());")
+            elif field_info[0] == 'vector' and field_info[2] == 'bool':
+                lines.append(f"        buffer.writeBoolArray({field_info[1]});")
+            elif field_info[0] == 'vector' and self._delta_fields(field_info[2]):
+                lines.append(f"        buffer.writeDeltaSequence({field_info[1]});")
+            elif field_info[0] == 'vector' and self._is_fixed_struct(field_info[2]):
+                lines.append(f"        buffer.writeRecords({field_info[1]});")
             elif field_info[0] == 'vector':
                 lines.append(f"        buffer.writeUint32({field_info[1]}.size());")
                 lines.append(f"        for (const auto& item : {field_info[1]}) {{")
@@ -1364,30 +3191,53 @@ public:
                     'float': 'writeFloat', 'double': 'writeDouble'
                 }[field_info[0]]
                 lines.append(f"        buffer.{write_method}({field_info[1]});")
-            # 固定数组需要特殊处理
-            elif field_info[0] == 'array':
-                lines.append(f"        // TODO: serialize fixed array {field_info[1]}")
+            elif field_info[0].startswith('std::array<'):
+                lines.extend(self._encode_array_lines(field_info[0], field_info[1], "        "))
+            elif field_info[0].startswith('std::unordered_map<'):
+                lines.append(f"        buffer.writeMap({field_info[1]});")
             else:
                 # 其他类型 - 检查是否为struct或enum
                 # 对于struct，调用serialize；对于enum，转换为int32_t
-                is_struct = any(s.name == field_info[0] for s in self.module.structs)
+                is_struct = (any(s.name == field_info[0] for s in self.module.structs) or field_info[0] in self.columnar
+                             or field_info[0].startswith('BoundedSequence<'))
                 if is_struct:
                     lines.append(f"        {field_info[1]}.serialize(buffer);")
                 else:
                     # Enum类型 - 转换为int32_t
                     lines.append(f"        buffer.writeInt32(static_cast<int32_t>({field_info[1]}));")
+        body = lines[body_start:]
+        del lines[body_start:]
+        lines.append("    void serialize(ByteBuffer& buffer) const {")
+        lines.append("        buffer.writeMsgId(msg_id);")
+        if self._direct_request(method) and req_fields:
+            # 发送端直接把调用参数传给 serializeFields，省去复制进 Request 的一步
+            args = [p for p in method.parameters if p.direction in ['in', 'inout']]
+            lines.append(f"        serializeFields(buffer, {', '.join(p.name for p in args)});")
+            lines.append("    }")
+            lines.append("")
+            lines.append("    // Fields after the msg_id, written straight from the caller's arguments")
+            lines.append(f"    static void serializeFields(ByteBuffer& buffer, {', '.join(self._in_param_decl(p) for p in args)}) {{")
+        lines.extend(body)
         lines.append("    }")
         
         # 生成deserialize方法
         lines.append("")
         lines.append("    void deserialize(ByteReader& reader) {")
-        lines.append("        msg_id = reader.readUint32();")
+        lines.append("        msg_id = reader.readMsgId();")
         for field_info in req_fields:
             if field_info[0] == 'vector<string>':
-                lines.append(f"        {field_info[1]} = reader.readStringVector();")
+                lines.append(f"        reader.readStringVectorInto({field_info[1]});")
+            elif field_info[0] == 'vector' and field_info[2] in self.BULK_TYPES:
+                lines.append(f"        reader.readArrayInto({field_info[1]});")
+            elif field_info[0] == 'vector' and field_info[2] == 'bool':
+                lines.append(f"        reader.readBoolArrayInto({field_info[1]});")
+            elif field_info[0] == 'vector' and self._delta_fields(field_info[2]):
+                lines.append(f"        reader.readDeltaSequenceInto({field_info[1]});")
+            elif field_info[0] == 'vector' and self._is_fixed_struct(field_info[2]):
+                lines.append(f"        reader.readRecordsInto({field_info[1]});")
             elif field_info[0] == 'vector':
                 lines.append(f"        {{")
-                lines.append(f"            uint32_t count = reader.readUint32();")
+                lines.append(f"            uint32_t count = reader.readCount();")
                 lines.append(f"            {field_info[1]}.resize(count);")
                 lines.append(f"            for (uint32_t i = 0; i < count; i++) {{")
                 if field_info[2] in ['int32_t', 'uint32_t', 'int64_t', 'uint64_t', 'int16_t', 'uint16_t',
@@ -1402,7 +3252,7 @@ public:
                     }[field_info[2]]
                     lines.append(f"                {field_info[1]}[i] = reader.{read_method}();")
                 elif field_info[2] == 'std::string':
-                    lines.append(f"                {field_info[1]}[i] = reader.readString();")
+                    lines.append(f"                reader.readStringInto({field_info[1]}[i]);")
                 else:
                     # 自定义类型 - 检查是否是enum或struct
                     is_enum = any(e.name == field_info[2] for e in (self.module.enums if self.module else []))
@@ -1417,7 +3267,7 @@ public:
                 lines.append(f"            }}")
                 lines.append(f"        }}")
             elif field_info[0] == 'std::string':
-                lines.append(f"        {field_info[1]} = reader.readString();")
+                lines.append(f"        reader.readStringInto({field_info[1]});")
             elif field_info[0] in ['int32_t', 'uint32_t', 'int64_t', 'uint64_t', 'int16_t', 'uint16_t',
                                     'int8_t', 'uint8_t', 'char', 'bool', 'float', 'double']:
                 read_method = {
@@ -1429,12 +3279,15 @@ public:
                     'float': 'readFloat', 'double': 'readDouble'
                 }[field_info[0]]
                 lines.append(f"        {field_info[1]} = reader.{read_method}();")
-            elif field_info[0] == 'array':
-                lines.append(f"        // TODO: deserialize fixed array {field_info[1]}")
+            elif field_info[0].startswith('std::array<'):
+                lines.extend(self._decode_array_lines(field_info[0], field_info[1], "        "))
+            elif field_info[0].startswith('std::unordered_map<'):
+                lines.append(f"        reader.readMapInto({field_info[1]});")
             else:
                 # 其他类型 - 检查是否为struct或enum
                 # 对于struct，调用deserialize；对于enum，从int32_t转换
-                is_struct = any(s.name == field_info[0] for s in self.module.structs)
+                is_struct = (any(s.name == field_info[0] for s in self.module.structs) or field_info[0] in self.columnar
+                             or field_info[0].startswith('BoundedSequence<'))
                 if is_struct:
                     lines.append(f"        {field_info[1]}.deserialize(reader);")
                 else:
@@ -1445,9 +3298,9 @@ public:
         lines.append("};")
         lines.append("")
         
-        # 响应消息
-        has_response = method.return_type != 'void' or any(p.direction in ['out', 'inout'] for p in method.parameters)
-        if has_response:
+        # 响应消息（流式方法的响应是 StreamChunkHeader + 元素，不生成 Response 结构）
+        has_response = self._has_response(method)
+        if has_response and not method.is_stream:
             lines.append(f"struct {method.name}Response {{")
             lines.append(f"    uint32_t msg_id = MSG_{method.name.upper()}_RESP;")
             
@@ -1478,7 +3331,7 @@ public:
             for param in method.parameters:
                 if param.direction in ['out', 'inout']:
                     cpp_type = self.map_type(param.type_name)
-                    if param.is_array and not param.array_size:
+                    if param.is_array:
                         # 动态数组：使用vector
                         if cpp_type == 'std::string':
                             lines.append(f"    std::vector<std::string> {param.name};")
@@ -1486,10 +3339,6 @@ public:
                         else:
                             lines.append(f"    std::vector<{cpp_type}> {param.name};")
                             resp_fields.append(('vector', param.name, cpp_type))
-                    elif param.is_array and param.array_size:
-                        # 固定数组
-                        lines.append(f"    {cpp_type} {param.name}[{param.array_size}];")
-                        resp_fields.append(('array', param.name, cpp_type, param.array_size))
                     elif cpp_type.startswith('std::vector<'):
                         # Already a vector type (from typedef or sequence)
                         lines.append(f"    {cpp_type} {param.name};")
@@ -1511,10 +3360,18 @@ public:
             # 生成serialize方法
             lines.append("")
             lines.append("    void serialize(ByteBuffer& buffer) const {")
-            lines.append("        buffer.writeUint32(msg_id);")
+            lines.append("        buffer.writeMsgId(msg_id);")
             for field_info in resp_fields:
                 if field_info[0] == 'vector<string>':
                     lines.append(f"        buffer.writeStringVector({field_info[1]});")
+                elif field_info[0] == 'vector' and field_info[2] in self.BULK_TYPES:
+                    lines.append(f"        buffer.writeArray({field_info[1]}.data(), {field_info[1]}.size());")
+                elif field_info[0] == 'vector' and field_info[2] == 'bool':
+                    lines.append(f"        buffer.writeBoolArray({field_info[1]});")
+                elif field_info[0] == 'vector' and self._delta_fields(field_info[2]):
+                    lines.append(f"        buffer.writeDeltaSequence({field_info[1]});")
+                elif field_info[0] == 'vector' and self._is_fixed_struct(field_info[2]):
+                    lines.append(f"        buffer.writeRecords({field_info[1]});")
                 elif field_info[0] == 'vector':
                     lines.append(f"        buffer.writeUint32({field_info[1]}.size());")
                     lines.append(f"        for (const auto& item : {field_info[1]}) {{")
@@ -1556,12 +3413,15 @@ public:
                         'float': 'writeFloat', 'double': 'writeDouble'
                     }[field_info[0]]
                     lines.append(f"        buffer.{write_method}({field_info[1]});")
-                elif field_info[0] == 'array':
-                    lines.append(f"        // TODO: serialize fixed array {field_info[1]}")
+                elif field_info[0].startswith('std::array<'):
+                    lines.extend(self._encode_array_lines(field_info[0], field_info[1], "        "))
+                elif field_info[0].startswith('std::unordered_map<'):
+                    lines.append(f"        buffer.writeMap({field_info[1]});")
                 else:
                     # 其他类型 - 检查是否为struct或enum
                     # 对于struct，调用serialize；对于enum，转换为int32_t
-                    is_struct = any(s.name == field_info[0] for s in self.module.structs)
+                    is_struct = (any(s.name == field_info[0] for s in self.module.structs) or field_info[0] in self.columnar
+                                 or field_info[0].startswith('BoundedSequence<'))
                     if is_struct:
                         lines.append(f"        {field_info[1]}.serialize(buffer);")
                     else:
@@ -1572,13 +3432,21 @@ public:
             # 生成deserialize方法
             lines.append("")
             lines.append("    void deserialize(ByteReader& reader) {")
-            lines.append("        msg_id = reader.readUint32();")
+            lines.append("        msg_id = reader.readMsgId();")
             for field_info in resp_fields:
                 if field_info[0] == 'vector<string>':
-                    lines.append(f"        {field_info[1]} = reader.readStringVector();")
+                    lines.append(f"        reader.readStringVectorInto({field_info[1]});")
+                elif field_info[0] == 'vector' and field_info[2] in self.BULK_TYPES:
+                    lines.append(f"        reader.readArrayInto({field_info[1]});")
+                elif field_info[0] == 'vector' and field_info[2] == 'bool':
+                    lines.append(f"        reader.readBoolArrayInto({field_info[1]});")
+                elif field_info[0] == 'vector' and self._delta_fields(field_info[2]):
+                    lines.append(f"        reader.readDeltaSequenceInto({field_info[1]});")
+                elif field_info[0] == 'vector' and self._is_fixed_struct(field_info[2]):
+                    lines.append(f"        reader.readRecordsInto({field_info[1]});")
                 elif field_info[0] == 'vector':
                     lines.append(f"        {{")
-                    lines.append(f"            uint32_t count = reader.readUint32();")
+                    lines.append(f"            uint32_t count = reader.readCount();")
                     lines.append(f"            {field_info[1]}.resize(count);")
                     lines.append(f"            for (uint32_t i = 0; i < count; i++) {{")
                     if field_info[2] in ['int32_t', 'uint32_t', 'int64_t', 'uint64_t', 'int16_t', 'uint16_t',
@@ -1593,7 +3461,7 @@ public:
                         }[field_info[2]]
                         lines.append(f"                {field_info[1]}[i] = reader.{read_method}();")
                     elif field_info[2] == 'std::string':
-                        lines.append(f"                {field_info[1]}[i] = reader.readString();")
+                        lines.append(f"                reader.readStringInto({field_info[1]}[i]);")
                     else:
                         # Custom types - check if it's a struct or enum
                         is_enum = any(e.name == field_info[2] for e in (self.module.enums if self.module else []))
@@ -1608,7 +3476,7 @@ public:
                     lines.append(f"            }}")
                     lines.append(f"        }}")
                 elif field_info[0] == 'std::string':
-                    lines.append(f"        {field_info[1]} = reader.readString();")
+                    lines.append(f"        reader.readStringInto({field_info[1]});")
                 elif field_info[0] in ['int32_t', 'uint32_t', 'int64_t', 'uint64_t', 'int16_t', 'uint16_t',
                                         'int8_t', 'uint8_t', 'char', 'bool', 'float', 'double']:
                     read_method = {
@@ -1620,12 +3488,15 @@ public:
                         'float': 'readFloat', 'double': 'readDouble'
                     }[field_info[0]]
                     lines.append(f"        {field_info[1]} = reader.{read_method}();")
-                elif field_info[0] == 'array':
-                    lines.append(f"        // TODO: deserialize fixed array {field_info[1]}")
+                elif field_info[0].startswith('std::array<'):
+                    lines.extend(self._decode_array_lines(field_info[0], field_info[1], "        "))
+                elif field_info[0].startswith('std::unordered_map<'):
+                    lines.append(f"        reader.readMapInto({field_info[1]});")
                 else:
                     # 其他类型 - 检查是否为struct或enum
                     # 对于struct，调用deserialize；对于enum，从int32_t转换
-                    is_struct = any(s.name == field_info[0] for s in self.module.structs)
+                    is_struct = (any(s.name == field_info[0] for s in self.module.structs) or field_info[0] in self.columnar
+                                 or field_info[0].startswith('BoundedSequence<'))
                     if is_struct:
                         lines.append(f"        {field_info[1]}.deserialize(reader);")
                     else:
@@ -1635,26 +3506,283 @@ public:
             
             lines.append("};")
         
+        if self._uses_request_view(method):
+            lines.append("")
+            lines.extend(self._generate_view_struct(method, f"{method.name}RequestView", self._request_view_fields(method)))
+        if self._uses_response_view(method):
+            lines.append("")
+            lines.extend(self._generate_view_struct(method, f"{method.name}ResponseView", self._response_view_fields(method)))
+        
         return lines
     
-    def _generate_observer_message_struct(self, method: IDLMethod) -> List[str]:
-        """为观察者方法生成请求消息结构（服务端推送给客户端）"""
-        lines = []
-        
-        lines.append(f"struct observer_{method.name}Request {{")
-        lines.append(f"    uint32_t msg_id = MSG_OBSERVER_{method.name.upper()}_REQ;")
-        
-        # 收集字段信息
-        req_fields = []
-        for param in method.parameters:
-            cpp_type = self.map_type(param.type_name)
-            lines.append(f"    {cpp_type} {param.name};")
-            req_fields.append((cpp_type, param.name, param.type_name))
+    def _view_type(self, cpp_type: str) -> Optional[str]:
+        """返回字符串类字段对应的视图类型，非字符串类型返回 None"""
+        if cpp_type == 'std::string':
+            return 'std::string_view'
+        if cpp_type == 'std::vector<std::string>':
+            return 'std::vector<std::string_view>'
+        return None
+    
+    def _field_cpp_type(self, param: IDLParameter) -> str:
+        """参数在消息结构中的 C++ 类型（动态数组为 vector）"""
+        cpp_type = self.map_type(param.type_name)
+        if param.is_array:
+            return f"std::vector<{cpp_type}>"
+        return cpp_type
+    
+    def _view_eligible(self, method: IDLMethod) -> bool:
+        """视图解码只用于在接收线程上同步处理的普通 RPC（不含流式）"""
+        return (self.view_decode and not method.is_callback and not method.is_stream
+                and self._stream_param(method) is None)
+    
+    def _request_view_fields(self, method: IDLMethod) -> List[Tuple[str, str]]:
+        """RequestView 的字段（与 Request 序列化顺序一致），只有 in 参数使用视图类型"""
+        fields = []
+        for param in method.parameters:
+            if param.direction in ['in', 'inout']:
+                cpp_type = self._field_cpp_type(param)
+                view_type = self._view_type(cpp_type) if param.direction == 'in' else None
+                fields.append((view_type or cpp_type, param.name))
+        return fields
+    
+    def _response_view_fields(self, method: IDLMethod) -> List[Tuple[str, str]]:
+        """ResponseView 的字段（与 Response 序列化顺序一致）"""
+        has_status_param = any(p.name == 'status' and p.direction in ['out', 'inout'] for p in method.parameters)
+        fields = []
+        if not has_status_param:
+            fields.append(('int32_t', 'status'))
+        if method.return_type != 'void':
+            cpp_type = self.map_type(method.return_type)
+            fields.append((self._view_type(cpp_type) or cpp_type, 'return_value'))
+        for param in method.parameters:
+            if param.direction in ['out', 'inout']:
+                cpp_type = self._field_cpp_type(param)
+                fields.append((self._view_type(cpp_type) or cpp_type, param.name))
+        if has_status_param:
+            fields.append(('int32_t', 'response_status'))
+        return fields
+    
+    def _uses_request_view(self, method: IDLMethod) -> bool:
+        """服务端是否用 RequestView 解码该方法的请求"""
+        return self._view_eligible(method) and any(
+            t in ('std::string_view', 'std::vector<std::string_view>')
+            for t, _ in self._request_view_fields(method))
+    
+    def _view_param_decl(self, method: IDLMethod, param: IDLParameter) -> Optional[str]:
+        """视图解码模式下 in 参数的服务端声明（非视图参数返回 None）"""
+        if param.direction != 'in' or not self._uses_request_view(method):
+            return None
+        view_type = self._view_type(self._field_cpp_type(param))
+        if view_type == 'std::string_view':
+            return f"std::string_view {param.name}"
+        if view_type:
+            return f"const {view_type}& {param.name}"
+        return None
+    
+    def _uses_response_view(self, method: IDLMethod) -> bool:
+        """客户端是否为该方法生成 ResponseView 版本的调用"""
+        return (self._view_eligible(method) and self._has_response(method)
+                and not any(p.direction == 'inout' for p in method.parameters)
+                and any(t in ('std::string_view', 'std::vector<std::string_view>')
+                        for t, _ in self._response_view_fields(method)))
+    
+    def _arena_type(self, cpp_type: str) -> str:
+        """arena 模式下把 std::string / std::vector 换成对应的 std::pmr 容器"""
+        if not self.pmr_arena or 'BoundedSequence<' in cpp_type or 'std::array<' in cpp_type:
+            return cpp_type  # 有界序列和定长数组的元素内联存储，不从 arena 分配
+        if 'std::unordered_map<' in cpp_type:
+            return cpp_type  # 哈希表节点按需分配，保持默认分配器
+        cpp_type = re.sub(r'std::string\b', 'std::pmr::string', cpp_type)
+        return cpp_type.replace('std::vector<', 'std::pmr::vector<')
+    
+    def _is_allocator_aware(self, cpp_type: str) -> bool:
+        """arena 模式下该类型的对象是否持有可从内存资源分配的容器（字符串、vector 或含这些成员的结构体）"""
+        if cpp_type == 'std::string' or cpp_type.startswith('std::vector<'):
+            return True
+        structs = (self.module.structs if self.module else []) + self.interface.structs
+        for struct in structs:
+            if struct.name == cpp_type:
+                return any(self._is_allocator_aware(self.map_type(t)) for t, _ in struct.fields)
+        return False
+    
+    def _request_arena_fields(self, method: IDLMethod) -> List[Tuple[str, str]]:
+        """Request 中需要从 arena 分配的字段（流式参数除外）"""
+        fields = []
+        for param in method.parameters:
+            if param.direction in ['in', 'inout'] and not param.is_stream:
+                cpp_type = self._field_cpp_type(param)
+                if self._is_allocator_aware(cpp_type):
+                    fields.append((cpp_type, param.name))
+        return fields
+    
+    def _uses_arena(self, method: IDLMethod) -> bool:
+        """服务端是否在 arena 上解码该方法的请求（只用于在接收线程上同步处理、未使用视图解码的普通 RPC）"""
+        return (self.pmr_arena and not method.is_callback and not method.is_stream
+                and self._stream_param(method) is None and not self._uses_request_view(method)
+                and bool(self._request_arena_fields(method)))
+    
+    def _arena_param_decl(self, method: IDLMethod, param: IDLParameter) -> Optional[str]:
+        """arena 模式下 in 参数的服务端声明：以常量引用直接使用 arena 上的成员，不涉及分配的参数返回 None"""
+        if param.direction != 'in' or not self._uses_arena(method):
+            return None
+        if param.is_stream:
+            return None
+        cpp_type = self._field_cpp_type(param)
+        if not self._is_allocator_aware(cpp_type):
+            return None
+        return f"const {self._arena_type(cpp_type)}& {param.name}"
+    
+    def _assign_stmt(self, method: IDLMethod, target: str, source: str, cpp_type: str,
+                     move: bool = False) -> str:
+        """在 Request 字段与普通类型之间复制：arena 模式下 vector 的分配器不同，需逐元素 assign；
+        move=True 表示 source 之后不再使用，可直接移动"""
+        if self._uses_arena(method) and cpp_type.startswith('std::vector<'):
+            return f"{target}.assign({source}.begin(), {source}.end());"
+        if move and not self._is_scalar(cpp_type):
+            return f"{target} = std::move({source});"
+        return f"{target} = {source};"
+    
+    def _array_elem(self, cpp_type: str) -> str:
+        """std::array<E, N> 的元素类型 E"""
+        return cpp_type[11:-1].rpartition(', ')[0]
+    
+    def _encode_array_lines(self, cpp_type: str, expr: str, indent: str) -> List[str]:
+        """定长数组：没有长度前缀，数值元素整块写入"""
+        elem = self._array_elem(cpp_type)
+        if elem in self.BULK_TYPES:
+            return [f"{indent}buffer.writeFixedArray({expr}.data(), {expr}.size());"]
+        return [f"{indent}for (const auto& item : {expr}) {{",
+                f"{indent}    {self._encode_item_stmt(elem, 'item')}",
+                f"{indent}}}"]
+    
+    def _decode_array_lines(self, cpp_type: str, expr: str, indent: str) -> List[str]:
+        """定长数组的反序列化，与 _encode_array_lines 对应"""
+        elem = self._array_elem(cpp_type)
+        if elem in self.BULK_TYPES:
+            return [f"{indent}reader.readFixedArray({expr}.data(), {expr}.size());"]
+        return [f"{indent}for (auto& item : {expr}) {{",
+                f"{indent}    {self._decode_item_stmt(elem, 'item')}",
+                f"{indent}}}"]
+    
+    def _out_param_decl(self, param: IDLParameter) -> str:
+        """out/inout 参数声明：非常量引用"""
+        return f"{self._field_cpp_type(param)}& {param.name}"
+    
+    def _is_scalar(self, cpp_type: str) -> bool:
+        """按值传递、复制无代价的类型（基本类型和枚举）"""
+        return cpp_type in self.FIXED_SIZES or self._is_enum(cpp_type)
+    
+    def _in_param_decl(self, param: IDLParameter) -> str:
+        """in 参数声明：标量按值，字符串/序列/数组/结构体按常量引用，调用链上不做深拷贝"""
+        cpp_type = self._field_cpp_type(param)
+        if self._is_scalar(cpp_type):
+            return f"{cpp_type} {param.name}"
+        return f"const {cpp_type}& {param.name}"
+    
+    def _direct_request(self, method: IDLMethod) -> bool:
+        """发送端是否直接从参数序列化请求（不构造 Request 副本）；
+        arena 模式的 Request 使用 std::pmr 容器，流式请求还需保留 stream_id/credit"""
+        return not self._uses_arena(method) and not method.is_stream and self._stream_param(method) is None
+    
+    def _generate_allocator_ctors(self, struct_name: str, fields: List[Tuple[str, str]],
+                                  copyable: bool) -> List[str]:
+        """arena 模式：生成接受 polymorphic_allocator 的构造函数，使嵌套容器从同一内存资源分配"""
+        aware = [name for cpp_type, name in fields if self._is_allocator_aware(cpp_type)]
+        if not self.pmr_arena or not aware:
+            return []
+        init = ", ".join(f"{name}(alloc)" for name in aware)
+        lines = [""]
+        if not copyable:
+            lines.append(f"    {struct_name}() = default;")
+            lines.append("    // Members allocate from the given resource (the server's per-request arena)")
+            lines.append(f"    explicit {struct_name}(const std::pmr::polymorphic_allocator<char>& alloc) : {init} {{}}")
+            return lines
+        # 作为 std::pmr::vector 的元素时，容器通过 uses-allocator 构造把自己的内存资源传下来
+        copy_init = ", ".join(f"{name}(other.{name}, alloc)" if name in aware else f"{name}(other.{name})"
+                              for _, name in fields)
+        move_init = ", ".join(f"{name}(std::move(other.{name}), alloc)" if name in aware else f"{name}(other.{name})"
+                              for _, name in fields)
+        lines.append("    // Allocator-aware: elements of a std::pmr::vector share its memory resource")
+        lines.append("    using allocator_type = std::pmr::polymorphic_allocator<char>;")
+        lines.append(f"    {struct_name}() = default;")
+        lines.append(f"    {struct_name}(const {struct_name}&) = default;")
+        lines.append(f"    {struct_name}({struct_name}&&) = default;")
+        lines.append(f"    {struct_name}& operator=(const {struct_name}&) = default;")
+        lines.append(f"    {struct_name}& operator=({struct_name}&&) = default;")
+        lines.append(f"    explicit {struct_name}(const allocator_type& alloc) : {init} {{}}")
+        lines.append(f"    {struct_name}(const {struct_name}& other, const allocator_type& alloc)")
+        lines.append(f"        : {copy_init} {{}}")
+        lines.append(f"    {struct_name}({struct_name}&& other, const allocator_type& alloc)")
+        lines.append(f"        : {move_init} {{}}")
+        return lines
+    
+    def _decode_field_lines(self, cpp_type: str, target: str, indent: str) -> List[str]:
+        """生成一个字段的反序列化语句（按 C++ 类型，支持视图类型和 vector）"""
+        if cpp_type == 'std::string_view':
+            return [f"{indent}{target} = reader.readStringView();"]
+        if cpp_type == 'std::vector<std::string_view>':
+            return [f"{indent}{target} = reader.readStringViewVector();"]
+        if cpp_type == 'std::vector<std::string>':
+            return [f"{indent}reader.readStringVectorInto({target});"]
+        if cpp_type.startswith('std::array<'):
+            return self._decode_array_lines(cpp_type, target, indent)
+        if cpp_type.startswith('std::unordered_map<'):
+            return [f"{indent}reader.readMapInto({target});"]
+        if cpp_type.startswith('std::vector<') and cpp_type[12:-1] in self.BULK_TYPES:
+            return [f"{indent}reader.readArrayInto({target});"]
+        if cpp_type == 'std::vector<bool>':
+            return [f"{indent}reader.readBoolArrayInto({target});"]
+        if cpp_type.startswith('std::vector<') and self._delta_fields(cpp_type[12:-1]):
+            return [f"{indent}reader.readDeltaSequenceInto({target});"]
+        if cpp_type.startswith('std::vector<') and self._is_fixed_struct(cpp_type[12:-1]):
+            return [f"{indent}reader.readRecordsInto({target});"]
+        if cpp_type.startswith('std::vector<'):
+            elem_type = cpp_type[12:-1]
+            return [f"{indent}{{",
+                    f"{indent}    uint32_t count = reader.readCount();",
+                    f"{indent}    {target}.resize(count);",
+                    f"{indent}    for (uint32_t i = 0; i < count; i++) {{",
+                    f"{indent}        {self._decode_item_stmt(elem_type, target + '[i]')}",
+                    f"{indent}    }}",
+                    f"{indent}}}"]
+        return [f"{indent}{self._decode_item_stmt(cpp_type, target)}"]
+    
+    def _generate_view_struct(self, method: IDLMethod, struct_name: str, fields: List[Tuple[str, str]]) -> List[str]:
+        """生成只读视图消息结构：字符串字段指向接收缓冲区，仅在处理期间有效"""
+        lines = []
+        lines.append(f"// Zero-copy view of {struct_name[:-4]}: string fields point into the receive")
+        lines.append("// buffer and are only valid while the message is being handled")
+        lines.append(f"struct {struct_name} {{")
+        lines.append("    uint32_t msg_id = 0;")
+        for cpp_type, name in fields:
+            lines.append(f"    {cpp_type} {name};")
+        lines.append("")
+        lines.append("    void deserialize(ByteReader& reader) {")
+        lines.append("        msg_id = reader.readMsgId();")
+        for cpp_type, name in fields:
+            lines.extend(self._decode_field_lines(cpp_type, name, "        "))
+        lines.append("    }")
+        lines.append("};")
+        return lines
+    
+    def _generate_observer_message_struct(self, method: IDLMethod) -> List[str]:
+        """为观察者方法生成请求消息结构（服务端推送给客户端）"""
+        lines = []
+        
+        lines.append(f"struct observer_{method.name}Request {{")
+        lines.append(f"    uint32_t msg_id = MSG_OBSERVER_{method.name.upper()}_REQ;")
+        
+        # 收集字段信息
+        req_fields = []
+        for param in method.parameters:
+            cpp_type = self.map_type(param.type_name)
+            lines.append(f"    {cpp_type} {param.name};")
+            req_fields.append((cpp_type, param.name, param.type_name))
         
         # 生成serialize方法
         lines.append("")
         lines.append("    void serialize(ByteBuffer& buffer) const {")
-        lines.append("        buffer.writeUint32(msg_id);")
+        lines.append("        buffer.writeMsgId(msg_id);")
         for cpp_type, field_name, idl_type in req_fields:
             if cpp_type == 'std::string':
                 lines.append(f"        buffer.writeString({field_name});")
@@ -1674,10 +3802,10 @@ public:
         # 生成deserialize方法
         lines.append("")
         lines.append("    void deserialize(ByteReader& reader) {")
-        lines.append("        msg_id = reader.readUint32();")
+        lines.append("        msg_id = reader.readMsgId();")
         for cpp_type, field_name, idl_type in req_fields:
             if cpp_type == 'std::string':
-                lines.append(f"        {field_name} = reader.readString();")
+                lines.append(f"        reader.readStringInto({field_name});")
             elif cpp_type in ['int32_t', 'int64_t']:
                 lines.append(f"        {field_name} = reader.readInt32();")
             elif cpp_type == 'uint32_t':
@@ -1685,7 +3813,7 @@ public:
             elif cpp_type == 'bool':
                 lines.append(f"        {field_name} = reader.readBool();")
             elif cpp_type == 'std::vector<std::string>':
-                lines.append(f"        {field_name} = reader.readStringVector();")
+                lines.append(f"        reader.readStringVectorInto({field_name});")
             else:
                 # 其他复杂类型暂时忽略反序列化
                 lines.append(f"        // TODO: deserialize {cpp_type} {field_name}")
@@ -1699,24 +3827,201 @@ public:
         """生成基础类（使用条件编译避免重复定义）"""
         return """#ifndef IPC_SOCKET_BASE_DEFINED
 #define IPC_SOCKET_BASE_DEFINED
+// Runtime control messages (handled by the generated code, not part of any IDL interface)
+const uint32_t MSG_CTRL_CALLBACK_CHANNEL_REQ = 0xFFFF0001;  // client -> server: route callbacks to this socket
+const uint32_t MSG_CTRL_CALLBACK_CHANNEL_ACK = 0xFFFF0002;  // server -> client: callback channel registered
+const uint32_t MSG_CTRL_STREAM_CREDIT = 0xFFFF0003;         // client -> server: may send N more stream chunks
+const uint32_t MSG_CTRL_HELLO = 0xFFFF0004;                 // client -> server: wire encodings wanted
+const uint32_t MSG_CTRL_HELLO_ACK = 0xFFFF0005;             // server -> client: wire encodings accepted
+const uint32_t MSG_CTRL_CALLBACK_TOKEN_REQ = 0xFFFF0006;    // client RPC socket -> server: token for CALLBACK_CHANNEL_REQ
+const uint32_t MSG_CTRL_CALLBACK_TOKEN = 0xFFFF0007;        // server -> client RPC socket: one-time token
+const uint32_t MSG_CTRL_BYE = 0xFFFF0008;                   // client RPC socket -> server: forget this client
+
+// Placement of the threads spawned by the generated runtime
+struct ThreadOptions {
+    std::vector<int> cpus;  // CPU cores the threads may run on (empty = any)
+    int priority;           // SCHED_FIFO priority 1-99 (0 = keep the default policy)
+    std::string name;       // thread name prefix, shown as "<name>-<role>" (max 15 chars)
+    
+    ThreadOptions() : priority(0) {}
+    
+    // Apply to the calling thread; returns false if any setting was rejected, with
+    // the rejected settings described in *error
+    bool applyToCurrentThread(const char* role, std::string* error = nullptr) const {
+        std::string failed;
+        pthread_t self = pthread_self();
+        if (!cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : cpus) {
+                if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+                else failed += "cpu " + std::to_string(cpu) + " out of range; ";
+            }
+            int rc = pthread_setaffinity_np(self, sizeof(set), &set);
+            if (rc != 0) failed += std::string("affinity: ") + std::strerror(rc) + "; ";
+        }
+        if (priority > 0) {
+            struct sched_param param;
+            param.sched_priority = priority;
+            int rc = pthread_setschedparam(self, SCHED_FIFO, &param);
+            if (rc != 0) failed += std::string("SCHED_FIFO priority: ") + std::strerror(rc) + "; ";
+        }
+        if (!name.empty()) {
+            std::string thread_name = name + "-" + role;
+            int rc = pthread_setname_np(self, thread_name.substr(0, 15).c_str());
+            if (rc != 0) failed += std::string("name: ") + std::strerror(rc) + "; ";
+        }
+        if (error) *error = failed;
+        return failed.empty();
+    }
+
+    // For runtime threads: a rejection is logged and counted in *failures instead
+    // of silently leaving the thread unplaced
+    void applyOrReport(const char* role, std::atomic<size_t>* failures) const {
+        std::string error;
+        if (applyToCurrentThread(role, &error)) return;
+        if (failures) (*failures)++;
+        std::cerr << "[ThreadOptions] placement of thread '" << role << "' rejected: " << error << std::endl;
+    }
+
+    // Try the options on a short-lived thread, leaving the caller's placement untouched
+    bool validate(std::string* error = nullptr) const {
+        bool ok = false;
+        std::thread probe([this, &ok, error]() { ok = applyToCurrentThread("probe", error); });
+        probe.join();
+        return ok;
+    }
+};
+
+#if __cplusplus >= 201703L
+// Per-request arena used by --pmr-arena servers: decoded requests allocate from it and
+// everything is handed back in one step when the handler's scope ends
+class RequestArena {
+public:
+    // The pool's largest block size must cover the arena's overflow blocks, otherwise
+    // the pool hands them straight back upstream and every large request allocates again
+    RequestArena() : pool_(std::pmr::pool_options{0, kMaxPooledBlock}), arena_(buffer_, sizeof(buffer_), &pool_) {}
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &arena_; }
+
+    // Releases the arena when destroyed; declare before the objects that use it
+    class Scope {
+    public:
+        explicit Scope(RequestArena& owner) : owner_(owner) {}
+        ~Scope() { owner_.arena_.release(); }
+    private:
+        RequestArena& owner_;
+    };
+
+private:
+    static constexpr size_t kMaxPooledBlock = 1024 * 1024;
+
+    alignas(std::max_align_t) unsigned char buffer_[64 * 1024];
+    std::pmr::unsynchronized_pool_resource pool_;  // Keeps overflow blocks for the next request
+    std::pmr::monotonic_buffer_resource arena_;
+};
+#endif
+
 // Socket Base Class
 class SocketBase {
 protected:
     int sockfd_;
     struct sockaddr_in addr_;
     bool connected_;
+    int wake_fd_;  // eventfd that interrupts blocking waits on shutdown (-1 if unavailable)
+    std::atomic<bool> woken_;
+    ThreadOptions thread_options_;
+    
+    // Without an eventfd, waitReadable() polls in slices this long so wake() is still seen
+    static const int kWakePollMs = 100;
     
 public:
-    SocketBase() : sockfd_(-1), connected_(false) {}
+    SocketBase() : sockfd_(-1), connected_(false),
+                   wake_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), woken_(false), placement_failures_(0) {}
     
     virtual ~SocketBase() {
         if (sockfd_ >= 0) {
             close(sockfd_);
         }
+        if (wake_fd_ >= 0) {
+            close(wake_fd_);
+        }
     }
     
     bool isConnected() const { return connected_; }
     
+    // Placement for threads started after this call (restart listeners to apply).
+    // The options are tried first; if the OS rejects them (no such CPU, SCHED_FIFO
+    // without CAP_SYS_NICE, ...) this returns false with the reason in *error and
+    // keeps the previous options
+    bool setThreadOptions(const ThreadOptions& options, std::string* error = nullptr) {
+        if (!options.validate(error)) return false;
+        thread_options_ = options;
+        return true;
+    }
+    const ThreadOptions& threadOptions() const { return thread_options_; }
+    
+    // Runtime threads whose placement was rejected when they started
+    size_t threadPlacementFailures() const { return placement_failures_; }
+    
+protected:
+    std::atomic<size_t> placement_failures_;
+    
+    // Start a runtime thread with the configured placement
+    template <typename Body>
+    std::thread spawnThread(const char* role, Body body) {
+        ThreadOptions options = thread_options_;
+        std::atomic<size_t>* failures = &placement_failures_;
+        return std::thread([options, role, body, failures]() {
+            options.applyOrReport(role, failures);
+            body();
+        });
+    }
+    
+    // Block until fd is readable; returns false once wake() has been called
+    bool waitReadable(int fd) {
+        struct pollfd fds[2];
+        fds[0].fd = fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = wake_fd_;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        int nfds = wake_fd_ >= 0 ? 2 : 1;
+        int timeout = wake_fd_ >= 0 ? -1 : kWakePollMs;
+        while (true) {
+            if (woken_) return false;
+            if (poll(fds, nfds, timeout) < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            if (fds[1].revents != 0) return false;
+            if (fds[0].revents & POLLIN) return true;
+            if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) return false;
+        }
+    }
+    
+    // Wake every thread blocked in waitReadable()
+    void wake() {
+        woken_ = true;
+        if (wake_fd_ < 0) return;
+        uint64_t one = 1;
+        ssize_t written = write(wake_fd_, &one, sizeof(one));
+        (void)written;
+    }
+    
+    // Re-arm waitReadable() after the woken threads have exited
+    void resetWake() {
+        woken_ = false;
+        if (wake_fd_ < 0) return;
+        uint64_t value;
+        ssize_t drained = read(wake_fd_, &value, sizeof(value));
+        (void)drained;
+    }
+    
+public:
+    
     ssize_t sendData(const void* data, size_t size) {
         // UDP: send datagram to server address
         return sendto(sockfd_, data, size, 0, 
@@ -1746,6 +4051,425 @@ public:
                         (struct sockaddr*)from_addr, &from_len);
     }
 };
+
+// Callback dispatcher pool: runs callbacks on worker threads so the listener
+// thread stays free to route RPC responses. Tasks submitted with the same
+// partition run in submission order on the same worker.
+class CallbackDispatcher {
+private:
+    struct Worker {
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::queue<std::function<void()>> tasks;
+        bool stopping;
+        Worker() : stopping(false) {}
+    };
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+public:
+    explicit CallbackDispatcher(size_t threads, const ThreadOptions& options = ThreadOptions(),
+                                std::atomic<size_t>* placement_failures = nullptr) {
+        if (threads == 0) threads = 1;
+        for (size_t i = 0; i < threads; i++) {
+            workers_.emplace_back(new Worker());
+            Worker* worker = workers_.back().get();
+            worker->thread = std::thread([worker, options, placement_failures]() {
+                options.applyOrReport("cb", placement_failures);
+                run(worker);
+            });
+        }
+    }
+
+    // Drains queued callbacks before joining the workers
+    ~CallbackDispatcher() {
+        for (auto& worker : workers_) {
+            {
+                std::lock_guard<std::mutex> lock(worker->mutex);
+                worker->stopping = true;
+            }
+            worker->cv.notify_one();
+        }
+        for (auto& worker : workers_) {
+            if (worker->thread.joinable()) worker->thread.join();
+        }
+    }
+
+    size_t threadCount() const { return workers_.size(); }
+
+    void dispatch(size_t partition, std::function<void()> task) {
+        Worker* worker = workers_[partition % workers_.size()].get();
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            worker->tasks.push(std::move(task));
+        }
+        worker->cv.notify_one();
+    }
+
+private:
+    static void run(Worker* worker) {
+        std::unique_lock<std::mutex> lock(worker->mutex);
+        while (true) {
+            worker->cv.wait(lock, [worker]() { return worker->stopping || !worker->tasks.empty(); });
+            if (worker->tasks.empty()) break;  // stopping and drained
+            std::function<void()> task = std::move(worker->tasks.front());
+            worker->tasks.pop();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+};
+
+// Header of one chunk of a streaming RPC (stream<T>); the encoded items follow it
+struct StreamChunkHeader {
+    uint32_t msg_id;
+    uint32_t stream_id;
+    uint32_t seq;
+    bool last;
+    uint32_t count;
+
+    StreamChunkHeader() : msg_id(0), stream_id(0), seq(0), last(false), count(0) {}
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        buffer.writeUint32(stream_id);
+        buffer.writeUint32(seq);
+        buffer.writeBool(last);
+        buffer.writeUint32(count);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        stream_id = reader.readUint32();
+        seq = reader.readUint32();
+        last = reader.readBool();
+        count = reader.readUint32();
+    }
+};
+
+// State shared by both ends of a stream: the peer, cancellation and completion
+class StreamBase {
+public:
+    StreamBase(int sockfd, const struct sockaddr_in& peer, uint32_t stream_id)
+        : sockfd_(sockfd), peer_(peer), stream_id_(stream_id), wire_flags_(0),
+          compress_threshold_(WIRE_LZ_THRESHOLD), cancelled_(false), done_(false) {}
+
+    virtual ~StreamBase() {}
+
+    // Encoding negotiated with the peer (call before the first item): chunks are
+    // encoded with wire_flags and, with WIRE_LZ, compressed above compress_threshold
+    virtual void setWireFormat(uint8_t wire_flags, size_t compress_threshold) {
+        wire_flags_ = wire_flags;
+        compress_threshold_ = compress_threshold;
+    }
+
+    // Called from the receive thread: credit for a writer, a chunk for a reader
+    virtual void addCredit(uint32_t credit) { (void)credit; }
+    virtual void pushChunk(const uint8_t* data, size_t size) { (void)data; (void)size; }
+
+    void cancel() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cancelled_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    bool cancelled() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return cancelled_;
+    }
+
+    bool done() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return done_;
+    }
+
+    void markDone() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = true;
+    }
+
+protected:
+    // Send flags(1) + size(3) + payload to the peer; false if it does not fit a frame
+    bool sendFrame(const ByteBuffer& buffer) {
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        return frame_size > 0 &&
+               sendto(sockfd_, send_buffer, frame_size, 0, (struct sockaddr*)&peer_, sizeof(peer_)) >= 0;
+    }
+
+    int sockfd_;
+    struct sockaddr_in peer_;
+    uint32_t stream_id_;
+    uint8_t wire_flags_;
+    size_t compress_threshold_;
+    bool cancelled_;
+    bool done_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+// Sending end of a stream. Items are packed into chunks of about kChunkBytes,
+// never more than one datagram holds; a chunk is only sent while the peer has
+// granted credit, so a slow reader throttles the producer instead of overrunning
+// its socket buffer.
+class StreamWriterBase : public StreamBase {
+public:
+    static const size_t kChunkBytes = 16384;
+    // Largest encoded items of one chunk: a UDP datagram less the frame header
+    // and the largest StreamChunkHeader (compact varints)
+    static const size_t kMaxChunkBytes = UDP_MAX_PAYLOAD - 4 - 20;
+
+    // Blocks up to 5 seconds for more credit; returns 0 on timeout
+    typedef std::function<uint32_t()> CreditSource;
+
+    StreamWriterBase(int sockfd, const struct sockaddr_in& peer, uint32_t msg_id,
+                     uint32_t stream_id, uint32_t credit)
+        : StreamBase(sockfd, peer, stream_id), count_(0), max_delay_(10), msg_id_(msg_id), seq_(0),
+          credit_(credit) {}
+
+    // Credit 0 is a keepalive: the reader is alive but still busy with earlier chunks
+    void addCredit(uint32_t credit) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            credit_ += credit;
+            heard_ = std::chrono::steady_clock::now();
+        }
+        cv_.notify_all();
+    }
+
+    void setWireFormat(uint8_t wire_flags, size_t compress_threshold) override {
+        StreamBase::setWireFormat(wire_flags, compress_threshold);
+        items_.setWireFlags(wire_flags);
+    }
+
+    // Longest an item waits in a partial chunk, checked as items are written
+    // (the first chunk always goes out with its first item)
+    void setMaxDelay(std::chrono::milliseconds delay) { max_delay_ = delay; }
+
+    // Fetch credit by polling instead of waiting for addCredit() (client uploads)
+    void setCreditSource(CreditSource source) { credit_source_ = source; }
+
+    // Send the buffered items now, e.g. before the producer blocks for a while;
+    // false once the stream was cancelled
+    bool sendPending() {
+        if (cancelled()) return false;
+        return count_ == 0 || flush(false, items_.size());
+    }
+
+    // Send the remaining items as the last chunk (called after the producer returns)
+    bool finish() {
+        if (done()) return !cancelled();
+        bool ok = !cancelled() && flush(true, items_.size());
+        markDone();
+        return ok;
+    }
+
+protected:
+    // Wait for credit (until the reader has been silent for 5 seconds), then send
+    // the first `bytes` of the buffered items (count_ items) as one chunk and
+    // start a new one
+    bool flush(bool last, size_t bytes) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (credit_ == 0 && credit_source_) {
+                lock.unlock();
+                uint32_t credit = credit_source_();
+                lock.lock();
+                credit_ += credit;
+            }
+            heard_ = std::chrono::steady_clock::now();
+            while (credit_ == 0 && !cancelled_ &&
+                   cv_.wait_until(lock, heard_ + std::chrono::seconds(5)) == std::cv_status::no_timeout) {}
+            if (credit_ == 0 || cancelled_) {
+                cancelled_ = true;
+                return false;
+            }
+            credit_--;
+        }
+
+        StreamChunkHeader header;
+        header.msg_id = msg_id_;
+        header.stream_id = stream_id_;
+        header.seq = seq_++;
+        header.last = last;
+        header.count = count_;
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        header.serialize(buffer);
+        buffer.writeBytes(items_.data(), bytes);
+        items_.clear();  // Also resets the WIRE_STRING_DICT dictionary for the next chunk
+        count_ = 0;
+        if (!sendFrame(buffer)) {
+            cancel();
+            return false;
+        }
+        return true;
+    }
+
+    // Send the chunk once it is full, when it is the first one (the reader sees
+    // items without waiting for a whole chunk) or when its oldest item has
+    // waited max_delay_
+    bool chunkDue() const {
+        return items_.size() >= kChunkBytes || seq_ == 0 ||
+               std::chrono::steady_clock::now() - chunk_started_ >= max_delay_;
+    }
+
+    ByteBuffer items_;
+    uint32_t count_;
+    std::chrono::steady_clock::time_point chunk_started_;  // When the first buffered item was written
+    std::chrono::milliseconds max_delay_;
+
+private:
+    uint32_t msg_id_;
+    uint32_t seq_;
+    uint32_t credit_;
+    CreditSource credit_source_;
+    std::chrono::steady_clock::time_point heard_;  // Last credit or keepalive from the reader
+};
+
+template <typename T>
+class StreamWriter : public StreamWriterBase {
+public:
+    typedef std::function<void(ByteBuffer&, const T&)> Encoder;
+
+    StreamWriter(int sockfd, const struct sockaddr_in& peer, uint32_t msg_id,
+                 uint32_t stream_id, uint32_t credit, Encoder encode)
+        : StreamWriterBase(sockfd, peer, msg_id, stream_id, credit), encode_(encode) {}
+
+    // Queue one item; returns false once the reader is gone or the stream was
+    // cancelled, or (dropping the item, the stream stays open) when the item
+    // alone does not fit in one datagram
+    bool write(const T& item) {
+        if (cancelled()) return false;
+        size_t before = items_.size();
+        encode_(items_, item);
+        if (items_.size() > kMaxChunkBytes) {
+            if (count_ == 0) {  // Alone in its chunk and still too large
+                items_.clear();
+                return false;
+            }
+            // Send the items before this one, then encode it again on its own so
+            // it cannot refer to the dictionary of the chunk that just went out
+            if (!flush(false, before)) return false;
+            encode_(items_, item);
+            if (items_.size() > kMaxChunkBytes) {
+                items_.clear();
+                return false;
+            }
+        }
+        if (count_++ == 0) chunk_started_ = std::chrono::steady_clock::now();
+        if (chunkDue()) return flush(false, items_.size());
+        return true;
+    }
+
+private:
+    Encoder encode_;
+};
+
+// Receiving end of a client stream (in stream<T> parameter). Chunks are queued
+// by the receive thread; credit goes back to the writer as they are consumed.
+class StreamReaderBase : public StreamBase {
+public:
+    StreamReaderBase(int sockfd, const struct sockaddr_in& peer, uint32_t stream_id, uint32_t window)
+        : StreamBase(sockfd, peer, stream_id), reader_(nullptr, 0), remaining_(0), last_seen_(false),
+          window_(window > 0 ? window : 1), expected_seq_(0), consumed_(0), started_(false) {}
+
+    void pushChunk(const uint8_t* data, size_t size) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (cancelled_) return;
+            chunks_.push(std::vector<uint8_t>(data, data + size));
+        }
+        cv_.notify_all();
+    }
+
+    // True once the whole stream has arrived (no lost chunk, no timeout)
+    bool complete() const { return last_seen_ && remaining_ == 0; }
+
+    // Skip unread items so the writer can finish
+    void drain() {
+        while (!last_seen_ && nextChunk()) {}
+        remaining_ = 0;
+    }
+
+protected:
+    // Make the next chunk current; false on timeout, cancellation or a lost chunk
+    bool nextChunk() {
+        if (started_ && ++consumed_ >= (window_ + 1) / 2) {
+            sendCredit(consumed_);
+            consumed_ = 0;
+        }
+        started_ = true;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!cv_.wait_for(lock, std::chrono::seconds(5), [this]() { return !chunks_.empty() || cancelled_; }) ||
+                cancelled_) {
+                cancelled_ = true;
+                return false;
+            }
+            current_ = std::move(chunks_.front());
+            chunks_.pop();
+        }
+        reader_ = ByteReader(current_.data(), current_.size(), wire_flags_);
+        StreamChunkHeader header;
+        header.deserialize(reader_);
+        if (header.seq != expected_seq_++) {
+            cancel();
+            return false;
+        }
+        remaining_ = header.count;
+        last_seen_ = header.last;
+        return true;
+    }
+
+    ByteReader reader_;
+    uint32_t remaining_;
+    bool last_seen_;
+
+private:
+    void sendCredit(uint32_t credit) {
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.writeUint32(MSG_CTRL_STREAM_CREDIT);
+        buffer.writeUint32(stream_id_);
+        buffer.writeUint32(credit);
+        sendFrame(buffer);
+    }
+
+    uint32_t window_;
+    uint32_t expected_seq_;
+    uint32_t consumed_;
+    bool started_;
+    std::queue<std::vector<uint8_t>> chunks_;
+    std::vector<uint8_t> current_;
+};
+
+template <typename T>
+class StreamReader : public StreamReaderBase {
+public:
+    typedef std::function<void(ByteReader&, T&)> Decoder;
+
+    StreamReader(int sockfd, const struct sockaddr_in& peer, uint32_t stream_id, uint32_t window,
+                 Decoder decode)
+        : StreamReaderBase(sockfd, peer, stream_id, window), decode_(decode) {}
+
+    // Next item; false at the end of the stream (check complete() for errors)
+    bool read(T& item) {
+        while (remaining_ == 0) {
+            if (last_seen_ || !nextChunk()) return false;
+        }
+        decode_(reader_, item);
+        remaining_--;
+        return true;
+    }
+
+private:
+    Decoder decode_;
+};
 #endif // IPC_SOCKET_BASE_DEFINED"""
     
     def _generate_client_interface(self) -> str:
@@ -1798,21 +4522,21 @@ public:
         lines.append("    void startListening() {")
         lines.append("        if (listening_ || !connected_) return;")
         lines.append("        listening_ = true;")
-        lines.append("        listener_thread_ = std::thread([this]() { listenLoop(); });")
+        lines.append("        listener_thread_ = spawnThread(\"rx\", [this]() { listenLoop(); });")
         lines.append("    }")
         lines.append("")
         lines.append("    void stopListening() {")
         lines.append("        listening_ = false;")
+        lines.append("        wake();")
         lines.append("        if (listener_thread_.joinable()) listener_thread_.join();")
+        lines.append("        resetWake();")
         lines.append("    }")
         lines.append("")
         lines.append("private:")
         lines.append("    void listenLoop() {")
         lines.append("        while (listening_ && connected_) {")
-        lines.append("            struct timeval tv;")
-        lines.append("            tv.tv_sec = 1;")
-        lines.append("            tv.tv_usec = 0;")
-        lines.append("            setsockopt(sockfd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));")
+        lines.append("            // Sleep in poll() until data arrives or stopListening() wakes us")
+        lines.append("            if (!waitReadable(sockfd_)) break;")
         lines.append("")
         lines.append("            uint32_t msg_size;")
         lines.append("            ssize_t received = recv(sockfd_, &msg_size, sizeof(msg_size), 0);")
@@ -1865,19 +4589,7 @@ public:
         lines.append("    // Override these methods to handle notifications")
         
         for method in self.interface.methods:
-            params = []
-            for param in method.parameters:
-                if param.direction == 'in':
-                    cpp_type = self.map_type(param.type_name)
-                    if param.is_array and not param.array_size:
-                        params.append(f"const std::vector<{cpp_type}>& {param.name}")
-                    elif param.is_array and param.array_size:
-                        params.append(f"const {cpp_type} {param.name}[{param.array_size}]")
-                    else:
-                        if cpp_type == 'std::string':
-                            params.append(f"const {cpp_type}& {param.name}")
-                        else:
-                            params.append(f"{cpp_type} {param.name}")
+            params = [self._in_param_decl(p) for p in method.parameters if p.direction == 'in']
             
             lines.append(f"    virtual void {method.name}({', '.join(params)}) {{")
             lines.append(f"        // Override to handle {method.name} notification")
@@ -1904,21 +4616,86 @@ public:
         lines.append("    // Message queue for RPC responses")
         lines.append("    struct QueuedMessage {")
         lines.append("        uint32_t msg_id;")
+        lines.append("        uint8_t wire_flags;  // Encoding of the payload (WireFlag bits)")
         lines.append("        std::vector<uint8_t> data;")
         lines.append("    };")
         lines.append("    std::queue<QueuedMessage> rpc_response_queue_;")
         lines.append("    std::mutex queue_mutex_;")
         lines.append("    std::condition_variable queue_cv_;")
         lines.append("")
+        lines.append("    // Optional worker pool for callbacks (null = run inline on the listener thread)")
+        lines.append("    std::unique_ptr<CallbackDispatcher> dispatcher_;")
+        lines.append("")
+        lines.append("    // Optional dedicated socket for server-pushed callbacks (-1 = shared socket)")
+        lines.append("    int callback_sockfd_;")
+        lines.append("    std::thread callback_thread_;")
+        lines.append("")
+        lines.append("    // Busy-poll mode: callers spin on the socket for their own response")
+        lines.append("    bool busy_poll_;")
+        lines.append("")
+        lines.append("    // Encoding of outgoing requests (WireFlag bits accepted by the server)")
+        lines.append("    uint8_t wire_flags_;")
+        lines.append("    size_t compress_threshold_;  // With WIRE_LZ: requests larger than this are compressed")
+        lines.append("")
+        has_lazy_callbacks = any(self._is_lazy_callback(m) for m in self.interface.methods)
+        if has_lazy_callbacks:
+            lines.append("    // Deliver callbacks with @lazy parameters to their ...Lazy overloads")
+            lines.append("    bool lazy_callbacks_;")
+            lines.append("")
+        has_streams = self._has_streams()
+        ctor_init = ("listening_(false), callback_sockfd_(-1), busy_poll_(false), wire_flags_(0), "
+                     "compress_threshold_(WIRE_LZ_THRESHOLD)")
+        if has_lazy_callbacks:
+            ctor_init += ", lazy_callbacks_(false)"
+        if has_streams:
+            lines.append("    // Streaming calls (stream<T> results and parameters)")
+            lines.append("    uint32_t next_stream_id_;")
+            lines.append("    uint32_t stream_window_;  // Chunks in flight before the server waits for credit")
+            lines.append("    std::chrono::milliseconds stream_chunk_delay_;  // Longest an item waits in a partial chunk")
+            lines.append("")
+            ctor_init += ", next_stream_id_(0), stream_window_(8), stream_chunk_delay_(10)"
         lines.append("public:")
-        lines.append(f"    {interface_name}Client() : listening_(false) {{}}")
+        lines.append(f"    {interface_name}Client() : {ctor_init} {{}}")
         lines.append("")
         lines.append(f"    ~{interface_name}Client() {{")
         lines.append("        stopListening();")
+        lines.append("        if (sockfd_ >= 0) {")
+        lines.append("            // Let the server drop this client and its callback route now rather than on timeout")
+        lines.append("            ByteBuffer bye;")
+        lines.append("            bye.writeMsgId(MSG_CTRL_BYE);")
+        lines.append("            uint8_t frame[FRAME_MAX_BYTES];")
+        lines.append("            size_t frame_size = encodeFrame(bye, FRAME_MAX_BYTES, frame);")
+        lines.append("            sendto(sockfd_, frame, frame_size, 0, (struct sockaddr*)&addr_, sizeof(addr_));")
+        lines.append("        }")
+        lines.append("        if (callback_sockfd_ >= 0) {")
+        lines.append("            close(callback_sockfd_);")
+        lines.append("        }")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    // Run callbacks on `threads` dispatcher threads instead of the listener thread.")
+        lines.append("    // Callbacks for the same partition (see @partition in the IDL, otherwise the")
+        lines.append("    // callback type) keep their order. Pass 0 to run callbacks inline again.")
+        lines.append("    void setCallbackDispatcher(size_t threads) {")
+        lines.append("        bool was_listening = listening_;")
+        lines.append("        stopListening();")
+        lines.append("        dispatcher_.reset(threads > 0 ? new CallbackDispatcher(threads, thread_options_, &placement_failures_) : nullptr);")
+        lines.append("        if (was_listening) startListening();")
         lines.append("    }")
         lines.append("")
+        if has_lazy_callbacks:
+            lines.append("    // Deliver callbacks whose parameters are @lazy structs to their ...Lazy overloads,")
+            lines.append("    // which decode each field on first access, instead of the fully decoded ones")
+            lines.append("    void setLazyCallbacks(bool enable) {")
+            lines.append("        bool was_listening = listening_;")
+            lines.append("        stopListening();")
+            lines.append("        lazy_callbacks_ = enable;")
+            lines.append("        if (was_listening) startListening();")
+            lines.append("    }")
+            lines.append("")
         lines.append("    // Setup UDP client")
-        lines.append("    bool connect(const std::string& host, uint16_t port) {")
+        lines.append("    // With separate_callback_channel, callbacks arrive on a second socket and")
+        lines.append("    // thread so RPC responses are never queued behind callback traffic.")
+        lines.append("    bool connect(const std::string& host, uint16_t port, bool separate_callback_channel = false) {")
         lines.append("        sockfd_ = socket(AF_INET, SOCK_DGRAM, 0);  // UDP socket")
         lines.append("        if (sockfd_ < 0) {")
         lines.append("            return false;")
@@ -1936,37 +4713,125 @@ public:
         lines.append("")
         lines.append("        connected_ = true;")
         lines.append("        ")
+        lines.append("        if (separate_callback_channel) {")
+        lines.append("            openCallbackChannel();  // Falls back to the shared socket on failure")
+        lines.append("        }")
+        lines.append("        ")
         lines.append("        // Auto-start listener thread for message reception")
         lines.append("        startListening();")
         lines.append("        ")
         lines.append("        return true;")
         lines.append("    }")
         lines.append("")
+        lines.append("    // True if callbacks are delivered on their own socket")
+        lines.append("    bool hasCallbackChannel() const { return callback_sockfd_ >= 0; }")
+        lines.append("")
+        lines.append("    // Low-latency mode: the calling thread spins on a non-blocking recv() for its")
+        lines.append("    // own response instead of waiting for the listener thread. The listener stops")
+        lines.append("    // reading the RPC socket; callbacks arriving there are handled while a call")
+        lines.append("    // spins or from pollCallbacks(), so pair this with a callback channel.")
+        lines.append("    // busy_poll_usec > 0 also sets SO_BUSY_POLL on the socket (may need privileges).")
+        lines.append("    void setBusyPoll(bool enable, int busy_poll_usec = 0) {")
+        lines.append("        bool was_listening = listening_;")
+        lines.append("        stopListening();")
+        lines.append("        {")
+        lines.append("            std::lock_guard<std::mutex> lock(send_mutex_);")
+        lines.append("            busy_poll_ = enable;")
+        lines.append("        }")
+        lines.append("#ifdef SO_BUSY_POLL")
+        lines.append("        if (enable && busy_poll_usec > 0 && sockfd_ >= 0) {")
+        lines.append("            setsockopt(sockfd_, SOL_SOCKET, SO_BUSY_POLL, &busy_poll_usec, sizeof(busy_poll_usec));")
+        lines.append("        }")
+        lines.append("#endif")
+        lines.append("        if (was_listening) startListening();")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    // Ask the server for a wire encoding (WireFlag bits, e.g. WIRE_COMPACT); requests")
+        lines.append("    // then use whatever subset it accepts. Returns the flags in effect, 0 if the")
+        lines.append("    // server declined or predates negotiation (after the usual 5 s timeout).")
+        lines.append("    uint8_t negotiateWireFlags(uint8_t wanted) {")
+        lines.append("        std::lock_guard<std::mutex> lock(send_mutex_);")
+        lines.append("        wire_flags_ = 0;")
+        lines.append("        uint8_t hello[9] = {0, 0, 0, 5};")
+        lines.append("        hello[4] = (MSG_CTRL_HELLO >> 24) & 0xFF;")
+        lines.append("        hello[5] = (MSG_CTRL_HELLO >> 16) & 0xFF;")
+        lines.append("        hello[6] = (MSG_CTRL_HELLO >> 8) & 0xFF;")
+        lines.append("        hello[7] = MSG_CTRL_HELLO & 0xFF;")
+        lines.append("        hello[8] = wanted & WIRE_SUPPORTED;")
+        lines.append("        if (sendData(hello, sizeof(hello)) < 0) return 0;")
+        lines.append("")
+        lines.append("        QueuedMessage ack;")
+        lines.append("        if (!waitForResponse(MSG_CTRL_HELLO_ACK, ack) || ack.data.size() < 5) return 0;")
+        lines.append("        wire_flags_ = ack.data[4] & hello[8];")
+        lines.append("        return wire_flags_;")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    uint8_t wireFlags() const { return wire_flags_; }")
+        lines.append("")
+        lines.append("    // Requests above this many bytes are compressed once WIRE_LZ is negotiated")
+        lines.append("    void setCompressionThreshold(size_t bytes) { compress_threshold_ = bytes; }")
+        lines.append("")
+        if has_streams:
+            lines.append("    // Flow control for stream<T> calls: chunks the writer may send ahead of the reader")
+            lines.append("    void setStreamWindow(uint32_t chunks) {")
+            lines.append("        std::lock_guard<std::mutex> lock(send_mutex_);")
+            lines.append("        stream_window_ = chunks > 0 ? chunks : 1;")
+            lines.append("    }")
+            lines.append("")
+            lines.append("    // Latency bound for stream<T> calls, both directions: a partial chunk is sent")
+            lines.append("    // once its oldest item has waited this long (checked as items are written;")
+            lines.append("    // the first chunk always goes out at once). 0 sends every item on its own.")
+            lines.append("    void setStreamChunkDelay(std::chrono::milliseconds delay) {")
+            lines.append("        std::lock_guard<std::mutex> lock(send_mutex_);")
+            lines.append("        stream_chunk_delay_ = delay;")
+            lines.append("    }")
+            lines.append("")
+        lines.append("    // Busy-poll mode: handle callbacks already waiting on the RPC socket")
+        lines.append("    void pollCallbacks() {")
+        lines.append("        std::lock_guard<std::mutex> lock(send_mutex_);")
+        lines.append("        uint8_t recv_buffer[65536];")
+        lines.append("        ssize_t received;")
+        lines.append("        while ((received = recv(sockfd_, recv_buffer, sizeof(recv_buffer), MSG_DONTWAIT)) > 0) {")
+        lines.append("            handleDatagram(recv_buffer, received);")
+        lines.append("        }")
+        lines.append("    }")
+        lines.append("")
         lines.append("    // Start async listening for broadcast messages")
         lines.append("    void startListening() {")
         lines.append("        if (listening_ || !connected_) return;")
         lines.append("        listening_ = true;")
-        lines.append("        listener_thread_ = std::thread([this]() {")
-        lines.append("            listenLoop();")
-        lines.append("        });")
+        lines.append("        if (!busy_poll_) {")
+        lines.append("            listener_thread_ = spawnThread(\"rx\", [this]() {")
+        lines.append("                listenLoop();")
+        lines.append("            });")
+        lines.append("        }")
+        lines.append("        if (callback_sockfd_ >= 0) {")
+        lines.append("            callback_thread_ = spawnThread(\"cbrx\", [this]() {")
+        lines.append("                callbackLoop();")
+        lines.append("            });")
+        lines.append("        }")
         lines.append("    }")
         lines.append("")
-        lines.append("    // Stop async listening")
+        lines.append("    // Stop async listening (returns as soon as the listener threads exit)")
         lines.append("    void stopListening() {")
         lines.append("        listening_ = false;")
+        lines.append("        wake();")
         lines.append("        if (listener_thread_.joinable()) {")
         lines.append("            listener_thread_.join();")
         lines.append("        }")
+        lines.append("        if (callback_thread_.joinable()) {")
+        lines.append("            callback_thread_.join();")
+        lines.append("        }")
+        lines.append("        resetWake();")
         lines.append("    }")
         lines.append("")
         lines.append("private:")
+        lines.extend(self._generate_callback_channel_setup())
+        lines.append("")
         lines.append("    void listenLoop() {")
         lines.append("        while (listening_ && connected_) {")
-        lines.append("            // Set recv timeout to allow periodic checking of listening_ flag")
-        lines.append("            struct timeval tv;")
-        lines.append("            tv.tv_sec = 1;")
-        lines.append("            tv.tv_usec = 0;")
-        lines.append("            setsockopt(sockfd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));")
+        lines.append("            // Sleep in poll() until data arrives or stopListening() wakes us")
+        lines.append("            if (!waitReadable(sockfd_)) break;")
         lines.append("")
         lines.append("            // Receive complete UDP datagram (size + data)")
         lines.append("            uint8_t recv_buffer[65536];")
@@ -1982,44 +4847,229 @@ public:
         lines.append("                break; // Error")
         lines.append("            }")
         lines.append("")
-        lines.append("            // Parse message: first 4 bytes = size, next bytes = data")
-        lines.append("            if (received < 8) continue;  // At least size(4) + msg_id(4)")
-        lines.append("            ")
-        lines.append("            uint32_t msg_size = (static_cast<uint32_t>(recv_buffer[0]) << 24) |")
-        lines.append("                                (static_cast<uint32_t>(recv_buffer[1]) << 16) |")
-        lines.append("                                (static_cast<uint32_t>(recv_buffer[2]) << 8) |")
-        lines.append("                                static_cast<uint32_t>(recv_buffer[3]);")
+        lines.append("            handleDatagram(recv_buffer, received);")
+        lines.append("        }")
+        lines.append("    }")
         lines.append("")
-        lines.append("            // Verify size matches")
-        lines.append("            if (received != msg_size + 4) continue;")
+        lines.append("    // Receives on the dedicated callback socket (see connect())")
+        lines.append("    void callbackLoop() {")
+        lines.append("        while (listening_ && connected_) {")
+        lines.append("            if (!waitReadable(callback_sockfd_)) break;")
         lines.append("")
-        lines.append("            // Parse message ID from data part")
-        lines.append("            uint8_t* data = recv_buffer + 4;")
-        lines.append("            uint32_t msg_id = (static_cast<uint32_t>(data[0]) << 24) |")
-        lines.append("                              (static_cast<uint32_t>(data[1]) << 16) |")
-        lines.append("                              (static_cast<uint32_t>(data[2]) << 8) |")
-        lines.append("                              static_cast<uint32_t>(data[3]);")
+        lines.append("            uint8_t recv_buffer[65536];")
+        lines.append("            ssize_t received = recv(callback_sockfd_, recv_buffer, sizeof(recv_buffer), 0);")
+        lines.append("            if (received <= 0) {")
+        lines.append("                if (errno == EAGAIN || errno == EWOULDBLOCK) {")
+        lines.append("                    continue;")
+        lines.append("                }")
+        lines.append("                break;")
+        lines.append("            }")
         lines.append("")
-        lines.append("            // Check if this is a callback message (REQ) or RPC response (RESP)")
-        lines.append("            bool is_callback = isCallbackMessage(msg_id);")
+        lines.append("            handleDatagram(recv_buffer, received);")
+        lines.append("        }")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    // Split a datagram into payload, message ID and wire flags; false if malformed")
+        lines.append("    static bool parseDatagram(const uint8_t* recv_buffer, ssize_t received, const uint8_t*& data,")
+        lines.append("                              uint32_t& msg_size, uint32_t& msg_id, uint8_t& wire_flags) {")
+        lines.append("        // Parse message: flags(1) + size(3), next bytes = data")
+        lines.append("        if (received < 8) return false;  // At least flags/size(4) + msg_id(4)")
+        lines.append("        ")
+        lines.append("        wire_flags = recv_buffer[0];")
+        lines.append("        msg_size = (static_cast<uint32_t>(recv_buffer[1]) << 16) |")
+        lines.append("                   (static_cast<uint32_t>(recv_buffer[2]) << 8) |")
+        lines.append("                   static_cast<uint32_t>(recv_buffer[3]);")
         lines.append("")
-        lines.append("            if (is_callback) {")
-        lines.append("                // Handle callback directly")
-        lines.append("                handleBroadcastMessage(msg_id, data, msg_size);")
+        lines.append("        // Verify size matches")
+        lines.append("        if (received != msg_size + 4) return false;")
+        lines.append("")
+        lines.append("        // Parse message ID from data part (compressed payloads stay valid until the")
+        lines.append("        // next datagram is parsed on this thread)")
+        lines.append("        data = recv_buffer + 4;")
+        lines.append("        static thread_local std::vector<uint8_t> inflated;")
+        lines.append("        if (!inflateFrame(wire_flags, data, msg_size, inflated)) return false;")
+        lines.append("        msg_id = (static_cast<uint32_t>(data[0]) << 24) |")
+        lines.append("                 (static_cast<uint32_t>(data[1]) << 16) |")
+        lines.append("                 (static_cast<uint32_t>(data[2]) << 8) |")
+        lines.append("                 static_cast<uint32_t>(data[3]);")
+        lines.append("        return true;")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    void handleDatagram(const uint8_t* recv_buffer, ssize_t received) {")
+        lines.append("        const uint8_t* data;")
+        lines.append("        uint32_t msg_size, msg_id;")
+        lines.append("        uint8_t wire_flags;")
+        lines.append("        if (!parseDatagram(recv_buffer, received, data, msg_size, msg_id, wire_flags)) return;")
+        lines.append("")
+        lines.append("        // Check if this is a callback message (REQ) or RPC response (RESP)")
+        lines.append("        bool is_callback = isCallbackMessage(msg_id);")
+        lines.append("")
+        lines.append("        if (is_callback) {")
+        lines.append("            // Handle callback directly; a malformed callback is dropped")
+        lines.append("            try {")
+        lines.append("                handleBroadcastMessage(msg_id, data, msg_size, wire_flags);")
+        lines.append("            } catch (const std::exception&) {")
+        lines.append("            }")
+        lines.append("        } else {")
+        lines.append("            // Queue RPC response for RPC method to retrieve")
+        lines.append("            QueuedMessage msg;")
+        lines.append("            msg.msg_id = msg_id;")
+        lines.append("            msg.wire_flags = wire_flags;")
+        lines.append("            msg.data.assign(data, data + msg_size);")
+        lines.append("            {")
+        lines.append("                std::lock_guard<std::mutex> lock(queue_mutex_);")
+        lines.append("                rpc_response_queue_.push(msg);")
+        lines.append("            }")
+        lines.append("            queue_cv_.notify_one();")
+        lines.append("        }")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    // True if msg answers expected_msg_id and, for stream_id != 0, belongs to that")
+        lines.append("    // stream (stream chunks and credit carry the stream ID right after the msg_id)")
+        lines.append("    static bool matchesResponse(const QueuedMessage& msg, uint32_t expected_msg_id, uint32_t stream_id) {")
+        lines.append("        if (msg.msg_id != expected_msg_id) return false;")
+        lines.append("        if (stream_id == 0) return true;")
+        lines.append("        try {")
+        lines.append("            ByteReader reader(msg.data.data(), msg.data.size(), msg.wire_flags);")
+        lines.append("            reader.readMsgId();")
+        lines.append("            return reader.readUint32() == stream_id;")
+        lines.append("        } catch (const std::exception&) {")
+        lines.append("            return false;")
+        lines.append("        }")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    // Remove the first queued message matching; false if there is none (queue_mutex_ held)")
+        lines.append("    bool takeQueued(uint32_t expected_msg_id, uint32_t stream_id, QueuedMessage& response_msg) {")
+        lines.append("        std::queue<QueuedMessage> temp_queue;")
+        lines.append("        bool found = false;")
+        lines.append("        while (!rpc_response_queue_.empty()) {")
+        lines.append("            if (!found && matchesResponse(rpc_response_queue_.front(), expected_msg_id, stream_id)) {")
+        lines.append("                response_msg = std::move(rpc_response_queue_.front());")
+        lines.append("                found = true;")
         lines.append("            } else {")
-        lines.append("                // Queue RPC response for RPC method to retrieve")
-        lines.append("                QueuedMessage msg;")
-        lines.append("                msg.msg_id = msg_id;")
-        lines.append("                msg.data.assign(data, data + msg_size);")
-        lines.append("                {")
-        lines.append("                    std::lock_guard<std::mutex> lock(queue_mutex_);")
-        lines.append("                    rpc_response_queue_.push(msg);")
-        lines.append("                }")
-        lines.append("                queue_cv_.notify_one();")
+        lines.append("                temp_queue.push(std::move(rpc_response_queue_.front()));")
         lines.append("            }")
+        lines.append("            rpc_response_queue_.pop();")
+        lines.append("        }")
+        lines.append("        rpc_response_queue_.swap(temp_queue);")
+        lines.append("        return found;")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    // Wait up to 5 seconds for the response with the given message ID (and stream ID,")
+        lines.append("    // unless 0); messages for other calls stay queued for them")
+        lines.append("    bool waitForResponse(uint32_t expected_msg_id, QueuedMessage& response_msg, uint32_t stream_id = 0) {")
+        lines.append("        if (busy_poll_) {")
+        lines.append("            return spinForResponse(expected_msg_id, response_msg, stream_id);")
         lines.append("        }")
+        lines.append("")
+        lines.append("        std::unique_lock<std::mutex> lock(queue_mutex_);")
+        lines.append("        return queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {")
+        lines.append("            return takeQueued(expected_msg_id, stream_id, response_msg);")
+        lines.append("        });")
         lines.append("    }")
         lines.append("")
+        lines.append("    // Busy-poll mode: spin on a non-blocking recv() on the calling thread.")
+        if has_streams:
+            lines.append("    // Callbacks received meanwhile are handled; stream messages are queued for the")
+            lines.append("    // stream call they belong to (it may be running on_item); stale responses are dropped.")
+        else:
+            lines.append("    // Callbacks received meanwhile are handled; stale responses are dropped.")
+        lines.append("    bool spinForResponse(uint32_t expected_msg_id, QueuedMessage& response_msg, uint32_t stream_id) {")
+        if has_streams:
+            lines.append("        {")
+            lines.append("            std::lock_guard<std::mutex> lock(queue_mutex_);")
+            lines.append("            if (takeQueued(expected_msg_id, stream_id, response_msg)) return true;")
+            lines.append("        }")
+        lines.append("        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);")
+        lines.append("        uint8_t recv_buffer[65536];")
+        lines.append("        while (std::chrono::steady_clock::now() < deadline) {")
+        lines.append("            ssize_t received = recv(sockfd_, recv_buffer, sizeof(recv_buffer), MSG_DONTWAIT);")
+        lines.append("            if (received < 0) {")
+        lines.append("                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;")
+        lines.append("                return false;")
+        lines.append("            }")
+        lines.append("")
+        lines.append("            const uint8_t* data;")
+        lines.append("            uint32_t msg_size, msg_id;")
+        lines.append("            uint8_t wire_flags;")
+        lines.append("            if (!parseDatagram(recv_buffer, received, data, msg_size, msg_id, wire_flags)) continue;")
+        lines.append("            if (isCallbackMessage(msg_id)) {")
+        lines.append("                handleBroadcastMessage(msg_id, data, msg_size, wire_flags);")
+        lines.append("                continue;")
+        lines.append("            }")
+        if has_streams:
+            lines.append("            if (msg_id != expected_msg_id && !isStreamMessage(msg_id)) continue;")
+        else:
+            lines.append("            if (msg_id != expected_msg_id) continue;")
+        lines.append("            QueuedMessage msg;")
+        lines.append("            msg.msg_id = msg_id;")
+        lines.append("            msg.wire_flags = wire_flags;")
+        lines.append("            msg.data.assign(data, data + msg_size);")
+        lines.append("            if (matchesResponse(msg, expected_msg_id, stream_id)) {")
+        lines.append("                response_msg = std::move(msg);")
+        lines.append("                return true;")
+        lines.append("            }")
+        if has_streams:
+            lines.append("            if (isStreamMessage(msg_id)) {")
+            lines.append("                std::lock_guard<std::mutex> lock(queue_mutex_);")
+            lines.append("                rpc_response_queue_.push(std::move(msg));")
+            lines.append("            }")
+        lines.append("        }")
+        lines.append("        return false;")
+        lines.append("    }")
+        lines.append("")
+        if has_streams:
+            lines.append("    // Chunks of server streams and upload credit, which may arrive while their")
+            lines.append("    // call is not receiving")
+            lines.append("    static bool isStreamMessage(uint32_t msg_id) {")
+            lines.append("        switch (msg_id) {")
+            for method in self.interface.methods:
+                if method.is_stream and not method.is_callback:
+                    lines.append(f"            case MSG_{method.name.upper()}_RESP:")
+            lines.append("            case MSG_CTRL_STREAM_CREDIT:")
+            lines.append("                return true;")
+            lines.append("            default:")
+            lines.append("                return false;")
+            lines.append("        }")
+            lines.append("    }")
+            lines.append("")
+        if has_streams:
+            lines.append("    // Grant the server credit for more chunks of a stream (send_mutex_ held)")
+            lines.append("    void sendStreamCredit(uint32_t stream_id, uint32_t credit) {")
+            lines.append("        uint8_t message[16] = {0, 0, 0, 12};")
+            lines.append("        const uint32_t fields[3] = {MSG_CTRL_STREAM_CREDIT, stream_id, credit};")
+            lines.append("        for (int i = 0; i < 3; i++) {")
+            lines.append("            message[4 + i * 4] = (fields[i] >> 24) & 0xFF;")
+            lines.append("            message[5 + i * 4] = (fields[i] >> 16) & 0xFF;")
+            lines.append("            message[6 + i * 4] = (fields[i] >> 8) & 0xFF;")
+            lines.append("            message[7 + i * 4] = fields[i] & 0xFF;")
+            lines.append("        }")
+            lines.append("        sendData(message, sizeof(message));")
+            lines.append("    }")
+            lines.append("")
+            lines.append("    // Block (up to 5 s) for credit the server grants to an upload; 0 on timeout (send_mutex_ held)")
+            lines.append("    uint32_t waitStreamCredit(uint32_t stream_id) {")
+            lines.append("        QueuedMessage credit_msg;")
+            lines.append("        if (!waitForResponse(MSG_CTRL_STREAM_CREDIT, credit_msg, stream_id)) return 0;")
+            lines.append("        ByteReader reader(credit_msg.data.data(), credit_msg.data.size());")
+            lines.append("        reader.readUint32();")
+            lines.append("        reader.readUint32();")
+            lines.append("        return reader.canRead(4) ? reader.readUint32() : 0;")
+            lines.append("    }")
+            lines.append("")
+            lines.append("    // Discard queued messages with this ID (and stream ID, unless 0)")
+            lines.append("    void dropQueued(uint32_t msg_id, uint32_t stream_id = 0) {")
+            lines.append("        std::lock_guard<std::mutex> lock(queue_mutex_);")
+            lines.append("        std::queue<QueuedMessage> kept;")
+            lines.append("        while (!rpc_response_queue_.empty()) {")
+            lines.append("            if (!matchesResponse(rpc_response_queue_.front(), msg_id, stream_id)) {")
+            lines.append("                kept.push(rpc_response_queue_.front());")
+            lines.append("            }")
+            lines.append("            rpc_response_queue_.pop();")
+            lines.append("        }")
+            lines.append("        rpc_response_queue_ = kept;")
+            lines.append("    }")
+            lines.append("")
         lines.append("    bool isCallbackMessage(uint32_t msg_id) {")
         lines.append("        // Check if message ID corresponds to a callback (REQ message)")
         lines.append("        switch (msg_id) {")
@@ -2043,8 +5093,9 @@ public:
         lines.append("        }")
         lines.append("    }")
         lines.append("")
-        lines.append("    void handleBroadcastMessage(uint32_t msg_id, const uint8_t* data, size_t size) {")
-        lines.append("        ByteReader reader(data, size);")
+        lines.append("    // Pushes arrive in the encoding this client negotiated (carried in the frame)")
+        lines.append("    void handleBroadcastMessage(uint32_t msg_id, const uint8_t* data, size_t size, uint8_t wire_flags) {")
+        lines.append("        ByteReader reader(data, size, wire_flags);")
         lines.append("        ")
         lines.append("        switch (msg_id) {")
         
@@ -2054,30 +5105,14 @@ public:
                 for method in observer_iface.methods:
                     msg_const = f"MSG_OBSERVER_{method.name.upper()}_REQ"
                     req_struct = f"observer_{method.name}Request"
-                    lines.append(f"            case {msg_const}: {{")
-                    lines.append(f"                {req_struct} request;")
-                    lines.append(f"                request.deserialize(reader);")
-                    # 调用观察者回调方法
-                    params = [f"request.{param.name}" for param in method.parameters]
-                    params_str = ", ".join(params)
-                    lines.append(f"                {method.name}({params_str});")
-                    lines.append(f"                break;")
-                    lines.append(f"            }}")
+                    lines.extend(self._generate_callback_dispatch_case(method, msg_const, req_struct))
         
         # 为 callback 方法添加消息处理
         for method in self.interface.methods:
             if method.is_callback:
                 msg_const = f"MSG_{method.name.upper()}_REQ"
                 req_struct = f"{method.name}Request"
-                lines.append(f"            case {msg_const}: {{")
-                lines.append(f"                {req_struct} request;")
-                lines.append(f"                request.deserialize(reader);")
-                # 调用回调方法
-                params = [f"request.{param.name}" for param in method.parameters]
-                params_str = ", ".join(params)
-                lines.append(f"                {method.name}({params_str});")
-                lines.append(f"                break;")
-                lines.append(f"            }}")
+                lines.extend(self._generate_callback_dispatch_case(method, msg_const, req_struct))
         
         lines.append("            default:")
         lines.append("                std::cout << \"[Client] Received unknown broadcast message: \" << msg_id << std::endl;")
@@ -2085,6 +5120,14 @@ public:
         lines.append("        }")
         lines.append("    }")
         lines.append("")
+        lines.append("    void dispatchCallback(size_t partition, std::function<void()> task) {")
+        lines.append("        if (dispatcher_) {")
+        lines.append("            dispatcher_->dispatch(partition, std::move(task));")
+        lines.append("        } else {")
+        lines.append("            task();")
+        lines.append("        }")
+        lines.append("    }")
+        lines.append("")
         lines.append("protected:")
         
         # 如果有关联的观察者接口，添加观察者回调方法
@@ -2092,10 +5135,7 @@ public:
             lines.append("    // Observer callbacks (from associated observer interfaces)")
             for observer_iface in self.observer_interfaces:
                 for method in observer_iface.methods:
-                    params = []
-                    for param in method.parameters:
-                        cpp_type = self.map_type(param.type_name)
-                        params.append(f"{cpp_type} {param.name}")
+                    params = [self._in_param_decl(p) for p in method.parameters]
                     
                     params_str = ", ".join(params)
                     lines.append(f"    virtual void {method.name}({params_str}) {{")
@@ -2109,10 +5149,7 @@ public:
         if callback_methods:
             lines.append("    // Callback methods (marked with 'callback' keyword in IDL)")
             for method in callback_methods:
-                params = []
-                for param in method.parameters:
-                    cpp_type = self.map_type(param.type_name)
-                    params.append(f"{cpp_type} {param.name}")
+                params = [self._in_param_decl(p) for p in method.parameters]
                 
                 params_str = ", ".join(params)
                 lines.append(f"    virtual void {method.name}({params_str}) {{")
@@ -2120,159 +5157,443 @@ public:
                 lines.append(f"        std::cout << \"[Client] 📢 Callback: {method.name}\" << std::endl;")
                 lines.append("    }")
                 lines.append("")
+                if self._is_lazy_callback(method):
+                    lazy_params = ", ".join(f"const {p.type_name}Lazy& {p.name}" for p in method.parameters)
+                    lines.append(f"    // {method.name} after setLazyCallbacks(true): fields are decoded on first access")
+                    lines.append("    // and the arguments stay valid only until this returns")
+                    lines.append(f"    virtual void {method.name}Lazy({lazy_params}) {{")
+                    lines.append(f"        std::cout << \"[Client] 📢 Callback: {method.name}Lazy\" << std::endl;")
+                    lines.append("    }")
+                    lines.append("")
         
         lines.append("public:")
         lines.append("")
-        
-        # 生成客户端方法（不包含 callback 方法）
-        for method in self.interface.methods:
-            if not method.is_callback:  # 跳过 callback 方法
-                lines.append(self._generate_client_method(method))
-                lines.append("")
-        
-        lines.append("};")
-        
-        return "\n".join(lines)
+        
+        # 生成客户端方法（不包含 callback 方法）
+        for method in self.interface.methods:
+            if not method.is_callback:  # 跳过 callback 方法
+                lines.append(self._generate_client_method(method))
+                lines.append("")
+                if self._uses_response_view(method):
+                    lines.append(self._generate_client_method(method, view=True))
+                    lines.append("")
+                if self._uses_lazy_result(method):
+                    lines.append(self._generate_client_method(method, lazy=True))
+                    lines.append("")
+        
+        lines.append("};")
+        
+        return "\n".join(lines)
+    
+    def _generate_callback_channel_setup(self) -> List[str]:
+        """生成客户端回调专用通道的注册逻辑"""
+        lines = []
+        lines.append("    // Ask the server, on the RPC socket, for the one-time token that proves this")
+        lines.append("    // client owns the RPC address it registers a callback channel for")
+        lines.append("    bool requestChannelToken(uint64_t& token) {")
+        lines.append("        ByteBuffer request;")
+        lines.append("        request.writeMsgId(MSG_CTRL_CALLBACK_TOKEN_REQ);")
+        lines.append("        uint8_t frame[FRAME_MAX_BYTES];")
+        lines.append("        size_t frame_size = encodeFrame(request, FRAME_MAX_BYTES, frame);")
+        lines.append("        for (int attempt = 0; attempt < 3; attempt++) {")
+        lines.append("            if (sendto(sockfd_, frame, frame_size, 0, (struct sockaddr*)&addr_, sizeof(addr_)) < 0) {")
+        lines.append("                return false;")
+        lines.append("            }")
+        lines.append("            struct pollfd pfd;")
+        lines.append("            pfd.fd = sockfd_;")
+        lines.append("            pfd.events = POLLIN;")
+        lines.append("            if (poll(&pfd, 1, 1000) <= 0) continue;")
+        lines.append("            uint8_t reply[64];")
+        lines.append("            ssize_t received = recv(sockfd_, reply, sizeof(reply), 0);")
+        lines.append("            if (received == 16) {")
+        lines.append("                ByteReader reader(reply + 4, 12);")
+        lines.append("                if (reader.readMsgId() == MSG_CTRL_CALLBACK_TOKEN) {")
+        lines.append("                    token = reader.readUint64();")
+        lines.append("                    return true;")
+        lines.append("                }")
+        lines.append("            }")
+        lines.append("        }")
+        lines.append("        return false;")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    // Open a second socket for callbacks and register it with the server.")
+        lines.append("    // The registration carries the RPC socket's port, and the token issued to")
+        lines.append("    // that socket, so the server can route this client's callbacks to the new socket.")
+        lines.append("    bool openCallbackChannel() {")
+        lines.append("        // Bind the RPC socket now so its port is known before the first request")
+        lines.append("        struct sockaddr_in local_addr;")
+        lines.append("        memset(&local_addr, 0, sizeof(local_addr));")
+        lines.append("        local_addr.sin_family = AF_INET;")
+        lines.append("        local_addr.sin_addr.s_addr = INADDR_ANY;")
+        lines.append("        local_addr.sin_port = 0;")
+        lines.append("        socklen_t local_len = sizeof(local_addr);")
+        lines.append("        if (bind(sockfd_, (struct sockaddr*)&local_addr, sizeof(local_addr)) < 0 ||")
+        lines.append("            getsockname(sockfd_, (struct sockaddr*)&local_addr, &local_len) < 0) {")
+        lines.append("            return false;")
+        lines.append("        }")
+        lines.append("")
+        lines.append("        uint64_t token;")
+        lines.append("        if (!requestChannelToken(token)) return false;")
+        lines.append("")
+        lines.append("        int fd = socket(AF_INET, SOCK_DGRAM, 0);")
+        lines.append("        if (fd < 0) return false;")
+        lines.append("")
+        lines.append("        struct timeval tv;")
+        lines.append("        tv.tv_sec = 1;")
+        lines.append("        tv.tv_usec = 0;")
+        lines.append("        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));")
+        lines.append("")
+        lines.append("        ByteBuffer buffer;")
+        lines.append("        buffer.writeUint32(MSG_CTRL_CALLBACK_CHANNEL_REQ);")
+        lines.append("        buffer.writeUint16(ntohs(local_addr.sin_port));")
+        lines.append("        buffer.writeUint64(token);")
+        lines.append("")
+        lines.append("        uint32_t msg_size = buffer.size();")
+        lines.append("        uint8_t send_buffer[64];")
+        lines.append("        send_buffer[0] = (msg_size >> 24) & 0xFF;")
+        lines.append("        send_buffer[1] = (msg_size >> 16) & 0xFF;")
+        lines.append("        send_buffer[2] = (msg_size >> 8) & 0xFF;")
+        lines.append("        send_buffer[3] = msg_size & 0xFF;")
+        lines.append("        memcpy(send_buffer + 4, buffer.data(), msg_size);")
+        lines.append("")
+        lines.append("        // UDP may drop the registration; retry a few times before giving up")
+        lines.append("        for (int attempt = 0; attempt < 3; attempt++) {")
+        lines.append("            if (sendto(fd, send_buffer, msg_size + 4, 0, (struct sockaddr*)&addr_, sizeof(addr_)) < 0) {")
+        lines.append("                break;")
+        lines.append("            }")
+        lines.append("            uint8_t recv_buffer[64];")
+        lines.append("            ssize_t received = recv(fd, recv_buffer, sizeof(recv_buffer), 0);")
+        lines.append("            if (received == 8) {")
+        lines.append("                ByteReader reader(recv_buffer + 4, 4);")
+        lines.append("                if (reader.readUint32() == MSG_CTRL_CALLBACK_CHANNEL_ACK) {")
+        lines.append("                    callback_sockfd_ = fd;")
+        lines.append("                    return true;")
+        lines.append("                }")
+        lines.append("            }")
+        lines.append("        }")
+        lines.append("")
+        lines.append("        close(fd);")
+        lines.append("        return false;")
+        lines.append("    }")
+        return lines
+    
+    def _generate_callback_dispatch_case(self, method: IDLMethod, msg_const: str, req_struct: str) -> List[str]:
+        """生成回调消息的 switch 分支：反序列化后交给 dispatchCallback"""
+        lines = []
+        lines.append(f"            case {msg_const}: {{")
+        if self._is_lazy_callback(method) and req_struct == f"{method.name}Request":
+            # 按需解码：消息复制进 RequestLazy，随分发任务存活；同类回调按类型保持顺序
+            lines.append("                if (lazy_callbacks_) {")
+            lines.append(f"                    std::shared_ptr<{req_struct}Lazy> lazy = std::make_shared<{req_struct}Lazy>(data, size, wire_flags);")
+            lines.append(f"                    dispatchCallback({msg_const}, [this, lazy]() {{")
+            lazy_args = ", ".join(f"lazy->{p.name}" for p in method.parameters)
+            lines.append(f"                        {method.name}Lazy({lazy_args});")
+            lines.append("                    });")
+            lines.append("                    break;")
+            lines.append("                }")
+        lines.append(f"                std::shared_ptr<{req_struct}> request = std::make_shared<{req_struct}>();")
+        lines.append(f"                request->deserialize(reader);")
+        lines.append(f"                dispatchCallback({self._partition_expr(method, msg_const)}, [this, request]() {{")
+        params = [f"request->{param.name}" for param in method.parameters]
+        lines.append(f"                    {method.name}({', '.join(params)});")
+        lines.append(f"                }});")
+        lines.append(f"                break;")
+        lines.append(f"            }}")
+        return lines
+    
+    def _partition_expr(self, method: IDLMethod, msg_const: str) -> str:
+        """回调分发分区键：@partition 指定的字段哈希，否则按回调类型"""
+        if 'partition' not in method.annotations:
+            return msg_const
+        path = method.annotations['partition'][0].split('.')
+        param = next(p for p in method.parameters if p.name == path[0])
+        type_name = param.type_name
+        structs = {st.name: st for st in (self.module.structs if self.module else []) + self.interface.structs}
+        for field_name in path[1:]:
+            type_name = next(t for t, n in structs[type_name].fields if n == field_name)
+        expr = "request->" + ".".join(path)
+        cpp_type = self.map_type(type_name)
+        if len(path) > 1:
+            cpp_type = self._arena_type(cpp_type)  # 结构体成员在 arena 模式下是 std::pmr 容器
+        if self._is_enum(type_name):
+            return f"static_cast<size_t>({expr})"
+        return f"std::hash<{cpp_type}>()({expr})"
+    
+    def _stream_param(self, method: IDLMethod) -> Optional[IDLParameter]:
+        """返回方法的客户端流式参数（in stream<T>），没有则返回 None"""
+        return next((p for p in method.parameters if p.is_stream), None)
+    
+    def _has_streams(self) -> bool:
+        """接口中是否有流式方法（stream<T> 返回或 stream<T> 参数）"""
+        return any(m.is_stream or self._stream_param(m) for m in self.interface.methods)
+    
+    def _has_response(self, method: IDLMethod) -> bool:
+        """方法是否需要 RESP 消息（客户端流式方法总是回复，告知上传已处理完）"""
+        return (method.return_type != 'void' or self._stream_param(method) is not None
+                or any(p.direction in ['out', 'inout'] for p in method.parameters))
+    
+    def _is_enum(self, idl_type: str) -> bool:
+        """判断类型是否为枚举（module 或接口内定义）"""
+        enums = (self.module.enums if self.module else []) + self.interface.enums
+        return any(e.name == idl_type for e in enums)
     
-    def _generate_client_method(self, method: IDLMethod) -> str:
-        """生成客户端方法（使用序列化）"""
+    def _encode_item_stmt(self, idl_type: str, expr: str) -> str:
+        """生成单个元素的序列化语句（流式传输的元素类型）"""
+        cpp_type = self.map_type(idl_type)
+        if cpp_type in self.WRITE_METHODS:
+            return f"buffer.{self.WRITE_METHODS[cpp_type]}({expr});"
+        if self._is_enum(idl_type) or self._is_enum(cpp_type):
+            return f"buffer.writeInt32(static_cast<int32_t>({expr}));"
+        return f"{expr}.serialize(buffer);"
+    
+    def _decode_item_stmt(self, idl_type: str, target: str) -> str:
+        """生成单个元素的反序列化语句（流式传输的元素类型）"""
+        cpp_type = self.map_type(idl_type)
+        if cpp_type in self.WRITE_METHODS:
+            read_method = 'read' + self.WRITE_METHODS[cpp_type][len('write'):]
+            return f"{target} = reader.{read_method}();"
+        if self._is_enum(idl_type) or self._is_enum(cpp_type):
+            return f"{target} = static_cast<{cpp_type}>(reader.readInt32());"
+        return f"{target}.deserialize(reader);"
+    
+    def _generate_client_method(self, method: IDLMethod, view: bool = False, lazy: bool = False) -> str:
+        """生成客户端方法（使用序列化）；view=True 时生成以 ResponseView 回调交付结果的版本，
+        lazy=True 时生成以 XxxLazy 回调交付 @lazy 结果的版本"""
         lines = []
         
-        # 方法签名
-        cpp_return_type = self.map_type(method.return_type) if method.return_type != 'void' else 'bool'
+        # 方法签名（流式、视图和按需解码版本返回 bool，结果通过回调交付）
+        if method.is_stream or view or lazy:
+            cpp_return_type = 'bool'
+        else:
+            cpp_return_type = self.map_type(method.return_type) if method.return_type != 'void' else 'bool'
         params = []
+        stream_param = self._stream_param(method)
         
         for param in method.parameters:
             cpp_type = self.map_type(param.type_name)
-            if param.direction == 'in':
-                if param.is_array:
-                    if param.array_size:
-                        params.append(f"const {cpp_type} {param.name}[{param.array_size}]")
-                    else:
-                        params.append(f"const std::vector<{cpp_type}>& {param.name}")
-                else:
-                    if cpp_type == 'std::string':
-                        params.append(f"const {cpp_type}& {param.name}")
-                    else:
-                        params.append(f"{cpp_type} {param.name}")
+            if param.is_stream:
+                # 客户端流式参数：调用方在回调中通过 writer 逐个写入元素
+                params.append(f"std::function<void(StreamWriter<{cpp_type}>&)> {param.name}")
+            elif param.direction == 'in':
+                params.append(self._in_param_decl(param))
+            elif view:
+                continue  # 输出参数包含在 ResponseView 中
             else:  # out 或 inout
-                if param.is_array:
-                    if param.array_size:
-                        params.append(f"{cpp_type} {param.name}[{param.array_size}]")
-                    else:
-                        params.append(f"std::vector<{cpp_type}>& {param.name}")
-                else:
-                    params.append(f"{cpp_type}& {param.name}")
-        
-        lines.append(f"    {cpp_return_type} {method.name}({', '.join(params)}) {{")
+                params.append(self._out_param_decl(param))
+        
+        method_name = method.name
+        if lazy:
+            method_name = f"{method.name}Lazy"
+            params.append(f"std::function<void(const {method.return_type}Lazy&)> on_result")
+            lines.append("    // On-demand variant: on_result sees the result with only its offset table read;")
+            lines.append("    // each field is decoded on first access from the received datagram, so the")
+            lines.append("    // result is valid only until on_result returns. False on timeout.")
+        elif view:
+            method_name = f"{method.name}View"
+            params.append(f"std::function<void(const {method.name}ResponseView&)> on_response")
+            lines.append("    // Zero-copy variant: on_response sees string results as views into the")
+            lines.append("    // received datagram, valid only until it returns. False on timeout.")
+        elif method.is_stream:
+            params.append(f"std::function<void(const {self.map_type(method.return_type)}&)> on_item")
+            lines.append("    // Server-streaming call: on_item runs for each item as its chunk arrives.")
+            lines.append("    // Returns false on timeout or when a chunk was lost. on_item runs without")
+            lines.append("    // the client's send lock, so it may call this client again (another stream")
+            lines.append("    // call included); each on_item call should return within 5 seconds, the")
+            lines.append("    // time the server waits without hearing from the reader.")
+        elif stream_param:
+            lines.append(f"    // Client-streaming call: {stream_param.name}(writer) produces the items; each")
+            lines.append("    // writer.write() goes out in chunks as soon as the server grants credit.")
+            lines.append(f"    // {stream_param.name} runs without the client's send lock, so it may call this")
+            lines.append("    // client again (another stream call included).")
+        lines.append(f"    {cpp_return_type} {method_name}({', '.join(params)}) {{")
         lines.append("        if (!connected_) {")
-        if method.return_type == 'void':
+        if method.return_type == 'void' or method.is_stream or view or lazy:
             lines.append("            return false;")
         else:
             lines.append(f"            return {cpp_return_type}();")
         lines.append("        }")
-        lines.append("")
-        lines.append(f"        // Prepare request")
-        lines.append(f"        {method.name}Request request;")
+        direct = self._direct_request(method)
+        args = [p.name for p in method.parameters if p.direction in ['in', 'inout']]
+        if not direct:
+            lines.append("")
+            lines.append(f"        // Prepare request")
+            lines.append(f"        {method.name}Request request;")
         
         for param in method.parameters:
-            if param.direction in ['in', 'inout']:
-                cpp_type = self.map_type(param.type_name)
-                if param.is_array and not param.array_size:
-                    # 动态数组：直接赋值vector
-                    lines.append(f"        request.{param.name} = {param.name};")
-                elif param.is_array and param.array_size:
-                    # 固定数组
-                    lines.append(f"        memcpy(request.{param.name}, {param.name}, sizeof(request.{param.name}));")
-                else:
-                    # 标量
-                    lines.append(f"        request.{param.name} = {param.name};")
+            if direct:
+                break
+            if param.direction in ['in', 'inout'] and not param.is_stream:
+                assign = self._assign_stmt(method, f"request.{param.name}", param.name, self._field_cpp_type(param))
+                lines.append(f"        {assign}")
         
         lines.append("")
         lines.append("        // Serialize and send request via UDP (thread-safe)")
-        lines.append("        std::lock_guard<std::mutex> lock(send_mutex_);")
-        lines.append("        ByteBuffer buffer;")
-        lines.append("        request.serialize(buffer);")
+        if method.is_stream or stream_param:
+            # 流式调用：回调 on_item / 生产者运行期间释放锁
+            lines.append("        std::unique_lock<std::mutex> lock(send_mutex_);")
+        else:
+            lines.append("        std::lock_guard<std::mutex> lock(send_mutex_);")
+        if method.is_stream or stream_param:
+            lines.append("        request.stream_id = ++next_stream_id_;")
+            lines.append("        request.credit = stream_window_;")
+            if method.is_stream:
+                lines.append("        request.max_delay_ms = static_cast<uint32_t>(stream_chunk_delay_.count());")
+        lines.append("        PooledByteBuffer pooled;")
+        lines.append("        ByteBuffer& buffer = *pooled;")
+        lines.append("        buffer.setWireFlags(wire_flags_);")
+        if not direct:
+            lines.append("        request.serialize(buffer);")
+        else:
+            # 参数直接写入缓冲区，不经过 Request 副本
+            lines.append(f"        buffer.writeMsgId(MSG_{method.name.upper()}_REQ);")
+            if args:
+                lines.append(f"        {method.name}Request::serializeFields(buffer, {', '.join(args)});")
         lines.append("        ")
-        lines.append("        // Prepare UDP datagram: size(4 bytes) + data")
-        lines.append("        uint32_t msg_size = buffer.size();")
-        lines.append("        uint8_t send_buffer[65536];")
-        lines.append("        send_buffer[0] = (msg_size >> 24) & 0xFF;")
-        lines.append("        send_buffer[1] = (msg_size >> 16) & 0xFF;")
-        lines.append("        send_buffer[2] = (msg_size >> 8) & 0xFF;")
-        lines.append("        send_buffer[3] = msg_size & 0xFF;")
-        lines.append("        memcpy(send_buffer + 4, buffer.data(), msg_size);")
+        lines.append("        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)")
+        lines.append("        uint8_t send_buffer[FRAME_MAX_BYTES];")
+        lines.append("        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);")
         lines.append("        ")
         lines.append("        // Send complete datagram")
-        lines.append("        if (sendData(send_buffer, msg_size + 4) < 0) {")
-        if method.return_type == 'void':
+        lines.append("        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {")
+        if method.return_type == 'void' or method.is_stream or view or lazy:
             lines.append("            return false;")
         else:
             lines.append(f"            return {cpp_return_type}();")
         lines.append("        }")
         lines.append("")
         
-        has_response = method.return_type != 'void' or any(p.direction in ['out', 'inout'] for p in method.parameters)
-        if has_response:
-            lines.append("        // Wait for response from queue (listener thread will queue it)")
-            lines.append(f"        uint32_t expected_msg_id = MSG_{method.name.upper()}_RESP;")
-            lines.append("        QueuedMessage response_msg;")
+        if stream_param:
+            elem_type = self.map_type(stream_param.type_name)
+            fail_value = "false" if method.return_type == 'void' else f"{cpp_return_type}()"
+            lines.append("        // Upload the stream, paced by the credit the server returns. The lock is")
+            lines.append("        // taken only to receive credit; a chunk is a single sendto() and needs none.")
+            lines.append("        lock.unlock();")
             lines.append("        {")
-            lines.append("            std::unique_lock<std::mutex> lock(queue_mutex_);")
-            lines.append("            // Wait up to 5 seconds for response")
-            lines.append("            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {")
-            lines.append("                // Check if expected response is in queue")
-            lines.append("                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;")
-            lines.append("                while (!temp_queue.empty()) {")
-            lines.append("                    if (temp_queue.front().msg_id == expected_msg_id) {")
-            lines.append("                        return true;")
-            lines.append("                    }")
-            lines.append("                    temp_queue.pop();")
-            lines.append("                }")
-            lines.append("                return false;")
-            lines.append("            })) {")
-            if method.return_type == 'void':
-                lines.append("                return false; // Timeout")
-            else:
-                lines.append(f"                return {cpp_return_type}(); // Timeout")
+            lines.append(f"            StreamWriter<{elem_type}> writer(sockfd_, addr_, MSG_{method.name.upper()}_CHUNK,")
+            lines.append("                request.stream_id, request.credit,")
+            lines.append(f"                [](ByteBuffer& buffer, const {elem_type}& item) {{ {self._encode_item_stmt(stream_param.type_name, 'item')} }});")
+            lines.append("            writer.setWireFormat(wire_flags_, compress_threshold_);")
+            lines.append("            writer.setMaxDelay(stream_chunk_delay_);")
+            lines.append("            uint32_t stream_id = request.stream_id;")
+            lines.append("            writer.setCreditSource([this, stream_id]() {")
+            lines.append("                std::lock_guard<std::mutex> credit_lock(send_mutex_);")
+            lines.append("                return waitStreamCredit(stream_id);")
+            lines.append("            });")
+            lines.append(f"            {stream_param.name}(writer);")
+            lines.append("            bool uploaded = writer.finish();")
+            lines.append("            if (!uploaded) {")
+            lines.append(f"                return {fail_value};")
+            lines.append("            }")
+            lines.append("        }")
+            lines.append("        lock.lock();")
+            lines.append("")
+        
+        has_response = self._has_response(method)
+        if method.is_stream:
+            elem_type = self.map_type(method.return_type)
+            lines.append("        // Receive chunks in order; hand credit back once half the window is consumed.")
+            lines.append("        // The lock is held only while receiving and sending, never around on_item.")
+            lines.append("        uint32_t expected_seq = 0;")
+            lines.append("        uint32_t consumed = 0;")
+            lines.append("        bool complete = false;")
+            lines.append("        auto last_sent = std::chrono::steady_clock::now();")
+            lines.append("        while (true) {")
+            lines.append("            QueuedMessage chunk_msg;")
+            lines.append(f"            if (!waitForResponse(MSG_{method.name.upper()}_RESP, chunk_msg, request.stream_id)) {{")
+            lines.append("                break; // Timeout")
             lines.append("            }")
             lines.append("")
-            lines.append("            // Find and remove the response message from queue")
-            lines.append("            std::queue<QueuedMessage> temp_queue;")
-            lines.append("            bool found = false;")
-            lines.append("            while (!rpc_response_queue_.empty()) {")
-            lines.append("                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {")
-            lines.append("                    response_msg = rpc_response_queue_.front();")
-            lines.append("                    found = true;")
-            lines.append("                } else {")
-            lines.append("                    temp_queue.push(rpc_response_queue_.front());")
+            lines.append("            ByteReader reader(chunk_msg.data.data(), chunk_msg.data.size(), chunk_msg.wire_flags);")
+            lines.append("            StreamChunkHeader header;")
+            lines.append("            header.deserialize(reader);")
+            lines.append("            if (header.seq != expected_seq++) break;  // Chunk lost")
+            lines.append("            lock.unlock();")
+            lines.append("            for (uint32_t i = 0; i < header.count; i++) {")
+            lines.append(f"                {elem_type} item;")
+            lines.append(f"                {self._decode_item_stmt(method.return_type, 'item')}")
+            lines.append("                on_item(item);")
+            lines.append("                if (std::chrono::steady_clock::now() - last_sent >= std::chrono::seconds(1)) {")
+            lines.append("                    // Slow consumer: keep the server waiting for credit instead of giving up")
+            lines.append("                    std::lock_guard<std::mutex> keepalive_lock(send_mutex_);")
+            lines.append("                    sendStreamCredit(request.stream_id, 0);")
+            lines.append("                    last_sent = std::chrono::steady_clock::now();")
             lines.append("                }")
-            lines.append("                rpc_response_queue_.pop();")
             lines.append("            }")
-            lines.append("            rpc_response_queue_ = temp_queue;")
+            lines.append("            lock.lock();")
+            lines.append("            if (header.last) {")
+            lines.append("                complete = true;")
+            lines.append("                break;")
+            lines.append("            }")
+            lines.append("            if (++consumed >= (request.credit + 1) / 2) {")
+            lines.append("                sendStreamCredit(request.stream_id, consumed);")
+            lines.append("                last_sent = std::chrono::steady_clock::now();")
+            lines.append("                consumed = 0;")
+            lines.append("            }")
+            lines.append("        }")
+            lines.append("        if (!complete) {")
+            lines.append("            // Chunks of the abandoned stream already queued would never be collected")
+            lines.append(f"            dropQueued(MSG_{method.name.upper()}_RESP, request.stream_id);")
+            lines.append("        }")
+            lines.append("        return complete;")
+        elif lazy:
+            lines.append("        // Wait for response (queued by the listener thread, or polled in busy-poll mode)")
+            lines.append("        QueuedMessage response_msg;")
+            lines.append(f"        if (!waitForResponse(MSG_{method.name.upper()}_RESP, response_msg)) {{")
+            lines.append("            return false; // Timeout")
+            lines.append("        }")
+            lines.append("")
+            lines.append(f"        // Same layout as {method.name}Response: msg_id, status, return_value")
+            lines.append("        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);")
+            lines.append("        reader.readMsgId();")
+            lines.append("        reader.readInt32();")
+            lines.append(f"        {method.return_type}Lazy result;")
+            lines.append("        result.deserialize(reader);")
+            lines.append("        on_result(result);")
+            lines.append("        return true;")
+        elif view:
+            lines.append("        // Wait for response (queued by the listener thread, or polled in busy-poll mode)")
+            lines.append("        QueuedMessage response_msg;")
+            lines.append(f"        if (!waitForResponse(MSG_{method.name.upper()}_RESP, response_msg)) {{")
+            lines.append("            return false; // Timeout")
+            lines.append("        }")
+            lines.append("")
+            lines.append(f"        {method.name}ResponseView response;")
+            lines.append("        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);")
+            lines.append("        response.deserialize(reader);")
+            lines.append("        on_response(response);")
+            lines.append("        return true;")
+        elif has_response:
+            lines.append("        // Wait for response (queued by the listener thread, or polled in busy-poll mode)")
+            lines.append("        QueuedMessage response_msg;")
+            lines.append(f"        if (!waitForResponse(MSG_{method.name.upper()}_RESP, response_msg)) {{")
+            if method.return_type == 'void':
+                lines.append("            return false; // Timeout")
+            else:
+                lines.append(f"            return {cpp_return_type}(); // Timeout")
             lines.append("        }")
             lines.append("")
             lines.append(f"        {method.name}Response response;")
-            lines.append("        ByteReader reader(response_msg.data.data(), response_msg.data.size());")
+            lines.append("        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);")
             lines.append("        response.deserialize(reader);")
             lines.append("")
+            if stream_param:
+                lines.append("        // Credit granted after the last chunk went out is no longer needed")
+                lines.append("        dropQueued(MSG_CTRL_STREAM_CREDIT, request.stream_id);")
+                lines.append("")
             
             # 处理输出参数
             for param in method.parameters:
                 if param.direction in ['out', 'inout']:
-                    cpp_type = self.map_type(param.type_name)
-                    if param.is_array and not param.array_size:
-                        # 动态数组：直接赋值
-                        lines.append(f"        {param.name} = response.{param.name};")
-                    elif param.is_array and param.array_size:
-                        # 固定数组
-                        lines.append(f"        memcpy({param.name}, response.{param.name}, sizeof(response.{param.name}));")
-                    else:
-                        # 标量
-                        lines.append(f"        {param.name} = response.{param.name};")
+                    # 动态数组、字符串和结构体从局部 response 移出
+                    assign = self._assign_stmt(method, param.name, f"response.{param.name}",
+                                               self._field_cpp_type(param), move=True)
+                    lines.append(f"        {assign}")
             
             if method.return_type != 'void':
-                lines.append("        return response.return_value;")
+                if self._is_scalar(cpp_return_type):
+                    lines.append("        return response.return_value;")
+                else:
+                    lines.append("        return std::move(response.return_value);")
             else:
                 # 检查是否有名为'status'的输出参数
                 has_status_param = any(p.name == 'status' and p.direction in ['out', 'inout'] for p in method.parameters)
@@ -2296,10 +5617,74 @@ public:
         lines.append("    int sockfd_;  // UDP socket")
         lines.append("    bool running_;")
         lines.append("    std::map<std::string, struct sockaddr_in> clients_;  // Track clients by address")
+        lines.append("    std::map<std::string, struct sockaddr_in> callback_routes_;  // Client key -> dedicated callback socket")
+        lines.append("    std::map<std::string, std::chrono::steady_clock::time_point> client_seen_;  // Last request per client")
+        lines.append("    std::map<std::string, uint8_t> client_wire_flags_;  // Encodings each client agreed to in MSG_CTRL_HELLO")
         lines.append("    mutable std::mutex clients_mutex_;")
         lines.append("")
+        lines.append("    // Callback channel registration: a token is issued to the client's RPC socket and")
+        lines.append("    // must come back with CALLBACK_CHANNEL_REQ, so only the owner of an RPC address")
+        lines.append("    // can route its callbacks elsewhere")
+        lines.append("    struct ChannelToken {")
+        lines.append("        uint64_t value;")
+        lines.append("        std::chrono::steady_clock::time_point issued;")
+        lines.append("    };")
+        lines.append("    std::map<std::string, ChannelToken> channel_tokens_;  // RPC client key -> pending token")
+        lines.append("    std::mt19937_64 token_rng_;")
+        lines.append("    std::chrono::seconds client_timeout_;  // Idle clients are forgotten after this (0 = never)")
+        lines.append("    std::chrono::steady_clock::time_point last_sweep_;")
+        lines.append("    static const size_t kMaxPendingTokens = 1024;")
+        lines.append("")
+        lines.append("    // Wire encodings offered to clients, and the encoding of the request being")
+        lines.append("    // handled on the run() thread (responses are sent back in the same encoding)")
+        lines.append("    uint8_t accepted_wire_flags_;")
+        lines.append("    uint8_t request_wire_flags_;")
+        lines.append("    size_t compress_threshold_;       // With WIRE_LZ: responses larger than this are compressed")
+        lines.append("    std::vector<uint8_t> inflated_;   // Decompressed request being handled (run() thread)")
+        lines.append("")
+        lines.append("    // Frames of the callback being broadcast, one per wire encoding in use; kept")
+        lines.append("    // between broadcasts so their storage is reused (under clients_mutex_)")
+        lines.append("    struct PushFrame {")
+        lines.append("        uint8_t flags;")
+        lines.append("        size_t size;")
+        lines.append("        std::vector<uint8_t> bytes;")
+        lines.append("    };")
+        lines.append("    std::vector<PushFrame> push_frames_;")
+        
+        batch_pairs = self._batch_pairs()
+        ctor_init = ("sockfd_(-1), running_(false), token_rng_(std::random_device()()), client_timeout_(0), "
+                     "accepted_wire_flags_(WIRE_SUPPORTED), request_wire_flags_(0), compress_threshold_(WIRE_LZ_THRESHOLD)")
+        if batch_pairs:
+            lines.append("")
+            lines.append("    // Callback batching (@batch): per-item pushes accumulate into batch callbacks")
+            lines.append("    std::thread batch_thread_;")
+            lines.append("    std::mutex batch_mutex_;")
+            lines.append("    std::mutex batch_flush_mutex_;")
+            lines.append("    std::condition_variable batch_cv_;")
+            lines.append("    bool batching_;")
+            lines.append("    std::chrono::milliseconds batch_window_;")
+            lines.append("    size_t batch_max_events_;")
+            for source, target in batch_pairs:
+                elem_type = self.map_type(source.parameters[0].type_name)
+                lines.append(f"    std::vector<{elem_type}> pending_{source.name}_;")
+            ctor_init += ", batching_(false), batch_window_(0), batch_max_events_(256)"
+        has_streams = self._has_streams()
+        if has_streams:
+            lines.append("")
+            lines.append("    // Streaming calls (stream<T>): each handler runs on its own thread")
+            lines.append("    struct ActiveStream {")
+            lines.append("        std::shared_ptr<StreamBase> stream;")
+            lines.append("        std::thread thread;")
+            lines.append("    };")
+            lines.append("    std::map<std::string, ActiveStream> streams_;  // \"client/stream_id\" -> stream")
+            lines.append("    std::mutex streams_mutex_;")
+        if any(self._uses_arena(m) for m in self.interface.methods):
+            lines.append("")
+            lines.append("    // Requests are decoded into this arena on the run() thread (--pmr-arena)")
+            lines.append("    RequestArena request_arena_;")
+        lines.append("")
         lines.append("public:")
-        lines.append(f"    {interface_name}Server() : sockfd_(-1), running_(false) {{}}")
+        lines.append(f"    {interface_name}Server() : {ctor_init} {{}}")
         lines.append("")
         lines.append("    ~" + interface_name + "Server() {")
         lines.append("        stop();")
@@ -2325,12 +5710,19 @@ public:
         lines.append("            return false;")
         lines.append("        }")
         lines.append("")
+        lines.append("        resetWake();")
         lines.append("        running_ = true;")
         lines.append("        return true;")
         lines.append("    }")
         lines.append("")
         lines.append("    void stop() {")
+        if batch_pairs:
+            lines.append("        // Deliver pending batches while the socket is still open")
+            lines.append("        stopBatching();")
+        if has_streams:
+            lines.append("        stopStreams();")
         lines.append("        running_ = false;")
+        lines.append("        wake();  // Unblock run() immediately")
         lines.append("        ")
         lines.append("        if (sockfd_ >= 0) {")
         lines.append("            close(sockfd_);")
@@ -2339,11 +5731,19 @@ public:
         lines.append("        ")
         lines.append("        std::lock_guard<std::mutex> lock(clients_mutex_);")
         lines.append("        clients_.clear();")
+        lines.append("        callback_routes_.clear();")
+        lines.append("        client_seen_.clear();")
+        lines.append("        client_wire_flags_.clear();")
+        lines.append("        channel_tokens_.clear();")
         lines.append("    }")
         lines.append("")
         lines.append("    // Main server loop - receive UDP datagrams")
+        lines.append("    // The calling thread takes on the configured ThreadOptions")
         lines.append("    void run() {")
+        lines.append("        thread_options_.applyOrReport(\"srv\", &placement_failures_);")
         lines.append("        while (running_) {")
+        lines.append("            if (!waitReadable(sockfd_)) break;")
+        lines.append("")
         lines.append("            uint8_t recv_buffer[65536];")
         lines.append("            struct sockaddr_in client_addr;")
         lines.append("            socklen_t addr_len = sizeof(client_addr);")
@@ -2356,54 +5756,93 @@ public:
         lines.append("                break;")
         lines.append("            }")
         lines.append("")
-        lines.append("            // Register client address")
-        lines.append("            {")
-        lines.append("                std::lock_guard<std::mutex> lock(clients_mutex_);")
-        lines.append("                char client_key[64];")
-        lines.append("                sprintf(client_key, \"%s:%d\", ")
-        lines.append("                        inet_ntoa(client_addr.sin_addr), ")
-        lines.append("                        ntohs(client_addr.sin_port));")
-        lines.append("                clients_[client_key] = client_addr;")
-        lines.append("            }")
-        lines.append("")
-        lines.append("            // Parse: first 4 bytes = size, rest = data")
+        lines.append("            // Parse: flags(1) + size(3), rest = data")
         lines.append("            if (received < 8) continue;")
         lines.append("            ")
-        lines.append("            uint32_t msg_size = (static_cast<uint32_t>(recv_buffer[0]) << 24) |")
-        lines.append("                                (static_cast<uint32_t>(recv_buffer[1]) << 16) |")
+        lines.append("            uint8_t wire_flags = recv_buffer[0];")
+        lines.append("            uint32_t msg_size = (static_cast<uint32_t>(recv_buffer[1]) << 16) |")
         lines.append("                                (static_cast<uint32_t>(recv_buffer[2]) << 8) |")
         lines.append("                                static_cast<uint32_t>(recv_buffer[3]);")
         lines.append("")
         lines.append("            if (received != msg_size + 4) continue;")
         lines.append("")
-        lines.append("            uint8_t* data = recv_buffer + 4;")
-        lines.append("            handleClientRequest(&client_addr, data, msg_size);")
+        lines.append("            const uint8_t* data = recv_buffer + 4;")
+        lines.append("            if (!inflateFrame(wire_flags, data, msg_size, inflated_)) continue;")
+        lines.append("            if (handleControlMessage(&client_addr, data, msg_size)) continue;")
+        lines.append("")
+        lines.append("            // Register client address")
+        lines.append("            {")
+        lines.append("                std::lock_guard<std::mutex> lock(clients_mutex_);")
+        lines.append("                touchClient(clientKey(client_addr), client_addr);")
+        lines.append("            }")
+        lines.append("")
+        lines.append("            request_wire_flags_ = wire_flags;")
+        lines.append("            try {")
+        lines.append("                handleClientRequest(&client_addr, data, msg_size);")
+        lines.append("            } catch (const std::exception&) {")
+        lines.append("                // Malformed request (count beyond the datagram, truncated field): drop it")
+        lines.append("            }")
         lines.append("        }")
         lines.append("    }")
         lines.append("")
         lines.append("    // Broadcast message to all known clients (with serialization)")
         lines.append("    template<typename T>")
-        lines.append("    void broadcast(const T& message) {")
+        lines.append("    bool broadcast(const T& message) {")
+        lines.append("        return broadcastEncoded([&message](ByteBuffer& buffer) { message.serialize(buffer); });")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    // Broadcast whatever encode(buffer) writes (msg_id first), framed like every other")
+        lines.append("    // message in the encoding each client negotiated. Returns false and sends nothing")
+        lines.append("    // if a frame exceeds one datagram")
+        lines.append("    template<typename Encode>")
+        lines.append("    bool broadcastEncoded(Encode encode) {")
         lines.append("        std::lock_guard<std::mutex> lock(clients_mutex_);")
         lines.append("        ")
-        lines.append("        // Serialize message once")
-        lines.append("        ByteBuffer buffer;")
-        lines.append("        message.serialize(buffer);")
-        lines.append("        ")
-        lines.append("        // Prepare datagram: size(4 bytes) + data")
-        lines.append("        uint32_t msg_size = buffer.size();")
-        lines.append("        uint8_t send_buffer[65536];")
-        lines.append("        send_buffer[0] = (msg_size >> 24) & 0xFF;")
-        lines.append("        send_buffer[1] = (msg_size >> 16) & 0xFF;")
-        lines.append("        send_buffer[2] = (msg_size >> 8) & 0xFF;")
-        lines.append("        send_buffer[3] = msg_size & 0xFF;")
-        lines.append("        memcpy(send_buffer + 4, buffer.data(), msg_size);")
+        lines.append("        // Serialize message once per wire encoding in use")
+        lines.append("        size_t frame_count = 0;")
+        lines.append("        for (const auto& pair : clients_) {")
+        lines.append("            uint8_t flags = clientWireFlags(pair.first);")
+        lines.append("            if (findPushFrame(flags, frame_count)) continue;")
+        lines.append("            if (frame_count == push_frames_.size()) push_frames_.emplace_back();")
+        lines.append("            PushFrame& frame = push_frames_[frame_count++];")
+        lines.append("            PooledByteBuffer pooled;")
+        lines.append("            ByteBuffer& buffer = *pooled;")
+        lines.append("            buffer.setWireFlags(flags);")
+        lines.append("            encode(buffer);")
+        lines.append("            ")
+        lines.append("            // Prepare datagram: flags(1) + size(3) + data")
+        lines.append("            frame.flags = flags;")
+        lines.append("            frame.bytes.resize(FRAME_MAX_BYTES);")
+        lines.append("            frame.size = encodeFrame(buffer, compress_threshold_, frame.bytes.data());")
+        lines.append("            if (frame.size == 0 || frame.size > UDP_MAX_PAYLOAD) return false;")
+        lines.append("        }")
         lines.append("        ")
-        lines.append("        // Send to all known clients")
+        lines.append("        // Send to all known clients (on their callback socket if they registered one)")
         lines.append("        for (const auto& pair : clients_) {")
-        lines.append("            sendto(sockfd_, send_buffer, msg_size + 4, 0,")
-        lines.append("                   (struct sockaddr*)&pair.second, sizeof(pair.second));")
+        lines.append("            const PushFrame* frame = findPushFrame(clientWireFlags(pair.first), frame_count);")
+        lines.append("            auto route = callback_routes_.find(pair.first);")
+        lines.append("            const struct sockaddr_in& dest = route != callback_routes_.end() ? route->second : pair.second;")
+        lines.append("            sendto(sockfd_, frame->bytes.data(), frame->size, 0,")
+        lines.append("                   (struct sockaddr*)&dest, sizeof(dest));")
         lines.append("        }")
+        lines.append("        return true;")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    // Restrict the wire encodings clients may negotiate (WireFlag bits)")
+        lines.append("    void setAcceptedWireFlags(uint8_t flags) {")
+        lines.append("        accepted_wire_flags_ = flags & WIRE_SUPPORTED;")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    // Responses above this many bytes are compressed for clients that negotiated WIRE_LZ")
+        lines.append("    void setCompressionThreshold(size_t bytes) { compress_threshold_ = bytes; }")
+        lines.append("")
+        lines.append("    // Clients that send nothing for this long are forgotten along with their callback")
+        lines.append("    // route; any request registers them again. The default 0 keeps them until they")
+        lines.append("    // disconnect. Only requests count as activity, so a client that just listens for")
+        lines.append("    // pushes is dropped once the timeout passes")
+        lines.append("    void setClientTimeout(std::chrono::seconds timeout) {")
+        lines.append("        std::lock_guard<std::mutex> lock(clients_mutex_);")
+        lines.append("        client_timeout_ = timeout;")
         lines.append("    }")
         lines.append("")
         lines.append("    // Get number of known clients")
@@ -2412,8 +5851,153 @@ public:
         lines.append("        return clients_.size();")
         lines.append("    }")
         lines.append("")
+        if batch_pairs:
+            lines.extend(self._generate_batching_methods(batch_pairs))
+            lines.append("")
         lines.append("private:")
-        lines.append("    void handleClientRequest(struct sockaddr_in* client_addr, uint8_t* data, size_t data_size) {")
+        lines.append("    static std::string clientKey(const struct sockaddr_in& addr) {")
+        lines.append("        char client_key[64];")
+        lines.append("        sprintf(client_key, \"%s:%d\", inet_ntoa(addr.sin_addr), ntohs(addr.sin_port));")
+        lines.append("        return client_key;")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    // Record a request from a client and, at most once a second, drop expired")
+        lines.append("    // channel tokens and clients idle for longer than client_timeout_")
+        lines.append("    // (caller holds clients_mutex_)")
+        lines.append("    void touchClient(const std::string& key, const struct sockaddr_in& addr) {")
+        lines.append("        auto now = std::chrono::steady_clock::now();")
+        lines.append("        clients_[key] = addr;")
+        lines.append("        client_seen_[key] = now;")
+        lines.append("        if (now - last_sweep_ < std::chrono::seconds(1)) return;")
+        lines.append("        last_sweep_ = now;")
+        lines.append("        for (auto it = channel_tokens_.begin(); it != channel_tokens_.end();) {")
+        lines.append("            if (now - it->second.issued > std::chrono::seconds(10)) it = channel_tokens_.erase(it);")
+        lines.append("            else ++it;")
+        lines.append("        }")
+        lines.append("        if (client_timeout_.count() == 0) return;")
+        lines.append("        std::vector<std::string> idle;")
+        lines.append("        for (const auto& seen : client_seen_) {")
+        lines.append("            if (now - seen.second > client_timeout_) idle.push_back(seen.first);")
+        lines.append("        }")
+        lines.append("        for (const auto& idle_key : idle) dropClient(idle_key);")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    // Encoding a client agreed to in MSG_CTRL_HELLO, 0 if it never negotiated")
+        lines.append("    // (caller holds clients_mutex_)")
+        lines.append("    uint8_t clientWireFlags(const std::string& key) const {")
+        lines.append("        auto it = client_wire_flags_.find(key);")
+        lines.append("        return it != client_wire_flags_.end() ? it->second : 0;")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    // The first count entries of push_frames_ hold the frames of the current broadcast")
+        lines.append("    const PushFrame* findPushFrame(uint8_t flags, size_t count) const {")
+        lines.append("        for (size_t i = 0; i < count; i++) {")
+        lines.append("            if (push_frames_[i].flags == flags) return &push_frames_[i];")
+        lines.append("        }")
+        lines.append("        return nullptr;")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    // Forget a client and its callback route (caller holds clients_mutex_)")
+        lines.append("    void dropClient(const std::string& key) {")
+        lines.append("        clients_.erase(key);")
+        lines.append("        callback_routes_.erase(key);")
+        lines.append("        client_seen_.erase(key);")
+        lines.append("        client_wire_flags_.erase(key);")
+        lines.append("        channel_tokens_.erase(key);")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    // Send a control message built in buffer to addr")
+        lines.append("    void sendControl(const ByteBuffer& buffer, const struct sockaddr_in* addr) {")
+        lines.append("        uint8_t frame[FRAME_MAX_BYTES];")
+        lines.append("        size_t frame_size = encodeFrame(buffer, FRAME_MAX_BYTES, frame);")
+        lines.append("        sendto(sockfd_, frame, frame_size, 0, (const struct sockaddr*)addr, sizeof(*addr));")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    // Runtime control messages; returns false for regular IDL requests")
+        lines.append("    bool handleControlMessage(struct sockaddr_in* from_addr, const uint8_t* data, size_t data_size) {")
+        lines.append("        ByteReader reader(data, data_size);")
+        lines.append("        uint32_t msg_id = reader.readMsgId();")
+        if has_streams:
+            lines.append("        if (msg_id == MSG_CTRL_STREAM_CREDIT) {")
+            lines.append("            if (!reader.canRead(8)) return true;")
+            lines.append("            uint32_t stream_id = reader.readUint32();")
+            lines.append("            uint32_t credit = reader.readUint32();")
+            lines.append("            std::lock_guard<std::mutex> lock(streams_mutex_);")
+            lines.append("            auto it = streams_.find(clientKey(*from_addr) + \"/\" + std::to_string(stream_id));")
+            lines.append("            if (it != streams_.end()) it->second.stream->addCredit(credit);")
+            lines.append("            return true;")
+            lines.append("        }")
+        lines.append("        if (msg_id == MSG_CTRL_HELLO) {")
+        lines.append("            if (!reader.canRead(1)) return true;")
+        lines.append("            uint8_t ack[9] = {0, 0, 0, 5};")
+        lines.append("            ack[4] = (MSG_CTRL_HELLO_ACK >> 24) & 0xFF;")
+        lines.append("            ack[5] = (MSG_CTRL_HELLO_ACK >> 16) & 0xFF;")
+        lines.append("            ack[6] = (MSG_CTRL_HELLO_ACK >> 8) & 0xFF;")
+        lines.append("            ack[7] = MSG_CTRL_HELLO_ACK & 0xFF;")
+        lines.append("            ack[8] = reader.readUint8() & accepted_wire_flags_;")
+        lines.append("            {")
+        lines.append("                // Callbacks pushed to this client use the same encoding")
+        lines.append("                std::lock_guard<std::mutex> lock(clients_mutex_);")
+        lines.append("                if (ack[8]) client_wire_flags_[clientKey(*from_addr)] = ack[8];")
+        lines.append("                else client_wire_flags_.erase(clientKey(*from_addr));")
+        lines.append("            }")
+        lines.append("            sendto(sockfd_, ack, sizeof(ack), 0, (struct sockaddr*)from_addr, sizeof(*from_addr));")
+        lines.append("            return true;")
+        lines.append("        }")
+        lines.append("        if (msg_id == MSG_CTRL_CALLBACK_TOKEN_REQ) {")
+        lines.append("            // Answered on the RPC socket it came from: only that socket's owner sees the token")
+        lines.append("            ByteBuffer reply;")
+        lines.append("            reply.writeMsgId(MSG_CTRL_CALLBACK_TOKEN);")
+        lines.append("            {")
+        lines.append("                std::lock_guard<std::mutex> lock(clients_mutex_);")
+        lines.append("                std::string key = clientKey(*from_addr);")
+        lines.append("                if (channel_tokens_.size() >= kMaxPendingTokens && !channel_tokens_.count(key)) return true;")
+        lines.append("                ChannelToken token = {token_rng_(), std::chrono::steady_clock::now()};")
+        lines.append("                channel_tokens_[key] = token;")
+        lines.append("                reply.writeUint64(token.value);")
+        lines.append("            }")
+        lines.append("            sendControl(reply, from_addr);")
+        lines.append("            return true;")
+        lines.append("        }")
+        lines.append("        if (msg_id == MSG_CTRL_BYE) {")
+        lines.append("            std::lock_guard<std::mutex> lock(clients_mutex_);")
+        lines.append("            dropClient(clientKey(*from_addr));")
+        lines.append("            return true;")
+        lines.append("        }")
+        lines.append("        if (msg_id != MSG_CTRL_CALLBACK_CHANNEL_REQ) return false;")
+        lines.append("        if (!reader.canRead(10)) return true;")
+        lines.append("")
+        lines.append("        // The client announces its RPC socket port from its callback socket, with the")
+        lines.append("        // token the server issued to that RPC socket; anything else is ignored")
+        lines.append("        struct sockaddr_in rpc_addr = *from_addr;")
+        lines.append("        rpc_addr.sin_port = htons(reader.readUint16());")
+        lines.append("        uint64_t token = reader.readUint64();")
+        lines.append("        {")
+        lines.append("            std::lock_guard<std::mutex> lock(clients_mutex_);")
+        lines.append("            std::string key = clientKey(rpc_addr);")
+        lines.append("            auto issued = channel_tokens_.find(key);")
+        lines.append("            if (issued == channel_tokens_.end() || issued->second.value != token) return true;")
+        lines.append("            channel_tokens_.erase(issued);")
+        lines.append("            touchClient(key, rpc_addr);")
+        lines.append("            callback_routes_[key] = *from_addr;")
+        lines.append("        }")
+        lines.append("")
+        lines.append("        uint8_t ack[8] = {0, 0, 0, 4};")
+        lines.append("        ack[4] = (MSG_CTRL_CALLBACK_CHANNEL_ACK >> 24) & 0xFF;")
+        lines.append("        ack[5] = (MSG_CTRL_CALLBACK_CHANNEL_ACK >> 16) & 0xFF;")
+        lines.append("        ack[6] = (MSG_CTRL_CALLBACK_CHANNEL_ACK >> 8) & 0xFF;")
+        lines.append("        ack[7] = MSG_CTRL_CALLBACK_CHANNEL_ACK & 0xFF;")
+        lines.append("        sendto(sockfd_, ack, sizeof(ack), 0, (struct sockaddr*)from_addr, sizeof(*from_addr));")
+        lines.append("        return true;")
+        lines.append("    }")
+        lines.append("")
+        if batch_pairs:
+            lines.extend(self._generate_batching_helpers(batch_pairs))
+            lines.append("")
+        if has_streams:
+            lines.extend(self._generate_stream_helpers())
+            lines.append("")
+        lines.append("    void handleClientRequest(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {")
         lines.append("        // Parse message ID from data")
         lines.append("        if (data_size < 4) return;")
         lines.append("        ")
@@ -2430,6 +6014,10 @@ public:
                 lines.append(f"                case MSG_{method.name.upper()}_REQ:")
                 lines.append(f"                    handle_{method.name}(client_addr, data, data_size);")
                 lines.append("                    break;")
+                if self._stream_param(method):
+                    lines.append(f"                case MSG_{method.name.upper()}_CHUNK:")
+                    lines.append("                    routeStreamChunk(client_addr, data, data_size);")
+                    lines.append("                    break;")
         
         lines.append("                default:")
         lines.append("                    break;")
@@ -2464,17 +6052,124 @@ public:
         
         return "\n".join(lines)
     
+    def _generate_stream_helpers(self) -> List[str]:
+        """生成服务端流式调用的线程管理（startStream / stopStreams）"""
+        lines = []
+        lines.append("    // Run a stream handler on its own thread so run() keeps routing credit")
+        lines.append("    void startStream(const std::string& key, std::shared_ptr<StreamBase> stream,")
+        lines.append("                     std::function<void()> body) {")
+        lines.append("        std::lock_guard<std::mutex> lock(streams_mutex_);")
+        lines.append("        // Reap streams whose handler has returned")
+        lines.append("        for (auto it = streams_.begin(); it != streams_.end();) {")
+        lines.append("            if (it->second.stream->done()) {")
+        lines.append("                if (it->second.thread.joinable()) it->second.thread.join();")
+        lines.append("                it = streams_.erase(it);")
+        lines.append("            } else {")
+        lines.append("                ++it;")
+        lines.append("            }")
+        lines.append("        }")
+        lines.append("        if (streams_.count(key)) return;  // Duplicate request")
+        lines.append("        ActiveStream& active = streams_[key];")
+        lines.append("        active.stream = stream;")
+        lines.append("        active.thread = spawnThread(\"stream\", body);")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    // Hand a client-stream chunk to the handler reading it")
+        lines.append("    void routeStreamChunk(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {")
+        lines.append("        if (data_size < 8) return;  // msg_id + smallest (compact) StreamChunkHeader")
+        lines.append("        ByteReader reader(data, data_size, request_wire_flags_);")
+        lines.append("        StreamChunkHeader header;")
+        lines.append("        header.deserialize(reader);")
+        lines.append("        std::lock_guard<std::mutex> lock(streams_mutex_);")
+        lines.append("        auto it = streams_.find(clientKey(*client_addr) + \"/\" + std::to_string(header.stream_id));")
+        lines.append("        if (it != streams_.end()) it->second.stream->pushChunk(data, data_size);")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    // Cancel running stream handlers and wait for their threads")
+        lines.append("    void stopStreams() {")
+        lines.append("        std::map<std::string, ActiveStream> streams;")
+        lines.append("        {")
+        lines.append("            std::lock_guard<std::mutex> lock(streams_mutex_);")
+        lines.append("            streams.swap(streams_);")
+        lines.append("        }")
+        lines.append("        for (auto& pair : streams) {")
+        lines.append("            pair.second.stream->cancel();")
+        lines.append("        }")
+        lines.append("        for (auto& pair : streams) {")
+        lines.append("            if (pair.second.thread.joinable()) pair.second.thread.join();")
+        lines.append("        }")
+        lines.append("    }")
+        return lines
+    
+    def _generate_server_stream_handler(self, method: IDLMethod) -> str:
+        """生成流式方法的服务端处理：在独立线程上调用用户实现并逐块发送"""
+        elem_type = self.map_type(method.return_type)
+        call_params = [f"request->{param.name}" for param in method.parameters]
+        call_params.append("*writer")
+        
+        lines = []
+        lines.append(f"    void handle_{method.name}(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {{")
+        lines.append(f"        auto request = std::make_shared<{method.name}Request>();")
+        lines.append("        ByteReader reader(data, data_size, request_wire_flags_);")
+        lines.append("        request->deserialize(reader);")
+        lines.append("")
+        lines.append(f"        auto writer = std::make_shared<StreamWriter<{elem_type}>>(")
+        lines.append(f"            sockfd_, *client_addr, MSG_{method.name.upper()}_RESP, request->stream_id, request->credit,")
+        lines.append(f"            [](ByteBuffer& buffer, const {elem_type}& item) {{ {self._encode_item_stmt(method.return_type, 'item')} }});")
+        lines.append("        writer->setWireFormat(request_wire_flags_, compress_threshold_);")
+        lines.append("        writer->setMaxDelay(std::chrono::milliseconds(request->max_delay_ms));")
+        lines.append("        startStream(clientKey(*client_addr) + \"/\" + std::to_string(request->stream_id), writer,")
+        lines.append("                    [this, request, writer]() {")
+        lines.append(f"                        on{method.name}({', '.join(call_params)});")
+        lines.append("                        writer->finish();")
+        lines.append("                    });")
+        lines.append("    }")
+        return "\n".join(lines)
+    
     def _generate_server_handler(self, method: IDLMethod) -> str:
         """生成服务端消息处理方法（UDP版本）"""
+        if method.is_stream:
+            return self._generate_server_stream_handler(method)
+        stream_param = self._stream_param(method)
         lines = []
         
-        lines.append(f"    void handle_{method.name}(struct sockaddr_in* client_addr, uint8_t* data, size_t data_size) {{")
-        lines.append(f"        {method.name}Request request;")
-        lines.append("        ByteReader reader(data, data_size);")
-        lines.append("        request.deserialize(reader);")
-        lines.append("")
+        if stream_param:
+            # 客户端流式参数：在独立线程上读取分块并调用用户实现，读完后再回复
+            elem_type = self.map_type(stream_param.type_name)
+            lines.append(f"    void handle_{method.name}(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {{")
+            lines.append(f"        auto request = std::make_shared<{method.name}Request>();")
+            lines.append("        ByteReader reader(data, data_size, request_wire_flags_);")
+            lines.append("        request->deserialize(reader);")
+            lines.append("")
+            lines.append(f"        auto {stream_param.name} = std::make_shared<StreamReader<{elem_type}>>(")
+            lines.append("            sockfd_, *client_addr, request->stream_id, request->credit,")
+            lines.append(f"            [](ByteReader& reader, {elem_type}& item) {{ {self._decode_item_stmt(stream_param.type_name, 'item')} }});")
+            lines.append(f"        {stream_param.name}->setWireFormat(request_wire_flags_, compress_threshold_);")
+            lines.append("        struct sockaddr_in client = *client_addr;")
+            lines.append(f"        startStream(clientKey(client) + \"/\" + std::to_string(request->stream_id), {stream_param.name},")
+            lines.append(f"                    [this, request, {stream_param.name}, client]() {{")
+            lines.append(f"                        finish_{method.name}(&client, *request, *{stream_param.name});")
+            lines.append(f"                        {stream_param.name}->markDone();")
+            lines.append("                    });")
+            lines.append("    }")
+            lines.append("")
+            lines.append(f"    void finish_{method.name}(const struct sockaddr_in* client_addr, {method.name}Request& request,")
+            lines.append(f"                   StreamReader<{elem_type}>& {stream_param.name}) {{")
+        else:
+            # 视图解码模式：字符串参数直接指向接收缓冲区，不再逐个分配
+            request_type = f"{method.name}RequestView" if self._uses_request_view(method) else f"{method.name}Request"
+            lines.append(f"    void handle_{method.name}(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {{")
+            if self._uses_arena(method):
+                # arena 模式：请求的所有容器都从 arena 分配，处理函数返回、请求析构后一次性归还
+                lines.append("        RequestArena::Scope arena_scope(request_arena_);  // Outlives the request below")
+                lines.append(f"        {request_type} request(request_arena_.resource());")
+            else:
+                lines.append(f"        {request_type} request;")
+            lines.append("        ByteReader reader(data, data_size, request_wire_flags_);")
+            lines.append("        request.deserialize(reader);")
+            lines.append("")
         
-        has_response = method.return_type != 'void' or any(p.direction in ['out', 'inout'] for p in method.parameters)
+        has_response = self._has_response(method)
         
         if has_response:
             lines.append(f"        {method.name}Response response;")
@@ -2485,7 +6180,10 @@ public:
             for param in method.parameters:
                 cpp_type = self.map_type(param.type_name)
                 
-                if param.direction == 'in':
+                if param.is_stream:
+                    # 流式参数：传入 StreamReader
+                    call_params.append(param.name)
+                elif param.direction == 'in':
                     # in参数：从request读取
                     call_params.append(f"request.{param.name}")
                 elif param.direction == 'out':
@@ -2493,7 +6191,9 @@ public:
                     call_params.append(f"response.{param.name}")
                 elif param.direction == 'inout':
                     # inout参数：从request复制到response，然后传递response的引用
-                    lines.append(f"        response.{param.name} = request.{param.name};")
+                    assign = self._assign_stmt(method, f"response.{param.name}", f"request.{param.name}",
+                                               self._field_cpp_type(param), move=True)
+                    lines.append(f"        {assign}")
                     call_params.append(f"response.{param.name}")
             
             # 调用用户实现的方法
@@ -2502,23 +6202,31 @@ public:
             else:
                 lines.append(f"        on{method.name}({', '.join(call_params)});")
             
+            if stream_param:
+                lines.append("")
+                lines.append("        // Let the upload finish even if the handler stopped reading early")
+                lines.append(f"        {stream_param.name}.drain();")
+                if not any(p.name == 'status' and p.direction in ['out', 'inout'] for p in method.parameters):
+                    lines.append(f"        if (!{stream_param.name}.complete()) response.status = -1;")
+            
             lines.append("")
             lines.append("        // Serialize and send response via UDP")
-            lines.append("        ByteBuffer buffer;")
+            lines.append("        PooledByteBuffer pooled;")
+            lines.append("        ByteBuffer& buffer = *pooled;")
+            if not stream_param:
+                # 应答与请求使用相同编码；流式上传的应答在处理线程上发送，保持默认编码
+                lines.append("        buffer.setWireFlags(request_wire_flags_);")
             lines.append("        response.serialize(buffer);")
             lines.append("        ")
-            lines.append("        // Prepare datagram: size(4) + data")
-            lines.append("        uint32_t resp_size = buffer.size();")
-            lines.append("        uint8_t send_buffer[65536];")
-            lines.append("        send_buffer[0] = (resp_size >> 24) & 0xFF;")
-            lines.append("        send_buffer[1] = (resp_size >> 16) & 0xFF;")
-            lines.append("        send_buffer[2] = (resp_size >> 8) & 0xFF;")
-            lines.append("        send_buffer[3] = resp_size & 0xFF;")
-            lines.append("        memcpy(send_buffer + 4, buffer.data(), resp_size);")
+            lines.append("        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)")
+            lines.append("        uint8_t send_buffer[FRAME_MAX_BYTES];")
+            lines.append("        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);")
             lines.append("        ")
             lines.append("        // Send response datagram to client")
-            lines.append("        sendto(sockfd_, send_buffer, resp_size + 4, 0,")
-            lines.append("               (struct sockaddr*)client_addr, sizeof(*client_addr));")
+            lines.append("        if (frame_size > 0) {")
+            lines.append("            sendto(sockfd_, send_buffer, frame_size, 0,")
+            lines.append("                   (struct sockaddr*)client_addr, sizeof(*client_addr));")
+            lines.append("        }")
         else:
             # 无响应的方法
             call_params = []
@@ -2538,41 +6246,151 @@ public:
         lines = []
         
         # 生成推送方法签名（UDP版本不需要exclude_fd）
-        params = []
-        for param in method.parameters:
-            cpp_type = self.map_type(param.type_name)
-            if param.is_array:
-                if param.array_size:
-                    params.append(f"const {cpp_type} {param.name}[{param.array_size}]")
-                else:
-                    params.append(f"const std::vector<{cpp_type}>& {param.name}")
-            else:
-                if cpp_type == 'std::string':
-                    params.append(f"const {cpp_type}& {param.name}")
-                else:
-                    params.append(f"{cpp_type} {param.name}")
-        
-        lines.append(f"    void push_{method.name}({', '.join(params)}) {{")
-        lines.append(f"        // Prepare callback request")
-        lines.append(f"        {method.name}Request request;")
-        
-        # 填充请求参数
-        for param in method.parameters:
-            cpp_type = self.map_type(param.type_name)
-            if param.is_array and not param.array_size:
-                lines.append(f"        request.{param.name} = {param.name};")
-            elif param.is_array and param.array_size:
-                lines.append(f"        memcpy(request.{param.name}, {param.name}, sizeof(request.{param.name}));")
-            else:
-                lines.append(f"        request.{param.name} = {param.name};")
+        params = [self._in_param_decl(p) for p in method.parameters]
         
-        lines.append("")
-        lines.append(f"        // Broadcast callback to all known clients via UDP")
-        lines.append(f"        broadcast(request);")
+        lines.append("    // False if the callback does not fit in one datagram (nothing is sent)")
+        lines.append(f"    bool push_{method.name}({', '.join(params)}) {{")
+        if 'batch' in method.annotations:
+            param = method.parameters[0]
+            lines.append(f"        // Accumulate into {method.annotations['batch'][0]} while a batch window is set")
+            lines.append("        {")
+            lines.append("            std::lock_guard<std::mutex> lock(batch_mutex_);")
+            lines.append("            if (batching_) {")
+            lines.append(f"                pending_{method.name}_.push_back({param.name});")
+            lines.append("                batch_cv_.notify_one();")
+            lines.append("                return true;")
+            lines.append("            }")
+            lines.append("        }")
+            lines.append("")
+        if not self._direct_request(method):
+            lines.append(f"        // Prepare callback request")
+            lines.append(f"        {method.name}Request request;")
+            
+            # 填充请求参数
+            for param in method.parameters:
+                assign = self._assign_stmt(method, f"request.{param.name}", param.name, self._field_cpp_type(param))
+                lines.append(f"        {assign}")
+            
+            lines.append("")
+            lines.append(f"        // Broadcast callback to all known clients via UDP")
+            lines.append(f"        return broadcast(request);")
+        else:
+            # 参数直接序列化进广播缓冲区，不复制进 Request
+            args = ", ".join(p.name for p in method.parameters)
+            lines.append(f"        // Broadcast callback to all known clients via UDP, serialized straight from the arguments")
+            lines.append("        return broadcastEncoded([&](ByteBuffer& buffer) {")
+            lines.append(f"            buffer.writeMsgId(MSG_{method.name.upper()}_REQ);")
+            if args:
+                lines.append(f"            {method.name}Request::serializeFields(buffer, {args});")
+            lines.append("        });")
         lines.append("    }")
         
         return "\n".join(lines)
     
+    def _batch_pairs(self) -> List[Tuple[IDLMethod, IDLMethod]]:
+        """返回 (单项回调, 批量回调) 对，由 @batch 注解声明"""
+        methods = {m.name: m for m in self.interface.methods}
+        return [(m, methods[m.annotations['batch'][0]])
+                for m in self.interface.methods
+                if m.is_callback and 'batch' in m.annotations]
+    
+    def _generate_batching_methods(self, batch_pairs: List[Tuple[IDLMethod, IDLMethod]]) -> List[str]:
+        """生成回调批量推送的控制方法和后台刷新线程"""
+        lines = []
+        lines.append("    // Enable callback batching: per-item pushes accumulate for `window` and go")
+        lines.append("    // out as batch callbacks of at most `max_events` items, split further so that")
+        lines.append("    // each one fits in a datagram.")
+        lines.append("    // A zero window disables batching and every push is sent immediately.")
+        lines.append("    void setBatchWindow(std::chrono::milliseconds window, size_t max_events = 256) {")
+        lines.append("        stopBatching();")
+        lines.append("        if (window.count() <= 0) return;")
+        lines.append("        {")
+        lines.append("            std::lock_guard<std::mutex> lock(batch_mutex_);")
+        lines.append("            batch_window_ = window;")
+        lines.append("            batch_max_events_ = max_events > 0 ? max_events : 1;")
+        lines.append("            batching_ = true;")
+        lines.append("        }")
+        lines.append("        batch_thread_ = spawnThread(\"batch\", [this]() { batchLoop(); });")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    // Send all accumulated events now")
+        lines.append("    void flushBatches() {")
+        lines.append("        std::lock_guard<std::mutex> flush_lock(batch_flush_mutex_);")
+        for source, target in batch_pairs:
+            elem_type = self.map_type(source.parameters[0].type_name)
+            lines.append(f"        std::vector<{elem_type}> {source.name}_events;")
+        lines.append("        size_t max_events;")
+        lines.append("        {")
+        lines.append("            std::lock_guard<std::mutex> lock(batch_mutex_);")
+        for source, target in batch_pairs:
+            lines.append(f"            {source.name}_events.swap(pending_{source.name}_);")
+        lines.append("            max_events = batch_max_events_;")
+        lines.append("        }")
+        for source, target in batch_pairs:
+            events = f"{source.name}_events"
+            lines.append(f"        for (size_t i = 0; i < {events}.size(); i += max_events) {{")
+            lines.append(f"            sendBatch_{target.name}({events}, i, std::min({events}.size(), i + max_events));")
+            lines.append("        }")
+        lines.append("    }")
+        return lines
+    
+    def _generate_batching_helpers(self, batch_pairs: List[Tuple[IDLMethod, IDLMethod]]) -> List[str]:
+        """生成批量推送的内部辅助方法（private 部分）"""
+        lines = []
+        for source, target in batch_pairs:
+            elem_type = self.map_type(source.parameters[0].type_name)
+            lines.append(f"    // Push events[begin, end) as {target.name} callbacks, halving any slice whose")
+            lines.append("    // encoding exceeds one datagram; a single event that does not fit is dropped")
+            lines.append(f"    void sendBatch_{target.name}(const std::vector<{elem_type}>& events, size_t begin, size_t end) {{")
+            lines.append(f"        bool sent = begin == 0 && end == events.size()")
+            lines.append(f"            ? push_{target.name}(events)  // Whole batch: no slice copy")
+            lines.append(f"            : push_{target.name}(std::vector<{elem_type}>(events.begin() + begin, events.begin() + end));")
+            lines.append("        if (sent) return;")
+            lines.append("        if (end - begin == 1) {")
+            lines.append(f"            std::cerr << \"[Server] {source.name} event larger than one datagram dropped\" << std::endl;")
+            lines.append("            return;")
+            lines.append("        }")
+            lines.append("        size_t middle = begin + (end - begin) / 2;")
+            lines.append(f"        sendBatch_{target.name}(events, begin, middle);")
+            lines.append(f"        sendBatch_{target.name}(events, middle, end);")
+            lines.append("    }")
+            lines.append("")
+        lines.append("    void stopBatching() {")
+        lines.append("        {")
+        lines.append("            std::lock_guard<std::mutex> lock(batch_mutex_);")
+        lines.append("            batching_ = false;")
+        lines.append("        }")
+        lines.append("        batch_cv_.notify_all();")
+        lines.append("        if (batch_thread_.joinable()) {")
+        lines.append("            batch_thread_.join();")
+        lines.append("        }")
+        lines.append("        flushBatches();")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    bool hasPendingBatches() const {")
+        pending = " || ".join(f"!pending_{source.name}_.empty()" for source, _ in batch_pairs)
+        lines.append(f"        return {pending};")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    bool batchFull() const {")
+        full = " || ".join(f"pending_{source.name}_.size() >= batch_max_events_" for source, _ in batch_pairs)
+        lines.append(f"        return {full};")
+        lines.append("    }")
+        lines.append("")
+        lines.append("    void batchLoop() {")
+        lines.append("        std::unique_lock<std::mutex> lock(batch_mutex_);")
+        lines.append("        while (batching_) {")
+        lines.append("            batch_cv_.wait(lock, [this]() { return !batching_ || hasPendingBatches(); });")
+        lines.append("            if (!batching_) break;")
+        lines.append("            // Let the window fill so the events go out as one datagram")
+        lines.append("            batch_cv_.wait_for(lock, batch_window_, [this]() { return !batching_ || batchFull(); });")
+        lines.append("            lock.unlock();")
+        lines.append("            flushBatches();")
+        lines.append("            lock.lock();")
+        lines.append("        }")
+        lines.append("    }")
+        return lines
+    
     def _generate_virtual_method(self, method: IDLMethod) -> str:
         """生成虚函数声明"""
         cpp_return_type = self.map_type(method.return_type)
@@ -2580,26 +6398,24 @@ public:
         
         for param in method.parameters:
             cpp_type = self.map_type(param.type_name)
-            if param.direction == 'in':
-                if param.is_array:
-                    if param.array_size:
-                        params.append(f"const {cpp_type} {param.name}[{param.array_size}]")
-                    else:
-                        params.append(f"const std::vector<{cpp_type}>& {param.name}")
-                else:
-                    if cpp_type == 'std::string':
-                        params.append(f"const {cpp_type}& {param.name}")
-                    else:
-                        params.append(f"{cpp_type} {param.name}")
+            if param.is_stream:
+                # 客户端流式参数：通过 reader.read() 逐个读取，在独立线程上调用
+                params.append(f"StreamReader<{cpp_type}>& {param.name}")
+            elif self._view_param_decl(method, param):
+                # 视图解码模式：仅在调用期间有效
+                params.append(self._view_param_decl(method, param))
+            elif self._arena_param_decl(method, param):
+                # arena 模式：引用 arena 上的 std::pmr 容器，仅在调用期间有效
+                params.append(self._arena_param_decl(method, param))
+            elif param.direction == 'in':
+                params.append(self._in_param_decl(param))
             else:  # out 或 inout
-                if param.is_array:
-                    if param.array_size:
-                        params.append(f"{cpp_type} {param.name}[{param.array_size}]")
-                    else:
-                        params.append(f"std::vector<{cpp_type}>& {param.name}")
-                else:
-                    params.append(f"{cpp_type}& {param.name}")
+                params.append(self._out_param_decl(param))
         
+        if method.is_stream:
+            # 流式方法：通过 writer.write() 逐个产出元素，在独立线程上调用
+            params.append(f"StreamWriter<{cpp_return_type}>& writer")
+            return f"    virtual void on{method.name}({', '.join(params)}) = 0;"
         return f"    virtual {cpp_return_type} on{method.name}({', '.join(params)}) = 0;"
     
     def generate_client_example(self) -> str:
@@ -2676,31 +6492,31 @@ public:
             for param in method.parameters:
                 cpp_type = self.map_type(param.type_name)
                 
-                if param.direction == 'in':
-                    if param.is_array:
-                        if param.array_size:
-                            params.append(f"const {cpp_type} {param.name}[{param.array_size}]")
-                        else:
-                            params.append(f"const {cpp_type}& {param.name}")
-                    else:
-                        if param.type_name == 'string':
-                            params.append(f"const {cpp_type}& {param.name}")
-                        else:
-                            params.append(f"{cpp_type} {param.name}")
+                if param.is_stream:
+                    params.append(f"StreamReader<{cpp_type}>& {param.name}")
+                elif self._view_param_decl(method, param):
+                    params.append(self._view_param_decl(method, param))
+                elif self._arena_param_decl(method, param):
+                    params.append(self._arena_param_decl(method, param))
+                elif param.direction == 'in':
+                    params.append(self._in_param_decl(param))
                 else:
-                    if param.is_array:
-                        if param.array_size:
-                            params.append(f"{cpp_type} {param.name}[{param.array_size}]")
-                        else:
-                            params.append(f"{cpp_type}& {param.name}")
-                    else:
-                        params.append(f"{cpp_type}& {param.name}")
+                    params.append(self._out_param_decl(param))
             
+            if method.is_stream:
+                params.append(f"StreamWriter<{cpp_return_type}>& writer")
+                cpp_return_type = 'void'
             lines.append(f"    {cpp_return_type} on{method.name}({', '.join(params)}) override {{")
             lines.append(f"        // TODO: Implement {method.name}")
             lines.append('        std::cout << "' + method.name + ' called" << std::endl;')
             
-            if method.return_type != 'void':
+            stream_param = self._stream_param(method)
+            if stream_param:
+                elem_type = self.map_type(stream_param.type_name)
+                lines.append(f"        // {elem_type} item; while ({stream_param.name}.read(item)) {{ ... }}")
+            if method.is_stream:
+                lines.append("        // writer.write(item) for each result; returns false once the client is gone")
+            elif method.return_type != 'void':
                 if method.return_type == 'int':
                     lines.append("        return 0;")
                 elif method.return_type == 'bool':
@@ -2756,6 +6572,10 @@ def main():
     parser.add_argument("-n", "--namespace", default="ipc", help="C++命名空间 (默认: ipc)")
     parser.add_argument("--no-examples", action="store_true", help="不生成示例代码")
     parser.add_argument("--check-only", action="store_true", help="仅检查语法，不生成代码")
+    parser.add_argument("--view-decode", action="store_true",
+                        help="字符串参数/结果解码为指向接收缓冲区的 std::string_view（需要 C++17）")
+    parser.add_argument("--pmr-arena", action="store_true",
+                        help="请求结构使用 std::pmr 容器，服务端在每次处理后复位的 arena 上解码（需要 C++17）")
     
     args = parser.parse_args()
     
@@ -2888,7 +6708,8 @@ def main():
         related_observers = observer_interfaces.get(interface.name, [])
         
         # 生成代码，传递所有接口名称和关联的观察者
-        generator = CppSocketCodeGenerator(interface, module, args.namespace, all_interface_names, related_observers)
+        generator = CppSocketCodeGenerator(interface, module, args.namespace, all_interface_names, related_observers,
+                                           view_decode=args.view_decode, pmr_arena=args.pmr_arena)
         
         # 生成头文件
         header_code = generator.generate_header()
@@ -2912,7 +6733,8 @@ def main():
             print(f"   ✅ 生成: {server_file}")
     
     # 生成Makefile
-    makefile_content = generate_makefile(interfaces, args.namespace)
+    makefile_content = generate_makefile(interfaces, args.namespace,
+                                         cxx_std="c++17" if args.view_decode or args.pmr_arena else "c++11")
     makefile_path = os.path.join(output_dir, "Makefile")
     with open(makefile_path, 'w', encoding='utf-8') as f:
         f.write(makefile_content)
@@ -2926,13 +6748,13 @@ def main():
     return 0
 
 
-def generate_makefile(interfaces: List[IDLInterface], namespace: str) -> str:
+def generate_makefile(interfaces: List[IDLInterface], namespace: str, cxx_std: str = "c++11") -> str:
     """生成Makefile"""
     lines = []
     lines.append("# Makefile for IDL Socket Generated Code")
     lines.append("")
     lines.append("CXX = g++")
-    lines.append("CXXFLAGS = -std=c++11 -Wall -O2 -pthread")
+    lines.append(f"CXXFLAGS = -std={cxx_std} -Wall -O2 -pthread")
     lines.append("LDFLAGS = -pthread")
     lines.append("")
     lines.append("all: " + " ".join([f"{iface.name.lower()}_client {iface.name.lower()}_server" for iface in interfaces]))
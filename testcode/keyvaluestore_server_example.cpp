@@ -41,17 +41,36 @@ protected:
         std::cout << "clear called" << std::endl;
     }
 
-    int64_t onbatchSet(std::vector<KeyValue> items) override {
+    int64_t onbatchSet(const std::vector<KeyValue>& items) override {
         // TODO: Implement batchSet
         std::cout << "batchSet called" << std::endl;
         return int64_t();
     }
 
-    void onbatchGet(std::vector<std::string> keys, std::vector<std::string>& values, std::vector<OperationStatus>& status) override {
+    void onbatchGet(const std::vector<std::string>& keys, std::vector<std::string>& values, std::vector<OperationStatus>& status) override {
         // TODO: Implement batchGet
         std::cout << "batchGet called" << std::endl;
     }
 
+    std::unordered_map<std::string, std::string> onbatchGetMap(const std::vector<std::string>& keys) override {
+        // TODO: Implement batchGetMap
+        std::cout << "batchGetMap called" << std::endl;
+        return std::unordered_map<std::string, std::string>();
+    }
+
+    void onscan(const std::string& prefix, StreamWriter<KeyValue>& writer) override {
+        // TODO: Implement scan
+        std::cout << "scan called" << std::endl;
+        // writer.write(item) for each result; returns false once the client is gone
+    }
+
+    int64_t onload(StreamReader<KeyValue>& items) override {
+        // TODO: Implement load
+        std::cout << "load called" << std::endl;
+        // KeyValue item; while (items.read(item)) { ... }
+        return int64_t();
+    }
+
 };
 
 int main() {
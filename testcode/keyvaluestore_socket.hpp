@@ -1,62 +1,216 @@
 #ifndef KEYVALUESTORE_SOCKET_HPP
 #define KEYVALUESTORE_SOCKET_HPP
 
+#include <array>
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <cstdint>
 #include <cstring>
+#include <stdexcept>
+#include <type_traits>
 #include <memory>
 #include <functional>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <random>
 #include <chrono>
 #include <condition_variable>
 #include <queue>
 #include <algorithm>
 #include <iostream>
 #include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <errno.h>
+#if __cplusplus >= 201703L
+#include <string_view>
+#include <memory_resource>
+#endif
 
 namespace ipc {
 
 #ifndef IPC_BYTE_BUFFER_DEFINED
 #define IPC_BYTE_BUFFER_DEFINED
+// Wire encodings. The sender's choice travels in the top byte of each frame's
+// size prefix (frames never exceed 24 bits), so every frame decodes on its own;
+// a client only uses an encoding the server accepted (MSG_CTRL_HELLO), and the
+// server answers and pushes callbacks to it in that encoding.
+enum WireFlag : uint8_t {
+    WIRE_COMPACT = 0x01,     // LEB128 varints for integers and lengths, zigzag for signed
+    WIRE_NATIVE_LE = 0x02,   // Fixed-width values in little-endian order, copied with memcpy
+    WIRE_STRING_DICT = 0x04, // Repeated strings within a message are sent once, then by index
+    WIRE_LZ = 0x08,          // Large payloads may be LZ-compressed (FRAME_COMPRESSED frames)
+    WIRE_SPARSE = 0x10       // Structs carry a presence bitmap; default-valued fields are left out
+};
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+const uint8_t WIRE_SUPPORTED = WIRE_COMPACT | WIRE_NATIVE_LE | WIRE_STRING_DICT | WIRE_LZ | WIRE_SPARSE;
+#else
+const uint8_t WIRE_SUPPORTED = WIRE_COMPACT | WIRE_STRING_DICT | WIRE_LZ | WIRE_SPARSE;  // Native mode needs a little-endian host
+#endif
+// In WIRE_STRING_DICT mode a string's length prefix is (length << 1) for a literal,
+// or (index << 1) | 1 for a reference to an earlier literal of the same message.
+// Only literals of at least this many bytes enter the dictionary.
+const uint32_t WIRE_DICT_MIN_LENGTH = 4;
+
 // Serialization helpers
 class ByteBuffer {
 private:
     std::vector<uint8_t> data_;
+    uint8_t wire_flags_ = 0;
+    // WIRE_STRING_DICT: first occurrence (offset in data_, length) of each dictionary
+    // string, indexed by an open-addressing table of entry index + 1 (0 = empty)
+    std::vector<std::pair<uint32_t, uint32_t>> dict_entries_;
+    std::vector<uint32_t> dict_slots_;
 
-public:
-    void writeUint32(uint32_t value) {
+    void putFixed32(uint32_t value) {
         data_.push_back((value >> 24) & 0xFF);
         data_.push_back((value >> 16) & 0xFF);
         data_.push_back((value >> 8) & 0xFF);
         data_.push_back(value & 0xFF);
     }
 
+    void putVarint(uint64_t value) {
+        while (value >= 0x80) {
+            data_.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        data_.push_back(static_cast<uint8_t>(value));
+    }
+
+    template <typename T>
+    void putNative(T value) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        data_.insert(data_.end(), bytes, bytes + sizeof(T));
+    }
+
+    static uint32_t hashBytes(const char* bytes, size_t size) {
+        uint32_t hash = 2166136261u;  // FNV-1a
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ static_cast<uint8_t>(bytes[i])) * 16777619u;
+        }
+        return hash;
+    }
+
+    // Slot holding str, or the empty slot where it belongs
+    size_t dictSlot(const char* str, size_t len, uint32_t hash) const {
+        size_t mask = dict_slots_.size() - 1;
+        for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+            uint32_t entry = dict_slots_[slot];
+            if (entry == 0) return slot;
+            const std::pair<uint32_t, uint32_t>& known = dict_entries_[entry - 1];
+            if (known.second == len && std::memcmp(&data_[known.first], str, len) == 0) return slot;
+        }
+    }
+
+    void dictGrow() {
+        std::vector<uint32_t> slots(dict_slots_.empty() ? 64 : dict_slots_.size() * 2, 0);
+        dict_slots_.swap(slots);
+        for (size_t i = 0; i < dict_entries_.size(); i++) {
+            const char* known = reinterpret_cast<const char*>(&data_[dict_entries_[i].first]);
+            size_t len = dict_entries_[i].second;
+            dict_slots_[dictSlot(known, len, hashBytes(known, len))] = static_cast<uint32_t>(i + 1);
+        }
+    }
+
+    void putString(const char* str, size_t len) {
+        if (!(wire_flags_ & WIRE_STRING_DICT)) {
+            writeUint32(static_cast<uint32_t>(len));
+            data_.insert(data_.end(), str, str + len);
+            return;
+        }
+        size_t slot = 0;
+        if (len >= WIRE_DICT_MIN_LENGTH) {
+            if ((dict_entries_.size() + 1) * 2 > dict_slots_.size()) dictGrow();
+            slot = dictSlot(str, len, hashBytes(str, len));
+            if (dict_slots_[slot] != 0) {
+                writeUint32(((dict_slots_[slot] - 1) << 1) | 1);
+                return;
+            }
+        }
+        writeUint32(static_cast<uint32_t>(len) << 1);
+        size_t offset = data_.size();
+        data_.insert(data_.end(), str, str + len);
+        if (len >= WIRE_DICT_MIN_LENGTH) {
+            dict_entries_.push_back(std::make_pair(static_cast<uint32_t>(offset), static_cast<uint32_t>(len)));
+            dict_slots_[slot] = static_cast<uint32_t>(dict_entries_.size());
+        }
+    }
+
+    static uint64_t zigzag(int64_t value) {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    // Whether a numeric sequence can be copied as raw bytes in the current encoding
+    template <typename T>
+    bool bulkCopy() const {
+        if (sizeof(T) == 1) return true;
+        if (!(wire_flags_ & WIRE_NATIVE_LE)) return false;
+        return !((wire_flags_ & WIRE_COMPACT) && std::is_integral<T>::value);
+    }
+
+    void writeValue(int8_t value) { writeInt8(value); }
+    void writeValue(uint8_t value) { writeUint8(value); }
+    void writeValue(char value) { writeChar(value); }
+    void writeValue(int16_t value) { writeInt16(value); }
+    void writeValue(uint16_t value) { writeUint16(value); }
+    void writeValue(int32_t value) { writeInt32(value); }
+    void writeValue(uint32_t value) { writeUint32(value); }
+    void writeValue(int64_t value) { writeInt64(value); }
+    void writeValue(uint64_t value) { writeUint64(value); }
+    void writeValue(float value) { writeFloat(value); }
+    void writeValue(double value) { writeDouble(value); }
+
+public:
+    void setWireFlags(uint8_t flags) { wire_flags_ = flags; }
+    uint8_t wireFlags() const { return wire_flags_; }
+
+    // Message IDs stay 4-byte big-endian in every encoding so that frames can
+    // be routed before they are decoded
+    void writeMsgId(uint32_t id) {
+        putFixed32(id);
+    }
+
+    void writeUint32(uint32_t value) {
+        if (wire_flags_ & WIRE_COMPACT) return putVarint(value);
+        if (wire_flags_ & WIRE_NATIVE_LE) return putNative(value);
+        putFixed32(value);
+    }
+
     void writeInt32(int32_t value) {
-        writeUint32(static_cast<uint32_t>(value));
+        if (wire_flags_ & WIRE_COMPACT) return putVarint(zigzag(value));
+        if (wire_flags_ & WIRE_NATIVE_LE) return putNative(value);
+        putFixed32(static_cast<uint32_t>(value));
     }
     
     void writeUint64(uint64_t value) {
-        writeUint32(static_cast<uint32_t>(value >> 32));
-        writeUint32(static_cast<uint32_t>(value & 0xFFFFFFFF));
+        if (wire_flags_ & WIRE_COMPACT) return putVarint(value);
+        if (wire_flags_ & WIRE_NATIVE_LE) return putNative(value);
+        putFixed32(static_cast<uint32_t>(value >> 32));
+        putFixed32(static_cast<uint32_t>(value & 0xFFFFFFFF));
     }
     
     void writeInt64(int64_t value) {
+        if (wire_flags_ & WIRE_COMPACT) return putVarint(zigzag(value));
         writeUint64(static_cast<uint64_t>(value));
     }
     
     void writeUint16(uint16_t value) {
+        if (wire_flags_ & WIRE_COMPACT) return putVarint(value);
+        if (wire_flags_ & WIRE_NATIVE_LE) return putNative(value);
         data_.push_back((value >> 8) & 0xFF);
         data_.push_back(value & 0xFF);
     }
     
     void writeInt16(int16_t value) {
+        if (wire_flags_ & WIRE_COMPACT) return putVarint(zigzag(value));
         writeUint16(static_cast<uint16_t>(value));
     }
     
@@ -77,21 +231,22 @@ public:
     }
     
     void writeDouble(double value) {
+        if (wire_flags_ & WIRE_NATIVE_LE) return putNative(value);
         uint64_t bits;
         std::memcpy(&bits, &value, sizeof(double));
-        writeUint32(static_cast<uint32_t>(bits >> 32));
-        writeUint32(static_cast<uint32_t>(bits & 0xFFFFFFFF));
+        putFixed32(static_cast<uint32_t>(bits >> 32));
+        putFixed32(static_cast<uint32_t>(bits & 0xFFFFFFFF));
     }
     
     void writeFloat(float value) {
+        if (wire_flags_ & WIRE_NATIVE_LE) return putNative(value);
         uint32_t bits;
         std::memcpy(&bits, &value, sizeof(float));
-        writeUint32(bits);
+        putFixed32(bits);
     }
 
     void writeString(const std::string& str) {
-        writeUint32(str.size());
-        data_.insert(data_.end(), str.begin(), str.end());
+        putString(str.data(), str.size());
     }
 
     void writeStringVector(const std::vector<std::string>& vec) {
@@ -101,9 +256,243 @@ public:
         }
     }
 
+#if __cplusplus >= 201703L
+    // std::pmr containers used by --pmr-arena headers
+    void writeString(const std::pmr::string& str) {
+        putString(str.data(), str.size());
+    }
+
+    void writeStringVector(const std::pmr::vector<std::pmr::string>& vec) {
+        writeUint32(vec.size());
+        for (const auto& item : vec) {
+            writeString(item);
+        }
+    }
+#endif
+
+    void writeBytes(const uint8_t* bytes, size_t size) {
+        data_.insert(data_.end(), bytes, bytes + size);
+    }
+
+    // Room for count 4-byte big-endian values filled in later (@lazy offset tables)
+    size_t reserveFixed32(size_t count) {
+        size_t pos = data_.size();
+        data_.resize(pos + 4 * count);
+        return pos;
+    }
+
+    void patchFixed32(size_t pos, uint32_t value) {
+        data_[pos] = (value >> 24) & 0xFF;
+        data_[pos + 1] = (value >> 16) & 0xFF;
+        data_[pos + 2] = (value >> 8) & 0xFF;
+        data_[pos + 3] = value & 0xFF;
+    }
+
+    // WIRE_SPARSE presence bitmap: one bit per struct field, LSB-first, (count + 7) / 8 bytes
+    void writePresence(uint64_t bits, size_t count) {
+        for (size_t i = 0; i < count; i += 8) {
+            data_.push_back(static_cast<uint8_t>(bits >> i));
+        }
+    }
+
+    // Whether a scalar differs from its default; bitwise, so -0.0 is still sent
+    template <typename T>
+    static bool nonZero(T value) {
+        T zero = T();
+        return std::memcmp(&value, &zero, sizeof(T)) != 0;
+    }
+
+    // sequence<bool>: count, then the bits packed LSB-first, 64 per little-endian
+    // word (the last word is truncated to the bytes it needs)
+    template <typename Vector>
+    void writeBoolArray(const Vector& bits) {
+        size_t count = bits.size();
+        writeUint32(static_cast<uint32_t>(count));
+        size_t pos = data_.size();
+        data_.resize(pos + (count + 7) / 8);
+        for (size_t base = 0; base < count; base += 64) {
+            size_t n = count - base < 64 ? count - base : 64;
+            uint64_t word = 0;
+            for (size_t i = 0; i < n; i++) {
+                word |= static_cast<uint64_t>(bits[base + i] ? 1 : 0) << i;
+            }
+            for (size_t b = 0; b < (n + 7) / 8; b++) {
+                data_[pos + base / 8 + b] = static_cast<uint8_t>(word >> (8 * b));
+            }
+        }
+    }
+
+    // @delta field inside a sequence: zigzag varint of the difference to the
+    // previous element (wrapping), independent of the wire encoding
+    template <typename T>
+    void writeDelta(T value, T& previous) {
+        putVarint(zigzag(static_cast<int64_t>(static_cast<uint64_t>(value) - static_cast<uint64_t>(previous))));
+        previous = value;
+    }
+
+    // Sequence of structs with @delta fields; T::DeltaState carries the previous element
+    template <typename Vector>
+    void writeDeltaSequence(const Vector& items) {
+        typename Vector::value_type::DeltaState delta;
+        writeUint32(static_cast<uint32_t>(items.size()));
+        for (const auto& item : items) {
+            item.serialize(*this, &delta);
+        }
+    }
+
+    // Fixed-size structs travel as their packed record (T::Packed)
+    bool nativeRecords() const {
+        return (wire_flags_ & (WIRE_NATIVE_LE | WIRE_COMPACT)) == WIRE_NATIVE_LE;
+    }
+
+    // Sequence of fixed-size structs: count, then the records. In native mode the
+    // buffer grows once; a struct without padding is laid out exactly like its
+    // record, so the whole sequence is a single memcpy.
+    template <typename Vector>
+    void writeRecords(const Vector& items) {
+        typedef typename Vector::value_type T;
+        typedef typename T::Packed Packed;
+        writeUint32(static_cast<uint32_t>(items.size()));
+        if (!nativeRecords()) {
+            for (const auto& item : items) {
+                item.serialize(*this);
+            }
+            return;
+        }
+        size_t pos = data_.size();
+        data_.resize(pos + items.size() * sizeof(Packed));
+        if (items.empty()) return;
+        if (sizeof(T) == sizeof(Packed) && std::is_trivially_copyable<T>::value) {
+            std::memcpy(&data_[pos], &items[0], items.size() * sizeof(T));
+            return;
+        }
+        for (size_t i = 0; i < items.size(); i++) {
+            Packed record;
+            items[i].pack(record);
+            std::memcpy(&data_[pos + i * sizeof(Packed)], &record, sizeof(Packed));
+        }
+    }
+
+    // Numeric sequence: count, then the elements. Byte-sized elements, and all
+    // fixed-width elements in native little-endian mode, are a single memcpy.
+    template <typename T>
+    void writeArray(const T* items, size_t count) {
+        writeUint32(static_cast<uint32_t>(count));
+        writeFixedArray(items, count);
+    }
+
+    // Fixed-size array (IDL T name[N]): the elements only, both sides know N
+    template <typename T>
+    void writeFixedArray(const T* items, size_t count) {
+        if (bulkCopy<T>()) {
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(items);
+            data_.insert(data_.end(), bytes, bytes + count * sizeof(T));
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            writeValue(items[i]);
+        }
+    }
+
+    // One map key/value or BoundedSequence element, encoded like a message field of
+    // that type (sequences inside a map are written element by element)
+    void writeItem(bool value) { writeBool(value); }
+    void writeItem(const std::string& value) { writeString(value); }
+
+    template <typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value>::type writeItem(T value) { writeValue(value); }
+
+    template <typename T>
+    typename std::enable_if<std::is_enum<T>::value>::type writeItem(T value) {
+        writeInt32(static_cast<int32_t>(value));
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_class<T>::value>::type writeItem(const T& value) { value.serialize(*this); }
+
+    template <typename T, typename A>
+    void writeItem(const std::vector<T, A>& vec) {
+        writeUint32(static_cast<uint32_t>(vec.size()));
+        for (const auto& item : vec) writeItem(item);
+    }
+
+    template <typename K, typename V, typename H, typename E, typename A>
+    void writeItem(const std::unordered_map<K, V, H, E, A>& map) { writeMap(map); }
+
+    // map<K, V>: count, then key, value for each entry in the table's iteration order
+    template <typename Map>
+    void writeMap(const Map& map) {
+        writeUint32(static_cast<uint32_t>(map.size()));
+        for (const auto& entry : map) {
+            writeItem(entry.first);
+            writeItem(entry.second);
+        }
+    }
+
     const uint8_t* data() const { return data_.data(); }
     size_t size() const { return data_.size(); }
-    void clear() { data_.clear(); }
+    size_t capacity() const { return data_.capacity(); }
+    void reserve(size_t bytes) { data_.reserve(bytes); }
+    void clear() {
+        data_.clear();
+        if (!dict_entries_.empty()) {
+            dict_entries_.clear();
+            std::fill(dict_slots_.begin(), dict_slots_.end(), 0);
+        }
+    }
+};
+
+// Per-thread pool of serialization buffers. Buffers keep their grown capacity
+// when they come back, so steady-state calls serialize without allocating;
+// a buffer that grew past kTrimCapacity is freed instead of pooled.
+class ByteBufferPool {
+public:
+    static const size_t kInitialCapacity = 4096;
+    static const size_t kTrimCapacity = 256 * 1024;
+    static const size_t kMaxPooled = 8;
+
+    static std::unique_ptr<ByteBuffer> acquire() {
+        std::vector<std::unique_ptr<ByteBuffer>>& pool = threadPool();
+        if (pool.empty()) {
+            std::unique_ptr<ByteBuffer> buffer(new ByteBuffer());
+            buffer->reserve(kInitialCapacity);
+            return buffer;
+        }
+        std::unique_ptr<ByteBuffer> buffer = std::move(pool.back());
+        pool.pop_back();
+        return buffer;
+    }
+
+    static void release(std::unique_ptr<ByteBuffer> buffer) {
+        std::vector<std::unique_ptr<ByteBuffer>>& pool = threadPool();
+        if (!buffer || buffer->capacity() > kTrimCapacity || pool.size() >= kMaxPooled) return;
+        buffer->clear();
+        buffer->setWireFlags(0);
+        pool.push_back(std::move(buffer));
+    }
+
+private:
+    static std::vector<std::unique_ptr<ByteBuffer>>& threadPool() {
+        static thread_local std::vector<std::unique_ptr<ByteBuffer>> pool;
+        if (pool.capacity() < kMaxPooled) pool.reserve(kMaxPooled);
+        return pool;
+    }
+};
+
+// Scoped lease on a pooled buffer; returns it to the pool on destruction
+class PooledByteBuffer {
+public:
+    PooledByteBuffer() : buffer_(ByteBufferPool::acquire()) {}
+    ~PooledByteBuffer() { ByteBufferPool::release(std::move(buffer_)); }
+
+    ByteBuffer& operator*() { return *buffer_; }
+    ByteBuffer* operator->() { return buffer_.get(); }
+
+private:
+    PooledByteBuffer(const PooledByteBuffer&);
+    PooledByteBuffer& operator=(const PooledByteBuffer&);
+
+    std::unique_ptr<ByteBuffer> buffer_;
 };
 
 class ByteReader {
@@ -111,15 +500,10 @@ private:
     const uint8_t* data_;
     size_t size_;
     size_t pos_;
+    uint8_t wire_flags_;
+    std::vector<std::pair<uint32_t, uint32_t>> dict_;  // WIRE_STRING_DICT literals (offset, length)
 
-public:
-    ByteReader(const uint8_t* data, size_t size) : data_(data), size_(size), pos_(0) {}
-
-    bool canRead(size_t bytes) const {
-        return pos_ + bytes <= size_;
-    }
-
-    uint32_t readUint32() {
+    uint32_t getFixed32() {
         if (!canRead(4)) throw std::runtime_error("Buffer underflow");
         uint32_t value = (static_cast<uint32_t>(data_[pos_]) << 24) | 
                          (static_cast<uint32_t>(data_[pos_+1]) << 16) |
@@ -129,21 +513,144 @@ public:
         return value;
     }
 
+    uint64_t getVarint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (!canRead(1)) throw std::runtime_error("Buffer underflow");
+            uint8_t byte = data_[pos_++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw std::runtime_error("Malformed varint");
+    }
+
+    template <typename T>
+    T getNative() {
+        if (!canRead(sizeof(T))) throw std::runtime_error("Buffer underflow");
+        T value;
+        std::memcpy(&value, data_ + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return value;
+    }
+
+    // Locate the next string's bytes, resolving dictionary references
+    const char* getString(uint32_t& len) {
+        uint32_t prefix = readUint32();
+        if (!(wire_flags_ & WIRE_STRING_DICT)) {
+            len = prefix;
+        } else if (prefix & 1) {
+            uint32_t index = prefix >> 1;
+            if (index >= dict_.size()) throw std::runtime_error("Bad string reference");
+            len = dict_[index].second;
+            return reinterpret_cast<const char*>(data_ + dict_[index].first);
+        } else {
+            len = prefix >> 1;
+            if (len >= WIRE_DICT_MIN_LENGTH && canRead(len)) {
+                dict_.push_back(std::make_pair(static_cast<uint32_t>(pos_), len));
+            }
+        }
+        if (!canRead(len)) throw std::runtime_error("Buffer underflow");
+        const char* str = reinterpret_cast<const char*>(data_ + pos_);
+        pos_ += len;
+        return str;
+    }
+
+    static int64_t unzigzag(uint64_t value) {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    template <typename T>
+    bool bulkCopy() const {
+        if (sizeof(T) == 1) return true;
+        if (!(wire_flags_ & WIRE_NATIVE_LE)) return false;
+        return !((wire_flags_ & WIRE_COMPACT) && std::is_integral<T>::value);
+    }
+
+    void readValue(int8_t& value) { value = readInt8(); }
+    void readValue(uint8_t& value) { value = readUint8(); }
+    void readValue(char& value) { value = readChar(); }
+    void readValue(int16_t& value) { value = readInt16(); }
+    void readValue(uint16_t& value) { value = readUint16(); }
+    void readValue(int32_t& value) { value = readInt32(); }
+    void readValue(uint32_t& value) { value = readUint32(); }
+    void readValue(int64_t& value) { value = readInt64(); }
+    void readValue(uint64_t& value) { value = readUint64(); }
+    void readValue(float& value) { value = readFloat(); }
+    void readValue(double& value) { value = readDouble(); }
+
+public:
+    ByteReader(const uint8_t* data, size_t size, uint8_t wire_flags = 0)
+        : data_(data), size_(size), pos_(0), wire_flags_(wire_flags) {}
+
+    uint8_t wireFlags() const { return wire_flags_; }
+    void setWireFlags(uint8_t flags) { wire_flags_ = flags; }
+
+    bool canRead(size_t bytes) const {
+        return pos_ + bytes <= size_;
+    }
+
+    // Element count of a container whose entries take at least one byte each, checked
+    // against the remaining input before anything is reserved for it
+    uint32_t readCount() {
+        uint32_t count = readUint32();
+        if (!canRead(count)) throw std::runtime_error("Buffer underflow");
+        return count;
+    }
+
+    void skip(size_t bytes) {
+        if (!canRead(bytes)) throw std::runtime_error("Buffer underflow");
+        pos_ += bytes;
+    }
+
+    const uint8_t* cursor() const { return data_ + pos_; }
+
+    uint32_t readFixed32() {
+        return getFixed32();
+    }
+
+    uint64_t readPresence(size_t count) {
+        size_t bytes = (count + 7) / 8;
+        if (!canRead(bytes)) throw std::runtime_error("Buffer underflow");
+        uint64_t bits = 0;
+        for (size_t i = 0; i < bytes; i++) {
+            bits |= static_cast<uint64_t>(data_[pos_ + i]) << (8 * i);
+        }
+        pos_ += bytes;
+        return bits;
+    }
+
+    uint32_t readMsgId() {
+        return getFixed32();
+    }
+
+    uint32_t readUint32() {
+        if (wire_flags_ & WIRE_COMPACT) return static_cast<uint32_t>(getVarint());
+        if (wire_flags_ & WIRE_NATIVE_LE) return getNative<uint32_t>();
+        return getFixed32();
+    }
+
     int32_t readInt32() {
-        return static_cast<int32_t>(readUint32());
+        if (wire_flags_ & WIRE_COMPACT) return static_cast<int32_t>(unzigzag(getVarint()));
+        if (wire_flags_ & WIRE_NATIVE_LE) return getNative<int32_t>();
+        return static_cast<int32_t>(getFixed32());
     }
     
     uint64_t readUint64() {
-        uint32_t high = readUint32();
-        uint32_t low = readUint32();
+        if (wire_flags_ & WIRE_COMPACT) return getVarint();
+        if (wire_flags_ & WIRE_NATIVE_LE) return getNative<uint64_t>();
+        uint32_t high = getFixed32();
+        uint32_t low = getFixed32();
         return (static_cast<uint64_t>(high) << 32) | low;
     }
     
     int64_t readInt64() {
+        if (wire_flags_ & WIRE_COMPACT) return unzigzag(getVarint());
         return static_cast<int64_t>(readUint64());
     }
     
     uint16_t readUint16() {
+        if (wire_flags_ & WIRE_COMPACT) return static_cast<uint16_t>(getVarint());
+        if (wire_flags_ & WIRE_NATIVE_LE) return getNative<uint16_t>();
         if (!canRead(2)) throw std::runtime_error("Buffer underflow");
         uint16_t value = (static_cast<uint16_t>(data_[pos_]) << 8) | 
                          static_cast<uint16_t>(data_[pos_+1]);
@@ -152,6 +659,7 @@ public:
     }
     
     int16_t readInt16() {
+        if (wire_flags_ & WIRE_COMPACT) return static_cast<int16_t>(unzigzag(getVarint()));
         return static_cast<int16_t>(readUint16());
     }
     
@@ -175,29 +683,30 @@ public:
     }
     
     double readDouble() {
-        uint64_t bits = (static_cast<uint64_t>(readUint32()) << 32) | readUint32();
+        if (wire_flags_ & WIRE_NATIVE_LE) return getNative<double>();
+        uint64_t high = getFixed32();
+        uint64_t bits = (high << 32) | getFixed32();
         double value;
         std::memcpy(&value, &bits, sizeof(double));
         return value;
     }
     
     float readFloat() {
-        uint32_t bits = readUint32();
+        if (wire_flags_ & WIRE_NATIVE_LE) return getNative<float>();
+        uint32_t bits = getFixed32();
         float value;
         std::memcpy(&value, &bits, sizeof(float));
         return value;
     }
 
     std::string readString() {
-        uint32_t len = readUint32();
-        if (!canRead(len)) throw std::runtime_error("Buffer underflow");
-        std::string str(reinterpret_cast<const char*>(data_ + pos_), len);
-        pos_ += len;
-        return str;
+        uint32_t len;
+        const char* str = getString(len);
+        return std::string(str, len);
     }
 
     std::vector<std::string> readStringVector() {
-        uint32_t count = readUint32();
+        uint32_t count = readCount();
         std::vector<std::string> vec;
         vec.reserve(count);
         for (uint32_t i = 0; i < count; i++) {
@@ -206,120 +715,632 @@ public:
         return vec;
     }
 
-    size_t position() const { return pos_; }
-};
-#endif // IPC_BYTE_BUFFER_DEFINED
+    // Numeric sequence written by ByteBuffer::writeArray
+    template <typename Vector>
+    void readArrayInto(Vector& vec) {
+        typedef typename Vector::value_type T;
+        uint32_t count = readCount();
+        if (bulkCopy<T>() && !canRead(static_cast<size_t>(count) * sizeof(T))) {
+            throw std::runtime_error("Buffer underflow");
+        }
+        vec.resize(count);
+        if (count > 0) readFixedArray(&vec[0], count);
+    }
 
-// Message IDs
-const uint32_t MSG_SET_REQ = 1000;
-const uint32_t MSG_SET_RESP = 1001;
-const uint32_t MSG_GET_REQ = 1002;
-const uint32_t MSG_GET_RESP = 1003;
-const uint32_t MSG_REMOVE_REQ = 1004;
-const uint32_t MSG_REMOVE_RESP = 1005;
-const uint32_t MSG_EXISTS_REQ = 1006;
-const uint32_t MSG_EXISTS_RESP = 1007;
-const uint32_t MSG_COUNT_REQ = 1008;
-const uint32_t MSG_COUNT_RESP = 1009;
-const uint32_t MSG_CLEAR_REQ = 1010;
-const uint32_t MSG_BATCHSET_REQ = 1011;
-const uint32_t MSG_BATCHSET_RESP = 1012;
-const uint32_t MSG_BATCHGET_REQ = 1013;
-const uint32_t MSG_BATCHGET_RESP = 1014;
-const uint32_t MSG_ONKEYCHANGED_REQ = 1015;
-const uint32_t MSG_ONBATCHCHANGED_REQ = 1016;
-const uint32_t MSG_ONCONNECTIONSTATUS_REQ = 1017;
+    // Fixed-size array written by ByteBuffer::writeFixedArray
+    template <typename T>
+    void readFixedArray(T* items, size_t count) {
+        if (bulkCopy<T>()) {
+            readBytes(items, count * sizeof(T));
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            readValue(items[i]);
+        }
+    }
 
-#ifndef IPC_KEYVALUESERVICE_TYPES_DEFINED
-#define IPC_KEYVALUESERVICE_TYPES_DEFINED
-enum class OperationStatus {
-    SUCCESS,
-    KEY_NOT_FOUND,
-    INVALID_KEY,
-    ERROR
-};
+    bool nativeRecords() const {
+        return (wire_flags_ & (WIRE_NATIVE_LE | WIRE_COMPACT)) == WIRE_NATIVE_LE;
+    }
 
-enum class ChangeEventType {
-    KEY_ADDED,
-    KEY_UPDATED,
-    KEY_REMOVED,
-    STORE_CLEARED
-};
+    void readBytes(void* out, size_t size) {
+        if (!canRead(size)) throw std::runtime_error("Buffer underflow");
+        if (size > 0) std::memcpy(out, data_ + pos_, size);
+        pos_ += size;
+    }
 
-struct KeyValue {
-    std::string key;
-    std::string value;
+    // Sequence written by ByteBuffer::writeBoolArray
+    template <typename Vector>
+    void readBoolArrayInto(Vector& bits) {
+        uint32_t count = readUint32();
+        size_t bytes = (static_cast<size_t>(count) + 7) / 8;
+        if (!canRead(bytes)) throw std::runtime_error("Buffer underflow");
+        bits.resize(count);
+        for (size_t base = 0; base < count; base += 64) {
+            size_t n = count - base < 64 ? count - base : 64;
+            uint64_t word = 0;
+            for (size_t b = 0; b < (n + 7) / 8; b++) {
+                word |= static_cast<uint64_t>(data_[pos_ + base / 8 + b]) << (8 * b);
+            }
+            for (size_t i = 0; i < n; i++) {
+                bits[base + i] = (word >> i) & 1;
+            }
+        }
+        pos_ += bytes;
+    }
 
-    void serialize(ByteBuffer& buffer) const {
-        buffer.writeString(key);
-        buffer.writeString(value);
+    template <typename T>
+    T readDelta(T& previous) {
+        previous = static_cast<T>(static_cast<uint64_t>(previous) + static_cast<uint64_t>(unzigzag(getVarint())));
+        return previous;
     }
 
-    void deserialize(ByteReader& reader) {
-        key = reader.readString();
-        value = reader.readString();
+    // Sequence written by ByteBuffer::writeDeltaSequence
+    template <typename Vector>
+    void readDeltaSequenceInto(Vector& vec) {
+        typename Vector::value_type::DeltaState delta;
+        vec.resize(readCount());
+        for (auto& item : vec) {
+            item.deserialize(*this, &delta);
+        }
     }
-};
 
-struct ChangeEvent {
-    ChangeEventType eventType;
-    std::string key;
-    std::string oldValue;
-    std::string newValue;
-    int64_t timestamp;
+    // Sequence written by ByteBuffer::writeRecords
+    template <typename Vector>
+    void readRecordsInto(Vector& vec) {
+        typedef typename Vector::value_type T;
+        typedef typename T::Packed Packed;
+        uint32_t count = readCount();
+        if (!nativeRecords()) {
+            vec.resize(count);
+            for (auto& item : vec) {
+                item.deserialize(*this);
+            }
+            return;
+        }
+        size_t bytes = static_cast<size_t>(count) * sizeof(Packed);
+        if (!canRead(bytes)) throw std::runtime_error("Buffer underflow");
+        vec.resize(count);
+        if (count == 0) return;
+        if (sizeof(T) == sizeof(Packed) && std::is_trivially_copyable<T>::value) {
+            std::memcpy(&vec[0], data_ + pos_, bytes);
+        } else {
+            for (uint32_t i = 0; i < count; i++) {
+                Packed record;
+                std::memcpy(&record, data_ + pos_ + i * sizeof(Packed), sizeof(Packed));
+                vec[i].unpack(record);
+            }
+        }
+        pos_ += bytes;
+    }
 
-    void serialize(ByteBuffer& buffer) const {
-        buffer.writeInt32(static_cast<int32_t>(eventType));
-        buffer.writeString(key);
-        buffer.writeString(oldValue);
-        buffer.writeString(newValue);
-        buffer.writeInt64(timestamp);
+    // Decode into an existing string or vector, reusing its capacity and allocator
+    template <typename String>
+    void readStringInto(String& str) {
+        uint32_t len;
+        const char* bytes = getString(len);
+        str.assign(bytes, len);
     }
 
-    void deserialize(ByteReader& reader) {
-        eventType = static_cast<ChangeEventType>(reader.readInt32());
-        key = reader.readString();
-        oldValue = reader.readString();
-        newValue = reader.readString();
-        timestamp = reader.readInt64();
+    template <typename Vector>
+    void readStringVectorInto(Vector& vec) {
+        uint32_t count = readCount();
+        vec.resize(count);
+        for (auto& str : vec) {
+            readStringInto(str);
+        }
     }
-};
 
-#endif // IPC_KEYVALUESERVICE_TYPES_DEFINED
+    // Counterparts of ByteBuffer::writeItem
+    void readItem(bool& value) { value = readBool(); }
+    void readItem(std::string& value) { readStringInto(value); }
 
-// Message Structures
-struct setRequest {
-    uint32_t msg_id = MSG_SET_REQ;
-    std::string key;
-    std::string value;
+    template <typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value>::type readItem(T& value) { readValue(value); }
 
-    void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
-        buffer.writeString(key);
-        buffer.writeString(value);
+    template <typename T>
+    typename std::enable_if<std::is_enum<T>::value>::type readItem(T& value) {
+        value = static_cast<T>(readInt32());
     }
 
-    void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        key = reader.readString();
-        value = reader.readString();
-    }
-};
+    template <typename T>
+    typename std::enable_if<std::is_class<T>::value>::type readItem(T& value) { value.deserialize(*this); }
 
-struct setResponse {
-    uint32_t msg_id = MSG_SET_RESP;
-    int32_t status = 0;
-    bool return_value;
+    template <typename T, typename A>
+    void readItem(std::vector<T, A>& vec) {
+        vec.resize(readCount());
+        for (auto& item : vec) readItem(item);
+    }
 
-    void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
-        buffer.writeInt32(status);
-        buffer.writeBool(return_value);
+    template <typename A>
+    void readItem(std::vector<bool, A>& vec) {
+        vec.resize(readCount());
+        for (size_t i = 0; i < vec.size(); i++) vec[i] = readBool();
     }
 
-    void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        status = reader.readInt32();
+    template <typename K, typename V, typename H, typename E, typename A>
+    void readItem(std::unordered_map<K, V, H, E, A>& map) { readMapInto(map); }
+
+    // map<K, V> written by ByteBuffer::writeMap: the table is reserved once and
+    // each value is decoded in place in its node, with no intermediate vectors
+    template <typename Map>
+    void readMapInto(Map& map) {
+        uint32_t count = readCount();
+        map.clear();
+        map.reserve(count);
+        for (uint32_t i = 0; i < count; i++) {
+            typename Map::key_type key;
+            readItem(key);
+            readItem(map[std::move(key)]);
+        }
+    }
+
+#if __cplusplus >= 201703L
+    // Zero-copy variants: the views point into the buffer being read
+    std::string_view readStringView() {
+        uint32_t len;
+        const char* str = getString(len);
+        return std::string_view(str, len);
+    }
+
+    std::vector<std::string_view> readStringViewVector() {
+        uint32_t count = readCount();
+        std::vector<std::string_view> vec;
+        vec.reserve(count);
+        for (uint32_t i = 0; i < count; i++) {
+            vec.push_back(readStringView());
+        }
+        return vec;
+    }
+#endif
+
+    size_t position() const { return pos_; }
+};
+
+// sequence<T, N>: at most N elements stored inline, so filling or decoding one never
+// touches the allocator. Encoded like sequence<T> (count, then the elements); growing
+// past N, including decoding a longer sequence, throws std::length_error.
+template <typename T, size_t N>
+class BoundedSequence {
+public:
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    BoundedSequence() : size_(0) {}
+
+    explicit BoundedSequence(size_t count) : size_(0) {
+        resize(count);
+    }
+
+    BoundedSequence(std::initializer_list<T> items) : size_(0) {
+        assign(items.begin(), items.end());
+    }
+
+    static size_t capacity() { return N; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    T* data() { return items_; }
+    const T* data() const { return items_; }
+    iterator begin() { return items_; }
+    iterator end() { return items_ + size_; }
+    const_iterator begin() const { return items_; }
+    const_iterator end() const { return items_ + size_; }
+    T& operator[](size_t i) { return items_[i]; }
+    const T& operator[](size_t i) const { return items_[i]; }
+
+    void push_back(const T& item) {
+        if (size_ == N) throw std::length_error("BoundedSequence: bound exceeded");
+        items_[size_++] = item;
+    }
+
+    void resize(size_t count) {
+        if (count > N) throw std::length_error("BoundedSequence: bound exceeded");
+        for (size_t i = size_; i < count; i++) items_[i] = T();
+        size_ = count;
+    }
+
+    void reserve(size_t count) {
+        if (count > N) throw std::length_error("BoundedSequence: bound exceeded");
+    }
+
+    void clear() { size_ = 0; }
+
+    template <typename Iterator>
+    void assign(Iterator first, Iterator last) {
+        clear();
+        for (; first != last; ++first) push_back(*first);
+    }
+
+    bool operator==(const BoundedSequence& other) const {
+        return size_ == other.size_ && std::equal(begin(), end(), other.begin());
+    }
+    bool operator!=(const BoundedSequence& other) const { return !(*this == other); }
+
+    void serialize(ByteBuffer& buffer) const { serializeItems(buffer, Encoding()); }
+    void deserialize(ByteReader& reader) { deserializeItems(reader, Encoding()); }
+
+private:
+    // 0: bits (writeBoolArray), 1: numeric block (writeArray), 2: element by element
+    typedef std::integral_constant<int, std::is_same<T, bool>::value ? 0 :
+                                        std::is_arithmetic<T>::value ? 1 : 2> Encoding;
+
+    void serializeItems(ByteBuffer& buffer, std::integral_constant<int, 0>) const { buffer.writeBoolArray(*this); }
+    void serializeItems(ByteBuffer& buffer, std::integral_constant<int, 1>) const { buffer.writeArray(items_, size_); }
+    void serializeItems(ByteBuffer& buffer, std::integral_constant<int, 2>) const {
+        buffer.writeUint32(static_cast<uint32_t>(size_));
+        for (size_t i = 0; i < size_; i++) buffer.writeItem(items_[i]);
+    }
+
+    void deserializeItems(ByteReader& reader, std::integral_constant<int, 0>) { reader.readBoolArrayInto(*this); }
+    void deserializeItems(ByteReader& reader, std::integral_constant<int, 1>) { reader.readArrayInto(*this); }
+    void deserializeItems(ByteReader& reader, std::integral_constant<int, 2>) {
+        resize(reader.readUint32());
+        for (size_t i = 0; i < size_; i++) reader.readItem(items_[i]);
+    }
+
+    T items_[N];
+    size_t size_;
+};
+
+// Byte-oriented LZ77 in the LZ4 block layout: per sequence a token (literal
+// count << 4 | match length - 4, 15 = more length bytes follow), the literals,
+// then a 2-byte little-endian match offset. The last sequence has no match.
+class LzCodec {
+public:
+    // Returns the compressed size, or 0 if the output would exceed capacity
+    static size_t compress(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity) {
+        static thread_local uint32_t table[kHashSize];  // Position + 1 of the last 4-byte sequence per hash
+        std::memset(table, 0, sizeof(table));
+        size_t out = 0;
+        size_t anchor = 0;
+        size_t pos = 0;
+        while (pos + kMinMatch <= size) {
+            uint32_t sequence = load32(src + pos);
+            uint32_t hash = (sequence * 2654435761u) >> (32 - kHashBits);
+            size_t candidate = table[hash];
+            table[hash] = static_cast<uint32_t>(pos + 1);
+            if (candidate == 0 || pos + 1 - candidate > 0xFFFF || load32(src + candidate - 1) != sequence) {
+                pos++;
+                continue;
+            }
+            size_t match = candidate - 1;
+            size_t length = kMinMatch;
+            while (pos + length < size && src[match + length] == src[pos + length]) length++;
+            if (!putSequence(src + anchor, pos - anchor, pos - match, length, dst, capacity, out)) return 0;
+            pos += length;
+            anchor = pos;
+        }
+        if (!putSequence(src + anchor, size - anchor, 0, 0, dst, capacity, out)) return 0;
+        return out;
+    }
+
+    // Expands to exactly size bytes; false if the input is malformed
+    static bool decompress(const uint8_t* src, size_t src_size, uint8_t* dst, size_t size) {
+        size_t in = 0;
+        size_t out = 0;
+        while (in < src_size) {
+            uint8_t token = src[in++];
+            size_t literals = token >> 4;
+            if (literals == 15 && !getLength(src, src_size, in, literals)) return false;
+            if (literals > src_size - in || literals > size - out) return false;
+            std::memcpy(dst + out, src + in, literals);
+            in += literals;
+            out += literals;
+            if (in == src_size) break;
+            if (src_size - in < 2) return false;
+            size_t offset = static_cast<size_t>(src[in]) | (static_cast<size_t>(src[in + 1]) << 8);
+            in += 2;
+            if (offset == 0 || offset > out) return false;
+            size_t length = token & 0x0F;
+            if (length == 15 && !getLength(src, src_size, in, length)) return false;
+            length += kMinMatch;
+            if (length > size - out) return false;
+            for (size_t i = 0; i < length; i++, out++) {
+                dst[out] = dst[out - offset];  // Byte by byte: the match may overlap its output
+            }
+        }
+        return out == size;
+    }
+
+private:
+    static const int kHashBits = 12;
+    static const size_t kHashSize = static_cast<size_t>(1) << kHashBits;
+    static const size_t kMinMatch = 4;
+
+    static uint32_t load32(const uint8_t* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static bool putLength(size_t length, uint8_t* dst, size_t capacity, size_t& out) {
+        for (; length >= 255; length -= 255) {
+            if (out >= capacity) return false;
+            dst[out++] = 255;
+        }
+        if (out >= capacity) return false;
+        dst[out++] = static_cast<uint8_t>(length);
+        return true;
+    }
+
+    static bool putSequence(const uint8_t* literals, size_t count, size_t offset, size_t length,
+                            uint8_t* dst, size_t capacity, size_t& out) {
+        size_t match = length ? length - kMinMatch : 0;
+        if (out >= capacity) return false;
+        dst[out++] = static_cast<uint8_t>(((count < 15 ? count : 15) << 4) | (match < 15 ? match : 15));
+        if (count >= 15 && !putLength(count - 15, dst, capacity, out)) return false;
+        if (count > capacity - out) return false;
+        if (count > 0) std::memcpy(dst + out, literals, count);
+        out += count;
+        if (length == 0) return true;
+        if (capacity - out < 2) return false;
+        dst[out++] = static_cast<uint8_t>(offset & 0xFF);
+        dst[out++] = static_cast<uint8_t>(offset >> 8);
+        return match < 15 || putLength(match - 15, dst, capacity, out);
+    }
+
+    static bool getLength(const uint8_t* src, size_t src_size, size_t& in, size_t& length) {
+        uint8_t byte;
+        do {
+            if (in >= src_size) return false;
+            byte = src[in++];
+            length += byte;
+        } while (byte == 255);
+        return true;
+    }
+};
+
+// Set in a frame's flags byte when the body after the msg_id is raw length(4) +
+// LZ block; only sent to peers that negotiated WIRE_LZ
+const uint8_t FRAME_COMPRESSED = 0x80;
+const size_t FRAME_MAX_BYTES = 65536;             // flags/size(4) + payload, one datagram
+const size_t UDP_MAX_PAYLOAD = 65507;             // Largest datagram sendto() accepts over IPv4
+const size_t FRAME_MAX_INFLATED = 16 * 1024 * 1024;
+const size_t WIRE_LZ_THRESHOLD = 1024;            // Default: smaller payloads are sent as is
+
+// Frame a serialized message as flags(1) + size(3) + payload, compressing it when
+// the encoding allows, it exceeds threshold and it shrinks. Returns the frame
+// length, or 0 if it does not fit in FRAME_MAX_BYTES.
+inline size_t encodeFrame(const ByteBuffer& buffer, size_t threshold, uint8_t* frame) {
+    uint8_t flags = buffer.wireFlags();
+    size_t size = buffer.size();
+    const uint8_t* payload = buffer.data();
+    if ((flags & WIRE_LZ) && size > threshold && size > 16) {
+        size_t body = size - 4;
+        size_t capacity = body - 8 < FRAME_MAX_BYTES - 12 ? body - 8 : FRAME_MAX_BYTES - 12;
+        size_t packed = LzCodec::compress(payload + 4, body, frame + 12, capacity);
+        if (packed > 0) {
+            std::memcpy(frame + 4, payload, 4);  // msg_id stays readable for routing
+            frame[8] = (body >> 24) & 0xFF;
+            frame[9] = (body >> 16) & 0xFF;
+            frame[10] = (body >> 8) & 0xFF;
+            frame[11] = body & 0xFF;
+            flags |= FRAME_COMPRESSED;
+            size = 8 + packed;
+        } else {
+            if (size > FRAME_MAX_BYTES - 4) return 0;
+            std::memcpy(frame + 4, payload, size);
+        }
+    } else {
+        if (size > FRAME_MAX_BYTES - 4) return 0;
+        std::memcpy(frame + 4, payload, size);
+    }
+    frame[0] = flags;
+    frame[1] = (size >> 16) & 0xFF;
+    frame[2] = (size >> 8) & 0xFF;
+    frame[3] = size & 0xFF;
+    return size + 4;
+}
+
+// Undo encodeFrame's compression: a FRAME_COMPRESSED payload is expanded into
+// inflated and data/size are pointed at it. False if the payload is malformed.
+inline bool inflateFrame(uint8_t& flags, const uint8_t*& data, uint32_t& size, std::vector<uint8_t>& inflated) {
+    if (!(flags & FRAME_COMPRESSED)) return true;
+    flags &= ~FRAME_COMPRESSED;
+    if (size < 8) return false;
+    uint32_t body = (static_cast<uint32_t>(data[4]) << 24) | (static_cast<uint32_t>(data[5]) << 16) |
+                    (static_cast<uint32_t>(data[6]) << 8) | static_cast<uint32_t>(data[7]);
+    if (body > FRAME_MAX_INFLATED) return false;
+    inflated.resize(4 + body);
+    std::memcpy(inflated.data(), data, 4);
+    if (!LzCodec::decompress(data + 8, size - 8, inflated.data() + 4, body)) return false;
+    data = inflated.data();
+    size = 4 + body;
+    return true;
+}
+#endif // IPC_BYTE_BUFFER_DEFINED
+
+// Message IDs
+const uint32_t MSG_SET_REQ = 1000;
+const uint32_t MSG_SET_RESP = 1001;
+const uint32_t MSG_GET_REQ = 1002;
+const uint32_t MSG_GET_RESP = 1003;
+const uint32_t MSG_REMOVE_REQ = 1004;
+const uint32_t MSG_REMOVE_RESP = 1005;
+const uint32_t MSG_EXISTS_REQ = 1006;
+const uint32_t MSG_EXISTS_RESP = 1007;
+const uint32_t MSG_COUNT_REQ = 1008;
+const uint32_t MSG_COUNT_RESP = 1009;
+const uint32_t MSG_CLEAR_REQ = 1010;
+const uint32_t MSG_BATCHSET_REQ = 1011;
+const uint32_t MSG_BATCHSET_RESP = 1012;
+const uint32_t MSG_BATCHGET_REQ = 1013;
+const uint32_t MSG_BATCHGET_RESP = 1014;
+const uint32_t MSG_BATCHGETMAP_REQ = 1015;
+const uint32_t MSG_BATCHGETMAP_RESP = 1016;
+const uint32_t MSG_SCAN_REQ = 1017;
+const uint32_t MSG_SCAN_RESP = 1018;
+const uint32_t MSG_LOAD_REQ = 1019;
+const uint32_t MSG_LOAD_RESP = 1020;
+const uint32_t MSG_LOAD_CHUNK = 1021;
+const uint32_t MSG_ONKEYCHANGED_REQ = 1022;
+const uint32_t MSG_ONBATCHCHANGED_REQ = 1023;
+const uint32_t MSG_ONCONNECTIONSTATUS_REQ = 1024;
+
+#ifndef IPC_KEYVALUESERVICE_TYPES_DEFINED
+#define IPC_KEYVALUESERVICE_TYPES_DEFINED
+enum class OperationStatus {
+    SUCCESS,
+    KEY_NOT_FOUND,
+    INVALID_KEY,
+    ERROR
+};
+
+enum class ChangeEventType {
+    KEY_ADDED,
+    KEY_UPDATED,
+    KEY_REMOVED,
+    STORE_CLEARED
+};
+
+struct KeyValue {
+    std::string key;
+    std::string value;
+
+    void serialize(ByteBuffer& buffer) const {
+        // WIRE_SPARSE: presence bitmap, then only the fields that differ from their default
+        uint64_t present = ~uint64_t(0);
+        if (buffer.wireFlags() & WIRE_SPARSE) {
+            present = 0;
+            if (!key.empty()) present |= uint64_t(1) << 0;
+            if (!value.empty()) present |= uint64_t(1) << 1;
+            buffer.writePresence(present, 2);
+        }
+        if (present & (uint64_t(1) << 0)) {
+            buffer.writeString(key);
+        }
+        if (present & (uint64_t(1) << 1)) {
+            buffer.writeString(value);
+        }
+    }
+
+    void deserialize(ByteReader& reader) {
+        // WIRE_SPARSE: fields the sender left out are reset to their default
+        uint64_t present = ~uint64_t(0);
+        if (reader.wireFlags() & WIRE_SPARSE) present = reader.readPresence(2);
+        if (present & (uint64_t(1) << 0)) {
+            reader.readStringInto(key);
+        } else {
+            key.clear();
+        }
+        if (present & (uint64_t(1) << 1)) {
+            reader.readStringInto(value);
+        } else {
+            value.clear();
+        }
+    }
+};
+
+struct ChangeEvent {
+    ChangeEventType eventType;
+    std::string key;
+    std::string oldValue;
+    std::string newValue;
+    int64_t timestamp;
+
+    // Previous element's @delta fields while a sequence is encoded or decoded
+    struct DeltaState {
+        int64_t timestamp = 0;
+    };
+
+    void serialize(ByteBuffer& buffer, DeltaState* delta = nullptr) const {
+        // WIRE_SPARSE: presence bitmap, then only the fields that differ from their default
+        uint64_t present = ~uint64_t(0);
+        if (buffer.wireFlags() & WIRE_SPARSE) {
+            present = uint64_t(0x10);
+            if (static_cast<int32_t>(eventType) != 0) present |= uint64_t(1) << 0;
+            if (!key.empty()) present |= uint64_t(1) << 1;
+            if (!oldValue.empty()) present |= uint64_t(1) << 2;
+            if (!newValue.empty()) present |= uint64_t(1) << 3;
+            buffer.writePresence(present, 5);
+        }
+        if (present & (uint64_t(1) << 0)) {
+            buffer.writeInt32(static_cast<int32_t>(eventType));
+        }
+        if (present & (uint64_t(1) << 1)) {
+            buffer.writeString(key);
+        }
+        if (present & (uint64_t(1) << 2)) {
+            buffer.writeString(oldValue);
+        }
+        if (present & (uint64_t(1) << 3)) {
+            buffer.writeString(newValue);
+        }
+        if (delta) buffer.writeDelta(timestamp, delta->timestamp);
+        else buffer.writeInt64(timestamp);
+    }
+
+    void deserialize(ByteReader& reader, DeltaState* delta = nullptr) {
+        // WIRE_SPARSE: fields the sender left out are reset to their default
+        uint64_t present = ~uint64_t(0);
+        if (reader.wireFlags() & WIRE_SPARSE) present = reader.readPresence(5);
+        if (present & (uint64_t(1) << 0)) {
+            eventType = static_cast<ChangeEventType>(reader.readInt32());
+        } else {
+            eventType = ChangeEventType();
+        }
+        if (present & (uint64_t(1) << 1)) {
+            reader.readStringInto(key);
+        } else {
+            key.clear();
+        }
+        if (present & (uint64_t(1) << 2)) {
+            reader.readStringInto(oldValue);
+        } else {
+            oldValue.clear();
+        }
+        if (present & (uint64_t(1) << 3)) {
+            reader.readStringInto(newValue);
+        } else {
+            newValue.clear();
+        }
+        if (delta) timestamp = reader.readDelta(delta->timestamp);
+        else timestamp = reader.readInt64();
+    }
+};
+
+#endif // IPC_KEYVALUESERVICE_TYPES_DEFINED
+
+// Message Structures
+struct setRequest {
+    uint32_t msg_id = MSG_SET_REQ;
+    std::string key;
+    std::string value;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, key, value);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::string& key, const std::string& value) {
+        buffer.writeString(key);
+        buffer.writeString(value);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        reader.readStringInto(key);
+        reader.readStringInto(value);
+    }
+};
+
+struct setResponse {
+    uint32_t msg_id = MSG_SET_RESP;
+    int32_t status = 0;
+    bool return_value;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        buffer.writeInt32(status);
+        buffer.writeBool(return_value);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        status = reader.readInt32();
         return_value = reader.readBool();
     }
 };
@@ -329,13 +1350,18 @@ struct getRequest {
     std::string key;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, key);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::string& key) {
         buffer.writeString(key);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        key = reader.readString();
+        msg_id = reader.readMsgId();
+        reader.readStringInto(key);
     }
 };
 
@@ -345,15 +1371,15 @@ struct getResponse {
     std::string return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
         buffer.writeString(return_value);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
-        return_value = reader.readString();
+        reader.readStringInto(return_value);
     }
 };
 
@@ -362,13 +1388,18 @@ struct removeRequest {
     std::string key;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, key);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::string& key) {
         buffer.writeString(key);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        key = reader.readString();
+        msg_id = reader.readMsgId();
+        reader.readStringInto(key);
     }
 };
 
@@ -378,13 +1409,13 @@ struct removeResponse {
     bool return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
         buffer.writeBool(return_value);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
         return_value = reader.readBool();
     }
@@ -395,13 +1426,18 @@ struct existsRequest {
     std::string key;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, key);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::string& key) {
         buffer.writeString(key);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        key = reader.readString();
+        msg_id = reader.readMsgId();
+        reader.readStringInto(key);
     }
 };
 
@@ -411,13 +1447,13 @@ struct existsResponse {
     bool return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
         buffer.writeBool(return_value);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
         return_value = reader.readBool();
     }
@@ -427,11 +1463,11 @@ struct countRequest {
     uint32_t msg_id = MSG_COUNT_REQ;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
     }
 };
 
@@ -441,13 +1477,13 @@ struct countResponse {
     int64_t return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
         buffer.writeInt64(return_value);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
         return_value = reader.readInt64();
     }
@@ -457,11 +1493,11 @@ struct clearRequest {
     uint32_t msg_id = MSG_CLEAR_REQ;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
     }
 };
 
@@ -471,7 +1507,12 @@ struct batchSetRequest {
     std::vector<KeyValue> items;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, items);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::vector<KeyValue>& items) {
         buffer.writeUint32(items.size());
         for (const auto& item : items) {
             item.serialize(buffer);
@@ -479,9 +1520,9 @@ struct batchSetRequest {
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         {
-            uint32_t count = reader.readUint32();
+            uint32_t count = reader.readCount();
             items.resize(count);
             for (uint32_t i = 0; i < count; i++) {
                 items[i].deserialize(reader);
@@ -496,13 +1537,13 @@ struct batchSetResponse {
     int64_t return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
         buffer.writeInt64(return_value);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
         return_value = reader.readInt64();
     }
@@ -513,13 +1554,18 @@ struct batchGetRequest {
     std::vector<std::string> keys;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, keys);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::vector<std::string>& keys) {
         buffer.writeStringVector(keys);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        keys = reader.readStringVector();
+        msg_id = reader.readMsgId();
+        reader.readStringVectorInto(keys);
     }
 };
 
@@ -530,7 +1576,7 @@ struct batchGetResponse {
     int32_t response_status = 0;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeStringVector(values);
         buffer.writeUint32(status.size());
         for (const auto& item : status) {
@@ -540,10 +1586,10 @@ struct batchGetResponse {
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        values = reader.readStringVector();
+        msg_id = reader.readMsgId();
+        reader.readStringVectorInto(values);
         {
-            uint32_t count = reader.readUint32();
+            uint32_t count = reader.readCount();
             status.resize(count);
             for (uint32_t i = 0; i < count; i++) {
                 status[i] = static_cast<OperationStatus>(reader.readInt32());
@@ -553,17 +1599,121 @@ struct batchGetResponse {
     }
 };
 
+struct batchGetMapRequest {
+    uint32_t msg_id = MSG_BATCHGETMAP_REQ;
+    std::vector<std::string> keys;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, keys);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::vector<std::string>& keys) {
+        buffer.writeStringVector(keys);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        reader.readStringVectorInto(keys);
+    }
+};
+
+struct batchGetMapResponse {
+    uint32_t msg_id = MSG_BATCHGETMAP_RESP;
+    int32_t status = 0;
+    std::unordered_map<std::string, std::string> return_value;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        buffer.writeInt32(status);
+        buffer.writeMap(return_value);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        status = reader.readInt32();
+        reader.readMapInto(return_value);
+    }
+};
+
+struct scanRequest {
+    uint32_t msg_id = MSG_SCAN_REQ;
+    std::string prefix;
+    uint32_t stream_id = 0;  // Chosen by the client, echoed in every chunk
+    uint32_t credit = 0;     // Chunks the writer may send before waiting for more
+    uint32_t max_delay_ms = 0;  // Longest the server holds an item in a partial chunk
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        buffer.writeString(prefix);
+        buffer.writeUint32(stream_id);
+        buffer.writeUint32(credit);
+        buffer.writeUint32(max_delay_ms);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        reader.readStringInto(prefix);
+        stream_id = reader.readUint32();
+        credit = reader.readUint32();
+        max_delay_ms = reader.readUint32();
+    }
+};
+
+
+struct loadRequest {
+    uint32_t msg_id = MSG_LOAD_REQ;
+    uint32_t stream_id = 0;  // Chosen by the client, echoed in every chunk
+    uint32_t credit = 0;     // Chunks the writer may send before waiting for more
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        buffer.writeUint32(stream_id);
+        buffer.writeUint32(credit);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        stream_id = reader.readUint32();
+        credit = reader.readUint32();
+    }
+};
+
+struct loadResponse {
+    uint32_t msg_id = MSG_LOAD_RESP;
+    int32_t status = 0;
+    int64_t return_value;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        buffer.writeInt32(status);
+        buffer.writeInt64(return_value);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        status = reader.readInt32();
+        return_value = reader.readInt64();
+    }
+};
+
 struct onKeyChangedRequest {
     uint32_t msg_id = MSG_ONKEYCHANGED_REQ;
     ChangeEvent event;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, event);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const ChangeEvent& event) {
         event.serialize(buffer);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         event.deserialize(reader);
     }
 };
@@ -574,22 +1724,18 @@ struct onBatchChangedRequest {
     std::vector<ChangeEvent> events;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
-        buffer.writeUint32(events.size());
-        for (const auto& item : events) {
-            item.serialize(buffer);
-        }
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, events);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::vector<ChangeEvent>& events) {
+        buffer.writeDeltaSequence(events);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        {
-            uint32_t count = reader.readUint32();
-            events.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                events[i].deserialize(reader);
-            }
-        }
+        msg_id = reader.readMsgId();
+        reader.readDeltaSequenceInto(events);
     }
 };
 
@@ -599,12 +1745,17 @@ struct onConnectionStatusRequest {
     bool connected;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, connected);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, bool connected) {
         buffer.writeBool(connected);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         connected = reader.readBool();
     }
 };
@@ -612,24 +1763,201 @@ struct onConnectionStatusRequest {
 
 #ifndef IPC_SOCKET_BASE_DEFINED
 #define IPC_SOCKET_BASE_DEFINED
+// Runtime control messages (handled by the generated code, not part of any IDL interface)
+const uint32_t MSG_CTRL_CALLBACK_CHANNEL_REQ = 0xFFFF0001;  // client -> server: route callbacks to this socket
+const uint32_t MSG_CTRL_CALLBACK_CHANNEL_ACK = 0xFFFF0002;  // server -> client: callback channel registered
+const uint32_t MSG_CTRL_STREAM_CREDIT = 0xFFFF0003;         // client -> server: may send N more stream chunks
+const uint32_t MSG_CTRL_HELLO = 0xFFFF0004;                 // client -> server: wire encodings wanted
+const uint32_t MSG_CTRL_HELLO_ACK = 0xFFFF0005;             // server -> client: wire encodings accepted
+const uint32_t MSG_CTRL_CALLBACK_TOKEN_REQ = 0xFFFF0006;    // client RPC socket -> server: token for CALLBACK_CHANNEL_REQ
+const uint32_t MSG_CTRL_CALLBACK_TOKEN = 0xFFFF0007;        // server -> client RPC socket: one-time token
+const uint32_t MSG_CTRL_BYE = 0xFFFF0008;                   // client RPC socket -> server: forget this client
+
+// Placement of the threads spawned by the generated runtime
+struct ThreadOptions {
+    std::vector<int> cpus;  // CPU cores the threads may run on (empty = any)
+    int priority;           // SCHED_FIFO priority 1-99 (0 = keep the default policy)
+    std::string name;       // thread name prefix, shown as "<name>-<role>" (max 15 chars)
+    
+    ThreadOptions() : priority(0) {}
+    
+    // Apply to the calling thread; returns false if any setting was rejected, with
+    // the rejected settings described in *error
+    bool applyToCurrentThread(const char* role, std::string* error = nullptr) const {
+        std::string failed;
+        pthread_t self = pthread_self();
+        if (!cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : cpus) {
+                if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+                else failed += "cpu " + std::to_string(cpu) + " out of range; ";
+            }
+            int rc = pthread_setaffinity_np(self, sizeof(set), &set);
+            if (rc != 0) failed += std::string("affinity: ") + std::strerror(rc) + "; ";
+        }
+        if (priority > 0) {
+            struct sched_param param;
+            param.sched_priority = priority;
+            int rc = pthread_setschedparam(self, SCHED_FIFO, &param);
+            if (rc != 0) failed += std::string("SCHED_FIFO priority: ") + std::strerror(rc) + "; ";
+        }
+        if (!name.empty()) {
+            std::string thread_name = name + "-" + role;
+            int rc = pthread_setname_np(self, thread_name.substr(0, 15).c_str());
+            if (rc != 0) failed += std::string("name: ") + std::strerror(rc) + "; ";
+        }
+        if (error) *error = failed;
+        return failed.empty();
+    }
+
+    // For runtime threads: a rejection is logged and counted in *failures instead
+    // of silently leaving the thread unplaced
+    void applyOrReport(const char* role, std::atomic<size_t>* failures) const {
+        std::string error;
+        if (applyToCurrentThread(role, &error)) return;
+        if (failures) (*failures)++;
+        std::cerr << "[ThreadOptions] placement of thread '" << role << "' rejected: " << error << std::endl;
+    }
+
+    // Try the options on a short-lived thread, leaving the caller's placement untouched
+    bool validate(std::string* error = nullptr) const {
+        bool ok = false;
+        std::thread probe([this, &ok, error]() { ok = applyToCurrentThread("probe", error); });
+        probe.join();
+        return ok;
+    }
+};
+
+#if __cplusplus >= 201703L
+// Per-request arena used by --pmr-arena servers: decoded requests allocate from it and
+// everything is handed back in one step when the handler's scope ends
+class RequestArena {
+public:
+    // The pool's largest block size must cover the arena's overflow blocks, otherwise
+    // the pool hands them straight back upstream and every large request allocates again
+    RequestArena() : pool_(std::pmr::pool_options{0, kMaxPooledBlock}), arena_(buffer_, sizeof(buffer_), &pool_) {}
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &arena_; }
+
+    // Releases the arena when destroyed; declare before the objects that use it
+    class Scope {
+    public:
+        explicit Scope(RequestArena& owner) : owner_(owner) {}
+        ~Scope() { owner_.arena_.release(); }
+    private:
+        RequestArena& owner_;
+    };
+
+private:
+    static constexpr size_t kMaxPooledBlock = 1024 * 1024;
+
+    alignas(std::max_align_t) unsigned char buffer_[64 * 1024];
+    std::pmr::unsynchronized_pool_resource pool_;  // Keeps overflow blocks for the next request
+    std::pmr::monotonic_buffer_resource arena_;
+};
+#endif
+
 // Socket Base Class
 class SocketBase {
 protected:
     int sockfd_;
     struct sockaddr_in addr_;
     bool connected_;
+    int wake_fd_;  // eventfd that interrupts blocking waits on shutdown (-1 if unavailable)
+    std::atomic<bool> woken_;
+    ThreadOptions thread_options_;
+    
+    // Without an eventfd, waitReadable() polls in slices this long so wake() is still seen
+    static const int kWakePollMs = 100;
     
 public:
-    SocketBase() : sockfd_(-1), connected_(false) {}
+    SocketBase() : sockfd_(-1), connected_(false),
+                   wake_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), woken_(false), placement_failures_(0) {}
     
     virtual ~SocketBase() {
         if (sockfd_ >= 0) {
             close(sockfd_);
         }
+        if (wake_fd_ >= 0) {
+            close(wake_fd_);
+        }
     }
     
     bool isConnected() const { return connected_; }
     
+    // Placement for threads started after this call (restart listeners to apply).
+    // The options are tried first; if the OS rejects them (no such CPU, SCHED_FIFO
+    // without CAP_SYS_NICE, ...) this returns false with the reason in *error and
+    // keeps the previous options
+    bool setThreadOptions(const ThreadOptions& options, std::string* error = nullptr) {
+        if (!options.validate(error)) return false;
+        thread_options_ = options;
+        return true;
+    }
+    const ThreadOptions& threadOptions() const { return thread_options_; }
+    
+    // Runtime threads whose placement was rejected when they started
+    size_t threadPlacementFailures() const { return placement_failures_; }
+    
+protected:
+    std::atomic<size_t> placement_failures_;
+    
+    // Start a runtime thread with the configured placement
+    template <typename Body>
+    std::thread spawnThread(const char* role, Body body) {
+        ThreadOptions options = thread_options_;
+        std::atomic<size_t>* failures = &placement_failures_;
+        return std::thread([options, role, body, failures]() {
+            options.applyOrReport(role, failures);
+            body();
+        });
+    }
+    
+    // Block until fd is readable; returns false once wake() has been called
+    bool waitReadable(int fd) {
+        struct pollfd fds[2];
+        fds[0].fd = fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = wake_fd_;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        int nfds = wake_fd_ >= 0 ? 2 : 1;
+        int timeout = wake_fd_ >= 0 ? -1 : kWakePollMs;
+        while (true) {
+            if (woken_) return false;
+            if (poll(fds, nfds, timeout) < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            if (fds[1].revents != 0) return false;
+            if (fds[0].revents & POLLIN) return true;
+            if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) return false;
+        }
+    }
+    
+    // Wake every thread blocked in waitReadable()
+    void wake() {
+        woken_ = true;
+        if (wake_fd_ < 0) return;
+        uint64_t one = 1;
+        ssize_t written = write(wake_fd_, &one, sizeof(one));
+        (void)written;
+    }
+    
+    // Re-arm waitReadable() after the woken threads have exited
+    void resetWake() {
+        woken_ = false;
+        if (wake_fd_ < 0) return;
+        uint64_t value;
+        ssize_t drained = read(wake_fd_, &value, sizeof(value));
+        (void)drained;
+    }
+    
+public:
+    
     ssize_t sendData(const void* data, size_t size) {
         // UDP: send datagram to server address
         return sendto(sockfd_, data, size, 0, 
@@ -659,6 +1987,425 @@ public:
                         (struct sockaddr*)from_addr, &from_len);
     }
 };
+
+// Callback dispatcher pool: runs callbacks on worker threads so the listener
+// thread stays free to route RPC responses. Tasks submitted with the same
+// partition run in submission order on the same worker.
+class CallbackDispatcher {
+private:
+    struct Worker {
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::queue<std::function<void()>> tasks;
+        bool stopping;
+        Worker() : stopping(false) {}
+    };
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+public:
+    explicit CallbackDispatcher(size_t threads, const ThreadOptions& options = ThreadOptions(),
+                                std::atomic<size_t>* placement_failures = nullptr) {
+        if (threads == 0) threads = 1;
+        for (size_t i = 0; i < threads; i++) {
+            workers_.emplace_back(new Worker());
+            Worker* worker = workers_.back().get();
+            worker->thread = std::thread([worker, options, placement_failures]() {
+                options.applyOrReport("cb", placement_failures);
+                run(worker);
+            });
+        }
+    }
+
+    // Drains queued callbacks before joining the workers
+    ~CallbackDispatcher() {
+        for (auto& worker : workers_) {
+            {
+                std::lock_guard<std::mutex> lock(worker->mutex);
+                worker->stopping = true;
+            }
+            worker->cv.notify_one();
+        }
+        for (auto& worker : workers_) {
+            if (worker->thread.joinable()) worker->thread.join();
+        }
+    }
+
+    size_t threadCount() const { return workers_.size(); }
+
+    void dispatch(size_t partition, std::function<void()> task) {
+        Worker* worker = workers_[partition % workers_.size()].get();
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            worker->tasks.push(std::move(task));
+        }
+        worker->cv.notify_one();
+    }
+
+private:
+    static void run(Worker* worker) {
+        std::unique_lock<std::mutex> lock(worker->mutex);
+        while (true) {
+            worker->cv.wait(lock, [worker]() { return worker->stopping || !worker->tasks.empty(); });
+            if (worker->tasks.empty()) break;  // stopping and drained
+            std::function<void()> task = std::move(worker->tasks.front());
+            worker->tasks.pop();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+};
+
+// Header of one chunk of a streaming RPC (stream<T>); the encoded items follow it
+struct StreamChunkHeader {
+    uint32_t msg_id;
+    uint32_t stream_id;
+    uint32_t seq;
+    bool last;
+    uint32_t count;
+
+    StreamChunkHeader() : msg_id(0), stream_id(0), seq(0), last(false), count(0) {}
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        buffer.writeUint32(stream_id);
+        buffer.writeUint32(seq);
+        buffer.writeBool(last);
+        buffer.writeUint32(count);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        stream_id = reader.readUint32();
+        seq = reader.readUint32();
+        last = reader.readBool();
+        count = reader.readUint32();
+    }
+};
+
+// State shared by both ends of a stream: the peer, cancellation and completion
+class StreamBase {
+public:
+    StreamBase(int sockfd, const struct sockaddr_in& peer, uint32_t stream_id)
+        : sockfd_(sockfd), peer_(peer), stream_id_(stream_id), wire_flags_(0),
+          compress_threshold_(WIRE_LZ_THRESHOLD), cancelled_(false), done_(false) {}
+
+    virtual ~StreamBase() {}
+
+    // Encoding negotiated with the peer (call before the first item): chunks are
+    // encoded with wire_flags and, with WIRE_LZ, compressed above compress_threshold
+    virtual void setWireFormat(uint8_t wire_flags, size_t compress_threshold) {
+        wire_flags_ = wire_flags;
+        compress_threshold_ = compress_threshold;
+    }
+
+    // Called from the receive thread: credit for a writer, a chunk for a reader
+    virtual void addCredit(uint32_t credit) { (void)credit; }
+    virtual void pushChunk(const uint8_t* data, size_t size) { (void)data; (void)size; }
+
+    void cancel() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cancelled_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    bool cancelled() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return cancelled_;
+    }
+
+    bool done() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return done_;
+    }
+
+    void markDone() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = true;
+    }
+
+protected:
+    // Send flags(1) + size(3) + payload to the peer; false if it does not fit a frame
+    bool sendFrame(const ByteBuffer& buffer) {
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        return frame_size > 0 &&
+               sendto(sockfd_, send_buffer, frame_size, 0, (struct sockaddr*)&peer_, sizeof(peer_)) >= 0;
+    }
+
+    int sockfd_;
+    struct sockaddr_in peer_;
+    uint32_t stream_id_;
+    uint8_t wire_flags_;
+    size_t compress_threshold_;
+    bool cancelled_;
+    bool done_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+// Sending end of a stream. Items are packed into chunks of about kChunkBytes,
+// never more than one datagram holds; a chunk is only sent while the peer has
+// granted credit, so a slow reader throttles the producer instead of overrunning
+// its socket buffer.
+class StreamWriterBase : public StreamBase {
+public:
+    static const size_t kChunkBytes = 16384;
+    // Largest encoded items of one chunk: a UDP datagram less the frame header
+    // and the largest StreamChunkHeader (compact varints)
+    static const size_t kMaxChunkBytes = UDP_MAX_PAYLOAD - 4 - 20;
+
+    // Blocks up to 5 seconds for more credit; returns 0 on timeout
+    typedef std::function<uint32_t()> CreditSource;
+
+    StreamWriterBase(int sockfd, const struct sockaddr_in& peer, uint32_t msg_id,
+                     uint32_t stream_id, uint32_t credit)
+        : StreamBase(sockfd, peer, stream_id), count_(0), max_delay_(10), msg_id_(msg_id), seq_(0),
+          credit_(credit) {}
+
+    // Credit 0 is a keepalive: the reader is alive but still busy with earlier chunks
+    void addCredit(uint32_t credit) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            credit_ += credit;
+            heard_ = std::chrono::steady_clock::now();
+        }
+        cv_.notify_all();
+    }
+
+    void setWireFormat(uint8_t wire_flags, size_t compress_threshold) override {
+        StreamBase::setWireFormat(wire_flags, compress_threshold);
+        items_.setWireFlags(wire_flags);
+    }
+
+    // Longest an item waits in a partial chunk, checked as items are written
+    // (the first chunk always goes out with its first item)
+    void setMaxDelay(std::chrono::milliseconds delay) { max_delay_ = delay; }
+
+    // Fetch credit by polling instead of waiting for addCredit() (client uploads)
+    void setCreditSource(CreditSource source) { credit_source_ = source; }
+
+    // Send the buffered items now, e.g. before the producer blocks for a while;
+    // false once the stream was cancelled
+    bool sendPending() {
+        if (cancelled()) return false;
+        return count_ == 0 || flush(false, items_.size());
+    }
+
+    // Send the remaining items as the last chunk (called after the producer returns)
+    bool finish() {
+        if (done()) return !cancelled();
+        bool ok = !cancelled() && flush(true, items_.size());
+        markDone();
+        return ok;
+    }
+
+protected:
+    // Wait for credit (until the reader has been silent for 5 seconds), then send
+    // the first `bytes` of the buffered items (count_ items) as one chunk and
+    // start a new one
+    bool flush(bool last, size_t bytes) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (credit_ == 0 && credit_source_) {
+                lock.unlock();
+                uint32_t credit = credit_source_();
+                lock.lock();
+                credit_ += credit;
+            }
+            heard_ = std::chrono::steady_clock::now();
+            while (credit_ == 0 && !cancelled_ &&
+                   cv_.wait_until(lock, heard_ + std::chrono::seconds(5)) == std::cv_status::no_timeout) {}
+            if (credit_ == 0 || cancelled_) {
+                cancelled_ = true;
+                return false;
+            }
+            credit_--;
+        }
+
+        StreamChunkHeader header;
+        header.msg_id = msg_id_;
+        header.stream_id = stream_id_;
+        header.seq = seq_++;
+        header.last = last;
+        header.count = count_;
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        header.serialize(buffer);
+        buffer.writeBytes(items_.data(), bytes);
+        items_.clear();  // Also resets the WIRE_STRING_DICT dictionary for the next chunk
+        count_ = 0;
+        if (!sendFrame(buffer)) {
+            cancel();
+            return false;
+        }
+        return true;
+    }
+
+    // Send the chunk once it is full, when it is the first one (the reader sees
+    // items without waiting for a whole chunk) or when its oldest item has
+    // waited max_delay_
+    bool chunkDue() const {
+        return items_.size() >= kChunkBytes || seq_ == 0 ||
+               std::chrono::steady_clock::now() - chunk_started_ >= max_delay_;
+    }
+
+    ByteBuffer items_;
+    uint32_t count_;
+    std::chrono::steady_clock::time_point chunk_started_;  // When the first buffered item was written
+    std::chrono::milliseconds max_delay_;
+
+private:
+    uint32_t msg_id_;
+    uint32_t seq_;
+    uint32_t credit_;
+    CreditSource credit_source_;
+    std::chrono::steady_clock::time_point heard_;  // Last credit or keepalive from the reader
+};
+
+template <typename T>
+class StreamWriter : public StreamWriterBase {
+public:
+    typedef std::function<void(ByteBuffer&, const T&)> Encoder;
+
+    StreamWriter(int sockfd, const struct sockaddr_in& peer, uint32_t msg_id,
+                 uint32_t stream_id, uint32_t credit, Encoder encode)
+        : StreamWriterBase(sockfd, peer, msg_id, stream_id, credit), encode_(encode) {}
+
+    // Queue one item; returns false once the reader is gone or the stream was
+    // cancelled, or (dropping the item, the stream stays open) when the item
+    // alone does not fit in one datagram
+    bool write(const T& item) {
+        if (cancelled()) return false;
+        size_t before = items_.size();
+        encode_(items_, item);
+        if (items_.size() > kMaxChunkBytes) {
+            if (count_ == 0) {  // Alone in its chunk and still too large
+                items_.clear();
+                return false;
+            }
+            // Send the items before this one, then encode it again on its own so
+            // it cannot refer to the dictionary of the chunk that just went out
+            if (!flush(false, before)) return false;
+            encode_(items_, item);
+            if (items_.size() > kMaxChunkBytes) {
+                items_.clear();
+                return false;
+            }
+        }
+        if (count_++ == 0) chunk_started_ = std::chrono::steady_clock::now();
+        if (chunkDue()) return flush(false, items_.size());
+        return true;
+    }
+
+private:
+    Encoder encode_;
+};
+
+// Receiving end of a client stream (in stream<T> parameter). Chunks are queued
+// by the receive thread; credit goes back to the writer as they are consumed.
+class StreamReaderBase : public StreamBase {
+public:
+    StreamReaderBase(int sockfd, const struct sockaddr_in& peer, uint32_t stream_id, uint32_t window)
+        : StreamBase(sockfd, peer, stream_id), reader_(nullptr, 0), remaining_(0), last_seen_(false),
+          window_(window > 0 ? window : 1), expected_seq_(0), consumed_(0), started_(false) {}
+
+    void pushChunk(const uint8_t* data, size_t size) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (cancelled_) return;
+            chunks_.push(std::vector<uint8_t>(data, data + size));
+        }
+        cv_.notify_all();
+    }
+
+    // True once the whole stream has arrived (no lost chunk, no timeout)
+    bool complete() const { return last_seen_ && remaining_ == 0; }
+
+    // Skip unread items so the writer can finish
+    void drain() {
+        while (!last_seen_ && nextChunk()) {}
+        remaining_ = 0;
+    }
+
+protected:
+    // Make the next chunk current; false on timeout, cancellation or a lost chunk
+    bool nextChunk() {
+        if (started_ && ++consumed_ >= (window_ + 1) / 2) {
+            sendCredit(consumed_);
+            consumed_ = 0;
+        }
+        started_ = true;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!cv_.wait_for(lock, std::chrono::seconds(5), [this]() { return !chunks_.empty() || cancelled_; }) ||
+                cancelled_) {
+                cancelled_ = true;
+                return false;
+            }
+            current_ = std::move(chunks_.front());
+            chunks_.pop();
+        }
+        reader_ = ByteReader(current_.data(), current_.size(), wire_flags_);
+        StreamChunkHeader header;
+        header.deserialize(reader_);
+        if (header.seq != expected_seq_++) {
+            cancel();
+            return false;
+        }
+        remaining_ = header.count;
+        last_seen_ = header.last;
+        return true;
+    }
+
+    ByteReader reader_;
+    uint32_t remaining_;
+    bool last_seen_;
+
+private:
+    void sendCredit(uint32_t credit) {
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.writeUint32(MSG_CTRL_STREAM_CREDIT);
+        buffer.writeUint32(stream_id_);
+        buffer.writeUint32(credit);
+        sendFrame(buffer);
+    }
+
+    uint32_t window_;
+    uint32_t expected_seq_;
+    uint32_t consumed_;
+    bool started_;
+    std::queue<std::vector<uint8_t>> chunks_;
+    std::vector<uint8_t> current_;
+};
+
+template <typename T>
+class StreamReader : public StreamReaderBase {
+public:
+    typedef std::function<void(ByteReader&, T&)> Decoder;
+
+    StreamReader(int sockfd, const struct sockaddr_in& peer, uint32_t stream_id, uint32_t window,
+                 Decoder decode)
+        : StreamReaderBase(sockfd, peer, stream_id, window), decode_(decode) {}
+
+    // Next item; false at the end of the stream (check complete() for errors)
+    bool read(T& item) {
+        while (remaining_ == 0) {
+            if (last_seen_ || !nextChunk()) return false;
+        }
+        decode_(reader_, item);
+        remaining_--;
+        return true;
+    }
+
+private:
+    Decoder decode_;
+};
 #endif // IPC_SOCKET_BASE_DEFINED
 
 // Client Interface for KeyValueStore
@@ -671,21 +2418,64 @@ private:
     // Message queue for RPC responses
     struct QueuedMessage {
         uint32_t msg_id;
+        uint8_t wire_flags;  // Encoding of the payload (WireFlag bits)
         std::vector<uint8_t> data;
     };
     std::queue<QueuedMessage> rpc_response_queue_;
     std::mutex queue_mutex_;
     std::condition_variable queue_cv_;
 
+    // Optional worker pool for callbacks (null = run inline on the listener thread)
+    std::unique_ptr<CallbackDispatcher> dispatcher_;
+
+    // Optional dedicated socket for server-pushed callbacks (-1 = shared socket)
+    int callback_sockfd_;
+    std::thread callback_thread_;
+
+    // Busy-poll mode: callers spin on the socket for their own response
+    bool busy_poll_;
+
+    // Encoding of outgoing requests (WireFlag bits accepted by the server)
+    uint8_t wire_flags_;
+    size_t compress_threshold_;  // With WIRE_LZ: requests larger than this are compressed
+
+    // Streaming calls (stream<T> results and parameters)
+    uint32_t next_stream_id_;
+    uint32_t stream_window_;  // Chunks in flight before the server waits for credit
+    std::chrono::milliseconds stream_chunk_delay_;  // Longest an item waits in a partial chunk
+
 public:
-    KeyValueStoreClient() : listening_(false) {}
+    KeyValueStoreClient() : listening_(false), callback_sockfd_(-1), busy_poll_(false), wire_flags_(0), compress_threshold_(WIRE_LZ_THRESHOLD), next_stream_id_(0), stream_window_(8), stream_chunk_delay_(10) {}
 
     ~KeyValueStoreClient() {
         stopListening();
+        if (sockfd_ >= 0) {
+            // Let the server drop this client and its callback route now rather than on timeout
+            ByteBuffer bye;
+            bye.writeMsgId(MSG_CTRL_BYE);
+            uint8_t frame[FRAME_MAX_BYTES];
+            size_t frame_size = encodeFrame(bye, FRAME_MAX_BYTES, frame);
+            sendto(sockfd_, frame, frame_size, 0, (struct sockaddr*)&addr_, sizeof(addr_));
+        }
+        if (callback_sockfd_ >= 0) {
+            close(callback_sockfd_);
+        }
+    }
+
+    // Run callbacks on `threads` dispatcher threads instead of the listener thread.
+    // Callbacks for the same partition (see @partition in the IDL, otherwise the
+    // callback type) keep their order. Pass 0 to run callbacks inline again.
+    void setCallbackDispatcher(size_t threads) {
+        bool was_listening = listening_;
+        stopListening();
+        dispatcher_.reset(threads > 0 ? new CallbackDispatcher(threads, thread_options_, &placement_failures_) : nullptr);
+        if (was_listening) startListening();
     }
 
     // Setup UDP client
-    bool connect(const std::string& host, uint16_t port) {
+    // With separate_callback_channel, callbacks arrive on a second socket and
+    // thread so RPC responses are never queued behind callback traffic.
+    bool connect(const std::string& host, uint16_t port, bool separate_callback_channel = false) {
         sockfd_ = socket(AF_INET, SOCK_DGRAM, 0);  // UDP socket
         if (sockfd_ < 0) {
             return false;
@@ -697,43 +2487,216 @@ public:
         tv.tv_usec = 0;
         setsockopt(sockfd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
 
-        addr_.sin_family = AF_INET;
-        addr_.sin_port = htons(port);
-        inet_pton(AF_INET, host.c_str(), &addr_.sin_addr);
+        addr_.sin_family = AF_INET;
+        addr_.sin_port = htons(port);
+        inet_pton(AF_INET, host.c_str(), &addr_.sin_addr);
+
+        connected_ = true;
+        
+        if (separate_callback_channel) {
+            openCallbackChannel();  // Falls back to the shared socket on failure
+        }
+        
+        // Auto-start listener thread for message reception
+        startListening();
+        
+        return true;
+    }
+
+    // True if callbacks are delivered on their own socket
+    bool hasCallbackChannel() const { return callback_sockfd_ >= 0; }
+
+    // Low-latency mode: the calling thread spins on a non-blocking recv() for its
+    // own response instead of waiting for the listener thread. The listener stops
+    // reading the RPC socket; callbacks arriving there are handled while a call
+    // spins or from pollCallbacks(), so pair this with a callback channel.
+    // busy_poll_usec > 0 also sets SO_BUSY_POLL on the socket (may need privileges).
+    void setBusyPoll(bool enable, int busy_poll_usec = 0) {
+        bool was_listening = listening_;
+        stopListening();
+        {
+            std::lock_guard<std::mutex> lock(send_mutex_);
+            busy_poll_ = enable;
+        }
+#ifdef SO_BUSY_POLL
+        if (enable && busy_poll_usec > 0 && sockfd_ >= 0) {
+            setsockopt(sockfd_, SOL_SOCKET, SO_BUSY_POLL, &busy_poll_usec, sizeof(busy_poll_usec));
+        }
+#endif
+        if (was_listening) startListening();
+    }
+
+    // Ask the server for a wire encoding (WireFlag bits, e.g. WIRE_COMPACT); requests
+    // then use whatever subset it accepts. Returns the flags in effect, 0 if the
+    // server declined or predates negotiation (after the usual 5 s timeout).
+    uint8_t negotiateWireFlags(uint8_t wanted) {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        wire_flags_ = 0;
+        uint8_t hello[9] = {0, 0, 0, 5};
+        hello[4] = (MSG_CTRL_HELLO >> 24) & 0xFF;
+        hello[5] = (MSG_CTRL_HELLO >> 16) & 0xFF;
+        hello[6] = (MSG_CTRL_HELLO >> 8) & 0xFF;
+        hello[7] = MSG_CTRL_HELLO & 0xFF;
+        hello[8] = wanted & WIRE_SUPPORTED;
+        if (sendData(hello, sizeof(hello)) < 0) return 0;
+
+        QueuedMessage ack;
+        if (!waitForResponse(MSG_CTRL_HELLO_ACK, ack) || ack.data.size() < 5) return 0;
+        wire_flags_ = ack.data[4] & hello[8];
+        return wire_flags_;
+    }
+
+    uint8_t wireFlags() const { return wire_flags_; }
 
-        connected_ = true;
-        
-        // Auto-start listener thread for message reception
-        startListening();
-        
-        return true;
+    // Requests above this many bytes are compressed once WIRE_LZ is negotiated
+    void setCompressionThreshold(size_t bytes) { compress_threshold_ = bytes; }
+
+    // Flow control for stream<T> calls: chunks the writer may send ahead of the reader
+    void setStreamWindow(uint32_t chunks) {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        stream_window_ = chunks > 0 ? chunks : 1;
+    }
+
+    // Latency bound for stream<T> calls, both directions: a partial chunk is sent
+    // once its oldest item has waited this long (checked as items are written;
+    // the first chunk always goes out at once). 0 sends every item on its own.
+    void setStreamChunkDelay(std::chrono::milliseconds delay) {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        stream_chunk_delay_ = delay;
+    }
+
+    // Busy-poll mode: handle callbacks already waiting on the RPC socket
+    void pollCallbacks() {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        uint8_t recv_buffer[65536];
+        ssize_t received;
+        while ((received = recv(sockfd_, recv_buffer, sizeof(recv_buffer), MSG_DONTWAIT)) > 0) {
+            handleDatagram(recv_buffer, received);
+        }
     }
 
     // Start async listening for broadcast messages
     void startListening() {
         if (listening_ || !connected_) return;
         listening_ = true;
-        listener_thread_ = std::thread([this]() {
-            listenLoop();
-        });
+        if (!busy_poll_) {
+            listener_thread_ = spawnThread("rx", [this]() {
+                listenLoop();
+            });
+        }
+        if (callback_sockfd_ >= 0) {
+            callback_thread_ = spawnThread("cbrx", [this]() {
+                callbackLoop();
+            });
+        }
     }
 
-    // Stop async listening
+    // Stop async listening (returns as soon as the listener threads exit)
     void stopListening() {
         listening_ = false;
+        wake();
         if (listener_thread_.joinable()) {
             listener_thread_.join();
         }
+        if (callback_thread_.joinable()) {
+            callback_thread_.join();
+        }
+        resetWake();
     }
 
 private:
+    // Ask the server, on the RPC socket, for the one-time token that proves this
+    // client owns the RPC address it registers a callback channel for
+    bool requestChannelToken(uint64_t& token) {
+        ByteBuffer request;
+        request.writeMsgId(MSG_CTRL_CALLBACK_TOKEN_REQ);
+        uint8_t frame[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(request, FRAME_MAX_BYTES, frame);
+        for (int attempt = 0; attempt < 3; attempt++) {
+            if (sendto(sockfd_, frame, frame_size, 0, (struct sockaddr*)&addr_, sizeof(addr_)) < 0) {
+                return false;
+            }
+            struct pollfd pfd;
+            pfd.fd = sockfd_;
+            pfd.events = POLLIN;
+            if (poll(&pfd, 1, 1000) <= 0) continue;
+            uint8_t reply[64];
+            ssize_t received = recv(sockfd_, reply, sizeof(reply), 0);
+            if (received == 16) {
+                ByteReader reader(reply + 4, 12);
+                if (reader.readMsgId() == MSG_CTRL_CALLBACK_TOKEN) {
+                    token = reader.readUint64();
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Open a second socket for callbacks and register it with the server.
+    // The registration carries the RPC socket's port, and the token issued to
+    // that socket, so the server can route this client's callbacks to the new socket.
+    bool openCallbackChannel() {
+        // Bind the RPC socket now so its port is known before the first request
+        struct sockaddr_in local_addr;
+        memset(&local_addr, 0, sizeof(local_addr));
+        local_addr.sin_family = AF_INET;
+        local_addr.sin_addr.s_addr = INADDR_ANY;
+        local_addr.sin_port = 0;
+        socklen_t local_len = sizeof(local_addr);
+        if (bind(sockfd_, (struct sockaddr*)&local_addr, sizeof(local_addr)) < 0 ||
+            getsockname(sockfd_, (struct sockaddr*)&local_addr, &local_len) < 0) {
+            return false;
+        }
+
+        uint64_t token;
+        if (!requestChannelToken(token)) return false;
+
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0) return false;
+
+        struct timeval tv;
+        tv.tv_sec = 1;
+        tv.tv_usec = 0;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+        ByteBuffer buffer;
+        buffer.writeUint32(MSG_CTRL_CALLBACK_CHANNEL_REQ);
+        buffer.writeUint16(ntohs(local_addr.sin_port));
+        buffer.writeUint64(token);
+
+        uint32_t msg_size = buffer.size();
+        uint8_t send_buffer[64];
+        send_buffer[0] = (msg_size >> 24) & 0xFF;
+        send_buffer[1] = (msg_size >> 16) & 0xFF;
+        send_buffer[2] = (msg_size >> 8) & 0xFF;
+        send_buffer[3] = msg_size & 0xFF;
+        memcpy(send_buffer + 4, buffer.data(), msg_size);
+
+        // UDP may drop the registration; retry a few times before giving up
+        for (int attempt = 0; attempt < 3; attempt++) {
+            if (sendto(fd, send_buffer, msg_size + 4, 0, (struct sockaddr*)&addr_, sizeof(addr_)) < 0) {
+                break;
+            }
+            uint8_t recv_buffer[64];
+            ssize_t received = recv(fd, recv_buffer, sizeof(recv_buffer), 0);
+            if (received == 8) {
+                ByteReader reader(recv_buffer + 4, 4);
+                if (reader.readUint32() == MSG_CTRL_CALLBACK_CHANNEL_ACK) {
+                    callback_sockfd_ = fd;
+                    return true;
+                }
+            }
+        }
+
+        close(fd);
+        return false;
+    }
+
     void listenLoop() {
         while (listening_ && connected_) {
-            // Set recv timeout to allow periodic checking of listening_ flag
-            struct timeval tv;
-            tv.tv_sec = 1;
-            tv.tv_usec = 0;
-            setsockopt(sockfd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            // Sleep in poll() until data arrives or stopListening() wakes us
+            if (!waitReadable(sockfd_)) break;
 
             // Receive complete UDP datagram (size + data)
             uint8_t recv_buffer[65536];
@@ -749,42 +2712,215 @@ private:
                 break; // Error
             }
 
-            // Parse message: first 4 bytes = size, next bytes = data
-            if (received < 8) continue;  // At least size(4) + msg_id(4)
-            
-            uint32_t msg_size = (static_cast<uint32_t>(recv_buffer[0]) << 24) |
-                                (static_cast<uint32_t>(recv_buffer[1]) << 16) |
-                                (static_cast<uint32_t>(recv_buffer[2]) << 8) |
-                                static_cast<uint32_t>(recv_buffer[3]);
+            handleDatagram(recv_buffer, received);
+        }
+    }
 
-            // Verify size matches
-            if (received != msg_size + 4) continue;
+    // Receives on the dedicated callback socket (see connect())
+    void callbackLoop() {
+        while (listening_ && connected_) {
+            if (!waitReadable(callback_sockfd_)) break;
+
+            uint8_t recv_buffer[65536];
+            ssize_t received = recv(callback_sockfd_, recv_buffer, sizeof(recv_buffer), 0);
+            if (received <= 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    continue;
+                }
+                break;
+            }
+
+            handleDatagram(recv_buffer, received);
+        }
+    }
 
-            // Parse message ID from data part
-            uint8_t* data = recv_buffer + 4;
-            uint32_t msg_id = (static_cast<uint32_t>(data[0]) << 24) |
-                              (static_cast<uint32_t>(data[1]) << 16) |
-                              (static_cast<uint32_t>(data[2]) << 8) |
-                              static_cast<uint32_t>(data[3]);
+    // Split a datagram into payload, message ID and wire flags; false if malformed
+    static bool parseDatagram(const uint8_t* recv_buffer, ssize_t received, const uint8_t*& data,
+                              uint32_t& msg_size, uint32_t& msg_id, uint8_t& wire_flags) {
+        // Parse message: flags(1) + size(3), next bytes = data
+        if (received < 8) return false;  // At least flags/size(4) + msg_id(4)
+        
+        wire_flags = recv_buffer[0];
+        msg_size = (static_cast<uint32_t>(recv_buffer[1]) << 16) |
+                   (static_cast<uint32_t>(recv_buffer[2]) << 8) |
+                   static_cast<uint32_t>(recv_buffer[3]);
+
+        // Verify size matches
+        if (received != msg_size + 4) return false;
+
+        // Parse message ID from data part (compressed payloads stay valid until the
+        // next datagram is parsed on this thread)
+        data = recv_buffer + 4;
+        static thread_local std::vector<uint8_t> inflated;
+        if (!inflateFrame(wire_flags, data, msg_size, inflated)) return false;
+        msg_id = (static_cast<uint32_t>(data[0]) << 24) |
+                 (static_cast<uint32_t>(data[1]) << 16) |
+                 (static_cast<uint32_t>(data[2]) << 8) |
+                 static_cast<uint32_t>(data[3]);
+        return true;
+    }
+
+    void handleDatagram(const uint8_t* recv_buffer, ssize_t received) {
+        const uint8_t* data;
+        uint32_t msg_size, msg_id;
+        uint8_t wire_flags;
+        if (!parseDatagram(recv_buffer, received, data, msg_size, msg_id, wire_flags)) return;
+
+        // Check if this is a callback message (REQ) or RPC response (RESP)
+        bool is_callback = isCallbackMessage(msg_id);
+
+        if (is_callback) {
+            // Handle callback directly; a malformed callback is dropped
+            try {
+                handleBroadcastMessage(msg_id, data, msg_size, wire_flags);
+            } catch (const std::exception&) {
+            }
+        } else {
+            // Queue RPC response for RPC method to retrieve
+            QueuedMessage msg;
+            msg.msg_id = msg_id;
+            msg.wire_flags = wire_flags;
+            msg.data.assign(data, data + msg_size);
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex_);
+                rpc_response_queue_.push(msg);
+            }
+            queue_cv_.notify_one();
+        }
+    }
 
-            // Check if this is a callback message (REQ) or RPC response (RESP)
-            bool is_callback = isCallbackMessage(msg_id);
+    // True if msg answers expected_msg_id and, for stream_id != 0, belongs to that
+    // stream (stream chunks and credit carry the stream ID right after the msg_id)
+    static bool matchesResponse(const QueuedMessage& msg, uint32_t expected_msg_id, uint32_t stream_id) {
+        if (msg.msg_id != expected_msg_id) return false;
+        if (stream_id == 0) return true;
+        try {
+            ByteReader reader(msg.data.data(), msg.data.size(), msg.wire_flags);
+            reader.readMsgId();
+            return reader.readUint32() == stream_id;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
 
-            if (is_callback) {
-                // Handle callback directly
-                handleBroadcastMessage(msg_id, data, msg_size);
+    // Remove the first queued message matching; false if there is none (queue_mutex_ held)
+    bool takeQueued(uint32_t expected_msg_id, uint32_t stream_id, QueuedMessage& response_msg) {
+        std::queue<QueuedMessage> temp_queue;
+        bool found = false;
+        while (!rpc_response_queue_.empty()) {
+            if (!found && matchesResponse(rpc_response_queue_.front(), expected_msg_id, stream_id)) {
+                response_msg = std::move(rpc_response_queue_.front());
+                found = true;
             } else {
-                // Queue RPC response for RPC method to retrieve
-                QueuedMessage msg;
-                msg.msg_id = msg_id;
-                msg.data.assign(data, data + msg_size);
-                {
-                    std::lock_guard<std::mutex> lock(queue_mutex_);
-                    rpc_response_queue_.push(msg);
-                }
-                queue_cv_.notify_one();
+                temp_queue.push(std::move(rpc_response_queue_.front()));
+            }
+            rpc_response_queue_.pop();
+        }
+        rpc_response_queue_.swap(temp_queue);
+        return found;
+    }
+
+    // Wait up to 5 seconds for the response with the given message ID (and stream ID,
+    // unless 0); messages for other calls stay queued for them
+    bool waitForResponse(uint32_t expected_msg_id, QueuedMessage& response_msg, uint32_t stream_id = 0) {
+        if (busy_poll_) {
+            return spinForResponse(expected_msg_id, response_msg, stream_id);
+        }
+
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        return queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
+            return takeQueued(expected_msg_id, stream_id, response_msg);
+        });
+    }
+
+    // Busy-poll mode: spin on a non-blocking recv() on the calling thread.
+    // Callbacks received meanwhile are handled; stream messages are queued for the
+    // stream call they belong to (it may be running on_item); stale responses are dropped.
+    bool spinForResponse(uint32_t expected_msg_id, QueuedMessage& response_msg, uint32_t stream_id) {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            if (takeQueued(expected_msg_id, stream_id, response_msg)) return true;
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        uint8_t recv_buffer[65536];
+        while (std::chrono::steady_clock::now() < deadline) {
+            ssize_t received = recv(sockfd_, recv_buffer, sizeof(recv_buffer), MSG_DONTWAIT);
+            if (received < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+                return false;
+            }
+
+            const uint8_t* data;
+            uint32_t msg_size, msg_id;
+            uint8_t wire_flags;
+            if (!parseDatagram(recv_buffer, received, data, msg_size, msg_id, wire_flags)) continue;
+            if (isCallbackMessage(msg_id)) {
+                handleBroadcastMessage(msg_id, data, msg_size, wire_flags);
+                continue;
+            }
+            if (msg_id != expected_msg_id && !isStreamMessage(msg_id)) continue;
+            QueuedMessage msg;
+            msg.msg_id = msg_id;
+            msg.wire_flags = wire_flags;
+            msg.data.assign(data, data + msg_size);
+            if (matchesResponse(msg, expected_msg_id, stream_id)) {
+                response_msg = std::move(msg);
+                return true;
+            }
+            if (isStreamMessage(msg_id)) {
+                std::lock_guard<std::mutex> lock(queue_mutex_);
+                rpc_response_queue_.push(std::move(msg));
+            }
+        }
+        return false;
+    }
+
+    // Chunks of server streams and upload credit, which may arrive while their
+    // call is not receiving
+    static bool isStreamMessage(uint32_t msg_id) {
+        switch (msg_id) {
+            case MSG_SCAN_RESP:
+            case MSG_CTRL_STREAM_CREDIT:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // Grant the server credit for more chunks of a stream (send_mutex_ held)
+    void sendStreamCredit(uint32_t stream_id, uint32_t credit) {
+        uint8_t message[16] = {0, 0, 0, 12};
+        const uint32_t fields[3] = {MSG_CTRL_STREAM_CREDIT, stream_id, credit};
+        for (int i = 0; i < 3; i++) {
+            message[4 + i * 4] = (fields[i] >> 24) & 0xFF;
+            message[5 + i * 4] = (fields[i] >> 16) & 0xFF;
+            message[6 + i * 4] = (fields[i] >> 8) & 0xFF;
+            message[7 + i * 4] = fields[i] & 0xFF;
+        }
+        sendData(message, sizeof(message));
+    }
+
+    // Block (up to 5 s) for credit the server grants to an upload; 0 on timeout (send_mutex_ held)
+    uint32_t waitStreamCredit(uint32_t stream_id) {
+        QueuedMessage credit_msg;
+        if (!waitForResponse(MSG_CTRL_STREAM_CREDIT, credit_msg, stream_id)) return 0;
+        ByteReader reader(credit_msg.data.data(), credit_msg.data.size());
+        reader.readUint32();
+        reader.readUint32();
+        return reader.canRead(4) ? reader.readUint32() : 0;
+    }
+
+    // Discard queued messages with this ID (and stream ID, unless 0)
+    void dropQueued(uint32_t msg_id, uint32_t stream_id = 0) {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        std::queue<QueuedMessage> kept;
+        while (!rpc_response_queue_.empty()) {
+            if (!matchesResponse(rpc_response_queue_.front(), msg_id, stream_id)) {
+                kept.push(rpc_response_queue_.front());
             }
+            rpc_response_queue_.pop();
         }
+        rpc_response_queue_ = kept;
     }
 
     bool isCallbackMessage(uint32_t msg_id) {
@@ -799,26 +2935,33 @@ private:
         }
     }
 
-    void handleBroadcastMessage(uint32_t msg_id, const uint8_t* data, size_t size) {
-        ByteReader reader(data, size);
+    // Pushes arrive in the encoding this client negotiated (carried in the frame)
+    void handleBroadcastMessage(uint32_t msg_id, const uint8_t* data, size_t size, uint8_t wire_flags) {
+        ByteReader reader(data, size, wire_flags);
         
         switch (msg_id) {
             case MSG_ONKEYCHANGED_REQ: {
-                onKeyChangedRequest request;
-                request.deserialize(reader);
-                onKeyChanged(request.event);
+                std::shared_ptr<onKeyChangedRequest> request = std::make_shared<onKeyChangedRequest>();
+                request->deserialize(reader);
+                dispatchCallback(std::hash<std::string>()(request->event.key), [this, request]() {
+                    onKeyChanged(request->event);
+                });
                 break;
             }
             case MSG_ONBATCHCHANGED_REQ: {
-                onBatchChangedRequest request;
-                request.deserialize(reader);
-                onBatchChanged(request.events);
+                std::shared_ptr<onBatchChangedRequest> request = std::make_shared<onBatchChangedRequest>();
+                request->deserialize(reader);
+                dispatchCallback(MSG_ONBATCHCHANGED_REQ, [this, request]() {
+                    onBatchChanged(request->events);
+                });
                 break;
             }
             case MSG_ONCONNECTIONSTATUS_REQ: {
-                onConnectionStatusRequest request;
-                request.deserialize(reader);
-                onConnectionStatus(request.connected);
+                std::shared_ptr<onConnectionStatusRequest> request = std::make_shared<onConnectionStatusRequest>();
+                request->deserialize(reader);
+                dispatchCallback(MSG_ONCONNECTIONSTATUS_REQ, [this, request]() {
+                    onConnectionStatus(request->connected);
+                });
                 break;
             }
             default:
@@ -827,14 +2970,22 @@ private:
         }
     }
 
+    void dispatchCallback(size_t partition, std::function<void()> task) {
+        if (dispatcher_) {
+            dispatcher_->dispatch(partition, std::move(task));
+        } else {
+            task();
+        }
+    }
+
 protected:
     // Callback methods (marked with 'callback' keyword in IDL)
-    virtual void onKeyChanged(ChangeEvent event) {
+    virtual void onKeyChanged(const ChangeEvent& event) {
         // Override to handle onKeyChanged callback from server
         std::cout << "[Client] 📢 Callback: onKeyChanged" << std::endl;
     }
 
-    virtual void onBatchChanged(std::vector<ChangeEvent> events) {
+    virtual void onBatchChanged(const std::vector<ChangeEvent>& events) {
         // Override to handle onBatchChanged callback from server
         std::cout << "[Client] 📢 Callback: onBatchChanged" << std::endl;
     }
@@ -851,67 +3002,31 @@ public:
             return bool();
         }
 
-        // Prepare request
-        setRequest request;
-        request.key = key;
-        request.value = value;
-
         // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_SET_REQ);
+        setRequest::serializeFields(buffer, key, value);
         
-        // Prepare UDP datagram: size(4 bytes) + data
-        uint32_t msg_size = buffer.size();
-        uint8_t send_buffer[65536];
-        send_buffer[0] = (msg_size >> 24) & 0xFF;
-        send_buffer[1] = (msg_size >> 16) & 0xFF;
-        send_buffer[2] = (msg_size >> 8) & 0xFF;
-        send_buffer[3] = msg_size & 0xFF;
-        memcpy(send_buffer + 4, buffer.data(), msg_size);
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
         
         // Send complete datagram
-        if (sendData(send_buffer, msg_size + 4) < 0) {
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
             return bool();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_SET_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return bool(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_SET_RESP, response_msg)) {
+            return bool(); // Timeout
         }
 
         setResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
         return response.return_value;
@@ -922,69 +3037,34 @@ public:
             return std::string();
         }
 
-        // Prepare request
-        getRequest request;
-        request.key = key;
-
         // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_GET_REQ);
+        getRequest::serializeFields(buffer, key);
         
-        // Prepare UDP datagram: size(4 bytes) + data
-        uint32_t msg_size = buffer.size();
-        uint8_t send_buffer[65536];
-        send_buffer[0] = (msg_size >> 24) & 0xFF;
-        send_buffer[1] = (msg_size >> 16) & 0xFF;
-        send_buffer[2] = (msg_size >> 8) & 0xFF;
-        send_buffer[3] = msg_size & 0xFF;
-        memcpy(send_buffer + 4, buffer.data(), msg_size);
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
         
         // Send complete datagram
-        if (sendData(send_buffer, msg_size + 4) < 0) {
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
             return std::string();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_GET_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return std::string(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_GET_RESP, response_msg)) {
+            return std::string(); // Timeout
         }
 
         getResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
-        return response.return_value;
+        return std::move(response.return_value);
     }
 
     bool remove(const std::string& key) {
@@ -992,66 +3072,31 @@ public:
             return bool();
         }
 
-        // Prepare request
-        removeRequest request;
-        request.key = key;
-
         // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_REMOVE_REQ);
+        removeRequest::serializeFields(buffer, key);
         
-        // Prepare UDP datagram: size(4 bytes) + data
-        uint32_t msg_size = buffer.size();
-        uint8_t send_buffer[65536];
-        send_buffer[0] = (msg_size >> 24) & 0xFF;
-        send_buffer[1] = (msg_size >> 16) & 0xFF;
-        send_buffer[2] = (msg_size >> 8) & 0xFF;
-        send_buffer[3] = msg_size & 0xFF;
-        memcpy(send_buffer + 4, buffer.data(), msg_size);
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
         
         // Send complete datagram
-        if (sendData(send_buffer, msg_size + 4) < 0) {
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
             return bool();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_REMOVE_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return bool(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_REMOVE_RESP, response_msg)) {
+            return bool(); // Timeout
         }
 
         removeResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
         return response.return_value;
@@ -1062,66 +3107,31 @@ public:
             return bool();
         }
 
-        // Prepare request
-        existsRequest request;
-        request.key = key;
-
         // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_EXISTS_REQ);
+        existsRequest::serializeFields(buffer, key);
         
-        // Prepare UDP datagram: size(4 bytes) + data
-        uint32_t msg_size = buffer.size();
-        uint8_t send_buffer[65536];
-        send_buffer[0] = (msg_size >> 24) & 0xFF;
-        send_buffer[1] = (msg_size >> 16) & 0xFF;
-        send_buffer[2] = (msg_size >> 8) & 0xFF;
-        send_buffer[3] = msg_size & 0xFF;
-        memcpy(send_buffer + 4, buffer.data(), msg_size);
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
         
         // Send complete datagram
-        if (sendData(send_buffer, msg_size + 4) < 0) {
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
             return bool();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_EXISTS_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return bool(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_EXISTS_RESP, response_msg)) {
+            return bool(); // Timeout
         }
 
         existsResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
         return response.return_value;
@@ -1132,240 +3142,311 @@ public:
             return int64_t();
         }
 
-        // Prepare request
-        countRequest request;
+        // Serialize and send request via UDP (thread-safe)
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_COUNT_REQ);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
+            return int64_t();
+        }
+
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
+        QueuedMessage response_msg;
+        if (!waitForResponse(MSG_COUNT_RESP, response_msg)) {
+            return int64_t(); // Timeout
+        }
+
+        countResponse response;
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
+        response.deserialize(reader);
+
+        return response.return_value;
+    }
+
+    bool clear() {
+        if (!connected_) {
+            return false;
+        }
 
         // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_CLEAR_REQ);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
+            return false;
+        }
+
+        return true;
+    }
+
+    int64_t batchSet(const std::vector<KeyValue>& items) {
+        if (!connected_) {
+            return int64_t();
+        }
+
+        // Serialize and send request via UDP (thread-safe)
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_BATCHSET_REQ);
+        batchSetRequest::serializeFields(buffer, items);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
+            return int64_t();
+        }
+
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
+        QueuedMessage response_msg;
+        if (!waitForResponse(MSG_BATCHSET_RESP, response_msg)) {
+            return int64_t(); // Timeout
+        }
+
+        batchSetResponse response;
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
+        response.deserialize(reader);
+
+        return response.return_value;
+    }
+
+    bool batchGet(const std::vector<std::string>& keys, std::vector<std::string>& values, std::vector<OperationStatus>& status) {
+        if (!connected_) {
+            return false;
+        }
+
+        // Serialize and send request via UDP (thread-safe)
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_BATCHGET_REQ);
+        batchGetRequest::serializeFields(buffer, keys);
         
-        // Prepare UDP datagram: size(4 bytes) + data
-        uint32_t msg_size = buffer.size();
-        uint8_t send_buffer[65536];
-        send_buffer[0] = (msg_size >> 24) & 0xFF;
-        send_buffer[1] = (msg_size >> 16) & 0xFF;
-        send_buffer[2] = (msg_size >> 8) & 0xFF;
-        send_buffer[3] = msg_size & 0xFF;
-        memcpy(send_buffer + 4, buffer.data(), msg_size);
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
         
         // Send complete datagram
-        if (sendData(send_buffer, msg_size + 4) < 0) {
-            return int64_t();
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
+            return false;
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_COUNT_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return int64_t(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_BATCHGET_RESP, response_msg)) {
+            return false; // Timeout
         }
 
-        countResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        batchGetResponse response;
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
-        return response.return_value;
+        values = std::move(response.values);
+        status = std::move(response.status);
+        return response.response_status == 0;
     }
 
-    bool clear() {
+    std::unordered_map<std::string, std::string> batchGetMap(const std::vector<std::string>& keys) {
         if (!connected_) {
-            return false;
+            return std::unordered_map<std::string, std::string>();
         }
 
-        // Prepare request
-        clearRequest request;
-
         // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_BATCHGETMAP_REQ);
+        batchGetMapRequest::serializeFields(buffer, keys);
         
-        // Prepare UDP datagram: size(4 bytes) + data
-        uint32_t msg_size = buffer.size();
-        uint8_t send_buffer[65536];
-        send_buffer[0] = (msg_size >> 24) & 0xFF;
-        send_buffer[1] = (msg_size >> 16) & 0xFF;
-        send_buffer[2] = (msg_size >> 8) & 0xFF;
-        send_buffer[3] = msg_size & 0xFF;
-        memcpy(send_buffer + 4, buffer.data(), msg_size);
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
         
         // Send complete datagram
-        if (sendData(send_buffer, msg_size + 4) < 0) {
-            return false;
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
+            return std::unordered_map<std::string, std::string>();
         }
 
-        return true;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
+        QueuedMessage response_msg;
+        if (!waitForResponse(MSG_BATCHGETMAP_RESP, response_msg)) {
+            return std::unordered_map<std::string, std::string>(); // Timeout
+        }
+
+        batchGetMapResponse response;
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
+        response.deserialize(reader);
+
+        return std::move(response.return_value);
     }
 
-    int64_t batchSet(std::vector<KeyValue> items) {
+    // Server-streaming call: on_item runs for each item as its chunk arrives.
+    // Returns false on timeout or when a chunk was lost. on_item runs without
+    // the client's send lock, so it may call this client again (another stream
+    // call included); each on_item call should return within 5 seconds, the
+    // time the server waits without hearing from the reader.
+    bool scan(const std::string& prefix, std::function<void(const KeyValue&)> on_item) {
         if (!connected_) {
-            return int64_t();
+            return false;
         }
 
         // Prepare request
-        batchSetRequest request;
-        request.items = items;
+        scanRequest request;
+        request.prefix = prefix;
 
         // Serialize and send request via UDP (thread-safe)
-        std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
+        std::unique_lock<std::mutex> lock(send_mutex_);
+        request.stream_id = ++next_stream_id_;
+        request.credit = stream_window_;
+        request.max_delay_ms = static_cast<uint32_t>(stream_chunk_delay_.count());
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
         request.serialize(buffer);
         
-        // Prepare UDP datagram: size(4 bytes) + data
-        uint32_t msg_size = buffer.size();
-        uint8_t send_buffer[65536];
-        send_buffer[0] = (msg_size >> 24) & 0xFF;
-        send_buffer[1] = (msg_size >> 16) & 0xFF;
-        send_buffer[2] = (msg_size >> 8) & 0xFF;
-        send_buffer[3] = msg_size & 0xFF;
-        memcpy(send_buffer + 4, buffer.data(), msg_size);
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
         
         // Send complete datagram
-        if (sendData(send_buffer, msg_size + 4) < 0) {
-            return int64_t();
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
+            return false;
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_BATCHSET_RESP;
-        QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return int64_t(); // Timeout
+        // Receive chunks in order; hand credit back once half the window is consumed.
+        // The lock is held only while receiving and sending, never around on_item.
+        uint32_t expected_seq = 0;
+        uint32_t consumed = 0;
+        bool complete = false;
+        auto last_sent = std::chrono::steady_clock::now();
+        while (true) {
+            QueuedMessage chunk_msg;
+            if (!waitForResponse(MSG_SCAN_RESP, chunk_msg, request.stream_id)) {
+                break; // Timeout
             }
 
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
+            ByteReader reader(chunk_msg.data.data(), chunk_msg.data.size(), chunk_msg.wire_flags);
+            StreamChunkHeader header;
+            header.deserialize(reader);
+            if (header.seq != expected_seq++) break;  // Chunk lost
+            lock.unlock();
+            for (uint32_t i = 0; i < header.count; i++) {
+                KeyValue item;
+                item.deserialize(reader);
+                on_item(item);
+                if (std::chrono::steady_clock::now() - last_sent >= std::chrono::seconds(1)) {
+                    // Slow consumer: keep the server waiting for credit instead of giving up
+                    std::lock_guard<std::mutex> keepalive_lock(send_mutex_);
+                    sendStreamCredit(request.stream_id, 0);
+                    last_sent = std::chrono::steady_clock::now();
                 }
-                rpc_response_queue_.pop();
             }
-            rpc_response_queue_ = temp_queue;
+            lock.lock();
+            if (header.last) {
+                complete = true;
+                break;
+            }
+            if (++consumed >= (request.credit + 1) / 2) {
+                sendStreamCredit(request.stream_id, consumed);
+                last_sent = std::chrono::steady_clock::now();
+                consumed = 0;
+            }
         }
-
-        batchSetResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
-        response.deserialize(reader);
-
-        return response.return_value;
+        if (!complete) {
+            // Chunks of the abandoned stream already queued would never be collected
+            dropQueued(MSG_SCAN_RESP, request.stream_id);
+        }
+        return complete;
     }
 
-    bool batchGet(std::vector<std::string> keys, std::vector<std::string>& values, std::vector<OperationStatus>& status) {
+    // Client-streaming call: items(writer) produces the items; each
+    // writer.write() goes out in chunks as soon as the server grants credit.
+    // items runs without the client's send lock, so it may call this
+    // client again (another stream call included).
+    int64_t load(std::function<void(StreamWriter<KeyValue>&)> items) {
         if (!connected_) {
-            return false;
+            return int64_t();
         }
 
         // Prepare request
-        batchGetRequest request;
-        request.keys = keys;
+        loadRequest request;
 
         // Serialize and send request via UDP (thread-safe)
-        std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
+        std::unique_lock<std::mutex> lock(send_mutex_);
+        request.stream_id = ++next_stream_id_;
+        request.credit = stream_window_;
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
         request.serialize(buffer);
         
-        // Prepare UDP datagram: size(4 bytes) + data
-        uint32_t msg_size = buffer.size();
-        uint8_t send_buffer[65536];
-        send_buffer[0] = (msg_size >> 24) & 0xFF;
-        send_buffer[1] = (msg_size >> 16) & 0xFF;
-        send_buffer[2] = (msg_size >> 8) & 0xFF;
-        send_buffer[3] = msg_size & 0xFF;
-        memcpy(send_buffer + 4, buffer.data(), msg_size);
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
         
         // Send complete datagram
-        if (sendData(send_buffer, msg_size + 4) < 0) {
-            return false;
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
+            return int64_t();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_BATCHGET_RESP;
-        QueuedMessage response_msg;
+        // Upload the stream, paced by the credit the server returns. The lock is
+        // taken only to receive credit; a chunk is a single sendto() and needs none.
+        lock.unlock();
         {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return false; // Timeout
+            StreamWriter<KeyValue> writer(sockfd_, addr_, MSG_LOAD_CHUNK,
+                request.stream_id, request.credit,
+                [](ByteBuffer& buffer, const KeyValue& item) { item.serialize(buffer); });
+            writer.setWireFormat(wire_flags_, compress_threshold_);
+            writer.setMaxDelay(stream_chunk_delay_);
+            uint32_t stream_id = request.stream_id;
+            writer.setCreditSource([this, stream_id]() {
+                std::lock_guard<std::mutex> credit_lock(send_mutex_);
+                return waitStreamCredit(stream_id);
+            });
+            items(writer);
+            bool uploaded = writer.finish();
+            if (!uploaded) {
+                return int64_t();
             }
+        }
+        lock.lock();
 
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
+        QueuedMessage response_msg;
+        if (!waitForResponse(MSG_LOAD_RESP, response_msg)) {
+            return int64_t(); // Timeout
         }
 
-        batchGetResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        loadResponse response;
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
-        values = response.values;
-        status = response.status;
-        return response.response_status == 0;
+        // Credit granted after the last chunk went out is no longer needed
+        dropQueued(MSG_CTRL_STREAM_CREDIT, request.stream_id);
+
+        return response.return_value;
     }
 
 };
@@ -1376,10 +3457,60 @@ private:
     int sockfd_;  // UDP socket
     bool running_;
     std::map<std::string, struct sockaddr_in> clients_;  // Track clients by address
+    std::map<std::string, struct sockaddr_in> callback_routes_;  // Client key -> dedicated callback socket
+    std::map<std::string, std::chrono::steady_clock::time_point> client_seen_;  // Last request per client
+    std::map<std::string, uint8_t> client_wire_flags_;  // Encodings each client agreed to in MSG_CTRL_HELLO
     mutable std::mutex clients_mutex_;
 
+    // Callback channel registration: a token is issued to the client's RPC socket and
+    // must come back with CALLBACK_CHANNEL_REQ, so only the owner of an RPC address
+    // can route its callbacks elsewhere
+    struct ChannelToken {
+        uint64_t value;
+        std::chrono::steady_clock::time_point issued;
+    };
+    std::map<std::string, ChannelToken> channel_tokens_;  // RPC client key -> pending token
+    std::mt19937_64 token_rng_;
+    std::chrono::seconds client_timeout_;  // Idle clients are forgotten after this (0 = never)
+    std::chrono::steady_clock::time_point last_sweep_;
+    static const size_t kMaxPendingTokens = 1024;
+
+    // Wire encodings offered to clients, and the encoding of the request being
+    // handled on the run() thread (responses are sent back in the same encoding)
+    uint8_t accepted_wire_flags_;
+    uint8_t request_wire_flags_;
+    size_t compress_threshold_;       // With WIRE_LZ: responses larger than this are compressed
+    std::vector<uint8_t> inflated_;   // Decompressed request being handled (run() thread)
+
+    // Frames of the callback being broadcast, one per wire encoding in use; kept
+    // between broadcasts so their storage is reused (under clients_mutex_)
+    struct PushFrame {
+        uint8_t flags;
+        size_t size;
+        std::vector<uint8_t> bytes;
+    };
+    std::vector<PushFrame> push_frames_;
+
+    // Callback batching (@batch): per-item pushes accumulate into batch callbacks
+    std::thread batch_thread_;
+    std::mutex batch_mutex_;
+    std::mutex batch_flush_mutex_;
+    std::condition_variable batch_cv_;
+    bool batching_;
+    std::chrono::milliseconds batch_window_;
+    size_t batch_max_events_;
+    std::vector<ChangeEvent> pending_onKeyChanged_;
+
+    // Streaming calls (stream<T>): each handler runs on its own thread
+    struct ActiveStream {
+        std::shared_ptr<StreamBase> stream;
+        std::thread thread;
+    };
+    std::map<std::string, ActiveStream> streams_;  // "client/stream_id" -> stream
+    std::mutex streams_mutex_;
+
 public:
-    KeyValueStoreServer() : sockfd_(-1), running_(false) {}
+    KeyValueStoreServer() : sockfd_(-1), running_(false), token_rng_(std::random_device()()), client_timeout_(0), accepted_wire_flags_(WIRE_SUPPORTED), request_wire_flags_(0), compress_threshold_(WIRE_LZ_THRESHOLD), batching_(false), batch_window_(0), batch_max_events_(256) {}
 
     ~KeyValueStoreServer() {
         stop();
@@ -1405,12 +3536,17 @@ public:
             return false;
         }
 
+        resetWake();
         running_ = true;
         return true;
     }
 
     void stop() {
+        // Deliver pending batches while the socket is still open
+        stopBatching();
+        stopStreams();
         running_ = false;
+        wake();  // Unblock run() immediately
         
         if (sockfd_ >= 0) {
             close(sockfd_);
@@ -1419,11 +3555,19 @@ public:
         
         std::lock_guard<std::mutex> lock(clients_mutex_);
         clients_.clear();
+        callback_routes_.clear();
+        client_seen_.clear();
+        client_wire_flags_.clear();
+        channel_tokens_.clear();
     }
 
     // Main server loop - receive UDP datagrams
+    // The calling thread takes on the configured ThreadOptions
     void run() {
+        thread_options_.applyOrReport("srv", &placement_failures_);
         while (running_) {
+            if (!waitReadable(sockfd_)) break;
+
             uint8_t recv_buffer[65536];
             struct sockaddr_in client_addr;
             socklen_t addr_len = sizeof(client_addr);
@@ -1436,54 +3580,93 @@ public:
                 break;
             }
 
-            // Register client address
-            {
-                std::lock_guard<std::mutex> lock(clients_mutex_);
-                char client_key[64];
-                sprintf(client_key, "%s:%d", 
-                        inet_ntoa(client_addr.sin_addr), 
-                        ntohs(client_addr.sin_port));
-                clients_[client_key] = client_addr;
-            }
-
-            // Parse: first 4 bytes = size, rest = data
+            // Parse: flags(1) + size(3), rest = data
             if (received < 8) continue;
             
-            uint32_t msg_size = (static_cast<uint32_t>(recv_buffer[0]) << 24) |
-                                (static_cast<uint32_t>(recv_buffer[1]) << 16) |
+            uint8_t wire_flags = recv_buffer[0];
+            uint32_t msg_size = (static_cast<uint32_t>(recv_buffer[1]) << 16) |
                                 (static_cast<uint32_t>(recv_buffer[2]) << 8) |
                                 static_cast<uint32_t>(recv_buffer[3]);
 
             if (received != msg_size + 4) continue;
 
-            uint8_t* data = recv_buffer + 4;
-            handleClientRequest(&client_addr, data, msg_size);
+            const uint8_t* data = recv_buffer + 4;
+            if (!inflateFrame(wire_flags, data, msg_size, inflated_)) continue;
+            if (handleControlMessage(&client_addr, data, msg_size)) continue;
+
+            // Register client address
+            {
+                std::lock_guard<std::mutex> lock(clients_mutex_);
+                touchClient(clientKey(client_addr), client_addr);
+            }
+
+            request_wire_flags_ = wire_flags;
+            try {
+                handleClientRequest(&client_addr, data, msg_size);
+            } catch (const std::exception&) {
+                // Malformed request (count beyond the datagram, truncated field): drop it
+            }
         }
     }
 
     // Broadcast message to all known clients (with serialization)
     template<typename T>
-    void broadcast(const T& message) {
+    bool broadcast(const T& message) {
+        return broadcastEncoded([&message](ByteBuffer& buffer) { message.serialize(buffer); });
+    }
+
+    // Broadcast whatever encode(buffer) writes (msg_id first), framed like every other
+    // message in the encoding each client negotiated. Returns false and sends nothing
+    // if a frame exceeds one datagram
+    template<typename Encode>
+    bool broadcastEncoded(Encode encode) {
         std::lock_guard<std::mutex> lock(clients_mutex_);
         
-        // Serialize message once
-        ByteBuffer buffer;
-        message.serialize(buffer);
-        
-        // Prepare datagram: size(4 bytes) + data
-        uint32_t msg_size = buffer.size();
-        uint8_t send_buffer[65536];
-        send_buffer[0] = (msg_size >> 24) & 0xFF;
-        send_buffer[1] = (msg_size >> 16) & 0xFF;
-        send_buffer[2] = (msg_size >> 8) & 0xFF;
-        send_buffer[3] = msg_size & 0xFF;
-        memcpy(send_buffer + 4, buffer.data(), msg_size);
+        // Serialize message once per wire encoding in use
+        size_t frame_count = 0;
+        for (const auto& pair : clients_) {
+            uint8_t flags = clientWireFlags(pair.first);
+            if (findPushFrame(flags, frame_count)) continue;
+            if (frame_count == push_frames_.size()) push_frames_.emplace_back();
+            PushFrame& frame = push_frames_[frame_count++];
+            PooledByteBuffer pooled;
+            ByteBuffer& buffer = *pooled;
+            buffer.setWireFlags(flags);
+            encode(buffer);
+            
+            // Prepare datagram: flags(1) + size(3) + data
+            frame.flags = flags;
+            frame.bytes.resize(FRAME_MAX_BYTES);
+            frame.size = encodeFrame(buffer, compress_threshold_, frame.bytes.data());
+            if (frame.size == 0 || frame.size > UDP_MAX_PAYLOAD) return false;
+        }
         
-        // Send to all known clients
+        // Send to all known clients (on their callback socket if they registered one)
         for (const auto& pair : clients_) {
-            sendto(sockfd_, send_buffer, msg_size + 4, 0,
-                   (struct sockaddr*)&pair.second, sizeof(pair.second));
+            const PushFrame* frame = findPushFrame(clientWireFlags(pair.first), frame_count);
+            auto route = callback_routes_.find(pair.first);
+            const struct sockaddr_in& dest = route != callback_routes_.end() ? route->second : pair.second;
+            sendto(sockfd_, frame->bytes.data(), frame->size, 0,
+                   (struct sockaddr*)&dest, sizeof(dest));
         }
+        return true;
+    }
+
+    // Restrict the wire encodings clients may negotiate (WireFlag bits)
+    void setAcceptedWireFlags(uint8_t flags) {
+        accepted_wire_flags_ = flags & WIRE_SUPPORTED;
+    }
+
+    // Responses above this many bytes are compressed for clients that negotiated WIRE_LZ
+    void setCompressionThreshold(size_t bytes) { compress_threshold_ = bytes; }
+
+    // Clients that send nothing for this long are forgotten along with their callback
+    // route; any request registers them again. The default 0 keeps them until they
+    // disconnect. Only requests count as activity, so a client that just listens for
+    // pushes is dropped once the timeout passes
+    void setClientTimeout(std::chrono::seconds timeout) {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        client_timeout_ = timeout;
     }
 
     // Get number of known clients
@@ -1492,8 +3675,268 @@ public:
         return clients_.size();
     }
 
+    // Enable callback batching: per-item pushes accumulate for `window` and go
+    // out as batch callbacks of at most `max_events` items, split further so that
+    // each one fits in a datagram.
+    // A zero window disables batching and every push is sent immediately.
+    void setBatchWindow(std::chrono::milliseconds window, size_t max_events = 256) {
+        stopBatching();
+        if (window.count() <= 0) return;
+        {
+            std::lock_guard<std::mutex> lock(batch_mutex_);
+            batch_window_ = window;
+            batch_max_events_ = max_events > 0 ? max_events : 1;
+            batching_ = true;
+        }
+        batch_thread_ = spawnThread("batch", [this]() { batchLoop(); });
+    }
+
+    // Send all accumulated events now
+    void flushBatches() {
+        std::lock_guard<std::mutex> flush_lock(batch_flush_mutex_);
+        std::vector<ChangeEvent> onKeyChanged_events;
+        size_t max_events;
+        {
+            std::lock_guard<std::mutex> lock(batch_mutex_);
+            onKeyChanged_events.swap(pending_onKeyChanged_);
+            max_events = batch_max_events_;
+        }
+        for (size_t i = 0; i < onKeyChanged_events.size(); i += max_events) {
+            sendBatch_onBatchChanged(onKeyChanged_events, i, std::min(onKeyChanged_events.size(), i + max_events));
+        }
+    }
+
 private:
-    void handleClientRequest(struct sockaddr_in* client_addr, uint8_t* data, size_t data_size) {
+    static std::string clientKey(const struct sockaddr_in& addr) {
+        char client_key[64];
+        sprintf(client_key, "%s:%d", inet_ntoa(addr.sin_addr), ntohs(addr.sin_port));
+        return client_key;
+    }
+
+    // Record a request from a client and, at most once a second, drop expired
+    // channel tokens and clients idle for longer than client_timeout_
+    // (caller holds clients_mutex_)
+    void touchClient(const std::string& key, const struct sockaddr_in& addr) {
+        auto now = std::chrono::steady_clock::now();
+        clients_[key] = addr;
+        client_seen_[key] = now;
+        if (now - last_sweep_ < std::chrono::seconds(1)) return;
+        last_sweep_ = now;
+        for (auto it = channel_tokens_.begin(); it != channel_tokens_.end();) {
+            if (now - it->second.issued > std::chrono::seconds(10)) it = channel_tokens_.erase(it);
+            else ++it;
+        }
+        if (client_timeout_.count() == 0) return;
+        std::vector<std::string> idle;
+        for (const auto& seen : client_seen_) {
+            if (now - seen.second > client_timeout_) idle.push_back(seen.first);
+        }
+        for (const auto& idle_key : idle) dropClient(idle_key);
+    }
+
+    // Encoding a client agreed to in MSG_CTRL_HELLO, 0 if it never negotiated
+    // (caller holds clients_mutex_)
+    uint8_t clientWireFlags(const std::string& key) const {
+        auto it = client_wire_flags_.find(key);
+        return it != client_wire_flags_.end() ? it->second : 0;
+    }
+
+    // The first count entries of push_frames_ hold the frames of the current broadcast
+    const PushFrame* findPushFrame(uint8_t flags, size_t count) const {
+        for (size_t i = 0; i < count; i++) {
+            if (push_frames_[i].flags == flags) return &push_frames_[i];
+        }
+        return nullptr;
+    }
+
+    // Forget a client and its callback route (caller holds clients_mutex_)
+    void dropClient(const std::string& key) {
+        clients_.erase(key);
+        callback_routes_.erase(key);
+        client_seen_.erase(key);
+        client_wire_flags_.erase(key);
+        channel_tokens_.erase(key);
+    }
+
+    // Send a control message built in buffer to addr
+    void sendControl(const ByteBuffer& buffer, const struct sockaddr_in* addr) {
+        uint8_t frame[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, FRAME_MAX_BYTES, frame);
+        sendto(sockfd_, frame, frame_size, 0, (const struct sockaddr*)addr, sizeof(*addr));
+    }
+
+    // Runtime control messages; returns false for regular IDL requests
+    bool handleControlMessage(struct sockaddr_in* from_addr, const uint8_t* data, size_t data_size) {
+        ByteReader reader(data, data_size);
+        uint32_t msg_id = reader.readMsgId();
+        if (msg_id == MSG_CTRL_STREAM_CREDIT) {
+            if (!reader.canRead(8)) return true;
+            uint32_t stream_id = reader.readUint32();
+            uint32_t credit = reader.readUint32();
+            std::lock_guard<std::mutex> lock(streams_mutex_);
+            auto it = streams_.find(clientKey(*from_addr) + "/" + std::to_string(stream_id));
+            if (it != streams_.end()) it->second.stream->addCredit(credit);
+            return true;
+        }
+        if (msg_id == MSG_CTRL_HELLO) {
+            if (!reader.canRead(1)) return true;
+            uint8_t ack[9] = {0, 0, 0, 5};
+            ack[4] = (MSG_CTRL_HELLO_ACK >> 24) & 0xFF;
+            ack[5] = (MSG_CTRL_HELLO_ACK >> 16) & 0xFF;
+            ack[6] = (MSG_CTRL_HELLO_ACK >> 8) & 0xFF;
+            ack[7] = MSG_CTRL_HELLO_ACK & 0xFF;
+            ack[8] = reader.readUint8() & accepted_wire_flags_;
+            {
+                // Callbacks pushed to this client use the same encoding
+                std::lock_guard<std::mutex> lock(clients_mutex_);
+                if (ack[8]) client_wire_flags_[clientKey(*from_addr)] = ack[8];
+                else client_wire_flags_.erase(clientKey(*from_addr));
+            }
+            sendto(sockfd_, ack, sizeof(ack), 0, (struct sockaddr*)from_addr, sizeof(*from_addr));
+            return true;
+        }
+        if (msg_id == MSG_CTRL_CALLBACK_TOKEN_REQ) {
+            // Answered on the RPC socket it came from: only that socket's owner sees the token
+            ByteBuffer reply;
+            reply.writeMsgId(MSG_CTRL_CALLBACK_TOKEN);
+            {
+                std::lock_guard<std::mutex> lock(clients_mutex_);
+                std::string key = clientKey(*from_addr);
+                if (channel_tokens_.size() >= kMaxPendingTokens && !channel_tokens_.count(key)) return true;
+                ChannelToken token = {token_rng_(), std::chrono::steady_clock::now()};
+                channel_tokens_[key] = token;
+                reply.writeUint64(token.value);
+            }
+            sendControl(reply, from_addr);
+            return true;
+        }
+        if (msg_id == MSG_CTRL_BYE) {
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            dropClient(clientKey(*from_addr));
+            return true;
+        }
+        if (msg_id != MSG_CTRL_CALLBACK_CHANNEL_REQ) return false;
+        if (!reader.canRead(10)) return true;
+
+        // The client announces its RPC socket port from its callback socket, with the
+        // token the server issued to that RPC socket; anything else is ignored
+        struct sockaddr_in rpc_addr = *from_addr;
+        rpc_addr.sin_port = htons(reader.readUint16());
+        uint64_t token = reader.readUint64();
+        {
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            std::string key = clientKey(rpc_addr);
+            auto issued = channel_tokens_.find(key);
+            if (issued == channel_tokens_.end() || issued->second.value != token) return true;
+            channel_tokens_.erase(issued);
+            touchClient(key, rpc_addr);
+            callback_routes_[key] = *from_addr;
+        }
+
+        uint8_t ack[8] = {0, 0, 0, 4};
+        ack[4] = (MSG_CTRL_CALLBACK_CHANNEL_ACK >> 24) & 0xFF;
+        ack[5] = (MSG_CTRL_CALLBACK_CHANNEL_ACK >> 16) & 0xFF;
+        ack[6] = (MSG_CTRL_CALLBACK_CHANNEL_ACK >> 8) & 0xFF;
+        ack[7] = MSG_CTRL_CALLBACK_CHANNEL_ACK & 0xFF;
+        sendto(sockfd_, ack, sizeof(ack), 0, (struct sockaddr*)from_addr, sizeof(*from_addr));
+        return true;
+    }
+
+    // Push events[begin, end) as onBatchChanged callbacks, halving any slice whose
+    // encoding exceeds one datagram; a single event that does not fit is dropped
+    void sendBatch_onBatchChanged(const std::vector<ChangeEvent>& events, size_t begin, size_t end) {
+        bool sent = begin == 0 && end == events.size()
+            ? push_onBatchChanged(events)  // Whole batch: no slice copy
+            : push_onBatchChanged(std::vector<ChangeEvent>(events.begin() + begin, events.begin() + end));
+        if (sent) return;
+        if (end - begin == 1) {
+            std::cerr << "[Server] onKeyChanged event larger than one datagram dropped" << std::endl;
+            return;
+        }
+        size_t middle = begin + (end - begin) / 2;
+        sendBatch_onBatchChanged(events, begin, middle);
+        sendBatch_onBatchChanged(events, middle, end);
+    }
+
+    void stopBatching() {
+        {
+            std::lock_guard<std::mutex> lock(batch_mutex_);
+            batching_ = false;
+        }
+        batch_cv_.notify_all();
+        if (batch_thread_.joinable()) {
+            batch_thread_.join();
+        }
+        flushBatches();
+    }
+
+    bool hasPendingBatches() const {
+        return !pending_onKeyChanged_.empty();
+    }
+
+    bool batchFull() const {
+        return pending_onKeyChanged_.size() >= batch_max_events_;
+    }
+
+    void batchLoop() {
+        std::unique_lock<std::mutex> lock(batch_mutex_);
+        while (batching_) {
+            batch_cv_.wait(lock, [this]() { return !batching_ || hasPendingBatches(); });
+            if (!batching_) break;
+            // Let the window fill so the events go out as one datagram
+            batch_cv_.wait_for(lock, batch_window_, [this]() { return !batching_ || batchFull(); });
+            lock.unlock();
+            flushBatches();
+            lock.lock();
+        }
+    }
+
+    // Run a stream handler on its own thread so run() keeps routing credit
+    void startStream(const std::string& key, std::shared_ptr<StreamBase> stream,
+                     std::function<void()> body) {
+        std::lock_guard<std::mutex> lock(streams_mutex_);
+        // Reap streams whose handler has returned
+        for (auto it = streams_.begin(); it != streams_.end();) {
+            if (it->second.stream->done()) {
+                if (it->second.thread.joinable()) it->second.thread.join();
+                it = streams_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (streams_.count(key)) return;  // Duplicate request
+        ActiveStream& active = streams_[key];
+        active.stream = stream;
+        active.thread = spawnThread("stream", body);
+    }
+
+    // Hand a client-stream chunk to the handler reading it
+    void routeStreamChunk(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
+        if (data_size < 8) return;  // msg_id + smallest (compact) StreamChunkHeader
+        ByteReader reader(data, data_size, request_wire_flags_);
+        StreamChunkHeader header;
+        header.deserialize(reader);
+        std::lock_guard<std::mutex> lock(streams_mutex_);
+        auto it = streams_.find(clientKey(*client_addr) + "/" + std::to_string(header.stream_id));
+        if (it != streams_.end()) it->second.stream->pushChunk(data, data_size);
+    }
+
+    // Cancel running stream handlers and wait for their threads
+    void stopStreams() {
+        std::map<std::string, ActiveStream> streams;
+        {
+            std::lock_guard<std::mutex> lock(streams_mutex_);
+            streams.swap(streams_);
+        }
+        for (auto& pair : streams) {
+            pair.second.stream->cancel();
+        }
+        for (auto& pair : streams) {
+            if (pair.second.thread.joinable()) pair.second.thread.join();
+        }
+    }
+
+    void handleClientRequest(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         // Parse message ID from data
         if (data_size < 4) return;
         
@@ -1527,228 +3970,327 @@ private:
                 case MSG_BATCHGET_REQ:
                     handle_batchGet(client_addr, data, data_size);
                     break;
+                case MSG_BATCHGETMAP_REQ:
+                    handle_batchGetMap(client_addr, data, data_size);
+                    break;
+                case MSG_SCAN_REQ:
+                    handle_scan(client_addr, data, data_size);
+                    break;
+                case MSG_LOAD_REQ:
+                    handle_load(client_addr, data, data_size);
+                    break;
+                case MSG_LOAD_CHUNK:
+                    routeStreamChunk(client_addr, data, data_size);
+                    break;
                 default:
                     break;
             }
     }
 
-    void handle_set(struct sockaddr_in* client_addr, uint8_t* data, size_t data_size) {
+    void handle_set(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         setRequest request;
-        ByteReader reader(data, data_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         setResponse response;
         response.return_value = onset(request.key, request.value);
 
         // Serialize and send response via UDP
-        ByteBuffer buffer;
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
         
-        // Prepare datagram: size(4) + data
-        uint32_t resp_size = buffer.size();
-        uint8_t send_buffer[65536];
-        send_buffer[0] = (resp_size >> 24) & 0xFF;
-        send_buffer[1] = (resp_size >> 16) & 0xFF;
-        send_buffer[2] = (resp_size >> 8) & 0xFF;
-        send_buffer[3] = resp_size & 0xFF;
-        memcpy(send_buffer + 4, buffer.data(), resp_size);
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
         
         // Send response datagram to client
-        sendto(sockfd_, send_buffer, resp_size + 4, 0,
-               (struct sockaddr*)client_addr, sizeof(*client_addr));
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
+        }
     }
 
-    void handle_get(struct sockaddr_in* client_addr, uint8_t* data, size_t data_size) {
+    void handle_get(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         getRequest request;
-        ByteReader reader(data, data_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         getResponse response;
         response.return_value = onget(request.key);
 
         // Serialize and send response via UDP
-        ByteBuffer buffer;
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
         
-        // Prepare datagram: size(4) + data
-        uint32_t resp_size = buffer.size();
-        uint8_t send_buffer[65536];
-        send_buffer[0] = (resp_size >> 24) & 0xFF;
-        send_buffer[1] = (resp_size >> 16) & 0xFF;
-        send_buffer[2] = (resp_size >> 8) & 0xFF;
-        send_buffer[3] = resp_size & 0xFF;
-        memcpy(send_buffer + 4, buffer.data(), resp_size);
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
         
         // Send response datagram to client
-        sendto(sockfd_, send_buffer, resp_size + 4, 0,
-               (struct sockaddr*)client_addr, sizeof(*client_addr));
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
+        }
     }
 
-    void handle_remove(struct sockaddr_in* client_addr, uint8_t* data, size_t data_size) {
+    void handle_remove(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         removeRequest request;
-        ByteReader reader(data, data_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         removeResponse response;
         response.return_value = onremove(request.key);
 
         // Serialize and send response via UDP
-        ByteBuffer buffer;
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
         
-        // Prepare datagram: size(4) + data
-        uint32_t resp_size = buffer.size();
-        uint8_t send_buffer[65536];
-        send_buffer[0] = (resp_size >> 24) & 0xFF;
-        send_buffer[1] = (resp_size >> 16) & 0xFF;
-        send_buffer[2] = (resp_size >> 8) & 0xFF;
-        send_buffer[3] = resp_size & 0xFF;
-        memcpy(send_buffer + 4, buffer.data(), resp_size);
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
         
         // Send response datagram to client
-        sendto(sockfd_, send_buffer, resp_size + 4, 0,
-               (struct sockaddr*)client_addr, sizeof(*client_addr));
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
+        }
     }
 
-    void handle_exists(struct sockaddr_in* client_addr, uint8_t* data, size_t data_size) {
+    void handle_exists(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         existsRequest request;
-        ByteReader reader(data, data_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         existsResponse response;
         response.return_value = onexists(request.key);
 
         // Serialize and send response via UDP
-        ByteBuffer buffer;
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
         
-        // Prepare datagram: size(4) + data
-        uint32_t resp_size = buffer.size();
-        uint8_t send_buffer[65536];
-        send_buffer[0] = (resp_size >> 24) & 0xFF;
-        send_buffer[1] = (resp_size >> 16) & 0xFF;
-        send_buffer[2] = (resp_size >> 8) & 0xFF;
-        send_buffer[3] = resp_size & 0xFF;
-        memcpy(send_buffer + 4, buffer.data(), resp_size);
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
         
         // Send response datagram to client
-        sendto(sockfd_, send_buffer, resp_size + 4, 0,
-               (struct sockaddr*)client_addr, sizeof(*client_addr));
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
+        }
     }
 
-    void handle_count(struct sockaddr_in* client_addr, uint8_t* data, size_t data_size) {
+    void handle_count(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         countRequest request;
-        ByteReader reader(data, data_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         countResponse response;
         response.return_value = oncount();
 
         // Serialize and send response via UDP
-        ByteBuffer buffer;
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
         
-        // Prepare datagram: size(4) + data
-        uint32_t resp_size = buffer.size();
-        uint8_t send_buffer[65536];
-        send_buffer[0] = (resp_size >> 24) & 0xFF;
-        send_buffer[1] = (resp_size >> 16) & 0xFF;
-        send_buffer[2] = (resp_size >> 8) & 0xFF;
-        send_buffer[3] = resp_size & 0xFF;
-        memcpy(send_buffer + 4, buffer.data(), resp_size);
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
         
         // Send response datagram to client
-        sendto(sockfd_, send_buffer, resp_size + 4, 0,
-               (struct sockaddr*)client_addr, sizeof(*client_addr));
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
+        }
     }
 
-    void handle_clear(struct sockaddr_in* client_addr, uint8_t* data, size_t data_size) {
+    void handle_clear(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         clearRequest request;
-        ByteReader reader(data, data_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         onclear();
     }
 
-    void handle_batchSet(struct sockaddr_in* client_addr, uint8_t* data, size_t data_size) {
+    void handle_batchSet(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         batchSetRequest request;
-        ByteReader reader(data, data_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         batchSetResponse response;
         response.return_value = onbatchSet(request.items);
 
         // Serialize and send response via UDP
-        ByteBuffer buffer;
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
         
-        // Prepare datagram: size(4) + data
-        uint32_t resp_size = buffer.size();
-        uint8_t send_buffer[65536];
-        send_buffer[0] = (resp_size >> 24) & 0xFF;
-        send_buffer[1] = (resp_size >> 16) & 0xFF;
-        send_buffer[2] = (resp_size >> 8) & 0xFF;
-        send_buffer[3] = resp_size & 0xFF;
-        memcpy(send_buffer + 4, buffer.data(), resp_size);
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
         
         // Send response datagram to client
-        sendto(sockfd_, send_buffer, resp_size + 4, 0,
-               (struct sockaddr*)client_addr, sizeof(*client_addr));
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
+        }
     }
 
-    void handle_batchGet(struct sockaddr_in* client_addr, uint8_t* data, size_t data_size) {
+    void handle_batchGet(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         batchGetRequest request;
-        ByteReader reader(data, data_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         batchGetResponse response;
         onbatchGet(request.keys, response.values, response.status);
 
         // Serialize and send response via UDP
-        ByteBuffer buffer;
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
         
-        // Prepare datagram: size(4) + data
-        uint32_t resp_size = buffer.size();
-        uint8_t send_buffer[65536];
-        send_buffer[0] = (resp_size >> 24) & 0xFF;
-        send_buffer[1] = (resp_size >> 16) & 0xFF;
-        send_buffer[2] = (resp_size >> 8) & 0xFF;
-        send_buffer[3] = resp_size & 0xFF;
-        memcpy(send_buffer + 4, buffer.data(), resp_size);
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
         
         // Send response datagram to client
-        sendto(sockfd_, send_buffer, resp_size + 4, 0,
-               (struct sockaddr*)client_addr, sizeof(*client_addr));
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
+        }
     }
 
-public:
-    // Callback push methods (send callbacks to clients)
-    void push_onKeyChanged(ChangeEvent event) {
-        // Prepare callback request
-        onKeyChangedRequest request;
-        request.event = event;
+    void handle_batchGetMap(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
+        batchGetMapRequest request;
+        ByteReader reader(data, data_size, request_wire_flags_);
+        request.deserialize(reader);
+
+        batchGetMapResponse response;
+        response.return_value = onbatchGetMap(request.keys);
+
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
+        response.serialize(buffer);
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
+        }
+    }
+
+    void handle_scan(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
+        auto request = std::make_shared<scanRequest>();
+        ByteReader reader(data, data_size, request_wire_flags_);
+        request->deserialize(reader);
+
+        auto writer = std::make_shared<StreamWriter<KeyValue>>(
+            sockfd_, *client_addr, MSG_SCAN_RESP, request->stream_id, request->credit,
+            [](ByteBuffer& buffer, const KeyValue& item) { item.serialize(buffer); });
+        writer->setWireFormat(request_wire_flags_, compress_threshold_);
+        writer->setMaxDelay(std::chrono::milliseconds(request->max_delay_ms));
+        startStream(clientKey(*client_addr) + "/" + std::to_string(request->stream_id), writer,
+                    [this, request, writer]() {
+                        onscan(request->prefix, *writer);
+                        writer->finish();
+                    });
+    }
+
+    void handle_load(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
+        auto request = std::make_shared<loadRequest>();
+        ByteReader reader(data, data_size, request_wire_flags_);
+        request->deserialize(reader);
+
+        auto items = std::make_shared<StreamReader<KeyValue>>(
+            sockfd_, *client_addr, request->stream_id, request->credit,
+            [](ByteReader& reader, KeyValue& item) { item.deserialize(reader); });
+        items->setWireFormat(request_wire_flags_, compress_threshold_);
+        struct sockaddr_in client = *client_addr;
+        startStream(clientKey(client) + "/" + std::to_string(request->stream_id), items,
+                    [this, request, items, client]() {
+                        finish_load(&client, *request, *items);
+                        items->markDone();
+                    });
+    }
+
+    void finish_load(const struct sockaddr_in* client_addr, loadRequest& request,
+                   StreamReader<KeyValue>& items) {
+        loadResponse response;
+        response.return_value = onload(items);
+
+        // Let the upload finish even if the handler stopped reading early
+        items.drain();
+        if (!items.complete()) response.status = -1;
 
-        // Broadcast callback to all known clients via UDP
-        broadcast(request);
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        response.serialize(buffer);
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
+        }
     }
 
-    void push_onBatchChanged(std::vector<ChangeEvent> events) {
-        // Prepare callback request
-        onBatchChangedRequest request;
-        request.events = events;
+public:
+    // Callback push methods (send callbacks to clients)
+    // False if the callback does not fit in one datagram (nothing is sent)
+    bool push_onKeyChanged(const ChangeEvent& event) {
+        // Accumulate into onBatchChanged while a batch window is set
+        {
+            std::lock_guard<std::mutex> lock(batch_mutex_);
+            if (batching_) {
+                pending_onKeyChanged_.push_back(event);
+                batch_cv_.notify_one();
+                return true;
+            }
+        }
 
-        // Broadcast callback to all known clients via UDP
-        broadcast(request);
+        // Broadcast callback to all known clients via UDP, serialized straight from the arguments
+        return broadcastEncoded([&](ByteBuffer& buffer) {
+            buffer.writeMsgId(MSG_ONKEYCHANGED_REQ);
+            onKeyChangedRequest::serializeFields(buffer, event);
+        });
     }
 
-    void push_onConnectionStatus(bool connected) {
-        // Prepare callback request
-        onConnectionStatusRequest request;
-        request.connected = connected;
+    // False if the callback does not fit in one datagram (nothing is sent)
+    bool push_onBatchChanged(const std::vector<ChangeEvent>& events) {
+        // Broadcast callback to all known clients via UDP, serialized straight from the arguments
+        return broadcastEncoded([&](ByteBuffer& buffer) {
+            buffer.writeMsgId(MSG_ONBATCHCHANGED_REQ);
+            onBatchChangedRequest::serializeFields(buffer, events);
+        });
+    }
 
-        // Broadcast callback to all known clients via UDP
-        broadcast(request);
+    // False if the callback does not fit in one datagram (nothing is sent)
+    bool push_onConnectionStatus(bool connected) {
+        // Broadcast callback to all known clients via UDP, serialized straight from the arguments
+        return broadcastEncoded([&](ByteBuffer& buffer) {
+            buffer.writeMsgId(MSG_ONCONNECTIONSTATUS_REQ);
+            onConnectionStatusRequest::serializeFields(buffer, connected);
+        });
     }
 
 protected:
@@ -1759,8 +4301,11 @@ protected:
     virtual bool onexists(const std::string& key) = 0;
     virtual int64_t oncount() = 0;
     virtual void onclear() = 0;
-    virtual int64_t onbatchSet(std::vector<KeyValue> items) = 0;
-    virtual void onbatchGet(std::vector<std::string> keys, std::vector<std::string>& values, std::vector<OperationStatus>& status) = 0;
+    virtual int64_t onbatchSet(const std::vector<KeyValue>& items) = 0;
+    virtual void onbatchGet(const std::vector<std::string>& keys, std::vector<std::string>& values, std::vector<OperationStatus>& status) = 0;
+    virtual std::unordered_map<std::string, std::string> onbatchGetMap(const std::vector<std::string>& keys) = 0;
+    virtual void onscan(const std::string& prefix, StreamWriter<KeyValue>& writer) = 0;
+    virtual int64_t onload(StreamReader<KeyValue>& items) = 0;
 
 };
 
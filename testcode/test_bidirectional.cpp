@@ -10,11 +10,16 @@ using namespace ipc;
 class TestClient : public KeyValueStoreClient {
 private:
     std::atomic<int> callback_count_{0};
+    std::atomic<int> large_events_{0};  // 收到的 "#big" 大事件数（单个或批量回调）
     
 public:
     // 重写回调方法以接收服务器推送
-    void onKeyChanged(ChangeEvent event) override {
+    void onKeyChanged(const ChangeEvent& event) override {
         callback_count_++;
+        if (event.key.compare(0, 4, "#big") == 0) {
+            large_events_++;
+            return;
+        }
         std::cout << "\n[客户端] 📢 收到回调 #" << callback_count_ 
                   << " - onKeyChanged:" << std::endl;
         std::cout << "  类型: " << static_cast<int>(event.eventType) << std::endl;
@@ -24,11 +29,15 @@ public:
         std::cout << "  时间戳: " << event.timestamp << std::endl;
     }
     
-    void onBatchChanged(std::vector<ChangeEvent> events) override {
+    void onBatchChanged(const std::vector<ChangeEvent>& events) override {
         callback_count_++;
         std::cout << "\n[客户端] 📢 收到回调 #" << callback_count_ 
                   << " - onBatchChanged: " << events.size() << " 个事件" << std::endl;
         for (size_t i = 0; i < events.size(); i++) {
+            if (events[i].key.compare(0, 4, "#big") == 0) {
+                large_events_++;
+                continue;
+            }
             std::cout << "  事件[" << i << "]: key=" << events[i].key 
                       << ", newValue=" << events[i].newValue << std::endl;
         }
@@ -42,6 +51,7 @@ public:
     }
     
     int getCallbackCount() const { return callback_count_; }
+    int getLargeEventCount() const { return large_events_; }
 };
 
 // 服务端实现
@@ -128,7 +138,7 @@ public:
         push_onKeyChanged(event);
     }
     
-    int64_t onbatchSet(std::vector<KeyValue> items) override {
+    int64_t onbatchSet(const std::vector<KeyValue>& items) override {
         std::lock_guard<std::mutex> lock(store_mutex_);
         std::cout << "[服务端] 📦 batchSet: " << items.size() << " 个项目" << std::endl;
         
@@ -153,7 +163,7 @@ public:
         return items.size();
     }
     
-    void onbatchGet(std::vector<std::string> keys, 
+    void onbatchGet(const std::vector<std::string>& keys, 
                     std::vector<std::string>& values, 
                     std::vector<OperationStatus>& status) override {
         std::lock_guard<std::mutex> lock(store_mutex_);
@@ -172,8 +182,195 @@ public:
             }
         }
     }
+    
+    std::unordered_map<std::string, std::string> onbatchGetMap(const std::vector<std::string>& keys) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        std::cout << "[服务端] 📦 batchGetMap: " << keys.size() << " 个键" << std::endl;
+        
+        std::unordered_map<std::string, std::string> found;
+        found.reserve(keys.size());
+        for (const auto& key : keys) {
+            auto it = store_.find(key);
+            if (it != store_.end()) found[key] = it->second;
+        }
+        return found;
+    }
+    
+    // 流式导入：在独立线程上调用，逐个读取客户端上传的键值对
+    int64_t onload(StreamReader<KeyValue>& items) override {
+        int64_t loaded = 0;
+        KeyValue item;
+        while (items.read(item)) {
+            std::lock_guard<std::mutex> lock(store_mutex_);
+            store_[item.key] = item.value;
+            loaded++;
+        }
+        std::cout << "[服务端] 📥 load: " << loaded << " 项" << (items.complete() ? "" : "（不完整）") << std::endl;
+        return loaded;
+    }
+    
+    // 流式扫描：在独立线程上调用，写入时不持有 store_mutex_（write 可能等待客户端信用）
+    void onscan(const std::string& prefix, StreamWriter<KeyValue>& writer) override {
+        std::vector<KeyValue> matches;
+        {
+            std::lock_guard<std::mutex> lock(store_mutex_);
+            for (const auto& pair : store_) {
+                if (pair.first.compare(0, prefix.size(), prefix) == 0) {
+                    KeyValue item;
+                    item.key = pair.first;
+                    item.value = pair.second;
+                    matches.push_back(item);
+                }
+            }
+        }
+        std::cout << "[服务端] 🌊 scan: " << prefix << " (" << matches.size() << " 项)" << std::endl;
+        for (const auto& item : matches) {
+            if (!writer.write(item)) return;
+        }
+        
+        // 前缀 "#bulk" 额外产出大量合成数据，用于测试分块与流控
+        if (prefix == "#bulk") {
+            for (int i = 0; i < 20000; i++) {
+                KeyValue item;
+                item.key = "bulk" + std::to_string(i);
+                item.value = std::string(32, 'x');
+                if (!writer.write(item)) return;
+            }
+        }
+        
+        // 前缀 "#tick" 每 100ms 产出一项，用于测试首块立即发送与分块延迟上限
+        if (prefix == "#tick") {
+            for (int i = 0; i < 3; i++) {
+                KeyValue item;
+                item.key = "tick" + std::to_string(i);
+                item.value = std::to_string(i);
+                if (!writer.write(item)) return;
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        }
+        
+        // 前缀 "#large" 产出接近单个数据报上限的值：两个 40KB 的值必须分到两块发送，
+        // 70KB 的值放不进任何数据报，write 返回 false 并丢弃该项
+        if (prefix == "#large") {
+            const char fills[] = {'a', 'b', 'c'};
+            for (char fill : fills) {
+                KeyValue item;
+                item.key = std::string("large_") + fill;
+                item.value = std::string(fill == 'c' ? 70000 : 40000, fill);
+                bool written = writer.write(item);
+                std::cout << "[服务端] write(" << item.key << ", " << item.value.size() << " 字节): "
+                          << (written ? "已写入" : "过大，已拒绝") << std::endl;
+            }
+        }
+    }
+};
+
+// 直接收发数据报的探测客户端：协商编码后登记为已知客户端，检查服务端推送的原始帧
+class PushProbe {
+private:
+    int sockfd_;
+    
+    void sendMessage(const ByteBuffer& buffer) {
+        uint8_t frame[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, FRAME_MAX_BYTES, frame);
+        send(sockfd_, frame, frame_size, 0);
+    }
+    
+public:
+    PushProbe() : sockfd_(socket(AF_INET, SOCK_DGRAM, 0)) {}
+    
+    ~PushProbe() {
+        if (sockfd_ < 0) return;
+        ByteBuffer bye;
+        bye.writeMsgId(MSG_CTRL_BYE);
+        sendMessage(bye);
+        close(sockfd_);
+    }
+    
+    // 协商 flags 后发送一个 count 请求：任意请求都会把发送方登记为推送对象
+    bool open(int port, uint8_t flags) {
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        if (sockfd_ < 0 || connect(sockfd_, (struct sockaddr*)&addr, sizeof(addr)) < 0) return false;
+        struct timeval tv = {1, 0};
+        setsockopt(sockfd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        
+        ByteBuffer hello;
+        hello.writeMsgId(MSG_CTRL_HELLO);
+        hello.writeUint8(flags);
+        sendMessage(hello);
+        uint8_t frame_flags;
+        size_t frame_size;
+        std::vector<uint8_t> payload;
+        if (!receive(MSG_CTRL_HELLO_ACK, frame_flags, frame_size, payload) || payload.size() < 5 || payload[4] != flags) {
+            return false;
+        }
+        
+        ByteBuffer count;
+        count.setWireFlags(flags);
+        countRequest().serialize(count);
+        sendMessage(count);
+        return receive(MSG_COUNT_RESP, frame_flags, frame_size, payload);
+    }
+    
+    // 等待 msg_id 的帧：frame_flags 为帧首字节（含 FRAME_COMPRESSED），payload 为解压后的消息
+    bool receive(uint32_t msg_id, uint8_t& frame_flags, size_t& frame_size, std::vector<uint8_t>& payload) {
+        static uint8_t recv_buffer[65536];
+        std::vector<uint8_t> inflated;
+        while (true) {
+            ssize_t received = recv(sockfd_, recv_buffer, sizeof(recv_buffer), 0);
+            if (received < 0) return false;
+            if (received < 8) continue;
+            uint8_t flags = recv_buffer[0];
+            uint32_t size = (static_cast<uint32_t>(recv_buffer[1]) << 16) |
+                            (static_cast<uint32_t>(recv_buffer[2]) << 8) |
+                            static_cast<uint32_t>(recv_buffer[3]);
+            if (static_cast<size_t>(received) != size + 4) continue;
+            const uint8_t* data = recv_buffer + 4;
+            if (!inflateFrame(flags, data, size, inflated)) continue;
+            uint32_t id = (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+                          (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]);
+            if (id != msg_id) continue;
+            frame_flags = recv_buffer[0];
+            frame_size = received;
+            payload.assign(data, data + size);
+            return true;
+        }
+    }
 };
 
+// 向所有客户端推送一批事件，检查探测客户端收到的帧使用协商的编码（compressed: 应为压缩帧）且内容可解码
+static bool checkPushEncoding(TestServer& server, const char* name, uint8_t flags,
+                              const std::vector<ChangeEvent>& events, size_t& frame_size, bool compressed = false) {
+    PushProbe probe;
+    if (!probe.open(8888, flags)) {
+        std::cout << "  " << name << ": 协商失败" << std::endl;
+        return false;
+    }
+    server.push_onBatchChanged(events);
+    uint8_t frame_flags;
+    std::vector<uint8_t> payload;
+    if (!probe.receive(MSG_ONBATCHCHANGED_REQ, frame_flags, frame_size, payload)) {
+        std::cout << "  " << name << ": 未收到推送" << std::endl;
+        return false;
+    }
+    onBatchChangedRequest request;
+    ByteReader reader(payload.data(), payload.size(), frame_flags & ~FRAME_COMPRESSED);
+    request.deserialize(reader);
+    bool same = request.events.size() == events.size();
+    for (size_t i = 0; same && i < events.size(); i++) {
+        same = request.events[i].key == events[i].key && request.events[i].newValue == events[i].newValue &&
+               request.events[i].timestamp == events[i].timestamp;
+    }
+    bool encoded = (frame_flags & ~FRAME_COMPRESSED) == flags &&
+                   ((frame_flags & FRAME_COMPRESSED) != 0) == compressed;
+    std::cout << "  " << name << ": " << frame_size << " 字节, 帧编码 0x" << std::hex << static_cast<int>(frame_flags)
+              << std::dec << (encoded && same ? " ✅" : " ❌") << std::endl;
+    return encoded && same;
+}
+
 int main() {
     std::cout << "========================================" << std::endl;
     std::cout << "UDP双向通信测试" << std::endl;
@@ -268,6 +465,12 @@ int main() {
                   << " (状态: " << static_cast<int>(statuses[i]) << ")" << std::endl;
     }
     
+    // 批量获取为键值表：不存在的键不出现在表中
+    std::unordered_map<std::string, std::string> found = client.batchGetMap(keys);
+    std::cout << "  batchGetMap: " << found.size() << " 个键存在";
+    if (found.count("name")) std::cout << ", name = " << found["name"];
+    std::cout << std::endl;
+    
     // 测试7: 服务器主动推送连接状态回调
     std::cout << "\n--- 测试7: 服务器主动推送 ---" << std::endl;
     server.push_onConnectionStatus(true);
@@ -281,6 +484,169 @@ int main() {
     int64_t final_count = client.count();
     std::cout << "清空后键数: " << final_count << std::endl;
     
+    // 测试9: 回调批量推送（@batch：onKeyChanged 合并为 onBatchChanged）
+    // 同时启用客户端回调线程池，回调不再占用监听线程
+    std::cout << "\n--- 测试9: 回调批量推送 + 回调线程池 ---" << std::endl;
+    client.setCallbackDispatcher(2);
+    server.setBatchWindow(std::chrono::milliseconds(100));
+    client.set("k1", "v1");
+    client.set("k2", "v2");
+    client.set("k3", "v3");
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    
+    // 一个窗口内的大事件超过一个数据报：批量回调按编码大小拆分，每个事件都应到达
+    const int kLargeEvents = 48;
+    for (int i = 0; i < kLargeEvents; i++) {
+        ChangeEvent event;
+        event.eventType = ChangeEventType::KEY_UPDATED;
+        event.key = "#big" + std::to_string(i);
+        event.oldValue = std::string(3000, 'a' + i % 26);
+        event.newValue = "v" + std::to_string(i);
+        server.push_onKeyChanged(event);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    server.setBatchWindow(std::chrono::milliseconds(0));
+    int large_received = client.getLargeEventCount();
+    std::cout << "大事件批量推送: " << large_received << "/" << kLargeEvents << " 个事件到达" << std::endl;
+    
+    // 测试10: 回调专用通道（RPC 响应与回调推送使用不同的 socket）
+    std::cout << "\n--- 测试10: 回调专用通道 ---" << std::endl;
+    TestClient channel_client;
+    ThreadOptions thread_options;      // 监听线程绑定到 CPU 0，线程名 "kvcli-rx"/"kvcli-cbrx"
+    thread_options.cpus.push_back(0);
+    thread_options.name = "kvcli";
+    std::string placement_error;
+    if (!channel_client.setThreadOptions(thread_options, &placement_error)) {
+        std::cout << "线程选项被拒绝: " << placement_error << std::endl;
+    }
+    ThreadOptions bad_options;         // 不存在的 CPU：setThreadOptions 返回 false 并保留原选项
+    bad_options.cpus.push_back(100000);
+    bool rejected = !channel_client.setThreadOptions(bad_options, &placement_error);
+    std::cout << "无效 CPU 选项: " << (rejected ? "已拒绝 (" + placement_error + ")" : "未拒绝") << std::endl;
+    if (channel_client.connect("127.0.0.1", 8888, true)) {
+        std::cout << "回调专用通道: " << (channel_client.hasCallbackChannel() ? "已建立" : "未建立") << std::endl;
+        std::cout << "get结果: " << channel_client.get("k1") << std::endl;
+        server.push_onConnectionStatus(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        std::cout << "专用通道客户端收到的回调数: " << channel_client.getCallbackCount() << std::endl;
+        std::cout << "线程放置失败数: " << channel_client.threadPlacementFailures() << std::endl;
+        
+        // 测试11: 忙轮询模式（调用线程自己在 socket 上自旋等待响应）
+        std::cout << "\n--- 测试11: 忙轮询模式 ---" << std::endl;
+        channel_client.setBusyPoll(true);
+        auto start = std::chrono::steady_clock::now();
+        int ok = 0;
+        for (int i = 0; i < 1000; ++i) {
+            if (channel_client.get("k1") == "v1") ok++;
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        std::cout << "忙轮询 get 成功: " << ok << "/1000, 平均延迟: " << elapsed / 1000.0 << " us" << std::endl;
+        channel_client.setBusyPoll(false);
+        std::cout << "恢复监听线程后 get结果: " << channel_client.get("k1") << std::endl;
+        
+        // 测试12: 服务端流式返回（分块发送 + 信用流控）
+        std::cout << "\n--- 测试12: 服务端流式返回 ---" << std::endl;
+        int scanned = 0;
+        bool scan_ok = channel_client.scan("k", [&](const KeyValue& item) {
+            // on_item 运行时不持有客户端的锁，可以在回调里再次调用同一个客户端
+            std::string current = channel_client.get(item.key);
+            std::cout << "  " << item.key << " = " << item.value << " (get: " << current << ")" << std::endl;
+            scanned++;
+        });
+        std::cout << "scan(\"k\"): " << (scan_ok ? "完成" : "失败") << ", " << scanned << " 项" << std::endl;
+        
+        channel_client.setStreamWindow(2);
+        size_t bulk = 0;
+        start = std::chrono::steady_clock::now();
+        scan_ok = channel_client.scan("#bulk", [&](const KeyValue& item) {
+            if (item.value.size() == 32) bulk++;
+        });
+        elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        std::cout << "scan(\"#bulk\"): " << (scan_ok ? "完成" : "失败") << ", " << bulk << " 项, 耗时 "
+                  << elapsed / 1000.0 << " ms" << std::endl;
+        
+        // 首块随第一项立即发出；之后部分填充的块最多等待 setStreamChunkDelay 设定的时间
+        channel_client.setStreamChunkDelay(std::chrono::milliseconds(50));
+        std::vector<long> tick_ms;
+        start = std::chrono::steady_clock::now();
+        scan_ok = channel_client.scan("#tick", [&](const KeyValue&) {
+            tick_ms.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count());
+        });
+        std::cout << "scan(\"#tick\"): " << (scan_ok ? "完成" : "失败") << ", 到达时间(ms):";
+        for (long ms : tick_ms) std::cout << " " << ms;
+        std::cout << std::endl;
+        
+        size_t large_items = 0;
+        size_t large_bytes = 0;
+        scan_ok = channel_client.scan("#large", [&](const KeyValue& item) {
+            large_items++;
+            large_bytes += item.value.size();
+        });
+        std::cout << "scan(\"#large\"): " << (scan_ok ? "完成" : "失败") << ", " << large_items << " 项, "
+                  << large_bytes << " 字节" << std::endl;
+        
+        // 测试13: 客户端流式上传（边产生边发送，服务端边收边处理）
+        std::cout << "\n--- 测试13: 客户端流式上传 ---" << std::endl;
+        std::string during_load;
+        int64_t loaded = channel_client.load([&](StreamWriter<KeyValue>& writer) {
+            // 生产者运行时不持有客户端的锁，可以在上传途中调用其它方法
+            during_load = channel_client.get("k1");
+            for (int i = 0; i < 20000; i++) {
+                KeyValue item;
+                item.key = "load" + std::to_string(i);
+                item.value = std::to_string(i);
+                if (!writer.write(item)) return;
+            }
+        });
+        std::cout << "load: 服务端导入 " << loaded << " 项, 上传中 get(k1) = " << during_load
+                  << ", load19999 = " << channel_client.get("load19999") << std::endl;
+        channel_client.stopListening();
+    }
+    
+    // 测试14: 回调推送使用每个客户端协商的编码（直接检查收到的数据报）
+    std::cout << "\n--- 测试14: 回调推送编码 ---" << std::endl;
+    client.stopListening();  // 主客户端不再处理推送，避免重复打印
+    std::vector<ChangeEvent> pushed;
+    for (int i = 0; i < 24; i++) {
+        ChangeEvent event;
+        event.eventType = ChangeEventType::KEY_UPDATED;
+        event.key = "profile:" + std::to_string(i % 4);
+        event.newValue = "value-" + std::to_string(i);
+        event.timestamp = 1700000000000LL + i;
+        pushed.push_back(event);
+    }
+    bool push_ok = true;
+    size_t plain_size = 0;
+    size_t compact_size = 0;
+    push_ok &= checkPushEncoding(server, "默认编码", 0, pushed, plain_size);
+    push_ok &= checkPushEncoding(server, "compact", WIRE_COMPACT, pushed, compact_size);
+    if (compact_size >= plain_size) {
+        std::cout << "  compact 推送没有变小" << std::endl;
+        push_ok = false;
+    }
+    // ChangeEventSeq 只作为推送发送：重复的键在字典模式下应只出现一次
+    size_t dict_size = 0;
+    push_ok &= checkPushEncoding(server, "dict", WIRE_STRING_DICT, pushed, dict_size);
+    if (dict_size >= plain_size) {
+        std::cout << "  dict 推送没有变小" << std::endl;
+        push_ok = false;
+    }
+    size_t other_size = 0;
+    if (WIRE_SUPPORTED & WIRE_NATIVE_LE) {
+        push_ok &= checkPushEncoding(server, "native", WIRE_NATIVE_LE, pushed, other_size);
+    }
+    push_ok &= checkPushEncoding(server, "sparse", WIRE_SPARSE, pushed, other_size);
+    push_ok &= checkPushEncoding(server, "全部", WIRE_SUPPORTED, pushed, other_size);
+    
+    // 超过压缩阈值的推送以 FRAME_COMPRESSED 帧发出
+    std::vector<ChangeEvent> large_pushed = pushed;
+    for (auto& event : large_pushed) event.oldValue = std::string(100, 'x');
+    push_ok &= checkPushEncoding(server, "lz", WIRE_LZ, large_pushed, other_size, true);
+    std::cout << "推送编码: " << (push_ok ? "通过" : "失败") << std::endl;
+    
     // 统计结果
     std::this_thread::sleep_for(std::chrono::seconds(1));
     std::cout << "\n========================================" << std::endl;
@@ -290,9 +656,8 @@ int main() {
     std::cout << "========================================" << std::endl;
     
     // 清理
-    client.stopListening();
     server.stop();
     server_thread.join();
     
-    return 0;
+    return large_received == kLargeEvents && push_ok ? 0 : 1;
 }
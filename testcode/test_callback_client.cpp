@@ -12,7 +12,7 @@ private:
     
 protected:
     // 实现 callback 方法
-    void onKeyChanged(ChangeEvent event) override {
+    void onKeyChanged(const ChangeEvent& event) override {
         std::cout << "[" << client_name_ << "] 📢 收到 callback: onKeyChanged" << std::endl;
         std::cout << "  事件类型: ";
         switch (event.eventType) {
@@ -40,7 +40,7 @@ protected:
         std::cout << std::endl;
     }
     
-    void onBatchChanged(std::vector<ChangeEvent> events) override {
+    void onBatchChanged(const std::vector<ChangeEvent>& events) override {
         std::cout << "[" << client_name_ << "] 📢 收到 callback: onBatchChanged" << std::endl;
         std::cout << "  变更数量: " << events.size() << std::endl;
         for (size_t i = 0; i < events.size(); i++) {
@@ -2,6 +2,7 @@
 #include "keyvaluestore_socket.hpp"
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <thread>
 #include <chrono>
 
@@ -10,9 +11,11 @@ using namespace ipc;
 class TestKeyValueStoreServer : public KeyValueStoreServer {
 private:
     std::map<std::string, std::string> store_;
+    std::mutex store_mutex_;  // scan/load 在独立线程上运行
     
 protected:
     bool onset(const std::string& key, const std::string& value) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
         std::cout << "[Server] set: " << key << " = " << value << std::endl;
         
         std::string oldValue = store_[key];
@@ -33,6 +36,7 @@ protected:
     }
 
     std::string onget(const std::string& key) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
         std::cout << "[Server] get: " << key << std::endl;
         
         if (store_.find(key) != store_.end()) {
@@ -42,6 +46,7 @@ protected:
     }
 
     bool onremove(const std::string& key) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
         std::cout << "[Server] remove: " << key << std::endl;
         
         if (store_.find(key) != store_.end()) {
@@ -65,14 +70,17 @@ protected:
     }
 
     bool onexists(const std::string& key) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
         return store_.find(key) != store_.end();
     }
 
     int64_t oncount() override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
         return store_.size();
     }
 
     void onclear() override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
         std::cout << "[Server] clear all" << std::endl;
         store_.clear();
         
@@ -88,7 +96,8 @@ protected:
         std::cout << "[Server] 📢 推送 callback: onKeyChanged (cleared)" << std::endl;
     }
 
-    int64_t onbatchSet(std::vector<KeyValue> items) override {
+    int64_t onbatchSet(const std::vector<KeyValue>& items) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
         std::cout << "[Server] batchSet: " << items.size() << " items" << std::endl;
         
         std::vector<ChangeEvent> events;
@@ -113,7 +122,8 @@ protected:
         return items.size();
     }
 
-    void onbatchGet(std::vector<std::string> keys, std::vector<std::string>& values, std::vector<OperationStatus>& status) override {
+    void onbatchGet(const std::vector<std::string>& keys, std::vector<std::string>& values, std::vector<OperationStatus>& status) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
         std::cout << "[Server] batchGet: " << keys.size() << " keys" << std::endl;
         
         values.clear();
@@ -129,18 +139,50 @@ protected:
             }
         }
     }
-    
-    void onClientConnected(int client_fd) override {
-        std::cout << "[Server] ✅ 客户端连接: fd=" << client_fd << std::endl;
+
+    std::unordered_map<std::string, std::string> onbatchGetMap(const std::vector<std::string>& keys) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        std::cout << "[Server] batchGetMap: " << keys.size() << " keys" << std::endl;
         
-        // 向新连接的客户端推送连接状态 callback
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        push_onConnectionStatus(true);
-        std::cout << "[Server] 📢 推送 callback: onConnectionStatus (connected)" << std::endl;
+        std::unordered_map<std::string, std::string> found;
+        for (const auto& key : keys) {
+            auto it = store_.find(key);
+            if (it != store_.end()) found[key] = it->second;
+        }
+        return found;
     }
-
-    void onClientDisconnected(int client_fd) override {
-        std::cout << "[Server] ❌ 客户端断开: fd=" << client_fd << std::endl;
+    
+    // 流式导入：逐个读取客户端上传的键值对
+    int64_t onload(StreamReader<KeyValue>& items) override {
+        int64_t loaded = 0;
+        KeyValue item;
+        while (items.read(item)) {
+            std::lock_guard<std::mutex> lock(store_mutex_);
+            store_[item.key] = item.value;
+            loaded++;
+        }
+        std::cout << "[Server] load: " << loaded << " items" << (items.complete() ? "" : " (incomplete)") << std::endl;
+        return loaded;
+    }
+    
+    // 流式扫描：先复制匹配项，写入时不持有 store_mutex_（write 可能等待客户端信用）
+    void onscan(const std::string& prefix, StreamWriter<KeyValue>& writer) override {
+        std::vector<KeyValue> matches;
+        {
+            std::lock_guard<std::mutex> lock(store_mutex_);
+            for (const auto& pair : store_) {
+                if (pair.first.compare(0, prefix.size(), prefix) == 0) {
+                    KeyValue item;
+                    item.key = pair.first;
+                    item.value = pair.second;
+                    matches.push_back(item);
+                }
+            }
+        }
+        std::cout << "[Server] scan: " << prefix << " (" << matches.size() << " items)" << std::endl;
+        for (const auto& item : matches) {
+            if (!writer.write(item)) return;
+        }
     }
 };
 
@@ -156,6 +198,24 @@ int main() {
     std::cout << "等待客户端连接..." << std::endl;
     std::cout << "----------------------------------------" << std::endl;
     
+    // UDP 没有连接事件：已知客户端数量增加时向客户端推送连接状态 callback
+    std::thread watcher([&server]() {
+        size_t known = 0;
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            size_t count = server.getClientCount();
+            if (count > known) {
+                std::cout << "[Server] ✅ 新客户端, 当前 " << count << " 个" << std::endl;
+                server.push_onConnectionStatus(true);
+                std::cout << "[Server] 📢 推送 callback: onConnectionStatus (connected)" << std::endl;
+            } else if (count < known) {
+                std::cout << "[Server] ❌ 客户端离开, 当前 " << count << " 个" << std::endl;
+            }
+            known = count;
+        }
+    });
+    watcher.detach();
+    
     server.run();
 
     return 0;
@@ -1,5 +1,7 @@
 #include <iostream>
 #include <cassert>
+#include <cstring>
+#include <mutex>
 #include "typetestservice_socket.hpp"
 
 using namespace ipc;
@@ -24,11 +26,40 @@ int passed_tests = 0;
         std::cout << "❌ 失败: " << msg << std::endl; \
     } while(0)
 
-int main() {
+// 记录 onComplexUpdate 回调：完整解码版本只计数，按需解码版本只访问两个字段
+class ComplexUpdateClient : public TypeTestServiceClient {
+public:
+    std::mutex mutex;
+    int eager_updates = 0;
+    int lazy_updates = 0;
+    std::vector<int32_t> lazy_i32seq;
+    std::vector<std::string> lazy_strseq;
+
+protected:
+    void onComplexUpdate(const ComplexData&) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        eager_updates++;
+    }
+
+    void onComplexUpdateLazy(const ComplexDataLazy& data) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        lazy_updates++;
+        lazy_i32seq = data.i32seq();
+        lazy_strseq = data.strseq();
+    }
+};
+
+// 用法: test_all_types_client [--compact] [--native] [--dict] [--lz] [--sparse]
+//   --compact  先协商紧凑编码（varint/zigzag），再用它跑全部测试
+//   --native   先协商原生小端编码（定长字段直接 memcpy），再用它跑全部测试
+//   --dict     先协商字符串字典（同一消息内重复的字符串只发送一次），再用它跑全部测试
+//   --lz       先协商压缩（超过阈值的消息 LZ 压缩），把请求阈值降到 64 字节后跑全部测试
+//   --sparse   先协商稀疏结构体编码（存在位图 + 省略默认值字段），再用它跑全部测试
+int main(int argc, char** argv) {
     std::cout << "=== TypeTest Client 全面测试 ===" << std::endl;
     std::cout << "连接到服务器 localhost:8888" << std::endl;
     
-    TypeTestServiceClient client;
+    ComplexUpdateClient client;
     if (!client.connect("127.0.0.1", 8888)) {
         std::cerr << "连接服务器失败" << std::endl;
         return 1;
@@ -37,6 +68,27 @@ int main() {
     std::cout << "连接成功！开始测试所有数据类型...\n" << std::endl;
     sleep(1); // 等待listener启动
     
+    uint8_t wanted = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--compact") == 0) wanted |= WIRE_COMPACT;
+        if (strcmp(argv[i], "--native") == 0) wanted |= WIRE_NATIVE_LE;
+        if (strcmp(argv[i], "--dict") == 0) wanted |= WIRE_STRING_DICT;
+        if (strcmp(argv[i], "--lz") == 0) wanted |= WIRE_LZ;
+        if (strcmp(argv[i], "--sparse") == 0) wanted |= WIRE_SPARSE;
+    }
+    if (wanted) {
+        uint8_t flags = client.negotiateWireFlags(wanted);
+        std::cout << "线路编码:" << (flags & WIRE_COMPACT ? " 紧凑 (varint/zigzag)" : "")
+                  << (flags & WIRE_NATIVE_LE ? " 原生小端" : "") << (flags & WIRE_STRING_DICT ? " 字符串字典" : "")
+                  << (flags & WIRE_LZ ? " LZ压缩" : "") << (flags & WIRE_SPARSE ? " 稀疏结构体" : "")
+                  << (flags ? "" : " 默认") << std::endl;
+        if (flags != wanted) {
+            std::cerr << "服务器未接受请求的编码" << std::endl;
+            return 1;
+        }
+        if (flags & WIRE_LZ) client.setCompressionThreshold(64);
+    }
+    
     // ========== 测试1: 整数类型 ==========
     TEST_START("整数类型 (int8~int64, uint8~uint64)");
     try {
@@ -279,6 +331,116 @@ int main() {
         TEST_FAIL(e.what());
     }
     
+    // ========== 测试20: 有界序列 ==========
+    TEST_START("有界序列 sequence<T, N>");
+    try {
+        BoundedSequence<int32_t, 16> seq = {1, 2, 3};
+        BoundedSequence<std::string, 4> tags = {"a", "b"};
+        BoundedSequence<int32_t, 16> result = client.testBoundedVector(seq, tags);
+        bool rejected = false;
+        try {
+            result.resize(17);
+        } catch (const std::length_error&) {
+            rejected = true;
+        }
+        if (result.size() == 4 && result[2] == 30 && result[3] == 2 && rejected) TEST_PASS();
+        else TEST_FAIL("返回值不正确");
+    } catch (const std::exception& e) {
+        TEST_FAIL(e.what());
+    }
+    
+    // ========== 测试21: 定长数组 ==========
+    TEST_START("定长数组字段与参数 T name[N]");
+    try {
+        SensorFrame frame;
+        frame.id = 7;
+        for (size_t i = 0; i < frame.matrix.size(); i++) frame.matrix[i] = i * 0.5;
+        frame.offsets = {{1.0f, 0.0f, -1.0f}};
+        std::array<int32_t, 4> weights = {{1, 2, 3, 4}};
+        std::array<std::string, 2> labels;
+        SensorFrame result = client.testFixedArrays(frame, weights, labels);
+        if (result.id == 7 && result.matrix[15] == 7.5 * 10 && result.offsets[2] == -1.0f &&
+            labels[0] == "sum=10" && labels[1] == "id=7") TEST_PASS();
+        else TEST_FAIL("返回值不正确");
+    } catch (const std::exception& e) {
+        TEST_FAIL(e.what());
+    }
+    
+    // ========== 测试22: map ==========
+    TEST_START("map<K, V>");
+    try {
+        std::unordered_map<std::string, std::vector<int32_t>> groups;
+        groups["a"] = {1, 2, 3};
+        groups["b"] = {};
+        std::unordered_map<Priority, IntegerTypes> records;
+        records[Priority::HIGH].i32 = 41;
+        records[Priority::LOW].i32 = -1;
+        std::unordered_map<std::string, std::vector<int32_t>> result = client.testMap(groups, records);
+        if (result.size() == 2 && result["a"] == std::vector<int32_t>{6} && result["b"] == std::vector<int32_t>{0} &&
+            records.size() == 2 && records[Priority::HIGH].i32 == 42 && records[Priority::LOW].i32 == 0) TEST_PASS();
+        else TEST_FAIL("返回值不正确");
+    } catch (const std::exception& e) {
+        TEST_FAIL(e.what());
+    }
+    
+    // ========== 测试23: map 的键类型 ==========
+    TEST_START("map 键：接口内枚举与 typedef 别名");
+    try {
+        std::unordered_map<Color, int64_t> colors;
+        colors[Color::RED] = 1;
+        colors[Color::BLUE] = 20;
+        std::unordered_map<std::string, int64_t> counts;
+        counts["x"] = 300;
+        int64_t total = client.testMapKeys(colors, counts);
+        if (total == 321) TEST_PASS();
+        else TEST_FAIL("返回值不正确");
+    } catch (const std::exception& e) {
+        TEST_FAIL(e.what());
+    }
+    
+    // ========== 测试24: 按需解码 (@lazy) ==========
+    TEST_START("按需解码 (@lazy) 的响应与回调");
+    try {
+        ComplexData data;
+        data.i32seq = {7, 8, 9};
+        data.dseq = {0.25};
+        data.strseq = {"lazy", "view"};
+        data.nestedseq.resize(2);
+        data.nestedseq[1].integers.i64 = -42;
+        data.nestedseq[1].priority = Priority::HIGH;
+        
+        client.setLazyCallbacks(true);
+        std::vector<int32_t> i32seq;
+        std::string second;
+        int64_t nested_i64 = 0;
+        bool ok = client.testComplexDataLazy(data, [&](const ComplexDataLazy& result) {
+            // 只解码访问到的字段，顺序与线路上的顺序无关
+            nested_i64 = result.nestedseq().size() == 2 ? result.nestedseq()[1].integers.i64 : 0;
+            second = result.strseq().size() == 2 ? result.strseq()[1] : "";
+            i32seq = result.i32seq();
+        });
+        // 回调在响应之前推送，按需解码版本应已在监听线程上运行
+        int lazy_updates = 0;
+        std::vector<int32_t> pushed_i32seq;
+        std::vector<std::string> pushed_strseq;
+        for (int i = 0; i < 100 && lazy_updates == 0; i++) {
+            {
+                std::lock_guard<std::mutex> lock(client.mutex);
+                lazy_updates = client.lazy_updates;
+                pushed_i32seq = client.lazy_i32seq;
+                pushed_strseq = client.lazy_strseq;
+            }
+            if (lazy_updates == 0) usleep(10000);
+        }
+        client.setLazyCallbacks(false);
+        
+        if (!ok || i32seq != data.i32seq || second != "view" || nested_i64 != -42) TEST_FAIL("响应字段不正确");
+        else if (lazy_updates != 1 || pushed_i32seq != data.i32seq || pushed_strseq != data.strseq) TEST_FAIL("回调字段不正确");
+        else TEST_PASS();
+    } catch (const std::exception& e) {
+        TEST_FAIL(e.what());
+    }
+    
     // ========== 总结 ==========
     std::cout << "\n" << std::string(60, '=') << std::endl;
     std::cout << "测试完成！" << std::endl;
@@ -42,24 +42,26 @@ public:
     }
     
     // 测试struct
-    IntegerTypes ontestStruct(IntegerTypes data) override {
+    IntegerTypes ontestStruct(const IntegerTypes& data) override {
         std::cout << "testStruct: i32=" << data.i32 << " i64=" << data.i64 << std::endl;
-        data.i32 += 100;
-        data.i64 += 1000;
-        return data;
+        IntegerTypes result = data;
+        result.i32 += 100;
+        result.i64 += 1000;
+        return result;
     }
     
     // 测试嵌套struct
-    NestedData ontestNestedStruct(NestedData data) override {
+    NestedData ontestNestedStruct(const NestedData& data) override {
         std::cout << "testNestedStruct: integers.i32=" << data.integers.i32 
                   << " floats.d=" << data.floats.d << std::endl;
-        data.integers.i32 += 50;
-        data.floats.d += 3.14;
-        return data;
+        NestedData result = data;
+        result.integers.i32 += 50;
+        result.floats.d += 3.14;
+        return result;
     }
     
     // 测试vector<int32_t>
-    std::vector<int32_t> ontestInt32Vector(std::vector<int32_t> seq) override {
+    std::vector<int32_t> ontestInt32Vector(const std::vector<int32_t>& seq) override {
         std::cout << "testInt32Vector: size=" << seq.size() << " [";
         for (size_t i = 0; i < seq.size() && i < 5; i++) {
             std::cout << seq[i] << " ";
@@ -72,7 +74,7 @@ public:
     }
     
     // 测试vector<uint64_t>
-    std::vector<uint64_t> ontestUInt64Vector(std::vector<uint64_t> seq) override {
+    std::vector<uint64_t> ontestUInt64Vector(const std::vector<uint64_t>& seq) override {
         std::cout << "testUInt64Vector: size=" << seq.size() << std::endl;
         std::vector<uint64_t> result;
         for (auto v : seq) result.push_back(v + 1000);
@@ -80,7 +82,7 @@ public:
     }
     
     // 测试vector<float>
-    std::vector<float> ontestFloatVector(std::vector<float> seq) override {
+    std::vector<float> ontestFloatVector(const std::vector<float>& seq) override {
         std::cout << "testFloatVector: size=" << seq.size() << std::endl;
         std::vector<float> result;
         for (auto v : seq) result.push_back(v * 1.5f);
@@ -88,7 +90,7 @@ public:
     }
     
     // 测试vector<double>
-    std::vector<double> ontestDoubleVector(std::vector<double> seq) override {
+    std::vector<double> ontestDoubleVector(const std::vector<double>& seq) override {
         std::cout << "testDoubleVector: size=" << seq.size() << std::endl;
         std::vector<double> result;
         for (auto v : seq) result.push_back(v * 2.0);
@@ -96,7 +98,7 @@ public:
     }
     
     // 测试vector<string>
-    std::vector<std::string> ontestStringVector(std::vector<std::string> seq) override {
+    std::vector<std::string> ontestStringVector(const std::vector<std::string>& seq) override {
         std::cout << "testStringVector: size=" << seq.size() << std::endl;
         std::vector<std::string> result;
         for (auto& s : seq) result.push_back("[" + s + "]");
@@ -104,7 +106,7 @@ public:
     }
     
     // 测试vector<bool>
-    std::vector<bool> ontestBoolVector(std::vector<bool> seq) override {
+    std::vector<bool> ontestBoolVector(const std::vector<bool>& seq) override {
         std::cout << "testBoolVector: size=" << seq.size() << std::endl;
         std::vector<bool> result;
         for (auto b : seq) result.push_back(!b);
@@ -112,30 +114,80 @@ public:
     }
     
     // 测试vector<enum>
-    std::vector<Priority> ontestEnumVector(std::vector<Priority> seq) override {
+    std::vector<Priority> ontestEnumVector(const std::vector<Priority>& seq) override {
         std::cout << "testEnumVector: size=" << seq.size() << std::endl;
         return seq;
     }
     
     // 测试vector<struct>
-    std::vector<IntegerTypes> ontestStructVector(std::vector<IntegerTypes> seq) override {
+    std::vector<IntegerTypes> ontestStructVector(const std::vector<IntegerTypes>& seq) override {
         std::cout << "testStructVector: size=" << seq.size() << std::endl;
-        for (auto& item : seq) {
+        std::vector<IntegerTypes> result = seq;
+        for (auto& item : result) {
             item.i32 += 10;
         }
-        return seq;
+        return result;
     }
     
     // 测试vector<嵌套struct>
-    std::vector<NestedData> ontestNestedStructVector(std::vector<NestedData> seq) override {
+    std::vector<NestedData> ontestNestedStructVector(const std::vector<NestedData>& seq) override {
         std::cout << "testNestedStructVector: size=" << seq.size() << std::endl;
         return seq;
     }
     
-    // 测试复杂数据
-    ComplexData ontestComplexData(ComplexData data) override {
+    // 测试有界序列
+    BoundedSequence<int32_t, 16> ontestBoundedVector(const BoundedSequence<int32_t, 16>& seq,
+                                                     const BoundedSequence<std::string, 4>& tags) override {
+        std::cout << "testBoundedVector: size=" << seq.size() << " tags=" << tags.size() << std::endl;
+        BoundedSequence<int32_t, 16> result;
+        for (auto v : seq) result.push_back(v * 10);
+        result.push_back(static_cast<int32_t>(tags.size()));
+        return result;
+    }
+    
+    // 测试定长数组：矩阵乘以权重之和，标签通过 out 数组返回
+    SensorFrame ontestFixedArrays(const SensorFrame& frame, const std::array<int32_t, 4>& weights,
+                                  std::array<std::string, 2>& labels) override {
+        std::cout << "testFixedArrays: id=" << frame.id << std::endl;
+        int32_t sum = 0;
+        for (auto w : weights) sum += w;
+        SensorFrame result = frame;
+        for (auto& v : result.matrix) v *= sum;
+        labels[0] = "sum=" + std::to_string(sum);
+        labels[1] = "id=" + std::to_string(frame.id);
+        return result;
+    }
+    
+    // 测试 map：返回每组的元素和，records 中每条记录的 i32 加一
+    std::unordered_map<std::string, std::vector<int32_t>> ontestMap(
+            const std::unordered_map<std::string, std::vector<int32_t>>& groups,
+            std::unordered_map<Priority, IntegerTypes>& records) override {
+        std::cout << "testMap: groups=" << groups.size() << " records=" << records.size() << std::endl;
+        std::unordered_map<std::string, std::vector<int32_t>> result;
+        for (const auto& group : groups) {
+            int32_t sum = 0;
+            for (auto v : group.second) sum += v;
+            result[group.first].push_back(sum);
+        }
+        for (auto& record : records) record.second.i32 += 1;
+        return result;
+    }
+    
+    // 测试 map 的键类型：返回所有计数之和
+    int64_t ontestMapKeys(const std::unordered_map<Color, int64_t>& colors,
+                          const std::unordered_map<std::string, int64_t>& counts) override {
+        std::cout << "testMapKeys: colors=" << colors.size() << " counts=" << counts.size() << std::endl;
+        int64_t total = 0;
+        for (const auto& entry : colors) total += entry.second;
+        for (const auto& entry : counts) total += entry.second;
+        return total;
+    }
+    
+    // 测试复杂数据：同时把收到的数据作为 onComplexUpdate 回调推送给客户端
+    ComplexData ontestComplexData(const ComplexData& data) override {
         std::cout << "testComplexData: i32seq.size=" << data.i32seq.size() 
                   << " strseq.size=" << data.strseq.size() << std::endl;
+        push_onComplexUpdate(data);
         return data;
     }
     
@@ -36,73 +36,97 @@ protected:
         return Priority();
     }
 
-    IntegerTypes ontestStruct(IntegerTypes data) override {
+    IntegerTypes ontestStruct(const IntegerTypes& data) override {
         // TODO: Implement testStruct
         std::cout << "testStruct called" << std::endl;
         return IntegerTypes();
     }
 
-    NestedData ontestNestedStruct(NestedData data) override {
+    NestedData ontestNestedStruct(const NestedData& data) override {
         // TODO: Implement testNestedStruct
         std::cout << "testNestedStruct called" << std::endl;
         return NestedData();
     }
 
-    std::vector<int32_t> ontestInt32Vector(std::vector<int32_t> seq) override {
+    std::vector<int32_t> ontestInt32Vector(const std::vector<int32_t>& seq) override {
         // TODO: Implement testInt32Vector
         std::cout << "testInt32Vector called" << std::endl;
         return std::vector<int32_t>();
     }
 
-    std::vector<uint64_t> ontestUInt64Vector(std::vector<uint64_t> seq) override {
+    std::vector<uint64_t> ontestUInt64Vector(const std::vector<uint64_t>& seq) override {
         // TODO: Implement testUInt64Vector
         std::cout << "testUInt64Vector called" << std::endl;
         return std::vector<uint64_t>();
     }
 
-    std::vector<float> ontestFloatVector(std::vector<float> seq) override {
+    std::vector<float> ontestFloatVector(const std::vector<float>& seq) override {
         // TODO: Implement testFloatVector
         std::cout << "testFloatVector called" << std::endl;
         return std::vector<float>();
     }
 
-    std::vector<double> ontestDoubleVector(std::vector<double> seq) override {
+    std::vector<double> ontestDoubleVector(const std::vector<double>& seq) override {
         // TODO: Implement testDoubleVector
         std::cout << "testDoubleVector called" << std::endl;
         return std::vector<double>();
     }
 
-    std::vector<std::string> ontestStringVector(std::vector<std::string> seq) override {
+    std::vector<std::string> ontestStringVector(const std::vector<std::string>& seq) override {
         // TODO: Implement testStringVector
         std::cout << "testStringVector called" << std::endl;
         return std::vector<std::string>();
     }
 
-    std::vector<bool> ontestBoolVector(std::vector<bool> seq) override {
+    std::vector<bool> ontestBoolVector(const std::vector<bool>& seq) override {
         // TODO: Implement testBoolVector
         std::cout << "testBoolVector called" << std::endl;
         return std::vector<bool>();
     }
 
-    std::vector<Priority> ontestEnumVector(std::vector<Priority> seq) override {
+    std::vector<Priority> ontestEnumVector(const std::vector<Priority>& seq) override {
         // TODO: Implement testEnumVector
         std::cout << "testEnumVector called" << std::endl;
         return std::vector<Priority>();
     }
 
-    std::vector<IntegerTypes> ontestStructVector(std::vector<IntegerTypes> seq) override {
+    std::vector<IntegerTypes> ontestStructVector(const std::vector<IntegerTypes>& seq) override {
         // TODO: Implement testStructVector
         std::cout << "testStructVector called" << std::endl;
         return std::vector<IntegerTypes>();
     }
 
-    std::vector<NestedData> ontestNestedStructVector(std::vector<NestedData> seq) override {
+    std::vector<NestedData> ontestNestedStructVector(const std::vector<NestedData>& seq) override {
         // TODO: Implement testNestedStructVector
         std::cout << "testNestedStructVector called" << std::endl;
         return std::vector<NestedData>();
     }
 
-    ComplexData ontestComplexData(ComplexData data) override {
+    BoundedSequence<int32_t, 16> ontestBoundedVector(const BoundedSequence<int32_t, 16>& seq, const BoundedSequence<std::string, 4>& tags) override {
+        // TODO: Implement testBoundedVector
+        std::cout << "testBoundedVector called" << std::endl;
+        return BoundedSequence<int32_t, 16>();
+    }
+
+    SensorFrame ontestFixedArrays(const SensorFrame& frame, const std::array<int32_t, 4>& weights, std::array<std::string, 2>& labels) override {
+        // TODO: Implement testFixedArrays
+        std::cout << "testFixedArrays called" << std::endl;
+        return SensorFrame();
+    }
+
+    std::unordered_map<std::string, std::vector<int32_t>> ontestMap(const std::unordered_map<std::string, std::vector<int32_t>>& groups, std::unordered_map<Priority, IntegerTypes>& records) override {
+        // TODO: Implement testMap
+        std::cout << "testMap called" << std::endl;
+        return std::unordered_map<std::string, std::vector<int32_t>>();
+    }
+
+    int64_t ontestMapKeys(const std::unordered_map<Color, int64_t>& colors, const std::unordered_map<std::string, int64_t>& counts) override {
+        // TODO: Implement testMapKeys
+        std::cout << "testMapKeys called" << std::endl;
+        return int64_t();
+    }
+
+    ComplexData ontestComplexData(const ComplexData& data) override {
         // TODO: Implement testComplexData
         std::cout << "testComplexData called" << std::endl;
         return ComplexData();
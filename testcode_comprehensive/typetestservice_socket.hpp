@@ -1,61 +1,216 @@
 #ifndef TYPETESTSERVICE_SOCKET_HPP
 #define TYPETESTSERVICE_SOCKET_HPP
 
+#include <array>
 #include <string>
 #include <vector>
+#include <map>
+#include <unordered_map>
 #include <cstdint>
 #include <cstring>
+#include <stdexcept>
+#include <type_traits>
 #include <memory>
 #include <functional>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <random>
 #include <chrono>
 #include <condition_variable>
 #include <queue>
 #include <algorithm>
 #include <iostream>
 #include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <errno.h>
+#if __cplusplus >= 201703L
+#include <string_view>
+#include <memory_resource>
+#endif
 
 namespace ipc {
 
 #ifndef IPC_BYTE_BUFFER_DEFINED
 #define IPC_BYTE_BUFFER_DEFINED
+// Wire encodings. The sender's choice travels in the top byte of each frame's
+// size prefix (frames never exceed 24 bits), so every frame decodes on its own;
+// a client only uses an encoding the server accepted (MSG_CTRL_HELLO), and the
+// server answers and pushes callbacks to it in that encoding.
+enum WireFlag : uint8_t {
+    WIRE_COMPACT = 0x01,     // LEB128 varints for integers and lengths, zigzag for signed
+    WIRE_NATIVE_LE = 0x02,   // Fixed-width values in little-endian order, copied with memcpy
+    WIRE_STRING_DICT = 0x04, // Repeated strings within a message are sent once, then by index
+    WIRE_LZ = 0x08,          // Large payloads may be LZ-compressed (FRAME_COMPRESSED frames)
+    WIRE_SPARSE = 0x10       // Structs carry a presence bitmap; default-valued fields are left out
+};
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+const uint8_t WIRE_SUPPORTED = WIRE_COMPACT | WIRE_NATIVE_LE | WIRE_STRING_DICT | WIRE_LZ | WIRE_SPARSE;
+#else
+const uint8_t WIRE_SUPPORTED = WIRE_COMPACT | WIRE_STRING_DICT | WIRE_LZ | WIRE_SPARSE;  // Native mode needs a little-endian host
+#endif
+// In WIRE_STRING_DICT mode a string's length prefix is (length << 1) for a literal,
+// or (index << 1) | 1 for a reference to an earlier literal of the same message.
+// Only literals of at least this many bytes enter the dictionary.
+const uint32_t WIRE_DICT_MIN_LENGTH = 4;
+
 // Serialization helpers
 class ByteBuffer {
 private:
     std::vector<uint8_t> data_;
+    uint8_t wire_flags_ = 0;
+    // WIRE_STRING_DICT: first occurrence (offset in data_, length) of each dictionary
+    // string, indexed by an open-addressing table of entry index + 1 (0 = empty)
+    std::vector<std::pair<uint32_t, uint32_t>> dict_entries_;
+    std::vector<uint32_t> dict_slots_;
 
-public:
-    void writeUint32(uint32_t value) {
+    void putFixed32(uint32_t value) {
         data_.push_back((value >> 24) & 0xFF);
         data_.push_back((value >> 16) & 0xFF);
         data_.push_back((value >> 8) & 0xFF);
         data_.push_back(value & 0xFF);
     }
 
+    void putVarint(uint64_t value) {
+        while (value >= 0x80) {
+            data_.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        data_.push_back(static_cast<uint8_t>(value));
+    }
+
+    template <typename T>
+    void putNative(T value) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        data_.insert(data_.end(), bytes, bytes + sizeof(T));
+    }
+
+    static uint32_t hashBytes(const char* bytes, size_t size) {
+        uint32_t hash = 2166136261u;  // FNV-1a
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ static_cast<uint8_t>(bytes[i])) * 16777619u;
+        }
+        return hash;
+    }
+
+    // Slot holding str, or the empty slot where it belongs
+    size_t dictSlot(const char* str, size_t len, uint32_t hash) const {
+        size_t mask = dict_slots_.size() - 1;
+        for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+            uint32_t entry = dict_slots_[slot];
+            if (entry == 0) return slot;
+            const std::pair<uint32_t, uint32_t>& known = dict_entries_[entry - 1];
+            if (known.second == len && std::memcmp(&data_[known.first], str, len) == 0) return slot;
+        }
+    }
+
+    void dictGrow() {
+        std::vector<uint32_t> slots(dict_slots_.empty() ? 64 : dict_slots_.size() * 2, 0);
+        dict_slots_.swap(slots);
+        for (size_t i = 0; i < dict_entries_.size(); i++) {
+            const char* known = reinterpret_cast<const char*>(&data_[dict_entries_[i].first]);
+            size_t len = dict_entries_[i].second;
+            dict_slots_[dictSlot(known, len, hashBytes(known, len))] = static_cast<uint32_t>(i + 1);
+        }
+    }
+
+    void putString(const char* str, size_t len) {
+        if (!(wire_flags_ & WIRE_STRING_DICT)) {
+            writeUint32(static_cast<uint32_t>(len));
+            data_.insert(data_.end(), str, str + len);
+            return;
+        }
+        size_t slot = 0;
+        if (len >= WIRE_DICT_MIN_LENGTH) {
+            if ((dict_entries_.size() + 1) * 2 > dict_slots_.size()) dictGrow();
+            slot = dictSlot(str, len, hashBytes(str, len));
+            if (dict_slots_[slot] != 0) {
+                writeUint32(((dict_slots_[slot] - 1) << 1) | 1);
+                return;
+            }
+        }
+        writeUint32(static_cast<uint32_t>(len) << 1);
+        size_t offset = data_.size();
+        data_.insert(data_.end(), str, str + len);
+        if (len >= WIRE_DICT_MIN_LENGTH) {
+            dict_entries_.push_back(std::make_pair(static_cast<uint32_t>(offset), static_cast<uint32_t>(len)));
+            dict_slots_[slot] = static_cast<uint32_t>(dict_entries_.size());
+        }
+    }
+
+    static uint64_t zigzag(int64_t value) {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    // Whether a numeric sequence can be copied as raw bytes in the current encoding
+    template <typename T>
+    bool bulkCopy() const {
+        if (sizeof(T) == 1) return true;
+        if (!(wire_flags_ & WIRE_NATIVE_LE)) return false;
+        return !((wire_flags_ & WIRE_COMPACT) && std::is_integral<T>::value);
+    }
+
+    void writeValue(int8_t value) { writeInt8(value); }
+    void writeValue(uint8_t value) { writeUint8(value); }
+    void writeValue(char value) { writeChar(value); }
+    void writeValue(int16_t value) { writeInt16(value); }
+    void writeValue(uint16_t value) { writeUint16(value); }
+    void writeValue(int32_t value) { writeInt32(value); }
+    void writeValue(uint32_t value) { writeUint32(value); }
+    void writeValue(int64_t value) { writeInt64(value); }
+    void writeValue(uint64_t value) { writeUint64(value); }
+    void writeValue(float value) { writeFloat(value); }
+    void writeValue(double value) { writeDouble(value); }
+
+public:
+    void setWireFlags(uint8_t flags) { wire_flags_ = flags; }
+    uint8_t wireFlags() const { return wire_flags_; }
+
+    // Message IDs stay 4-byte big-endian in every encoding so that frames can
+    // be routed before they are decoded
+    void writeMsgId(uint32_t id) {
+        putFixed32(id);
+    }
+
+    void writeUint32(uint32_t value) {
+        if (wire_flags_ & WIRE_COMPACT) return putVarint(value);
+        if (wire_flags_ & WIRE_NATIVE_LE) return putNative(value);
+        putFixed32(value);
+    }
+
     void writeInt32(int32_t value) {
-        writeUint32(static_cast<uint32_t>(value));
+        if (wire_flags_ & WIRE_COMPACT) return putVarint(zigzag(value));
+        if (wire_flags_ & WIRE_NATIVE_LE) return putNative(value);
+        putFixed32(static_cast<uint32_t>(value));
     }
     
     void writeUint64(uint64_t value) {
-        writeUint32(static_cast<uint32_t>(value >> 32));
-        writeUint32(static_cast<uint32_t>(value & 0xFFFFFFFF));
+        if (wire_flags_ & WIRE_COMPACT) return putVarint(value);
+        if (wire_flags_ & WIRE_NATIVE_LE) return putNative(value);
+        putFixed32(static_cast<uint32_t>(value >> 32));
+        putFixed32(static_cast<uint32_t>(value & 0xFFFFFFFF));
     }
     
     void writeInt64(int64_t value) {
+        if (wire_flags_ & WIRE_COMPACT) return putVarint(zigzag(value));
         writeUint64(static_cast<uint64_t>(value));
     }
     
     void writeUint16(uint16_t value) {
+        if (wire_flags_ & WIRE_COMPACT) return putVarint(value);
+        if (wire_flags_ & WIRE_NATIVE_LE) return putNative(value);
         data_.push_back((value >> 8) & 0xFF);
         data_.push_back(value & 0xFF);
     }
     
     void writeInt16(int16_t value) {
+        if (wire_flags_ & WIRE_COMPACT) return putVarint(zigzag(value));
         writeUint16(static_cast<uint16_t>(value));
     }
     
@@ -76,21 +231,22 @@ public:
     }
     
     void writeDouble(double value) {
+        if (wire_flags_ & WIRE_NATIVE_LE) return putNative(value);
         uint64_t bits;
         std::memcpy(&bits, &value, sizeof(double));
-        writeUint32(static_cast<uint32_t>(bits >> 32));
-        writeUint32(static_cast<uint32_t>(bits & 0xFFFFFFFF));
+        putFixed32(static_cast<uint32_t>(bits >> 32));
+        putFixed32(static_cast<uint32_t>(bits & 0xFFFFFFFF));
     }
     
     void writeFloat(float value) {
+        if (wire_flags_ & WIRE_NATIVE_LE) return putNative(value);
         uint32_t bits;
         std::memcpy(&bits, &value, sizeof(float));
-        writeUint32(bits);
+        putFixed32(bits);
     }
 
     void writeString(const std::string& str) {
-        writeUint32(str.size());
-        data_.insert(data_.end(), str.begin(), str.end());
+        putString(str.data(), str.size());
     }
 
     void writeStringVector(const std::vector<std::string>& vec) {
@@ -100,9 +256,243 @@ public:
         }
     }
 
+#if __cplusplus >= 201703L
+    // std::pmr containers used by --pmr-arena headers
+    void writeString(const std::pmr::string& str) {
+        putString(str.data(), str.size());
+    }
+
+    void writeStringVector(const std::pmr::vector<std::pmr::string>& vec) {
+        writeUint32(vec.size());
+        for (const auto& item : vec) {
+            writeString(item);
+        }
+    }
+#endif
+
+    void writeBytes(const uint8_t* bytes, size_t size) {
+        data_.insert(data_.end(), bytes, bytes + size);
+    }
+
+    // Room for count 4-byte big-endian values filled in later (@lazy offset tables)
+    size_t reserveFixed32(size_t count) {
+        size_t pos = data_.size();
+        data_.resize(pos + 4 * count);
+        return pos;
+    }
+
+    void patchFixed32(size_t pos, uint32_t value) {
+        data_[pos] = (value >> 24) & 0xFF;
+        data_[pos + 1] = (value >> 16) & 0xFF;
+        data_[pos + 2] = (value >> 8) & 0xFF;
+        data_[pos + 3] = value & 0xFF;
+    }
+
+    // WIRE_SPARSE presence bitmap: one bit per struct field, LSB-first, (count + 7) / 8 bytes
+    void writePresence(uint64_t bits, size_t count) {
+        for (size_t i = 0; i < count; i += 8) {
+            data_.push_back(static_cast<uint8_t>(bits >> i));
+        }
+    }
+
+    // Whether a scalar differs from its default; bitwise, so -0.0 is still sent
+    template <typename T>
+    static bool nonZero(T value) {
+        T zero = T();
+        return std::memcmp(&value, &zero, sizeof(T)) != 0;
+    }
+
+    // sequence<bool>: count, then the bits packed LSB-first, 64 per little-endian
+    // word (the last word is truncated to the bytes it needs)
+    template <typename Vector>
+    void writeBoolArray(const Vector& bits) {
+        size_t count = bits.size();
+        writeUint32(static_cast<uint32_t>(count));
+        size_t pos = data_.size();
+        data_.resize(pos + (count + 7) / 8);
+        for (size_t base = 0; base < count; base += 64) {
+            size_t n = count - base < 64 ? count - base : 64;
+            uint64_t word = 0;
+            for (size_t i = 0; i < n; i++) {
+                word |= static_cast<uint64_t>(bits[base + i] ? 1 : 0) << i;
+            }
+            for (size_t b = 0; b < (n + 7) / 8; b++) {
+                data_[pos + base / 8 + b] = static_cast<uint8_t>(word >> (8 * b));
+            }
+        }
+    }
+
+    // @delta field inside a sequence: zigzag varint of the difference to the
+    // previous element (wrapping), independent of the wire encoding
+    template <typename T>
+    void writeDelta(T value, T& previous) {
+        putVarint(zigzag(static_cast<int64_t>(static_cast<uint64_t>(value) - static_cast<uint64_t>(previous))));
+        previous = value;
+    }
+
+    // Sequence of structs with @delta fields; T::DeltaState carries the previous element
+    template <typename Vector>
+    void writeDeltaSequence(const Vector& items) {
+        typename Vector::value_type::DeltaState delta;
+        writeUint32(static_cast<uint32_t>(items.size()));
+        for (const auto& item : items) {
+            item.serialize(*this, &delta);
+        }
+    }
+
+    // Fixed-size structs travel as their packed record (T::Packed)
+    bool nativeRecords() const {
+        return (wire_flags_ & (WIRE_NATIVE_LE | WIRE_COMPACT)) == WIRE_NATIVE_LE;
+    }
+
+    // Sequence of fixed-size structs: count, then the records. In native mode the
+    // buffer grows once; a struct without padding is laid out exactly like its
+    // record, so the whole sequence is a single memcpy.
+    template <typename Vector>
+    void writeRecords(const Vector& items) {
+        typedef typename Vector::value_type T;
+        typedef typename T::Packed Packed;
+        writeUint32(static_cast<uint32_t>(items.size()));
+        if (!nativeRecords()) {
+            for (const auto& item : items) {
+                item.serialize(*this);
+            }
+            return;
+        }
+        size_t pos = data_.size();
+        data_.resize(pos + items.size() * sizeof(Packed));
+        if (items.empty()) return;
+        if (sizeof(T) == sizeof(Packed) && std::is_trivially_copyable<T>::value) {
+            std::memcpy(&data_[pos], &items[0], items.size() * sizeof(T));
+            return;
+        }
+        for (size_t i = 0; i < items.size(); i++) {
+            Packed record;
+            items[i].pack(record);
+            std::memcpy(&data_[pos + i * sizeof(Packed)], &record, sizeof(Packed));
+        }
+    }
+
+    // Numeric sequence: count, then the elements. Byte-sized elements, and all
+    // fixed-width elements in native little-endian mode, are a single memcpy.
+    template <typename T>
+    void writeArray(const T* items, size_t count) {
+        writeUint32(static_cast<uint32_t>(count));
+        writeFixedArray(items, count);
+    }
+
+    // Fixed-size array (IDL T name[N]): the elements only, both sides know N
+    template <typename T>
+    void writeFixedArray(const T* items, size_t count) {
+        if (bulkCopy<T>()) {
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(items);
+            data_.insert(data_.end(), bytes, bytes + count * sizeof(T));
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            writeValue(items[i]);
+        }
+    }
+
+    // One map key/value or BoundedSequence element, encoded like a message field of
+    // that type (sequences inside a map are written element by element)
+    void writeItem(bool value) { writeBool(value); }
+    void writeItem(const std::string& value) { writeString(value); }
+
+    template <typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value>::type writeItem(T value) { writeValue(value); }
+
+    template <typename T>
+    typename std::enable_if<std::is_enum<T>::value>::type writeItem(T value) {
+        writeInt32(static_cast<int32_t>(value));
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_class<T>::value>::type writeItem(const T& value) { value.serialize(*this); }
+
+    template <typename T, typename A>
+    void writeItem(const std::vector<T, A>& vec) {
+        writeUint32(static_cast<uint32_t>(vec.size()));
+        for (const auto& item : vec) writeItem(item);
+    }
+
+    template <typename K, typename V, typename H, typename E, typename A>
+    void writeItem(const std::unordered_map<K, V, H, E, A>& map) { writeMap(map); }
+
+    // map<K, V>: count, then key, value for each entry in the table's iteration order
+    template <typename Map>
+    void writeMap(const Map& map) {
+        writeUint32(static_cast<uint32_t>(map.size()));
+        for (const auto& entry : map) {
+            writeItem(entry.first);
+            writeItem(entry.second);
+        }
+    }
+
     const uint8_t* data() const { return data_.data(); }
     size_t size() const { return data_.size(); }
-    void clear() { data_.clear(); }
+    size_t capacity() const { return data_.capacity(); }
+    void reserve(size_t bytes) { data_.reserve(bytes); }
+    void clear() {
+        data_.clear();
+        if (!dict_entries_.empty()) {
+            dict_entries_.clear();
+            std::fill(dict_slots_.begin(), dict_slots_.end(), 0);
+        }
+    }
+};
+
+// Per-thread pool of serialization buffers. Buffers keep their grown capacity
+// when they come back, so steady-state calls serialize without allocating;
+// a buffer that grew past kTrimCapacity is freed instead of pooled.
+class ByteBufferPool {
+public:
+    static const size_t kInitialCapacity = 4096;
+    static const size_t kTrimCapacity = 256 * 1024;
+    static const size_t kMaxPooled = 8;
+
+    static std::unique_ptr<ByteBuffer> acquire() {
+        std::vector<std::unique_ptr<ByteBuffer>>& pool = threadPool();
+        if (pool.empty()) {
+            std::unique_ptr<ByteBuffer> buffer(new ByteBuffer());
+            buffer->reserve(kInitialCapacity);
+            return buffer;
+        }
+        std::unique_ptr<ByteBuffer> buffer = std::move(pool.back());
+        pool.pop_back();
+        return buffer;
+    }
+
+    static void release(std::unique_ptr<ByteBuffer> buffer) {
+        std::vector<std::unique_ptr<ByteBuffer>>& pool = threadPool();
+        if (!buffer || buffer->capacity() > kTrimCapacity || pool.size() >= kMaxPooled) return;
+        buffer->clear();
+        buffer->setWireFlags(0);
+        pool.push_back(std::move(buffer));
+    }
+
+private:
+    static std::vector<std::unique_ptr<ByteBuffer>>& threadPool() {
+        static thread_local std::vector<std::unique_ptr<ByteBuffer>> pool;
+        if (pool.capacity() < kMaxPooled) pool.reserve(kMaxPooled);
+        return pool;
+    }
+};
+
+// Scoped lease on a pooled buffer; returns it to the pool on destruction
+class PooledByteBuffer {
+public:
+    PooledByteBuffer() : buffer_(ByteBufferPool::acquire()) {}
+    ~PooledByteBuffer() { ByteBufferPool::release(std::move(buffer_)); }
+
+    ByteBuffer& operator*() { return *buffer_; }
+    ByteBuffer* operator->() { return buffer_.get(); }
+
+private:
+    PooledByteBuffer(const PooledByteBuffer&);
+    PooledByteBuffer& operator=(const PooledByteBuffer&);
+
+    std::unique_ptr<ByteBuffer> buffer_;
 };
 
 class ByteReader {
@@ -110,15 +500,10 @@ private:
     const uint8_t* data_;
     size_t size_;
     size_t pos_;
+    uint8_t wire_flags_;
+    std::vector<std::pair<uint32_t, uint32_t>> dict_;  // WIRE_STRING_DICT literals (offset, length)
 
-public:
-    ByteReader(const uint8_t* data, size_t size) : data_(data), size_(size), pos_(0) {}
-
-    bool canRead(size_t bytes) const {
-        return pos_ + bytes <= size_;
-    }
-
-    uint32_t readUint32() {
+    uint32_t getFixed32() {
         if (!canRead(4)) throw std::runtime_error("Buffer underflow");
         uint32_t value = (static_cast<uint32_t>(data_[pos_]) << 24) | 
                          (static_cast<uint32_t>(data_[pos_+1]) << 16) |
@@ -128,21 +513,144 @@ public:
         return value;
     }
 
+    uint64_t getVarint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (!canRead(1)) throw std::runtime_error("Buffer underflow");
+            uint8_t byte = data_[pos_++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw std::runtime_error("Malformed varint");
+    }
+
+    template <typename T>
+    T getNative() {
+        if (!canRead(sizeof(T))) throw std::runtime_error("Buffer underflow");
+        T value;
+        std::memcpy(&value, data_ + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return value;
+    }
+
+    // Locate the next string's bytes, resolving dictionary references
+    const char* getString(uint32_t& len) {
+        uint32_t prefix = readUint32();
+        if (!(wire_flags_ & WIRE_STRING_DICT)) {
+            len = prefix;
+        } else if (prefix & 1) {
+            uint32_t index = prefix >> 1;
+            if (index >= dict_.size()) throw std::runtime_error("Bad string reference");
+            len = dict_[index].second;
+            return reinterpret_cast<const char*>(data_ + dict_[index].first);
+        } else {
+            len = prefix >> 1;
+            if (len >= WIRE_DICT_MIN_LENGTH && canRead(len)) {
+                dict_.push_back(std::make_pair(static_cast<uint32_t>(pos_), len));
+            }
+        }
+        if (!canRead(len)) throw std::runtime_error("Buffer underflow");
+        const char* str = reinterpret_cast<const char*>(data_ + pos_);
+        pos_ += len;
+        return str;
+    }
+
+    static int64_t unzigzag(uint64_t value) {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    template <typename T>
+    bool bulkCopy() const {
+        if (sizeof(T) == 1) return true;
+        if (!(wire_flags_ & WIRE_NATIVE_LE)) return false;
+        return !((wire_flags_ & WIRE_COMPACT) && std::is_integral<T>::value);
+    }
+
+    void readValue(int8_t& value) { value = readInt8(); }
+    void readValue(uint8_t& value) { value = readUint8(); }
+    void readValue(char& value) { value = readChar(); }
+    void readValue(int16_t& value) { value = readInt16(); }
+    void readValue(uint16_t& value) { value = readUint16(); }
+    void readValue(int32_t& value) { value = readInt32(); }
+    void readValue(uint32_t& value) { value = readUint32(); }
+    void readValue(int64_t& value) { value = readInt64(); }
+    void readValue(uint64_t& value) { value = readUint64(); }
+    void readValue(float& value) { value = readFloat(); }
+    void readValue(double& value) { value = readDouble(); }
+
+public:
+    ByteReader(const uint8_t* data, size_t size, uint8_t wire_flags = 0)
+        : data_(data), size_(size), pos_(0), wire_flags_(wire_flags) {}
+
+    uint8_t wireFlags() const { return wire_flags_; }
+    void setWireFlags(uint8_t flags) { wire_flags_ = flags; }
+
+    bool canRead(size_t bytes) const {
+        return pos_ + bytes <= size_;
+    }
+
+    // Element count of a container whose entries take at least one byte each, checked
+    // against the remaining input before anything is reserved for it
+    uint32_t readCount() {
+        uint32_t count = readUint32();
+        if (!canRead(count)) throw std::runtime_error("Buffer underflow");
+        return count;
+    }
+
+    void skip(size_t bytes) {
+        if (!canRead(bytes)) throw std::runtime_error("Buffer underflow");
+        pos_ += bytes;
+    }
+
+    const uint8_t* cursor() const { return data_ + pos_; }
+
+    uint32_t readFixed32() {
+        return getFixed32();
+    }
+
+    uint64_t readPresence(size_t count) {
+        size_t bytes = (count + 7) / 8;
+        if (!canRead(bytes)) throw std::runtime_error("Buffer underflow");
+        uint64_t bits = 0;
+        for (size_t i = 0; i < bytes; i++) {
+            bits |= static_cast<uint64_t>(data_[pos_ + i]) << (8 * i);
+        }
+        pos_ += bytes;
+        return bits;
+    }
+
+    uint32_t readMsgId() {
+        return getFixed32();
+    }
+
+    uint32_t readUint32() {
+        if (wire_flags_ & WIRE_COMPACT) return static_cast<uint32_t>(getVarint());
+        if (wire_flags_ & WIRE_NATIVE_LE) return getNative<uint32_t>();
+        return getFixed32();
+    }
+
     int32_t readInt32() {
-        return static_cast<int32_t>(readUint32());
+        if (wire_flags_ & WIRE_COMPACT) return static_cast<int32_t>(unzigzag(getVarint()));
+        if (wire_flags_ & WIRE_NATIVE_LE) return getNative<int32_t>();
+        return static_cast<int32_t>(getFixed32());
     }
     
     uint64_t readUint64() {
-        uint32_t high = readUint32();
-        uint32_t low = readUint32();
+        if (wire_flags_ & WIRE_COMPACT) return getVarint();
+        if (wire_flags_ & WIRE_NATIVE_LE) return getNative<uint64_t>();
+        uint32_t high = getFixed32();
+        uint32_t low = getFixed32();
         return (static_cast<uint64_t>(high) << 32) | low;
     }
     
     int64_t readInt64() {
+        if (wire_flags_ & WIRE_COMPACT) return unzigzag(getVarint());
         return static_cast<int64_t>(readUint64());
     }
     
     uint16_t readUint16() {
+        if (wire_flags_ & WIRE_COMPACT) return static_cast<uint16_t>(getVarint());
+        if (wire_flags_ & WIRE_NATIVE_LE) return getNative<uint16_t>();
         if (!canRead(2)) throw std::runtime_error("Buffer underflow");
         uint16_t value = (static_cast<uint16_t>(data_[pos_]) << 8) | 
                          static_cast<uint16_t>(data_[pos_+1]);
@@ -151,6 +659,7 @@ public:
     }
     
     int16_t readInt16() {
+        if (wire_flags_ & WIRE_COMPACT) return static_cast<int16_t>(unzigzag(getVarint()));
         return static_cast<int16_t>(readUint16());
     }
     
@@ -174,29 +683,30 @@ public:
     }
     
     double readDouble() {
-        uint64_t bits = (static_cast<uint64_t>(readUint32()) << 32) | readUint32();
+        if (wire_flags_ & WIRE_NATIVE_LE) return getNative<double>();
+        uint64_t high = getFixed32();
+        uint64_t bits = (high << 32) | getFixed32();
         double value;
         std::memcpy(&value, &bits, sizeof(double));
         return value;
     }
     
     float readFloat() {
-        uint32_t bits = readUint32();
+        if (wire_flags_ & WIRE_NATIVE_LE) return getNative<float>();
+        uint32_t bits = getFixed32();
         float value;
         std::memcpy(&value, &bits, sizeof(float));
         return value;
     }
 
     std::string readString() {
-        uint32_t len = readUint32();
-        if (!canRead(len)) throw std::runtime_error("Buffer underflow");
-        std::string str(reinterpret_cast<const char*>(data_ + pos_), len);
-        pos_ += len;
-        return str;
+        uint32_t len;
+        const char* str = getString(len);
+        return std::string(str, len);
     }
 
     std::vector<std::string> readStringVector() {
-        uint32_t count = readUint32();
+        uint32_t count = readCount();
         std::vector<std::string> vec;
         vec.reserve(count);
         for (uint32_t i = 0; i < count; i++) {
@@ -205,103 +715,659 @@ public:
         return vec;
     }
 
-    size_t position() const { return pos_; }
-};
-#endif // IPC_BYTE_BUFFER_DEFINED
+    // Numeric sequence written by ByteBuffer::writeArray
+    template <typename Vector>
+    void readArrayInto(Vector& vec) {
+        typedef typename Vector::value_type T;
+        uint32_t count = readCount();
+        if (bulkCopy<T>() && !canRead(static_cast<size_t>(count) * sizeof(T))) {
+            throw std::runtime_error("Buffer underflow");
+        }
+        vec.resize(count);
+        if (count > 0) readFixedArray(&vec[0], count);
+    }
 
-// Message IDs
-const uint32_t MSG_TESTINTEGERS_REQ = 1000;
-const uint32_t MSG_TESTINTEGERS_RESP = 1001;
-const uint32_t MSG_TESTFLOATS_REQ = 1002;
-const uint32_t MSG_TESTFLOATS_RESP = 1003;
-const uint32_t MSG_TESTCHARANDBOOL_REQ = 1004;
-const uint32_t MSG_TESTCHARANDBOOL_RESP = 1005;
-const uint32_t MSG_TESTSTRING_REQ = 1006;
-const uint32_t MSG_TESTSTRING_RESP = 1007;
-const uint32_t MSG_TESTENUM_REQ = 1008;
-const uint32_t MSG_TESTENUM_RESP = 1009;
-const uint32_t MSG_TESTSTRUCT_REQ = 1010;
-const uint32_t MSG_TESTSTRUCT_RESP = 1011;
-const uint32_t MSG_TESTNESTEDSTRUCT_REQ = 1012;
-const uint32_t MSG_TESTNESTEDSTRUCT_RESP = 1013;
-const uint32_t MSG_TESTINT32VECTOR_REQ = 1014;
-const uint32_t MSG_TESTINT32VECTOR_RESP = 1015;
-const uint32_t MSG_TESTUINT64VECTOR_REQ = 1016;
-const uint32_t MSG_TESTUINT64VECTOR_RESP = 1017;
-const uint32_t MSG_TESTFLOATVECTOR_REQ = 1018;
-const uint32_t MSG_TESTFLOATVECTOR_RESP = 1019;
-const uint32_t MSG_TESTDOUBLEVECTOR_REQ = 1020;
-const uint32_t MSG_TESTDOUBLEVECTOR_RESP = 1021;
-const uint32_t MSG_TESTSTRINGVECTOR_REQ = 1022;
-const uint32_t MSG_TESTSTRINGVECTOR_RESP = 1023;
-const uint32_t MSG_TESTBOOLVECTOR_REQ = 1024;
-const uint32_t MSG_TESTBOOLVECTOR_RESP = 1025;
-const uint32_t MSG_TESTENUMVECTOR_REQ = 1026;
-const uint32_t MSG_TESTENUMVECTOR_RESP = 1027;
-const uint32_t MSG_TESTSTRUCTVECTOR_REQ = 1028;
-const uint32_t MSG_TESTSTRUCTVECTOR_RESP = 1029;
-const uint32_t MSG_TESTNESTEDSTRUCTVECTOR_REQ = 1030;
-const uint32_t MSG_TESTNESTEDSTRUCTVECTOR_RESP = 1031;
-const uint32_t MSG_TESTCOMPLEXDATA_REQ = 1032;
-const uint32_t MSG_TESTCOMPLEXDATA_RESP = 1033;
-const uint32_t MSG_TESTOUTPARAMS_REQ = 1034;
-const uint32_t MSG_TESTOUTPARAMS_RESP = 1035;
-const uint32_t MSG_TESTOUTVECTORS_REQ = 1036;
-const uint32_t MSG_TESTOUTVECTORS_RESP = 1037;
-const uint32_t MSG_TESTINOUTPARAMS_REQ = 1038;
-const uint32_t MSG_TESTINOUTPARAMS_RESP = 1039;
-const uint32_t MSG_ONINTEGERUPDATE_REQ = 1040;
-const uint32_t MSG_ONFLOATUPDATE_REQ = 1041;
-const uint32_t MSG_ONSTRUCTUPDATE_REQ = 1042;
-const uint32_t MSG_ONVECTORUPDATE_REQ = 1043;
-const uint32_t MSG_ONCOMPLEXUPDATE_REQ = 1044;
+    // Fixed-size array written by ByteBuffer::writeFixedArray
+    template <typename T>
+    void readFixedArray(T* items, size_t count) {
+        if (bulkCopy<T>()) {
+            readBytes(items, count * sizeof(T));
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            readValue(items[i]);
+        }
+    }
 
-#ifndef IPC_TYPETEST_TYPES_DEFINED
-#define IPC_TYPETEST_TYPES_DEFINED
-enum class Priority {
-    LOW,
-    MEDIUM,
-    HIGH,
-    CRITICAL
-};
+    bool nativeRecords() const {
+        return (wire_flags_ & (WIRE_NATIVE_LE | WIRE_COMPACT)) == WIRE_NATIVE_LE;
+    }
 
-enum class Status {
-    PENDING,
-    PROCESSING,
-    COMPLETED,
-    FAILED
-};
+    void readBytes(void* out, size_t size) {
+        if (!canRead(size)) throw std::runtime_error("Buffer underflow");
+        if (size > 0) std::memcpy(out, data_ + pos_, size);
+        pos_ += size;
+    }
 
-struct IntegerTypes {
-    int8_t i8;
-    uint8_t u8;
-    int16_t i16;
-    uint16_t u16;
-    int32_t i32;
-    uint32_t u32;
-    int64_t i64;
-    uint64_t u64;
+    // Sequence written by ByteBuffer::writeBoolArray
+    template <typename Vector>
+    void readBoolArrayInto(Vector& bits) {
+        uint32_t count = readUint32();
+        size_t bytes = (static_cast<size_t>(count) + 7) / 8;
+        if (!canRead(bytes)) throw std::runtime_error("Buffer underflow");
+        bits.resize(count);
+        for (size_t base = 0; base < count; base += 64) {
+            size_t n = count - base < 64 ? count - base : 64;
+            uint64_t word = 0;
+            for (size_t b = 0; b < (n + 7) / 8; b++) {
+                word |= static_cast<uint64_t>(data_[pos_ + base / 8 + b]) << (8 * b);
+            }
+            for (size_t i = 0; i < n; i++) {
+                bits[base + i] = (word >> i) & 1;
+            }
+        }
+        pos_ += bytes;
+    }
 
-    void serialize(ByteBuffer& buffer) const {
-        buffer.writeInt8(i8);
-        buffer.writeUint8(u8);
-        buffer.writeInt16(i16);
-        buffer.writeUint16(u16);
-        buffer.writeInt32(i32);
-        buffer.writeUint32(u32);
-        buffer.writeInt64(i64);
-        buffer.writeUint64(u64);
+    template <typename T>
+    T readDelta(T& previous) {
+        previous = static_cast<T>(static_cast<uint64_t>(previous) + static_cast<uint64_t>(unzigzag(getVarint())));
+        return previous;
     }
 
-    void deserialize(ByteReader& reader) {
-        i8 = reader.readInt8();
-        u8 = reader.readUint8();
-        i16 = reader.readInt16();
-        u16 = reader.readUint16();
-        i32 = reader.readInt32();
-        u32 = reader.readUint32();
-        i64 = reader.readInt64();
-        u64 = reader.readUint64();
+    // Sequence written by ByteBuffer::writeDeltaSequence
+    template <typename Vector>
+    void readDeltaSequenceInto(Vector& vec) {
+        typename Vector::value_type::DeltaState delta;
+        vec.resize(readCount());
+        for (auto& item : vec) {
+            item.deserialize(*this, &delta);
+        }
+    }
+
+    // Sequence written by ByteBuffer::writeRecords
+    template <typename Vector>
+    void readRecordsInto(Vector& vec) {
+        typedef typename Vector::value_type T;
+        typedef typename T::Packed Packed;
+        uint32_t count = readCount();
+        if (!nativeRecords()) {
+            vec.resize(count);
+            for (auto& item : vec) {
+                item.deserialize(*this);
+            }
+            return;
+        }
+        size_t bytes = static_cast<size_t>(count) * sizeof(Packed);
+        if (!canRead(bytes)) throw std::runtime_error("Buffer underflow");
+        vec.resize(count);
+        if (count == 0) return;
+        if (sizeof(T) == sizeof(Packed) && std::is_trivially_copyable<T>::value) {
+            std::memcpy(&vec[0], data_ + pos_, bytes);
+        } else {
+            for (uint32_t i = 0; i < count; i++) {
+                Packed record;
+                std::memcpy(&record, data_ + pos_ + i * sizeof(Packed), sizeof(Packed));
+                vec[i].unpack(record);
+            }
+        }
+        pos_ += bytes;
+    }
+
+    // Decode into an existing string or vector, reusing its capacity and allocator
+    template <typename String>
+    void readStringInto(String& str) {
+        uint32_t len;
+        const char* bytes = getString(len);
+        str.assign(bytes, len);
+    }
+
+    template <typename Vector>
+    void readStringVectorInto(Vector& vec) {
+        uint32_t count = readCount();
+        vec.resize(count);
+        for (auto& str : vec) {
+            readStringInto(str);
+        }
+    }
+
+    // Counterparts of ByteBuffer::writeItem
+    void readItem(bool& value) { value = readBool(); }
+    void readItem(std::string& value) { readStringInto(value); }
+
+    template <typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value>::type readItem(T& value) { readValue(value); }
+
+    template <typename T>
+    typename std::enable_if<std::is_enum<T>::value>::type readItem(T& value) {
+        value = static_cast<T>(readInt32());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_class<T>::value>::type readItem(T& value) { value.deserialize(*this); }
+
+    template <typename T, typename A>
+    void readItem(std::vector<T, A>& vec) {
+        vec.resize(readCount());
+        for (auto& item : vec) readItem(item);
+    }
+
+    template <typename A>
+    void readItem(std::vector<bool, A>& vec) {
+        vec.resize(readCount());
+        for (size_t i = 0; i < vec.size(); i++) vec[i] = readBool();
+    }
+
+    template <typename K, typename V, typename H, typename E, typename A>
+    void readItem(std::unordered_map<K, V, H, E, A>& map) { readMapInto(map); }
+
+    // map<K, V> written by ByteBuffer::writeMap: the table is reserved once and
+    // each value is decoded in place in its node, with no intermediate vectors
+    template <typename Map>
+    void readMapInto(Map& map) {
+        uint32_t count = readCount();
+        map.clear();
+        map.reserve(count);
+        for (uint32_t i = 0; i < count; i++) {
+            typename Map::key_type key;
+            readItem(key);
+            readItem(map[std::move(key)]);
+        }
+    }
+
+#if __cplusplus >= 201703L
+    // Zero-copy variants: the views point into the buffer being read
+    std::string_view readStringView() {
+        uint32_t len;
+        const char* str = getString(len);
+        return std::string_view(str, len);
+    }
+
+    std::vector<std::string_view> readStringViewVector() {
+        uint32_t count = readCount();
+        std::vector<std::string_view> vec;
+        vec.reserve(count);
+        for (uint32_t i = 0; i < count; i++) {
+            vec.push_back(readStringView());
+        }
+        return vec;
+    }
+#endif
+
+    size_t position() const { return pos_; }
+};
+
+// sequence<T, N>: at most N elements stored inline, so filling or decoding one never
+// touches the allocator. Encoded like sequence<T> (count, then the elements); growing
+// past N, including decoding a longer sequence, throws std::length_error.
+template <typename T, size_t N>
+class BoundedSequence {
+public:
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    BoundedSequence() : size_(0) {}
+
+    explicit BoundedSequence(size_t count) : size_(0) {
+        resize(count);
+    }
+
+    BoundedSequence(std::initializer_list<T> items) : size_(0) {
+        assign(items.begin(), items.end());
+    }
+
+    static size_t capacity() { return N; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    T* data() { return items_; }
+    const T* data() const { return items_; }
+    iterator begin() { return items_; }
+    iterator end() { return items_ + size_; }
+    const_iterator begin() const { return items_; }
+    const_iterator end() const { return items_ + size_; }
+    T& operator[](size_t i) { return items_[i]; }
+    const T& operator[](size_t i) const { return items_[i]; }
+
+    void push_back(const T& item) {
+        if (size_ == N) throw std::length_error("BoundedSequence: bound exceeded");
+        items_[size_++] = item;
+    }
+
+    void resize(size_t count) {
+        if (count > N) throw std::length_error("BoundedSequence: bound exceeded");
+        for (size_t i = size_; i < count; i++) items_[i] = T();
+        size_ = count;
+    }
+
+    void reserve(size_t count) {
+        if (count > N) throw std::length_error("BoundedSequence: bound exceeded");
+    }
+
+    void clear() { size_ = 0; }
+
+    template <typename Iterator>
+    void assign(Iterator first, Iterator last) {
+        clear();
+        for (; first != last; ++first) push_back(*first);
+    }
+
+    bool operator==(const BoundedSequence& other) const {
+        return size_ == other.size_ && std::equal(begin(), end(), other.begin());
+    }
+    bool operator!=(const BoundedSequence& other) const { return !(*this == other); }
+
+    void serialize(ByteBuffer& buffer) const { serializeItems(buffer, Encoding()); }
+    void deserialize(ByteReader& reader) { deserializeItems(reader, Encoding()); }
+
+private:
+    // 0: bits (writeBoolArray), 1: numeric block (writeArray), 2: element by element
+    typedef std::integral_constant<int, std::is_same<T, bool>::value ? 0 :
+                                        std::is_arithmetic<T>::value ? 1 : 2> Encoding;
+
+    void serializeItems(ByteBuffer& buffer, std::integral_constant<int, 0>) const { buffer.writeBoolArray(*this); }
+    void serializeItems(ByteBuffer& buffer, std::integral_constant<int, 1>) const { buffer.writeArray(items_, size_); }
+    void serializeItems(ByteBuffer& buffer, std::integral_constant<int, 2>) const {
+        buffer.writeUint32(static_cast<uint32_t>(size_));
+        for (size_t i = 0; i < size_; i++) buffer.writeItem(items_[i]);
+    }
+
+    void deserializeItems(ByteReader& reader, std::integral_constant<int, 0>) { reader.readBoolArrayInto(*this); }
+    void deserializeItems(ByteReader& reader, std::integral_constant<int, 1>) { reader.readArrayInto(*this); }
+    void deserializeItems(ByteReader& reader, std::integral_constant<int, 2>) {
+        resize(reader.readUint32());
+        for (size_t i = 0; i < size_; i++) reader.readItem(items_[i]);
+    }
+
+    T items_[N];
+    size_t size_;
+};
+
+// Byte-oriented LZ77 in the LZ4 block layout: per sequence a token (literal
+// count << 4 | match length - 4, 15 = more length bytes follow), the literals,
+// then a 2-byte little-endian match offset. The last sequence has no match.
+class LzCodec {
+public:
+    // Returns the compressed size, or 0 if the output would exceed capacity
+    static size_t compress(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity) {
+        static thread_local uint32_t table[kHashSize];  // Position + 1 of the last 4-byte sequence per hash
+        std::memset(table, 0, sizeof(table));
+        size_t out = 0;
+        size_t anchor = 0;
+        size_t pos = 0;
+        while (pos + kMinMatch <= size) {
+            uint32_t sequence = load32(src + pos);
+            uint32_t hash = (sequence * 2654435761u) >> (32 - kHashBits);
+            size_t candidate = table[hash];
+            table[hash] = static_cast<uint32_t>(pos + 1);
+            if (candidate == 0 || pos + 1 - candidate > 0xFFFF || load32(src + candidate - 1) != sequence) {
+                pos++;
+                continue;
+            }
+            size_t match = candidate - 1;
+            size_t length = kMinMatch;
+            while (pos + length < size && src[match + length] == src[pos + length]) length++;
+            if (!putSequence(src + anchor, pos - anchor, pos - match, length, dst, capacity, out)) return 0;
+            pos += length;
+            anchor = pos;
+        }
+        if (!putSequence(src + anchor, size - anchor, 0, 0, dst, capacity, out)) return 0;
+        return out;
+    }
+
+    // Expands to exactly size bytes; false if the input is malformed
+    static bool decompress(const uint8_t* src, size_t src_size, uint8_t* dst, size_t size) {
+        size_t in = 0;
+        size_t out = 0;
+        while (in < src_size) {
+            uint8_t token = src[in++];
+            size_t literals = token >> 4;
+            if (literals == 15 && !getLength(src, src_size, in, literals)) return false;
+            if (literals > src_size - in || literals > size - out) return false;
+            std::memcpy(dst + out, src + in, literals);
+            in += literals;
+            out += literals;
+            if (in == src_size) break;
+            if (src_size - in < 2) return false;
+            size_t offset = static_cast<size_t>(src[in]) | (static_cast<size_t>(src[in + 1]) << 8);
+            in += 2;
+            if (offset == 0 || offset > out) return false;
+            size_t length = token & 0x0F;
+            if (length == 15 && !getLength(src, src_size, in, length)) return false;
+            length += kMinMatch;
+            if (length > size - out) return false;
+            for (size_t i = 0; i < length; i++, out++) {
+                dst[out] = dst[out - offset];  // Byte by byte: the match may overlap its output
+            }
+        }
+        return out == size;
+    }
+
+private:
+    static const int kHashBits = 12;
+    static const size_t kHashSize = static_cast<size_t>(1) << kHashBits;
+    static const size_t kMinMatch = 4;
+
+    static uint32_t load32(const uint8_t* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static bool putLength(size_t length, uint8_t* dst, size_t capacity, size_t& out) {
+        for (; length >= 255; length -= 255) {
+            if (out >= capacity) return false;
+            dst[out++] = 255;
+        }
+        if (out >= capacity) return false;
+        dst[out++] = static_cast<uint8_t>(length);
+        return true;
+    }
+
+    static bool putSequence(const uint8_t* literals, size_t count, size_t offset, size_t length,
+                            uint8_t* dst, size_t capacity, size_t& out) {
+        size_t match = length ? length - kMinMatch : 0;
+        if (out >= capacity) return false;
+        dst[out++] = static_cast<uint8_t>(((count < 15 ? count : 15) << 4) | (match < 15 ? match : 15));
+        if (count >= 15 && !putLength(count - 15, dst, capacity, out)) return false;
+        if (count > capacity - out) return false;
+        if (count > 0) std::memcpy(dst + out, literals, count);
+        out += count;
+        if (length == 0) return true;
+        if (capacity - out < 2) return false;
+        dst[out++] = static_cast<uint8_t>(offset & 0xFF);
+        dst[out++] = static_cast<uint8_t>(offset >> 8);
+        return match < 15 || putLength(match - 15, dst, capacity, out);
+    }
+
+    static bool getLength(const uint8_t* src, size_t src_size, size_t& in, size_t& length) {
+        uint8_t byte;
+        do {
+            if (in >= src_size) return false;
+            byte = src[in++];
+            length += byte;
+        } while (byte == 255);
+        return true;
+    }
+};
+
+// Set in a frame's flags byte when the body after the msg_id is raw length(4) +
+// LZ block; only sent to peers that negotiated WIRE_LZ
+const uint8_t FRAME_COMPRESSED = 0x80;
+const size_t FRAME_MAX_BYTES = 65536;             // flags/size(4) + payload, one datagram
+const size_t UDP_MAX_PAYLOAD = 65507;             // Largest datagram sendto() accepts over IPv4
+const size_t FRAME_MAX_INFLATED = 16 * 1024 * 1024;
+const size_t WIRE_LZ_THRESHOLD = 1024;            // Default: smaller payloads are sent as is
+
+// Frame a serialized message as flags(1) + size(3) + payload, compressing it when
+// the encoding allows, it exceeds threshold and it shrinks. Returns the frame
+// length, or 0 if it does not fit in FRAME_MAX_BYTES.
+inline size_t encodeFrame(const ByteBuffer& buffer, size_t threshold, uint8_t* frame) {
+    uint8_t flags = buffer.wireFlags();
+    size_t size = buffer.size();
+    const uint8_t* payload = buffer.data();
+    if ((flags & WIRE_LZ) && size > threshold && size > 16) {
+        size_t body = size - 4;
+        size_t capacity = body - 8 < FRAME_MAX_BYTES - 12 ? body - 8 : FRAME_MAX_BYTES - 12;
+        size_t packed = LzCodec::compress(payload + 4, body, frame + 12, capacity);
+        if (packed > 0) {
+            std::memcpy(frame + 4, payload, 4);  // msg_id stays readable for routing
+            frame[8] = (body >> 24) & 0xFF;
+            frame[9] = (body >> 16) & 0xFF;
+            frame[10] = (body >> 8) & 0xFF;
+            frame[11] = body & 0xFF;
+            flags |= FRAME_COMPRESSED;
+            size = 8 + packed;
+        } else {
+            if (size > FRAME_MAX_BYTES - 4) return 0;
+            std::memcpy(frame + 4, payload, size);
+        }
+    } else {
+        if (size > FRAME_MAX_BYTES - 4) return 0;
+        std::memcpy(frame + 4, payload, size);
+    }
+    frame[0] = flags;
+    frame[1] = (size >> 16) & 0xFF;
+    frame[2] = (size >> 8) & 0xFF;
+    frame[3] = size & 0xFF;
+    return size + 4;
+}
+
+// Undo encodeFrame's compression: a FRAME_COMPRESSED payload is expanded into
+// inflated and data/size are pointed at it. False if the payload is malformed.
+inline bool inflateFrame(uint8_t& flags, const uint8_t*& data, uint32_t& size, std::vector<uint8_t>& inflated) {
+    if (!(flags & FRAME_COMPRESSED)) return true;
+    flags &= ~FRAME_COMPRESSED;
+    if (size < 8) return false;
+    uint32_t body = (static_cast<uint32_t>(data[4]) << 24) | (static_cast<uint32_t>(data[5]) << 16) |
+                    (static_cast<uint32_t>(data[6]) << 8) | static_cast<uint32_t>(data[7]);
+    if (body > FRAME_MAX_INFLATED) return false;
+    inflated.resize(4 + body);
+    std::memcpy(inflated.data(), data, 4);
+    if (!LzCodec::decompress(data + 8, size - 8, inflated.data() + 4, body)) return false;
+    data = inflated.data();
+    size = 4 + body;
+    return true;
+}
+#endif // IPC_BYTE_BUFFER_DEFINED
+
+// Message IDs
+const uint32_t MSG_TESTINTEGERS_REQ = 1000;
+const uint32_t MSG_TESTINTEGERS_RESP = 1001;
+const uint32_t MSG_TESTFLOATS_REQ = 1002;
+const uint32_t MSG_TESTFLOATS_RESP = 1003;
+const uint32_t MSG_TESTCHARANDBOOL_REQ = 1004;
+const uint32_t MSG_TESTCHARANDBOOL_RESP = 1005;
+const uint32_t MSG_TESTSTRING_REQ = 1006;
+const uint32_t MSG_TESTSTRING_RESP = 1007;
+const uint32_t MSG_TESTENUM_REQ = 1008;
+const uint32_t MSG_TESTENUM_RESP = 1009;
+const uint32_t MSG_TESTSTRUCT_REQ = 1010;
+const uint32_t MSG_TESTSTRUCT_RESP = 1011;
+const uint32_t MSG_TESTNESTEDSTRUCT_REQ = 1012;
+const uint32_t MSG_TESTNESTEDSTRUCT_RESP = 1013;
+const uint32_t MSG_TESTINT32VECTOR_REQ = 1014;
+const uint32_t MSG_TESTINT32VECTOR_RESP = 1015;
+const uint32_t MSG_TESTUINT64VECTOR_REQ = 1016;
+const uint32_t MSG_TESTUINT64VECTOR_RESP = 1017;
+const uint32_t MSG_TESTFLOATVECTOR_REQ = 1018;
+const uint32_t MSG_TESTFLOATVECTOR_RESP = 1019;
+const uint32_t MSG_TESTDOUBLEVECTOR_REQ = 1020;
+const uint32_t MSG_TESTDOUBLEVECTOR_RESP = 1021;
+const uint32_t MSG_TESTSTRINGVECTOR_REQ = 1022;
+const uint32_t MSG_TESTSTRINGVECTOR_RESP = 1023;
+const uint32_t MSG_TESTBOOLVECTOR_REQ = 1024;
+const uint32_t MSG_TESTBOOLVECTOR_RESP = 1025;
+const uint32_t MSG_TESTENUMVECTOR_REQ = 1026;
+const uint32_t MSG_TESTENUMVECTOR_RESP = 1027;
+const uint32_t MSG_TESTSTRUCTVECTOR_REQ = 1028;
+const uint32_t MSG_TESTSTRUCTVECTOR_RESP = 1029;
+const uint32_t MSG_TESTNESTEDSTRUCTVECTOR_REQ = 1030;
+const uint32_t MSG_TESTNESTEDSTRUCTVECTOR_RESP = 1031;
+const uint32_t MSG_TESTBOUNDEDVECTOR_REQ = 1032;
+const uint32_t MSG_TESTBOUNDEDVECTOR_RESP = 1033;
+const uint32_t MSG_TESTFIXEDARRAYS_REQ = 1034;
+const uint32_t MSG_TESTFIXEDARRAYS_RESP = 1035;
+const uint32_t MSG_TESTMAP_REQ = 1036;
+const uint32_t MSG_TESTMAP_RESP = 1037;
+const uint32_t MSG_TESTMAPKEYS_REQ = 1038;
+const uint32_t MSG_TESTMAPKEYS_RESP = 1039;
+const uint32_t MSG_TESTCOMPLEXDATA_REQ = 1040;
+const uint32_t MSG_TESTCOMPLEXDATA_RESP = 1041;
+const uint32_t MSG_TESTOUTPARAMS_REQ = 1042;
+const uint32_t MSG_TESTOUTPARAMS_RESP = 1043;
+const uint32_t MSG_TESTOUTVECTORS_REQ = 1044;
+const uint32_t MSG_TESTOUTVECTORS_RESP = 1045;
+const uint32_t MSG_TESTINOUTPARAMS_REQ = 1046;
+const uint32_t MSG_TESTINOUTPARAMS_RESP = 1047;
+const uint32_t MSG_ONINTEGERUPDATE_REQ = 1048;
+const uint32_t MSG_ONFLOATUPDATE_REQ = 1049;
+const uint32_t MSG_ONSTRUCTUPDATE_REQ = 1050;
+const uint32_t MSG_ONVECTORUPDATE_REQ = 1051;
+const uint32_t MSG_ONCOMPLEXUPDATE_REQ = 1052;
+
+#ifndef IPC_TYPETEST_TYPES_DEFINED
+#define IPC_TYPETEST_TYPES_DEFINED
+enum class Priority {
+    LOW,
+    MEDIUM,
+    HIGH,
+    CRITICAL
+};
+
+enum class Status {
+    PENDING,
+    PROCESSING,
+    COMPLETED,
+    FAILED
+};
+
+struct IntegerTypes {
+    int8_t i8;
+    uint8_t u8;
+    int16_t i16;
+    uint16_t u16;
+    int32_t i32;
+    uint32_t u32;
+    int64_t i64;
+    uint64_t u64;
+
+    // Fixed-size fields only: in native little-endian mode the wire record is
+    // this packed layout, written and read with memcpy
+#pragma pack(push, 1)
+    struct Packed {
+        int8_t i8;
+        uint8_t u8;
+        int16_t i16;
+        uint16_t u16;
+        int32_t i32;
+        uint32_t u32;
+        int64_t i64;
+        uint64_t u64;
+    };
+#pragma pack(pop)
+    static_assert(sizeof(Packed) == 30, "IntegerTypes record must be 30 bytes on the wire");
+
+    void pack(Packed& record) const {
+        record.i8 = i8;
+        record.u8 = u8;
+        record.i16 = i16;
+        record.u16 = u16;
+        record.i32 = i32;
+        record.u32 = u32;
+        record.i64 = i64;
+        record.u64 = u64;
+    }
+
+    void unpack(const Packed& record) {
+        i8 = record.i8;
+        u8 = record.u8;
+        i16 = record.i16;
+        u16 = record.u16;
+        i32 = record.i32;
+        u32 = record.u32;
+        i64 = record.i64;
+        u64 = record.u64;
+    }
+
+    void serialize(ByteBuffer& buffer) const {
+        if (buffer.nativeRecords()) {
+            Packed record;
+            pack(record);
+            buffer.writeBytes(reinterpret_cast<const uint8_t*>(&record), sizeof(record));
+            return;
+        }
+        // WIRE_SPARSE: presence bitmap, then only the fields that differ from their default
+        uint64_t present = ~uint64_t(0);
+        if (buffer.wireFlags() & WIRE_SPARSE) {
+            present = 0;
+            if (ByteBuffer::nonZero(i8)) present |= uint64_t(1) << 0;
+            if (ByteBuffer::nonZero(u8)) present |= uint64_t(1) << 1;
+            if (ByteBuffer::nonZero(i16)) present |= uint64_t(1) << 2;
+            if (ByteBuffer::nonZero(u16)) present |= uint64_t(1) << 3;
+            if (ByteBuffer::nonZero(i32)) present |= uint64_t(1) << 4;
+            if (ByteBuffer::nonZero(u32)) present |= uint64_t(1) << 5;
+            if (ByteBuffer::nonZero(i64)) present |= uint64_t(1) << 6;
+            if (ByteBuffer::nonZero(u64)) present |= uint64_t(1) << 7;
+            buffer.writePresence(present, 8);
+        }
+        if (present & (uint64_t(1) << 0)) {
+            buffer.writeInt8(i8);
+        }
+        if (present & (uint64_t(1) << 1)) {
+            buffer.writeUint8(u8);
+        }
+        if (present & (uint64_t(1) << 2)) {
+            buffer.writeInt16(i16);
+        }
+        if (present & (uint64_t(1) << 3)) {
+            buffer.writeUint16(u16);
+        }
+        if (present & (uint64_t(1) << 4)) {
+            buffer.writeInt32(i32);
+        }
+        if (present & (uint64_t(1) << 5)) {
+            buffer.writeUint32(u32);
+        }
+        if (present & (uint64_t(1) << 6)) {
+            buffer.writeInt64(i64);
+        }
+        if (present & (uint64_t(1) << 7)) {
+            buffer.writeUint64(u64);
+        }
+    }
+
+    void deserialize(ByteReader& reader) {
+        if (reader.nativeRecords()) {
+            Packed record;
+            reader.readBytes(&record, sizeof(record));
+            unpack(record);
+            return;
+        }
+        // WIRE_SPARSE: fields the sender left out are reset to their default
+        uint64_t present = ~uint64_t(0);
+        if (reader.wireFlags() & WIRE_SPARSE) present = reader.readPresence(8);
+        if (present & (uint64_t(1) << 0)) {
+            i8 = reader.readInt8();
+        } else {
+            i8 = int8_t();
+        }
+        if (present & (uint64_t(1) << 1)) {
+            u8 = reader.readUint8();
+        } else {
+            u8 = uint8_t();
+        }
+        if (present & (uint64_t(1) << 2)) {
+            i16 = reader.readInt16();
+        } else {
+            i16 = int16_t();
+        }
+        if (present & (uint64_t(1) << 3)) {
+            u16 = reader.readUint16();
+        } else {
+            u16 = uint16_t();
+        }
+        if (present & (uint64_t(1) << 4)) {
+            i32 = reader.readInt32();
+        } else {
+            i32 = int32_t();
+        }
+        if (present & (uint64_t(1) << 5)) {
+            u32 = reader.readUint32();
+        } else {
+            u32 = uint32_t();
+        }
+        if (present & (uint64_t(1) << 6)) {
+            i64 = reader.readInt64();
+        } else {
+            i64 = int64_t();
+        }
+        if (present & (uint64_t(1) << 7)) {
+            u64 = reader.readUint64();
+        } else {
+            u64 = uint64_t();
+        }
     }
 };
 
@@ -313,19 +1379,63 @@ struct FloatAndCharTypes {
     std::string str;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeFloat(f);
-        buffer.writeDouble(d);
-        buffer.writeChar(c);
-        buffer.writeBool(b);
-        buffer.writeString(str);
+        // WIRE_SPARSE: presence bitmap, then only the fields that differ from their default
+        uint64_t present = ~uint64_t(0);
+        if (buffer.wireFlags() & WIRE_SPARSE) {
+            present = 0;
+            if (ByteBuffer::nonZero(f)) present |= uint64_t(1) << 0;
+            if (ByteBuffer::nonZero(d)) present |= uint64_t(1) << 1;
+            if (ByteBuffer::nonZero(c)) present |= uint64_t(1) << 2;
+            if (ByteBuffer::nonZero(b)) present |= uint64_t(1) << 3;
+            if (!str.empty()) present |= uint64_t(1) << 4;
+            buffer.writePresence(present, 5);
+        }
+        if (present & (uint64_t(1) << 0)) {
+            buffer.writeFloat(f);
+        }
+        if (present & (uint64_t(1) << 1)) {
+            buffer.writeDouble(d);
+        }
+        if (present & (uint64_t(1) << 2)) {
+            buffer.writeChar(c);
+        }
+        if (present & (uint64_t(1) << 3)) {
+            buffer.writeBool(b);
+        }
+        if (present & (uint64_t(1) << 4)) {
+            buffer.writeString(str);
+        }
     }
 
     void deserialize(ByteReader& reader) {
-        f = reader.readFloat();
-        d = reader.readDouble();
-        c = reader.readChar();
-        b = reader.readBool();
-        str = reader.readString();
+        // WIRE_SPARSE: fields the sender left out are reset to their default
+        uint64_t present = ~uint64_t(0);
+        if (reader.wireFlags() & WIRE_SPARSE) present = reader.readPresence(5);
+        if (present & (uint64_t(1) << 0)) {
+            f = reader.readFloat();
+        } else {
+            f = float();
+        }
+        if (present & (uint64_t(1) << 1)) {
+            d = reader.readDouble();
+        } else {
+            d = double();
+        }
+        if (present & (uint64_t(1) << 2)) {
+            c = reader.readChar();
+        } else {
+            c = char();
+        }
+        if (present & (uint64_t(1) << 3)) {
+            b = reader.readBool();
+        } else {
+            b = bool();
+        }
+        if (present & (uint64_t(1) << 4)) {
+            reader.readStringInto(str);
+        } else {
+            str.clear();
+        }
     }
 };
 
@@ -336,17 +1446,109 @@ struct NestedData {
     Status status;
 
     void serialize(ByteBuffer& buffer) const {
+        // WIRE_SPARSE: presence bitmap, then only the fields that differ from their default
+        uint64_t present = ~uint64_t(0);
+        if (buffer.wireFlags() & WIRE_SPARSE) {
+            present = uint64_t(0x3);
+            if (static_cast<int32_t>(priority) != 0) present |= uint64_t(1) << 2;
+            if (static_cast<int32_t>(status) != 0) present |= uint64_t(1) << 3;
+            buffer.writePresence(present, 4);
+        }
         integers.serialize(buffer);
         floats.serialize(buffer);
-        buffer.writeInt32(static_cast<int32_t>(priority));
-        buffer.writeInt32(static_cast<int32_t>(status));
+        if (present & (uint64_t(1) << 2)) {
+            buffer.writeInt32(static_cast<int32_t>(priority));
+        }
+        if (present & (uint64_t(1) << 3)) {
+            buffer.writeInt32(static_cast<int32_t>(status));
+        }
     }
 
     void deserialize(ByteReader& reader) {
+        // WIRE_SPARSE: fields the sender left out are reset to their default
+        uint64_t present = ~uint64_t(0);
+        if (reader.wireFlags() & WIRE_SPARSE) present = reader.readPresence(4);
         integers.deserialize(reader);
         floats.deserialize(reader);
-        priority = static_cast<Priority>(reader.readInt32());
-        status = static_cast<Status>(reader.readInt32());
+        if (present & (uint64_t(1) << 2)) {
+            priority = static_cast<Priority>(reader.readInt32());
+        } else {
+            priority = Priority();
+        }
+        if (present & (uint64_t(1) << 3)) {
+            status = static_cast<Status>(reader.readInt32());
+        } else {
+            status = Status();
+        }
+    }
+};
+
+struct SensorFrame {
+    uint32_t id;
+    std::array<double, 16> matrix;
+    std::array<float, 3> offsets;
+
+    // Fixed-size fields only: in native little-endian mode the wire record is
+    // this packed layout, written and read with memcpy
+#pragma pack(push, 1)
+    struct Packed {
+        uint32_t id;
+        double matrix[16];
+        float offsets[3];
+    };
+#pragma pack(pop)
+    static_assert(sizeof(Packed) == 144, "SensorFrame record must be 144 bytes on the wire");
+
+    void pack(Packed& record) const {
+        record.id = id;
+        std::memcpy(record.matrix, matrix.data(), sizeof(record.matrix));
+        std::memcpy(record.offsets, offsets.data(), sizeof(record.offsets));
+    }
+
+    void unpack(const Packed& record) {
+        id = record.id;
+        std::memcpy(matrix.data(), record.matrix, sizeof(record.matrix));
+        std::memcpy(offsets.data(), record.offsets, sizeof(record.offsets));
+    }
+
+    void serialize(ByteBuffer& buffer) const {
+        if (buffer.nativeRecords()) {
+            Packed record;
+            pack(record);
+            buffer.writeBytes(reinterpret_cast<const uint8_t*>(&record), sizeof(record));
+            return;
+        }
+        // WIRE_SPARSE: presence bitmap, then only the fields that differ from their default
+        uint64_t present = ~uint64_t(0);
+        if (buffer.wireFlags() & WIRE_SPARSE) {
+            present = uint64_t(0x6);
+            if (ByteBuffer::nonZero(id)) present |= uint64_t(1) << 0;
+            buffer.writePresence(present, 3);
+        }
+        if (present & (uint64_t(1) << 0)) {
+            buffer.writeUint32(id);
+        }
+        buffer.writeFixedArray(matrix.data(), matrix.size());
+        buffer.writeFixedArray(offsets.data(), offsets.size());
+    }
+
+    void deserialize(ByteReader& reader) {
+        if (reader.nativeRecords()) {
+            Packed record;
+            reader.readBytes(&record, sizeof(record));
+            unpack(record);
+            return;
+        }
+        // WIRE_SPARSE: fields the sender left out are reset to their default
+        uint64_t present = ~uint64_t(0);
+        if (reader.wireFlags() & WIRE_SPARSE) present = reader.readPresence(3);
+        if (present & (uint64_t(1) << 0)) {
+            id = reader.readUint32();
+        } else {
+            id = uint32_t();
+        }
+        reader.readFixedArray(matrix.data(), matrix.size());
+        reader.readFixedArray(offsets.data(), offsets.size());
     }
 };
 
@@ -370,201 +1572,337 @@ struct ComplexData {
     std::vector<NestedData> nestedseq;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(i8seq.size());
-        for (const auto& item : i8seq) {
-            buffer.writeInt8(item);
-        }
-        buffer.writeUint32(u8seq.size());
-        for (const auto& item : u8seq) {
-            buffer.writeUint8(item);
-        }
-        buffer.writeUint32(i16seq.size());
-        for (const auto& item : i16seq) {
-            buffer.writeInt16(item);
-        }
-        buffer.writeUint32(u16seq.size());
-        for (const auto& item : u16seq) {
-            buffer.writeUint16(item);
-        }
-        buffer.writeUint32(i32seq.size());
-        for (const auto& item : i32seq) {
-            buffer.writeInt32(item);
-        }
-        buffer.writeUint32(u32seq.size());
-        for (const auto& item : u32seq) {
-            buffer.writeUint32(item);
-        }
-        buffer.writeUint32(i64seq.size());
-        for (const auto& item : i64seq) {
-            buffer.writeInt64(item);
-        }
-        buffer.writeUint32(u64seq.size());
-        for (const auto& item : u64seq) {
-            buffer.writeUint64(item);
-        }
-        buffer.writeUint32(fseq.size());
-        for (const auto& item : fseq) {
-            buffer.writeFloat(item);
-        }
-        buffer.writeUint32(dseq.size());
-        for (const auto& item : dseq) {
-            buffer.writeDouble(item);
-        }
-        buffer.writeUint32(cseq.size());
-        for (const auto& item : cseq) {
-            buffer.writeChar(item);
-        }
-        buffer.writeUint32(bseq.size());
-        for (const auto& item : bseq) {
-            buffer.writeBool(item);
-        }
+        // @lazy: table of field end offsets (relative to the body), then the body.
+        // Fields must decode on their own, so the string dictionary is paused.
+        uint8_t wire_flags = buffer.wireFlags();
+        buffer.setWireFlags(wire_flags & ~WIRE_STRING_DICT);
+        size_t table = buffer.reserveFixed32(17);
+        size_t body = buffer.size();
+        buffer.writeArray(i8seq.data(), i8seq.size());
+        buffer.patchFixed32(table + 0, static_cast<uint32_t>(buffer.size() - body));
+        buffer.writeArray(u8seq.data(), u8seq.size());
+        buffer.patchFixed32(table + 4, static_cast<uint32_t>(buffer.size() - body));
+        buffer.writeArray(i16seq.data(), i16seq.size());
+        buffer.patchFixed32(table + 8, static_cast<uint32_t>(buffer.size() - body));
+        buffer.writeArray(u16seq.data(), u16seq.size());
+        buffer.patchFixed32(table + 12, static_cast<uint32_t>(buffer.size() - body));
+        buffer.writeArray(i32seq.data(), i32seq.size());
+        buffer.patchFixed32(table + 16, static_cast<uint32_t>(buffer.size() - body));
+        buffer.writeArray(u32seq.data(), u32seq.size());
+        buffer.patchFixed32(table + 20, static_cast<uint32_t>(buffer.size() - body));
+        buffer.writeArray(i64seq.data(), i64seq.size());
+        buffer.patchFixed32(table + 24, static_cast<uint32_t>(buffer.size() - body));
+        buffer.writeArray(u64seq.data(), u64seq.size());
+        buffer.patchFixed32(table + 28, static_cast<uint32_t>(buffer.size() - body));
+        buffer.writeArray(fseq.data(), fseq.size());
+        buffer.patchFixed32(table + 32, static_cast<uint32_t>(buffer.size() - body));
+        buffer.writeArray(dseq.data(), dseq.size());
+        buffer.patchFixed32(table + 36, static_cast<uint32_t>(buffer.size() - body));
+        buffer.writeArray(cseq.data(), cseq.size());
+        buffer.patchFixed32(table + 40, static_cast<uint32_t>(buffer.size() - body));
+        buffer.writeBoolArray(bseq);
+        buffer.patchFixed32(table + 44, static_cast<uint32_t>(buffer.size() - body));
         buffer.writeUint32(strseq.size());
         for (const auto& item : strseq) {
             buffer.writeString(item);
         }
+        buffer.patchFixed32(table + 48, static_cast<uint32_t>(buffer.size() - body));
         buffer.writeUint32(priseq.size());
         for (const auto& item : priseq) {
             buffer.writeInt32(static_cast<int32_t>(item));
         }
+        buffer.patchFixed32(table + 52, static_cast<uint32_t>(buffer.size() - body));
         buffer.writeUint32(stseq.size());
         for (const auto& item : stseq) {
             buffer.writeInt32(static_cast<int32_t>(item));
         }
-        buffer.writeUint32(intseq.size());
-        for (const auto& item : intseq) {
-            item.serialize(buffer);
-        }
+        buffer.patchFixed32(table + 56, static_cast<uint32_t>(buffer.size() - body));
+        buffer.writeRecords(intseq);
+        buffer.patchFixed32(table + 60, static_cast<uint32_t>(buffer.size() - body));
         buffer.writeUint32(nestedseq.size());
         for (const auto& item : nestedseq) {
             item.serialize(buffer);
         }
+        buffer.patchFixed32(table + 64, static_cast<uint32_t>(buffer.size() - body));
+        buffer.setWireFlags(wire_flags);
     }
 
     void deserialize(ByteReader& reader) {
+        uint8_t wire_flags = reader.wireFlags();
+        reader.setWireFlags(wire_flags & ~WIRE_STRING_DICT);
+        reader.skip(68);  // Offset table: only ComplexDataLazy needs it
+        reader.readArrayInto(i8seq);
+        reader.readArrayInto(u8seq);
+        reader.readArrayInto(i16seq);
+        reader.readArrayInto(u16seq);
+        reader.readArrayInto(i32seq);
+        reader.readArrayInto(u32seq);
+        reader.readArrayInto(i64seq);
+        reader.readArrayInto(u64seq);
+        reader.readArrayInto(fseq);
+        reader.readArrayInto(dseq);
+        reader.readArrayInto(cseq);
+        reader.readBoolArrayInto(bseq);
         {
-            uint32_t count = reader.readUint32();
-            i8seq.resize(count);
+            uint32_t count = reader.readCount();
+            strseq.resize(count);
             for (uint32_t i = 0; i < count; i++) {
-                i8seq[i] = reader.readInt8();
+                reader.readStringInto(strseq[i]);
             }
         }
         {
-            uint32_t count = reader.readUint32();
-            u8seq.resize(count);
+            uint32_t count = reader.readCount();
+            priseq.resize(count);
             for (uint32_t i = 0; i < count; i++) {
-                u8seq[i] = reader.readUint8();
+                priseq[i] = static_cast<Priority>(reader.readInt32());
             }
         }
         {
-            uint32_t count = reader.readUint32();
-            i16seq.resize(count);
+            uint32_t count = reader.readCount();
+            stseq.resize(count);
             for (uint32_t i = 0; i < count; i++) {
-                i16seq[i] = reader.readInt16();
+                stseq[i] = static_cast<Status>(reader.readInt32());
             }
         }
+        reader.readRecordsInto(intseq);
         {
-            uint32_t count = reader.readUint32();
-            u16seq.resize(count);
+            uint32_t count = reader.readCount();
+            nestedseq.resize(count);
             for (uint32_t i = 0; i < count; i++) {
-                u16seq[i] = reader.readUint16();
+                nestedseq[i].deserialize(reader);
             }
         }
-        {
-            uint32_t count = reader.readUint32();
-            i32seq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                i32seq[i] = reader.readInt32();
-            }
+        reader.setWireFlags(wire_flags);
+    }
+};
+
+// ComplexData decoded on demand: deserialize() only reads the offset table, and each
+// field is decoded on first access. The buffer being read must outlive this object.
+class ComplexDataLazy {
+public:
+    ComplexDataLazy() : body_(nullptr), wire_flags_(0), loaded_(0) {}
+
+    void deserialize(ByteReader& reader) {
+        wire_flags_ = reader.wireFlags() & ~WIRE_STRING_DICT;
+        uint32_t begin = 0;
+        for (size_t i = 0; i < 17; i++) {
+            ends_[i] = reader.readFixed32();
+            if (ends_[i] < begin) throw std::runtime_error("ComplexData: bad offset table");
+            begin = ends_[i];
         }
-        {
-            uint32_t count = reader.readUint32();
-            u32seq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                u32seq[i] = reader.readUint32();
-            }
+        body_ = reader.cursor();
+        reader.skip(ends_[16]);
+        loaded_ = 0;
+    }
+
+    const std::vector<int8_t>& i8seq() const {
+        if (!(loaded_ & (static_cast<uint64_t>(1) << 0))) {
+            ByteReader reader = fieldReader(0);
+            reader.readArrayInto(i8seq_);
+            loaded_ |= static_cast<uint64_t>(1) << 0;
         }
-        {
-            uint32_t count = reader.readUint32();
-            i64seq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                i64seq[i] = reader.readInt64();
-            }
+        return i8seq_;
+    }
+
+    const std::vector<uint8_t>& u8seq() const {
+        if (!(loaded_ & (static_cast<uint64_t>(1) << 1))) {
+            ByteReader reader = fieldReader(1);
+            reader.readArrayInto(u8seq_);
+            loaded_ |= static_cast<uint64_t>(1) << 1;
         }
-        {
-            uint32_t count = reader.readUint32();
-            u64seq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                u64seq[i] = reader.readUint64();
-            }
+        return u8seq_;
+    }
+
+    const std::vector<int16_t>& i16seq() const {
+        if (!(loaded_ & (static_cast<uint64_t>(1) << 2))) {
+            ByteReader reader = fieldReader(2);
+            reader.readArrayInto(i16seq_);
+            loaded_ |= static_cast<uint64_t>(1) << 2;
         }
-        {
-            uint32_t count = reader.readUint32();
-            fseq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                fseq[i] = reader.readFloat();
-            }
+        return i16seq_;
+    }
+
+    const std::vector<uint16_t>& u16seq() const {
+        if (!(loaded_ & (static_cast<uint64_t>(1) << 3))) {
+            ByteReader reader = fieldReader(3);
+            reader.readArrayInto(u16seq_);
+            loaded_ |= static_cast<uint64_t>(1) << 3;
         }
-        {
-            uint32_t count = reader.readUint32();
-            dseq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                dseq[i] = reader.readDouble();
-            }
+        return u16seq_;
+    }
+
+    const std::vector<int32_t>& i32seq() const {
+        if (!(loaded_ & (static_cast<uint64_t>(1) << 4))) {
+            ByteReader reader = fieldReader(4);
+            reader.readArrayInto(i32seq_);
+            loaded_ |= static_cast<uint64_t>(1) << 4;
         }
-        {
-            uint32_t count = reader.readUint32();
-            cseq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                cseq[i] = reader.readChar();
-            }
+        return i32seq_;
+    }
+
+    const std::vector<uint32_t>& u32seq() const {
+        if (!(loaded_ & (static_cast<uint64_t>(1) << 5))) {
+            ByteReader reader = fieldReader(5);
+            reader.readArrayInto(u32seq_);
+            loaded_ |= static_cast<uint64_t>(1) << 5;
+        }
+        return u32seq_;
+    }
+
+    const std::vector<int64_t>& i64seq() const {
+        if (!(loaded_ & (static_cast<uint64_t>(1) << 6))) {
+            ByteReader reader = fieldReader(6);
+            reader.readArrayInto(i64seq_);
+            loaded_ |= static_cast<uint64_t>(1) << 6;
+        }
+        return i64seq_;
+    }
+
+    const std::vector<uint64_t>& u64seq() const {
+        if (!(loaded_ & (static_cast<uint64_t>(1) << 7))) {
+            ByteReader reader = fieldReader(7);
+            reader.readArrayInto(u64seq_);
+            loaded_ |= static_cast<uint64_t>(1) << 7;
+        }
+        return u64seq_;
+    }
+
+    const std::vector<float>& fseq() const {
+        if (!(loaded_ & (static_cast<uint64_t>(1) << 8))) {
+            ByteReader reader = fieldReader(8);
+            reader.readArrayInto(fseq_);
+            loaded_ |= static_cast<uint64_t>(1) << 8;
+        }
+        return fseq_;
+    }
+
+    const std::vector<double>& dseq() const {
+        if (!(loaded_ & (static_cast<uint64_t>(1) << 9))) {
+            ByteReader reader = fieldReader(9);
+            reader.readArrayInto(dseq_);
+            loaded_ |= static_cast<uint64_t>(1) << 9;
+        }
+        return dseq_;
+    }
+
+    const std::vector<char>& cseq() const {
+        if (!(loaded_ & (static_cast<uint64_t>(1) << 10))) {
+            ByteReader reader = fieldReader(10);
+            reader.readArrayInto(cseq_);
+            loaded_ |= static_cast<uint64_t>(1) << 10;
         }
-        {
-            uint32_t count = reader.readUint32();
-            bseq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                bseq[i] = reader.readBool();
-            }
+        return cseq_;
+    }
+
+    const std::vector<bool>& bseq() const {
+        if (!(loaded_ & (static_cast<uint64_t>(1) << 11))) {
+            ByteReader reader = fieldReader(11);
+            reader.readBoolArrayInto(bseq_);
+            loaded_ |= static_cast<uint64_t>(1) << 11;
         }
-        {
-            uint32_t count = reader.readUint32();
-            strseq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                strseq[i] = reader.readString();
-            }
+        return bseq_;
+    }
+
+    const std::vector<std::string>& strseq() const {
+        if (!(loaded_ & (static_cast<uint64_t>(1) << 12))) {
+            ByteReader reader = fieldReader(12);
+            reader.readStringVectorInto(strseq_);
+            loaded_ |= static_cast<uint64_t>(1) << 12;
         }
-        {
-            uint32_t count = reader.readUint32();
-            priseq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                priseq[i] = static_cast<Priority>(reader.readInt32());
+        return strseq_;
+    }
+
+    const std::vector<Priority>& priseq() const {
+        if (!(loaded_ & (static_cast<uint64_t>(1) << 13))) {
+            ByteReader reader = fieldReader(13);
+            {
+                uint32_t count = reader.readCount();
+                priseq_.resize(count);
+                for (uint32_t i = 0; i < count; i++) {
+                    priseq_[i] = static_cast<Priority>(reader.readInt32());
+                }
             }
+            loaded_ |= static_cast<uint64_t>(1) << 13;
         }
-        {
-            uint32_t count = reader.readUint32();
-            stseq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                stseq[i] = static_cast<Status>(reader.readInt32());
+        return priseq_;
+    }
+
+    const std::vector<Status>& stseq() const {
+        if (!(loaded_ & (static_cast<uint64_t>(1) << 14))) {
+            ByteReader reader = fieldReader(14);
+            {
+                uint32_t count = reader.readCount();
+                stseq_.resize(count);
+                for (uint32_t i = 0; i < count; i++) {
+                    stseq_[i] = static_cast<Status>(reader.readInt32());
+                }
             }
+            loaded_ |= static_cast<uint64_t>(1) << 14;
         }
-        {
-            uint32_t count = reader.readUint32();
-            intseq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                intseq[i].deserialize(reader);
-            }
+        return stseq_;
+    }
+
+    const std::vector<IntegerTypes>& intseq() const {
+        if (!(loaded_ & (static_cast<uint64_t>(1) << 15))) {
+            ByteReader reader = fieldReader(15);
+            reader.readRecordsInto(intseq_);
+            loaded_ |= static_cast<uint64_t>(1) << 15;
         }
-        {
-            uint32_t count = reader.readUint32();
-            nestedseq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                nestedseq[i].deserialize(reader);
+        return intseq_;
+    }
+
+    const std::vector<NestedData>& nestedseq() const {
+        if (!(loaded_ & (static_cast<uint64_t>(1) << 16))) {
+            ByteReader reader = fieldReader(16);
+            {
+                uint32_t count = reader.readCount();
+                nestedseq_.resize(count);
+                for (uint32_t i = 0; i < count; i++) {
+                    nestedseq_[i].deserialize(reader);
+                }
             }
+            loaded_ |= static_cast<uint64_t>(1) << 16;
         }
+        return nestedseq_;
     }
+
+private:
+    ByteReader fieldReader(size_t index) const {
+        uint32_t begin = index ? ends_[index - 1] : 0;
+        return ByteReader(body_ + begin, ends_[index] - begin, wire_flags_);
+    }
+
+    const uint8_t* body_;
+    uint8_t wire_flags_;
+    uint32_t ends_[17];
+    mutable uint64_t loaded_;  // Bit i: field i decoded
+    mutable std::vector<int8_t> i8seq_;
+    mutable std::vector<uint8_t> u8seq_;
+    mutable std::vector<int16_t> i16seq_;
+    mutable std::vector<uint16_t> u16seq_;
+    mutable std::vector<int32_t> i32seq_;
+    mutable std::vector<uint32_t> u32seq_;
+    mutable std::vector<int64_t> i64seq_;
+    mutable std::vector<uint64_t> u64seq_;
+    mutable std::vector<float> fseq_;
+    mutable std::vector<double> dseq_;
+    mutable std::vector<char> cseq_;
+    mutable std::vector<bool> bseq_;
+    mutable std::vector<std::string> strseq_;
+    mutable std::vector<Priority> priseq_;
+    mutable std::vector<Status> stseq_;
+    mutable std::vector<IntegerTypes> intseq_;
+    mutable std::vector<NestedData> nestedseq_;
 };
 
 #endif // IPC_TYPETEST_TYPES_DEFINED
 
+enum class Color {
+    RED,
+    GREEN,
+    BLUE
+};
+
 // Message Structures
 struct testIntegersRequest {
     uint32_t msg_id = MSG_TESTINTEGERS_REQ;
@@ -578,7 +1916,12 @@ struct testIntegersRequest {
     uint64_t u64;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, i8, u8, i16, u16, i32, u32, i64, u64);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, int8_t i8, uint8_t u8, int16_t i16, uint16_t u16, int32_t i32, uint32_t u32, int64_t i64, uint64_t u64) {
         buffer.writeInt8(i8);
         buffer.writeUint8(u8);
         buffer.writeInt16(i16);
@@ -590,7 +1933,7 @@ struct testIntegersRequest {
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         i8 = reader.readInt8();
         u8 = reader.readUint8();
         i16 = reader.readInt16();
@@ -608,13 +1951,13 @@ struct testIntegersResponse {
     int32_t return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
         buffer.writeInt32(return_value);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
         return_value = reader.readInt32();
     }
@@ -626,13 +1969,18 @@ struct testFloatsRequest {
     double d;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, f, d);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, float f, double d) {
         buffer.writeFloat(f);
         buffer.writeDouble(d);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         f = reader.readFloat();
         d = reader.readDouble();
     }
@@ -644,13 +1992,13 @@ struct testFloatsResponse {
     double return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
         buffer.writeDouble(return_value);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
         return_value = reader.readDouble();
     }
@@ -662,13 +2010,18 @@ struct testCharAndBoolRequest {
     bool b;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, c, b);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, char c, bool b) {
         buffer.writeChar(c);
         buffer.writeBool(b);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         c = reader.readChar();
         b = reader.readBool();
     }
@@ -680,13 +2033,13 @@ struct testCharAndBoolResponse {
     bool return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
         buffer.writeBool(return_value);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
         return_value = reader.readBool();
     }
@@ -697,13 +2050,18 @@ struct testStringRequest {
     std::string str;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, str);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::string& str) {
         buffer.writeString(str);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        str = reader.readString();
+        msg_id = reader.readMsgId();
+        reader.readStringInto(str);
     }
 };
 
@@ -713,15 +2071,15 @@ struct testStringResponse {
     std::string return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
         buffer.writeString(return_value);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
-        return_value = reader.readString();
+        reader.readStringInto(return_value);
     }
 };
 
@@ -731,13 +2089,18 @@ struct testEnumRequest {
     Status s;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, p, s);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, Priority p, Status s) {
         buffer.writeInt32(static_cast<int32_t>(p));
         buffer.writeInt32(static_cast<int32_t>(s));
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         p = static_cast<Priority>(reader.readInt32());
         s = static_cast<Status>(reader.readInt32());
     }
@@ -749,13 +2112,13 @@ struct testEnumResponse {
     Priority return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
         buffer.writeInt32(static_cast<int32_t>(return_value));
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
         return_value = static_cast<Priority>(reader.readInt32());
     }
@@ -766,12 +2129,17 @@ struct testStructRequest {
     IntegerTypes data;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, data);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const IntegerTypes& data) {
         data.serialize(buffer);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         data.deserialize(reader);
     }
 };
@@ -782,13 +2150,13 @@ struct testStructResponse {
     IntegerTypes return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
         return_value.serialize(buffer);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
         return_value.deserialize(reader);
     }
@@ -799,12 +2167,17 @@ struct testNestedStructRequest {
     NestedData data;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, data);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const NestedData& data) {
         data.serialize(buffer);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         data.deserialize(reader);
     }
 };
@@ -815,13 +2188,13 @@ struct testNestedStructResponse {
     NestedData return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
         return_value.serialize(buffer);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
         return_value.deserialize(reader);
     }
@@ -832,22 +2205,18 @@ struct testInt32VectorRequest {
     std::vector<int32_t> seq;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
-        buffer.writeUint32(seq.size());
-        for (const auto& item : seq) {
-            buffer.writeInt32(item);
-        }
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, seq);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::vector<int32_t>& seq) {
+        buffer.writeArray(seq.data(), seq.size());
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        {
-            uint32_t count = reader.readUint32();
-            seq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                seq[i] = reader.readInt32();
-            }
-        }
+        msg_id = reader.readMsgId();
+        reader.readArrayInto(seq);
     }
 };
 
@@ -857,24 +2226,15 @@ struct testInt32VectorResponse {
     std::vector<int32_t> return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
-        buffer.writeUint32(return_value.size());
-        for (const auto& item : return_value) {
-            buffer.writeInt32(item);
-        }
+        buffer.writeArray(return_value.data(), return_value.size());
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
-        {
-            uint32_t count = reader.readUint32();
-            return_value.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                return_value[i] = reader.readInt32();
-            }
-        }
+        reader.readArrayInto(return_value);
     }
 };
 
@@ -883,22 +2243,18 @@ struct testUInt64VectorRequest {
     std::vector<uint64_t> seq;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
-        buffer.writeUint32(seq.size());
-        for (const auto& item : seq) {
-            buffer.writeUint64(item);
-        }
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, seq);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::vector<uint64_t>& seq) {
+        buffer.writeArray(seq.data(), seq.size());
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        {
-            uint32_t count = reader.readUint32();
-            seq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                seq[i] = reader.readUint64();
-            }
-        }
+        msg_id = reader.readMsgId();
+        reader.readArrayInto(seq);
     }
 };
 
@@ -908,24 +2264,15 @@ struct testUInt64VectorResponse {
     std::vector<uint64_t> return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
-        buffer.writeUint32(return_value.size());
-        for (const auto& item : return_value) {
-            buffer.writeUint64(item);
-        }
+        buffer.writeArray(return_value.data(), return_value.size());
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
-        {
-            uint32_t count = reader.readUint32();
-            return_value.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                return_value[i] = reader.readUint64();
-            }
-        }
+        reader.readArrayInto(return_value);
     }
 };
 
@@ -934,22 +2281,18 @@ struct testFloatVectorRequest {
     std::vector<float> seq;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
-        buffer.writeUint32(seq.size());
-        for (const auto& item : seq) {
-            buffer.writeFloat(item);
-        }
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, seq);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::vector<float>& seq) {
+        buffer.writeArray(seq.data(), seq.size());
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        {
-            uint32_t count = reader.readUint32();
-            seq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                seq[i] = reader.readFloat();
-            }
-        }
+        msg_id = reader.readMsgId();
+        reader.readArrayInto(seq);
     }
 };
 
@@ -959,24 +2302,15 @@ struct testFloatVectorResponse {
     std::vector<float> return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
-        buffer.writeUint32(return_value.size());
-        for (const auto& item : return_value) {
-            buffer.writeFloat(item);
-        }
+        buffer.writeArray(return_value.data(), return_value.size());
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
-        {
-            uint32_t count = reader.readUint32();
-            return_value.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                return_value[i] = reader.readFloat();
-            }
-        }
+        reader.readArrayInto(return_value);
     }
 };
 
@@ -985,22 +2319,18 @@ struct testDoubleVectorRequest {
     std::vector<double> seq;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
-        buffer.writeUint32(seq.size());
-        for (const auto& item : seq) {
-            buffer.writeDouble(item);
-        }
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, seq);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::vector<double>& seq) {
+        buffer.writeArray(seq.data(), seq.size());
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        {
-            uint32_t count = reader.readUint32();
-            seq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                seq[i] = reader.readDouble();
-            }
-        }
+        msg_id = reader.readMsgId();
+        reader.readArrayInto(seq);
     }
 };
 
@@ -1010,24 +2340,15 @@ struct testDoubleVectorResponse {
     std::vector<double> return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
-        buffer.writeUint32(return_value.size());
-        for (const auto& item : return_value) {
-            buffer.writeDouble(item);
-        }
+        buffer.writeArray(return_value.data(), return_value.size());
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
-        {
-            uint32_t count = reader.readUint32();
-            return_value.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                return_value[i] = reader.readDouble();
-            }
-        }
+        reader.readArrayInto(return_value);
     }
 };
 
@@ -1036,13 +2357,18 @@ struct testStringVectorRequest {
     std::vector<std::string> seq;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, seq);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::vector<std::string>& seq) {
         buffer.writeStringVector(seq);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        seq = reader.readStringVector();
+        msg_id = reader.readMsgId();
+        reader.readStringVectorInto(seq);
     }
 };
 
@@ -1052,15 +2378,15 @@ struct testStringVectorResponse {
     std::vector<std::string> return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
         buffer.writeStringVector(return_value);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
-        return_value = reader.readStringVector();
+        reader.readStringVectorInto(return_value);
     }
 };
 
@@ -1069,22 +2395,18 @@ struct testBoolVectorRequest {
     std::vector<bool> seq;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
-        buffer.writeUint32(seq.size());
-        for (const auto& item : seq) {
-            buffer.writeBool(item);
-        }
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, seq);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::vector<bool>& seq) {
+        buffer.writeBoolArray(seq);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        {
-            uint32_t count = reader.readUint32();
-            seq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                seq[i] = reader.readBool();
-            }
-        }
+        msg_id = reader.readMsgId();
+        reader.readBoolArrayInto(seq);
     }
 };
 
@@ -1094,24 +2416,15 @@ struct testBoolVectorResponse {
     std::vector<bool> return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
-        buffer.writeUint32(return_value.size());
-        for (const auto& item : return_value) {
-            buffer.writeBool(item);
-        }
+        buffer.writeBoolArray(return_value);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
-        {
-            uint32_t count = reader.readUint32();
-            return_value.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                return_value[i] = reader.readBool();
-            }
-        }
+        reader.readBoolArrayInto(return_value);
     }
 };
 
@@ -1120,7 +2433,12 @@ struct testEnumVectorRequest {
     std::vector<Priority> seq;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, seq);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::vector<Priority>& seq) {
         buffer.writeUint32(seq.size());
         for (const auto& item : seq) {
             buffer.writeInt32(static_cast<int32_t>(item));
@@ -1128,9 +2446,9 @@ struct testEnumVectorRequest {
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         {
-            uint32_t count = reader.readUint32();
+            uint32_t count = reader.readCount();
             seq.resize(count);
             for (uint32_t i = 0; i < count; i++) {
                 seq[i] = static_cast<Priority>(reader.readInt32());
@@ -1145,7 +2463,7 @@ struct testEnumVectorResponse {
     std::vector<Priority> return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
         buffer.writeUint32(return_value.size());
         for (const auto& item : return_value) {
@@ -1154,10 +2472,10 @@ struct testEnumVectorResponse {
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
         {
-            uint32_t count = reader.readUint32();
+            uint32_t count = reader.readCount();
             return_value.resize(count);
             for (uint32_t i = 0; i < count; i++) {
                 return_value[i] = static_cast<Priority>(reader.readInt32());
@@ -1171,7 +2489,50 @@ struct testStructVectorRequest {
     std::vector<IntegerTypes> seq;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, seq);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::vector<IntegerTypes>& seq) {
+        buffer.writeRecords(seq);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        reader.readRecordsInto(seq);
+    }
+};
+
+struct testStructVectorResponse {
+    uint32_t msg_id = MSG_TESTSTRUCTVECTOR_RESP;
+    int32_t status = 0;
+    std::vector<IntegerTypes> return_value;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        buffer.writeInt32(status);
+        buffer.writeRecords(return_value);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        status = reader.readInt32();
+        reader.readRecordsInto(return_value);
+    }
+};
+
+struct testNestedStructVectorRequest {
+    uint32_t msg_id = MSG_TESTNESTEDSTRUCTVECTOR_REQ;
+    std::vector<NestedData> seq;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, seq);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::vector<NestedData>& seq) {
         buffer.writeUint32(seq.size());
         for (const auto& item : seq) {
             item.serialize(buffer);
@@ -1179,9 +2540,9 @@ struct testStructVectorRequest {
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         {
-            uint32_t count = reader.readUint32();
+            uint32_t count = reader.readCount();
             seq.resize(count);
             for (uint32_t i = 0; i < count; i++) {
                 seq[i].deserialize(reader);
@@ -1190,13 +2551,13 @@ struct testStructVectorRequest {
     }
 };
 
-struct testStructVectorResponse {
-    uint32_t msg_id = MSG_TESTSTRUCTVECTOR_RESP;
+struct testNestedStructVectorResponse {
+    uint32_t msg_id = MSG_TESTNESTEDSTRUCTVECTOR_RESP;
     int32_t status = 0;
-    std::vector<IntegerTypes> return_value;
+    std::vector<NestedData> return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
         buffer.writeUint32(return_value.size());
         for (const auto& item : return_value) {
@@ -1205,10 +2566,10 @@ struct testStructVectorResponse {
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
         {
-            uint32_t count = reader.readUint32();
+            uint32_t count = reader.readCount();
             return_value.resize(count);
             for (uint32_t i = 0; i < count; i++) {
                 return_value[i].deserialize(reader);
@@ -1217,54 +2578,177 @@ struct testStructVectorResponse {
     }
 };
 
-struct testNestedStructVectorRequest {
-    uint32_t msg_id = MSG_TESTNESTEDSTRUCTVECTOR_REQ;
-    std::vector<NestedData> seq;
+struct testBoundedVectorRequest {
+    uint32_t msg_id = MSG_TESTBOUNDEDVECTOR_REQ;
+    BoundedSequence<int32_t, 16> seq;
+    BoundedSequence<std::string, 4> tags;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, seq, tags);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const BoundedSequence<int32_t, 16>& seq, const BoundedSequence<std::string, 4>& tags) {
+        seq.serialize(buffer);
+        tags.serialize(buffer);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        seq.deserialize(reader);
+        tags.deserialize(reader);
+    }
+};
+
+struct testBoundedVectorResponse {
+    uint32_t msg_id = MSG_TESTBOUNDEDVECTOR_RESP;
+    int32_t status = 0;
+    BoundedSequence<int32_t, 16> return_value;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        buffer.writeInt32(status);
+        return_value.serialize(buffer);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        status = reader.readInt32();
+        return_value.deserialize(reader);
+    }
+};
+
+struct testFixedArraysRequest {
+    uint32_t msg_id = MSG_TESTFIXEDARRAYS_REQ;
+    SensorFrame frame;
+    std::array<int32_t, 4> weights;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, frame, weights);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const SensorFrame& frame, const std::array<int32_t, 4>& weights) {
+        frame.serialize(buffer);
+        buffer.writeFixedArray(weights.data(), weights.size());
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        frame.deserialize(reader);
+        reader.readFixedArray(weights.data(), weights.size());
+    }
+};
+
+struct testFixedArraysResponse {
+    uint32_t msg_id = MSG_TESTFIXEDARRAYS_RESP;
+    int32_t status = 0;
+    SensorFrame return_value;
+    std::array<std::string, 2> labels;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        buffer.writeInt32(status);
+        return_value.serialize(buffer);
+        for (const auto& item : labels) {
+            buffer.writeString(item);
+        }
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        status = reader.readInt32();
+        return_value.deserialize(reader);
+        for (auto& item : labels) {
+            item = reader.readString();
+        }
+    }
+};
+
+struct testMapRequest {
+    uint32_t msg_id = MSG_TESTMAP_REQ;
+    std::unordered_map<std::string, std::vector<int32_t>> groups;
+    std::unordered_map<Priority, IntegerTypes> records;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, groups, records);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::unordered_map<std::string, std::vector<int32_t>>& groups, const std::unordered_map<Priority, IntegerTypes>& records) {
+        buffer.writeMap(groups);
+        buffer.writeMap(records);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        reader.readMapInto(groups);
+        reader.readMapInto(records);
+    }
+};
+
+struct testMapResponse {
+    uint32_t msg_id = MSG_TESTMAP_RESP;
+    int32_t status = 0;
+    std::unordered_map<std::string, std::vector<int32_t>> return_value;
+    std::unordered_map<Priority, IntegerTypes> records;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        buffer.writeInt32(status);
+        buffer.writeMap(return_value);
+        buffer.writeMap(records);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        status = reader.readInt32();
+        reader.readMapInto(return_value);
+        reader.readMapInto(records);
+    }
+};
+
+struct testMapKeysRequest {
+    uint32_t msg_id = MSG_TESTMAPKEYS_REQ;
+    std::unordered_map<Color, int64_t> colors;
+    std::unordered_map<std::string, int64_t> counts;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
-        buffer.writeUint32(seq.size());
-        for (const auto& item : seq) {
-            item.serialize(buffer);
-        }
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, colors, counts);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::unordered_map<Color, int64_t>& colors, const std::unordered_map<std::string, int64_t>& counts) {
+        buffer.writeMap(colors);
+        buffer.writeMap(counts);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        {
-            uint32_t count = reader.readUint32();
-            seq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                seq[i].deserialize(reader);
-            }
-        }
+        msg_id = reader.readMsgId();
+        reader.readMapInto(colors);
+        reader.readMapInto(counts);
     }
 };
 
-struct testNestedStructVectorResponse {
-    uint32_t msg_id = MSG_TESTNESTEDSTRUCTVECTOR_RESP;
+struct testMapKeysResponse {
+    uint32_t msg_id = MSG_TESTMAPKEYS_RESP;
     int32_t status = 0;
-    std::vector<NestedData> return_value;
+    int64_t return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
-        buffer.writeUint32(return_value.size());
-        for (const auto& item : return_value) {
-            item.serialize(buffer);
-        }
+        buffer.writeInt64(return_value);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
-        {
-            uint32_t count = reader.readUint32();
-            return_value.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                return_value[i].deserialize(reader);
-            }
-        }
+        return_value = reader.readInt64();
     }
 };
 
@@ -1273,12 +2757,17 @@ struct testComplexDataRequest {
     ComplexData data;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, data);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const ComplexData& data) {
         data.serialize(buffer);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         data.deserialize(reader);
     }
 };
@@ -1289,13 +2778,13 @@ struct testComplexDataResponse {
     ComplexData return_value;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
         return_value.serialize(buffer);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
         return_value.deserialize(reader);
     }
@@ -1306,12 +2795,17 @@ struct testOutParamsRequest {
     int32_t input;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, input);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, int32_t input) {
         buffer.writeInt32(input);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         input = reader.readInt32();
     }
 };
@@ -1335,7 +2829,7 @@ struct testOutParamsResponse {
     Priority o_p;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
         buffer.writeInt8(o_i8);
         buffer.writeUint8(o_u8);
@@ -1354,7 +2848,7 @@ struct testOutParamsResponse {
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
         o_i8 = reader.readInt8();
         o_u8 = reader.readUint8();
@@ -1368,7 +2862,7 @@ struct testOutParamsResponse {
         o_d = reader.readDouble();
         o_c = reader.readChar();
         o_b = reader.readBool();
-        o_str = reader.readString();
+        reader.readStringInto(o_str);
         o_p = static_cast<Priority>(reader.readInt32());
     }
 };
@@ -1378,12 +2872,17 @@ struct testOutVectorsRequest {
     int32_t count;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, count);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, int32_t count) {
         buffer.writeInt32(count);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         count = reader.readInt32();
     }
 };
@@ -1398,270 +2897,870 @@ struct testOutVectorsResponse {
     std::vector<IntegerTypes> o_structseq;
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
+        buffer.writeMsgId(msg_id);
         buffer.writeInt32(status);
-        buffer.writeUint32(o_i32seq.size());
-        for (const auto& item : o_i32seq) {
-            buffer.writeInt32(item);
-        }
-        buffer.writeUint32(o_fseq.size());
-        for (const auto& item : o_fseq) {
-            buffer.writeFloat(item);
-        }
+        buffer.writeArray(o_i32seq.data(), o_i32seq.size());
+        buffer.writeArray(o_fseq.data(), o_fseq.size());
         buffer.writeStringVector(o_strseq);
         buffer.writeUint32(o_pseq.size());
         for (const auto& item : o_pseq) {
             buffer.writeInt32(static_cast<int32_t>(item));
         }
-        buffer.writeUint32(o_structseq.size());
-        for (const auto& item : o_structseq) {
-            item.serialize(buffer);
-        }
+        buffer.writeRecords(o_structseq);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+        msg_id = reader.readMsgId();
         status = reader.readInt32();
+        reader.readArrayInto(o_i32seq);
+        reader.readArrayInto(o_fseq);
+        reader.readStringVectorInto(o_strseq);
         {
-            uint32_t count = reader.readUint32();
-            o_i32seq.resize(count);
+            uint32_t count = reader.readCount();
+            o_pseq.resize(count);
             for (uint32_t i = 0; i < count; i++) {
-                o_i32seq[i] = reader.readInt32();
+                o_pseq[i] = static_cast<Priority>(reader.readInt32());
             }
         }
-        {
-            uint32_t count = reader.readUint32();
-            o_fseq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                o_fseq[i] = reader.readFloat();
+        reader.readRecordsInto(o_structseq);
+    }
+};
+
+struct testInOutParamsRequest {
+    uint32_t msg_id = MSG_TESTINOUTPARAMS_REQ;
+    int32_t value;
+    std::string str;
+    IntegerTypes data;
+    std::vector<int32_t> seq;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, value, str, data, seq);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, int32_t value, const std::string& str, const IntegerTypes& data, const std::vector<int32_t>& seq) {
+        buffer.writeInt32(value);
+        buffer.writeString(str);
+        data.serialize(buffer);
+        buffer.writeArray(seq.data(), seq.size());
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        value = reader.readInt32();
+        reader.readStringInto(str);
+        data.deserialize(reader);
+        reader.readArrayInto(seq);
+    }
+};
+
+struct testInOutParamsResponse {
+    uint32_t msg_id = MSG_TESTINOUTPARAMS_RESP;
+    int32_t status = 0;
+    int32_t value;
+    std::string str;
+    IntegerTypes data;
+    std::vector<int32_t> seq;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        buffer.writeInt32(status);
+        buffer.writeInt32(value);
+        buffer.writeString(str);
+        data.serialize(buffer);
+        buffer.writeArray(seq.data(), seq.size());
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        status = reader.readInt32();
+        value = reader.readInt32();
+        reader.readStringInto(str);
+        data.deserialize(reader);
+        reader.readArrayInto(seq);
+    }
+};
+
+struct onIntegerUpdateRequest {
+    uint32_t msg_id = MSG_ONINTEGERUPDATE_REQ;
+    int8_t i8;
+    uint8_t u8;
+    int32_t i32;
+    int64_t i64;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, i8, u8, i32, i64);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, int8_t i8, uint8_t u8, int32_t i32, int64_t i64) {
+        buffer.writeInt8(i8);
+        buffer.writeUint8(u8);
+        buffer.writeInt32(i32);
+        buffer.writeInt64(i64);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        i8 = reader.readInt8();
+        u8 = reader.readUint8();
+        i32 = reader.readInt32();
+        i64 = reader.readInt64();
+    }
+};
+
+
+struct onFloatUpdateRequest {
+    uint32_t msg_id = MSG_ONFLOATUPDATE_REQ;
+    float f;
+    double d;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, f, d);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, float f, double d) {
+        buffer.writeFloat(f);
+        buffer.writeDouble(d);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        f = reader.readFloat();
+        d = reader.readDouble();
+    }
+};
+
+
+struct onStructUpdateRequest {
+    uint32_t msg_id = MSG_ONSTRUCTUPDATE_REQ;
+    IntegerTypes data;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, data);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const IntegerTypes& data) {
+        data.serialize(buffer);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        data.deserialize(reader);
+    }
+};
+
+
+struct onVectorUpdateRequest {
+    uint32_t msg_id = MSG_ONVECTORUPDATE_REQ;
+    std::vector<int32_t> seq;
+    std::vector<std::string> strseq;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, seq, strseq);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const std::vector<int32_t>& seq, const std::vector<std::string>& strseq) {
+        buffer.writeArray(seq.data(), seq.size());
+        buffer.writeStringVector(strseq);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        reader.readArrayInto(seq);
+        reader.readStringVectorInto(strseq);
+    }
+};
+
+
+struct onComplexUpdateRequest {
+    uint32_t msg_id = MSG_ONCOMPLEXUPDATE_REQ;
+    ComplexData data;
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.writeMsgId(msg_id);
+        serializeFields(buffer, data);
+    }
+
+    // Fields after the msg_id, written straight from the caller's arguments
+    static void serializeFields(ByteBuffer& buffer, const ComplexData& data) {
+        data.serialize(buffer);
+    }
+
+    void deserialize(ByteReader& reader) {
+        msg_id = reader.readMsgId();
+        data.deserialize(reader);
+    }
+};
+
+
+// onComplexUpdate callback with its @lazy parameters decoded on demand. The
+// parameters point into message, so this object is neither copied nor moved.
+struct onComplexUpdateRequestLazy {
+    std::vector<uint8_t> message;
+    ComplexDataLazy data;
+
+    onComplexUpdateRequestLazy(const uint8_t* bytes, size_t length, uint8_t wire_flags) : message(bytes, bytes + length) {
+        ByteReader reader(message.data(), message.size(), wire_flags);
+        reader.readMsgId();
+        data.deserialize(reader);
+    }
+    onComplexUpdateRequestLazy(const onComplexUpdateRequestLazy&) = delete;
+    onComplexUpdateRequestLazy& operator=(const onComplexUpdateRequestLazy&) = delete;
+};
+
+#ifndef IPC_SOCKET_BASE_DEFINED
+#define IPC_SOCKET_BASE_DEFINED
+// Runtime control messages (handled by the generated code, not part of any IDL interface)
+const uint32_t MSG_CTRL_CALLBACK_CHANNEL_REQ = 0xFFFF0001;  // client -> server: route callbacks to this socket
+const uint32_t MSG_CTRL_CALLBACK_CHANNEL_ACK = 0xFFFF0002;  // server -> client: callback channel registered
+const uint32_t MSG_CTRL_STREAM_CREDIT = 0xFFFF0003;         // client -> server: may send N more stream chunks
+const uint32_t MSG_CTRL_HELLO = 0xFFFF0004;                 // client -> server: wire encodings wanted
+const uint32_t MSG_CTRL_HELLO_ACK = 0xFFFF0005;             // server -> client: wire encodings accepted
+const uint32_t MSG_CTRL_CALLBACK_TOKEN_REQ = 0xFFFF0006;    // client RPC socket -> server: token for CALLBACK_CHANNEL_REQ
+const uint32_t MSG_CTRL_CALLBACK_TOKEN = 0xFFFF0007;        // server -> client RPC socket: one-time token
+const uint32_t MSG_CTRL_BYE = 0xFFFF0008;                   // client RPC socket -> server: forget this client
+
+// Placement of the threads spawned by the generated runtime
+struct ThreadOptions {
+    std::vector<int> cpus;  // CPU cores the threads may run on (empty = any)
+    int priority;           // SCHED_FIFO priority 1-99 (0 = keep the default policy)
+    std::string name;       // thread name prefix, shown as "<name>-<role>" (max 15 chars)
+    
+    ThreadOptions() : priority(0) {}
+    
+    // Apply to the calling thread; returns false if any setting was rejected, with
+    // the rejected settings described in *error
+    bool applyToCurrentThread(const char* role, std::string* error = nullptr) const {
+        std::string failed;
+        pthread_t self = pthread_self();
+        if (!cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : cpus) {
+                if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+                else failed += "cpu " + std::to_string(cpu) + " out of range; ";
             }
+            int rc = pthread_setaffinity_np(self, sizeof(set), &set);
+            if (rc != 0) failed += std::string("affinity: ") + std::strerror(rc) + "; ";
         }
-        o_strseq = reader.readStringVector();
-        {
-            uint32_t count = reader.readUint32();
-            o_pseq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                o_pseq[i] = static_cast<Priority>(reader.readInt32());
-            }
+        if (priority > 0) {
+            struct sched_param param;
+            param.sched_priority = priority;
+            int rc = pthread_setschedparam(self, SCHED_FIFO, &param);
+            if (rc != 0) failed += std::string("SCHED_FIFO priority: ") + std::strerror(rc) + "; ";
         }
-        {
-            uint32_t count = reader.readUint32();
-            o_structseq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                o_structseq[i].deserialize(reader);
+        if (!name.empty()) {
+            std::string thread_name = name + "-" + role;
+            int rc = pthread_setname_np(self, thread_name.substr(0, 15).c_str());
+            if (rc != 0) failed += std::string("name: ") + std::strerror(rc) + "; ";
+        }
+        if (error) *error = failed;
+        return failed.empty();
+    }
+
+    // For runtime threads: a rejection is logged and counted in *failures instead
+    // of silently leaving the thread unplaced
+    void applyOrReport(const char* role, std::atomic<size_t>* failures) const {
+        std::string error;
+        if (applyToCurrentThread(role, &error)) return;
+        if (failures) (*failures)++;
+        std::cerr << "[ThreadOptions] placement of thread '" << role << "' rejected: " << error << std::endl;
+    }
+
+    // Try the options on a short-lived thread, leaving the caller's placement untouched
+    bool validate(std::string* error = nullptr) const {
+        bool ok = false;
+        std::thread probe([this, &ok, error]() { ok = applyToCurrentThread("probe", error); });
+        probe.join();
+        return ok;
+    }
+};
+
+#if __cplusplus >= 201703L
+// Per-request arena used by --pmr-arena servers: decoded requests allocate from it and
+// everything is handed back in one step when the handler's scope ends
+class RequestArena {
+public:
+    // The pool's largest block size must cover the arena's overflow blocks, otherwise
+    // the pool hands them straight back upstream and every large request allocates again
+    RequestArena() : pool_(std::pmr::pool_options{0, kMaxPooledBlock}), arena_(buffer_, sizeof(buffer_), &pool_) {}
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &arena_; }
+
+    // Releases the arena when destroyed; declare before the objects that use it
+    class Scope {
+    public:
+        explicit Scope(RequestArena& owner) : owner_(owner) {}
+        ~Scope() { owner_.arena_.release(); }
+    private:
+        RequestArena& owner_;
+    };
+
+private:
+    static constexpr size_t kMaxPooledBlock = 1024 * 1024;
+
+    alignas(std::max_align_t) unsigned char buffer_[64 * 1024];
+    std::pmr::unsynchronized_pool_resource pool_;  // Keeps overflow blocks for the next request
+    std::pmr::monotonic_buffer_resource arena_;
+};
+#endif
+
+// Socket Base Class
+class SocketBase {
+protected:
+    int sockfd_;
+    struct sockaddr_in addr_;
+    bool connected_;
+    int wake_fd_;  // eventfd that interrupts blocking waits on shutdown (-1 if unavailable)
+    std::atomic<bool> woken_;
+    ThreadOptions thread_options_;
+    
+    // Without an eventfd, waitReadable() polls in slices this long so wake() is still seen
+    static const int kWakePollMs = 100;
+    
+public:
+    SocketBase() : sockfd_(-1), connected_(false),
+                   wake_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), woken_(false), placement_failures_(0) {}
+    
+    virtual ~SocketBase() {
+        if (sockfd_ >= 0) {
+            close(sockfd_);
+        }
+        if (wake_fd_ >= 0) {
+            close(wake_fd_);
+        }
+    }
+    
+    bool isConnected() const { return connected_; }
+    
+    // Placement for threads started after this call (restart listeners to apply).
+    // The options are tried first; if the OS rejects them (no such CPU, SCHED_FIFO
+    // without CAP_SYS_NICE, ...) this returns false with the reason in *error and
+    // keeps the previous options
+    bool setThreadOptions(const ThreadOptions& options, std::string* error = nullptr) {
+        if (!options.validate(error)) return false;
+        thread_options_ = options;
+        return true;
+    }
+    const ThreadOptions& threadOptions() const { return thread_options_; }
+    
+    // Runtime threads whose placement was rejected when they started
+    size_t threadPlacementFailures() const { return placement_failures_; }
+    
+protected:
+    std::atomic<size_t> placement_failures_;
+    
+    // Start a runtime thread with the configured placement
+    template <typename Body>
+    std::thread spawnThread(const char* role, Body body) {
+        ThreadOptions options = thread_options_;
+        std::atomic<size_t>* failures = &placement_failures_;
+        return std::thread([options, role, body, failures]() {
+            options.applyOrReport(role, failures);
+            body();
+        });
+    }
+    
+    // Block until fd is readable; returns false once wake() has been called
+    bool waitReadable(int fd) {
+        struct pollfd fds[2];
+        fds[0].fd = fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = wake_fd_;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        int nfds = wake_fd_ >= 0 ? 2 : 1;
+        int timeout = wake_fd_ >= 0 ? -1 : kWakePollMs;
+        while (true) {
+            if (woken_) return false;
+            if (poll(fds, nfds, timeout) < 0) {
+                if (errno == EINTR) continue;
+                return false;
             }
+            if (fds[1].revents != 0) return false;
+            if (fds[0].revents & POLLIN) return true;
+            if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) return false;
         }
     }
+    
+    // Wake every thread blocked in waitReadable()
+    void wake() {
+        woken_ = true;
+        if (wake_fd_ < 0) return;
+        uint64_t one = 1;
+        ssize_t written = write(wake_fd_, &one, sizeof(one));
+        (void)written;
+    }
+    
+    // Re-arm waitReadable() after the woken threads have exited
+    void resetWake() {
+        woken_ = false;
+        if (wake_fd_ < 0) return;
+        uint64_t value;
+        ssize_t drained = read(wake_fd_, &value, sizeof(value));
+        (void)drained;
+    }
+    
+public:
+    
+    ssize_t sendData(const void* data, size_t size) {
+        // UDP: send datagram to server address
+        return sendto(sockfd_, data, size, 0, 
+                      (struct sockaddr*)&addr_, sizeof(addr_));
+    }
+    
+    ssize_t receiveData(void* buffer, size_t size) {
+        // UDP: receive datagram
+        struct sockaddr_in from_addr;
+        socklen_t from_len = sizeof(from_addr);
+        return recvfrom(sockfd_, buffer, size, 0,
+                        (struct sockaddr*)&from_addr, &from_len);
+    }
+    
+    static ssize_t sendDataToSocket(int fd, const void* data, size_t size,
+                                   const struct sockaddr_in* addr) {
+        // UDP: send to specific address
+        return sendto(fd, data, size, 0,
+                      (struct sockaddr*)addr, sizeof(*addr));
+    }
+    
+    static ssize_t receiveDataFromSocket(int fd, void* buffer, size_t size,
+                                        struct sockaddr_in* from_addr) {
+        // UDP: receive from any address
+        socklen_t from_len = sizeof(*from_addr);
+        return recvfrom(fd, buffer, size, 0,
+                        (struct sockaddr*)from_addr, &from_len);
+    }
 };
 
-struct testInOutParamsRequest {
-    uint32_t msg_id = MSG_TESTINOUTPARAMS_REQ;
-    int32_t value;
-    std::string str;
-    IntegerTypes data;
-    std::vector<int32_t> seq;
+// Callback dispatcher pool: runs callbacks on worker threads so the listener
+// thread stays free to route RPC responses. Tasks submitted with the same
+// partition run in submission order on the same worker.
+class CallbackDispatcher {
+private:
+    struct Worker {
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::queue<std::function<void()>> tasks;
+        bool stopping;
+        Worker() : stopping(false) {}
+    };
+    std::vector<std::unique_ptr<Worker>> workers_;
 
-    void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
-        buffer.writeInt32(value);
-        buffer.writeString(str);
-        data.serialize(buffer);
-        buffer.writeUint32(seq.size());
-        for (const auto& item : seq) {
-            buffer.writeInt32(item);
+public:
+    explicit CallbackDispatcher(size_t threads, const ThreadOptions& options = ThreadOptions(),
+                                std::atomic<size_t>* placement_failures = nullptr) {
+        if (threads == 0) threads = 1;
+        for (size_t i = 0; i < threads; i++) {
+            workers_.emplace_back(new Worker());
+            Worker* worker = workers_.back().get();
+            worker->thread = std::thread([worker, options, placement_failures]() {
+                options.applyOrReport("cb", placement_failures);
+                run(worker);
+            });
         }
     }
 
-    void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        value = reader.readInt32();
-        str = reader.readString();
-        data.deserialize(reader);
-        {
-            uint32_t count = reader.readUint32();
-            seq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                seq[i] = reader.readInt32();
+    // Drains queued callbacks before joining the workers
+    ~CallbackDispatcher() {
+        for (auto& worker : workers_) {
+            {
+                std::lock_guard<std::mutex> lock(worker->mutex);
+                worker->stopping = true;
             }
+            worker->cv.notify_one();
+        }
+        for (auto& worker : workers_) {
+            if (worker->thread.joinable()) worker->thread.join();
         }
     }
-};
 
-struct testInOutParamsResponse {
-    uint32_t msg_id = MSG_TESTINOUTPARAMS_RESP;
-    int32_t status = 0;
-    int32_t value;
-    std::string str;
-    IntegerTypes data;
-    std::vector<int32_t> seq;
+    size_t threadCount() const { return workers_.size(); }
 
-    void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
-        buffer.writeInt32(status);
-        buffer.writeInt32(value);
-        buffer.writeString(str);
-        data.serialize(buffer);
-        buffer.writeUint32(seq.size());
-        for (const auto& item : seq) {
-            buffer.writeInt32(item);
+    void dispatch(size_t partition, std::function<void()> task) {
+        Worker* worker = workers_[partition % workers_.size()].get();
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            worker->tasks.push(std::move(task));
         }
+        worker->cv.notify_one();
     }
 
-    void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        status = reader.readInt32();
-        value = reader.readInt32();
-        str = reader.readString();
-        data.deserialize(reader);
-        {
-            uint32_t count = reader.readUint32();
-            seq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                seq[i] = reader.readInt32();
-            }
+private:
+    static void run(Worker* worker) {
+        std::unique_lock<std::mutex> lock(worker->mutex);
+        while (true) {
+            worker->cv.wait(lock, [worker]() { return worker->stopping || !worker->tasks.empty(); });
+            if (worker->tasks.empty()) break;  // stopping and drained
+            std::function<void()> task = std::move(worker->tasks.front());
+            worker->tasks.pop();
+            lock.unlock();
+            task();
+            lock.lock();
         }
     }
 };
 
-struct onIntegerUpdateRequest {
-    uint32_t msg_id = MSG_ONINTEGERUPDATE_REQ;
-    int8_t i8;
-    uint8_t u8;
-    int32_t i32;
-    int64_t i64;
+// Header of one chunk of a streaming RPC (stream<T>); the encoded items follow it
+struct StreamChunkHeader {
+    uint32_t msg_id;
+    uint32_t stream_id;
+    uint32_t seq;
+    bool last;
+    uint32_t count;
+
+    StreamChunkHeader() : msg_id(0), stream_id(0), seq(0), last(false), count(0) {}
 
     void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
-        buffer.writeInt8(i8);
-        buffer.writeUint8(u8);
-        buffer.writeInt32(i32);
-        buffer.writeInt64(i64);
+        buffer.writeMsgId(msg_id);
+        buffer.writeUint32(stream_id);
+        buffer.writeUint32(seq);
+        buffer.writeBool(last);
+        buffer.writeUint32(count);
     }
 
     void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        i8 = reader.readInt8();
-        u8 = reader.readUint8();
-        i32 = reader.readInt32();
-        i64 = reader.readInt64();
+        msg_id = reader.readMsgId();
+        stream_id = reader.readUint32();
+        seq = reader.readUint32();
+        last = reader.readBool();
+        count = reader.readUint32();
     }
 };
 
+// State shared by both ends of a stream: the peer, cancellation and completion
+class StreamBase {
+public:
+    StreamBase(int sockfd, const struct sockaddr_in& peer, uint32_t stream_id)
+        : sockfd_(sockfd), peer_(peer), stream_id_(stream_id), wire_flags_(0),
+          compress_threshold_(WIRE_LZ_THRESHOLD), cancelled_(false), done_(false) {}
 
-struct onFloatUpdateRequest {
-    uint32_t msg_id = MSG_ONFLOATUPDATE_REQ;
-    float f;
-    double d;
+    virtual ~StreamBase() {}
 
-    void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
-        buffer.writeFloat(f);
-        buffer.writeDouble(d);
+    // Encoding negotiated with the peer (call before the first item): chunks are
+    // encoded with wire_flags and, with WIRE_LZ, compressed above compress_threshold
+    virtual void setWireFormat(uint8_t wire_flags, size_t compress_threshold) {
+        wire_flags_ = wire_flags;
+        compress_threshold_ = compress_threshold;
     }
 
-    void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        f = reader.readFloat();
-        d = reader.readDouble();
+    // Called from the receive thread: credit for a writer, a chunk for a reader
+    virtual void addCredit(uint32_t credit) { (void)credit; }
+    virtual void pushChunk(const uint8_t* data, size_t size) { (void)data; (void)size; }
+
+    void cancel() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cancelled_ = true;
+        }
+        cv_.notify_all();
     }
-};
 
+    bool cancelled() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return cancelled_;
+    }
 
-struct onStructUpdateRequest {
-    uint32_t msg_id = MSG_ONSTRUCTUPDATE_REQ;
-    IntegerTypes data;
+    bool done() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return done_;
+    }
 
-    void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
-        data.serialize(buffer);
+    void markDone() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = true;
     }
 
-    void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        data.deserialize(reader);
+protected:
+    // Send flags(1) + size(3) + payload to the peer; false if it does not fit a frame
+    bool sendFrame(const ByteBuffer& buffer) {
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        return frame_size > 0 &&
+               sendto(sockfd_, send_buffer, frame_size, 0, (struct sockaddr*)&peer_, sizeof(peer_)) >= 0;
     }
+
+    int sockfd_;
+    struct sockaddr_in peer_;
+    uint32_t stream_id_;
+    uint8_t wire_flags_;
+    size_t compress_threshold_;
+    bool cancelled_;
+    bool done_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
 };
 
+// Sending end of a stream. Items are packed into chunks of about kChunkBytes,
+// never more than one datagram holds; a chunk is only sent while the peer has
+// granted credit, so a slow reader throttles the producer instead of overrunning
+// its socket buffer.
+class StreamWriterBase : public StreamBase {
+public:
+    static const size_t kChunkBytes = 16384;
+    // Largest encoded items of one chunk: a UDP datagram less the frame header
+    // and the largest StreamChunkHeader (compact varints)
+    static const size_t kMaxChunkBytes = UDP_MAX_PAYLOAD - 4 - 20;
 
-struct onVectorUpdateRequest {
-    uint32_t msg_id = MSG_ONVECTORUPDATE_REQ;
-    std::vector<int32_t> seq;
-    std::vector<std::string> strseq;
+    // Blocks up to 5 seconds for more credit; returns 0 on timeout
+    typedef std::function<uint32_t()> CreditSource;
 
-    void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
-        buffer.writeUint32(seq.size());
-        for (const auto& item : seq) {
-            buffer.writeInt32(item);
+    StreamWriterBase(int sockfd, const struct sockaddr_in& peer, uint32_t msg_id,
+                     uint32_t stream_id, uint32_t credit)
+        : StreamBase(sockfd, peer, stream_id), count_(0), max_delay_(10), msg_id_(msg_id), seq_(0),
+          credit_(credit) {}
+
+    // Credit 0 is a keepalive: the reader is alive but still busy with earlier chunks
+    void addCredit(uint32_t credit) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            credit_ += credit;
+            heard_ = std::chrono::steady_clock::now();
         }
-        buffer.writeStringVector(strseq);
+        cv_.notify_all();
     }
 
-    void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
+    void setWireFormat(uint8_t wire_flags, size_t compress_threshold) override {
+        StreamBase::setWireFormat(wire_flags, compress_threshold);
+        items_.setWireFlags(wire_flags);
+    }
+
+    // Longest an item waits in a partial chunk, checked as items are written
+    // (the first chunk always goes out with its first item)
+    void setMaxDelay(std::chrono::milliseconds delay) { max_delay_ = delay; }
+
+    // Fetch credit by polling instead of waiting for addCredit() (client uploads)
+    void setCreditSource(CreditSource source) { credit_source_ = source; }
+
+    // Send the buffered items now, e.g. before the producer blocks for a while;
+    // false once the stream was cancelled
+    bool sendPending() {
+        if (cancelled()) return false;
+        return count_ == 0 || flush(false, items_.size());
+    }
+
+    // Send the remaining items as the last chunk (called after the producer returns)
+    bool finish() {
+        if (done()) return !cancelled();
+        bool ok = !cancelled() && flush(true, items_.size());
+        markDone();
+        return ok;
+    }
+
+protected:
+    // Wait for credit (until the reader has been silent for 5 seconds), then send
+    // the first `bytes` of the buffered items (count_ items) as one chunk and
+    // start a new one
+    bool flush(bool last, size_t bytes) {
         {
-            uint32_t count = reader.readUint32();
-            seq.resize(count);
-            for (uint32_t i = 0; i < count; i++) {
-                seq[i] = reader.readInt32();
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (credit_ == 0 && credit_source_) {
+                lock.unlock();
+                uint32_t credit = credit_source_();
+                lock.lock();
+                credit_ += credit;
             }
+            heard_ = std::chrono::steady_clock::now();
+            while (credit_ == 0 && !cancelled_ &&
+                   cv_.wait_until(lock, heard_ + std::chrono::seconds(5)) == std::cv_status::no_timeout) {}
+            if (credit_ == 0 || cancelled_) {
+                cancelled_ = true;
+                return false;
+            }
+            credit_--;
+        }
+
+        StreamChunkHeader header;
+        header.msg_id = msg_id_;
+        header.stream_id = stream_id_;
+        header.seq = seq_++;
+        header.last = last;
+        header.count = count_;
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        header.serialize(buffer);
+        buffer.writeBytes(items_.data(), bytes);
+        items_.clear();  // Also resets the WIRE_STRING_DICT dictionary for the next chunk
+        count_ = 0;
+        if (!sendFrame(buffer)) {
+            cancel();
+            return false;
         }
-        strseq = reader.readStringVector();
+        return true;
     }
-};
 
+    // Send the chunk once it is full, when it is the first one (the reader sees
+    // items without waiting for a whole chunk) or when its oldest item has
+    // waited max_delay_
+    bool chunkDue() const {
+        return items_.size() >= kChunkBytes || seq_ == 0 ||
+               std::chrono::steady_clock::now() - chunk_started_ >= max_delay_;
+    }
 
-struct onComplexUpdateRequest {
-    uint32_t msg_id = MSG_ONCOMPLEXUPDATE_REQ;
-    ComplexData data;
+    ByteBuffer items_;
+    uint32_t count_;
+    std::chrono::steady_clock::time_point chunk_started_;  // When the first buffered item was written
+    std::chrono::milliseconds max_delay_;
 
-    void serialize(ByteBuffer& buffer) const {
-        buffer.writeUint32(msg_id);
-        data.serialize(buffer);
-    }
+private:
+    uint32_t msg_id_;
+    uint32_t seq_;
+    uint32_t credit_;
+    CreditSource credit_source_;
+    std::chrono::steady_clock::time_point heard_;  // Last credit or keepalive from the reader
+};
 
-    void deserialize(ByteReader& reader) {
-        msg_id = reader.readUint32();
-        data.deserialize(reader);
+template <typename T>
+class StreamWriter : public StreamWriterBase {
+public:
+    typedef std::function<void(ByteBuffer&, const T&)> Encoder;
+
+    StreamWriter(int sockfd, const struct sockaddr_in& peer, uint32_t msg_id,
+                 uint32_t stream_id, uint32_t credit, Encoder encode)
+        : StreamWriterBase(sockfd, peer, msg_id, stream_id, credit), encode_(encode) {}
+
+    // Queue one item; returns false once the reader is gone or the stream was
+    // cancelled, or (dropping the item, the stream stays open) when the item
+    // alone does not fit in one datagram
+    bool write(const T& item) {
+        if (cancelled()) return false;
+        size_t before = items_.size();
+        encode_(items_, item);
+        if (items_.size() > kMaxChunkBytes) {
+            if (count_ == 0) {  // Alone in its chunk and still too large
+                items_.clear();
+                return false;
+            }
+            // Send the items before this one, then encode it again on its own so
+            // it cannot refer to the dictionary of the chunk that just went out
+            if (!flush(false, before)) return false;
+            encode_(items_, item);
+            if (items_.size() > kMaxChunkBytes) {
+                items_.clear();
+                return false;
+            }
+        }
+        if (count_++ == 0) chunk_started_ = std::chrono::steady_clock::now();
+        if (chunkDue()) return flush(false, items_.size());
+        return true;
     }
-};
 
+private:
+    Encoder encode_;
+};
 
-#ifndef IPC_SOCKET_BASE_DEFINED
-#define IPC_SOCKET_BASE_DEFINED
-// Socket Base Class
-class SocketBase {
-protected:
-    int sockfd_;
-    struct sockaddr_in addr_;
-    bool connected_;
-    
+// Receiving end of a client stream (in stream<T> parameter). Chunks are queued
+// by the receive thread; credit goes back to the writer as they are consumed.
+class StreamReaderBase : public StreamBase {
 public:
-    SocketBase() : sockfd_(-1), connected_(false) {}
-    
-    virtual ~SocketBase() {
-        if (sockfd_ >= 0) {
-            close(sockfd_);
+    StreamReaderBase(int sockfd, const struct sockaddr_in& peer, uint32_t stream_id, uint32_t window)
+        : StreamBase(sockfd, peer, stream_id), reader_(nullptr, 0), remaining_(0), last_seen_(false),
+          window_(window > 0 ? window : 1), expected_seq_(0), consumed_(0), started_(false) {}
+
+    void pushChunk(const uint8_t* data, size_t size) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (cancelled_) return;
+            chunks_.push(std::vector<uint8_t>(data, data + size));
         }
+        cv_.notify_all();
     }
-    
-    bool isConnected() const { return connected_; }
-    
-    ssize_t sendData(const void* data, size_t size) {
-        return send(sockfd_, data, size, 0);
-    }
-    
-    ssize_t receiveData(void* buffer, size_t size) {
-        return recv(sockfd_, buffer, size, 0);
+
+    // True once the whole stream has arrived (no lost chunk, no timeout)
+    bool complete() const { return last_seen_ && remaining_ == 0; }
+
+    // Skip unread items so the writer can finish
+    void drain() {
+        while (!last_seen_ && nextChunk()) {}
+        remaining_ = 0;
     }
-    
-    static ssize_t sendDataToSocket(int fd, const void* data, size_t size) {
-        return send(fd, data, size, 0);
+
+protected:
+    // Make the next chunk current; false on timeout, cancellation or a lost chunk
+    bool nextChunk() {
+        if (started_ && ++consumed_ >= (window_ + 1) / 2) {
+            sendCredit(consumed_);
+            consumed_ = 0;
+        }
+        started_ = true;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!cv_.wait_for(lock, std::chrono::seconds(5), [this]() { return !chunks_.empty() || cancelled_; }) ||
+                cancelled_) {
+                cancelled_ = true;
+                return false;
+            }
+            current_ = std::move(chunks_.front());
+            chunks_.pop();
+        }
+        reader_ = ByteReader(current_.data(), current_.size(), wire_flags_);
+        StreamChunkHeader header;
+        header.deserialize(reader_);
+        if (header.seq != expected_seq_++) {
+            cancel();
+            return false;
+        }
+        remaining_ = header.count;
+        last_seen_ = header.last;
+        return true;
     }
-    
-    static ssize_t receiveDataFromSocket(int fd, void* buffer, size_t size) {
-        return recv(fd, buffer, size, 0);
+
+    ByteReader reader_;
+    uint32_t remaining_;
+    bool last_seen_;
+
+private:
+    void sendCredit(uint32_t credit) {
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.writeUint32(MSG_CTRL_STREAM_CREDIT);
+        buffer.writeUint32(stream_id_);
+        buffer.writeUint32(credit);
+        sendFrame(buffer);
+    }
+
+    uint32_t window_;
+    uint32_t expected_seq_;
+    uint32_t consumed_;
+    bool started_;
+    std::queue<std::vector<uint8_t>> chunks_;
+    std::vector<uint8_t> current_;
+};
+
+template <typename T>
+class StreamReader : public StreamReaderBase {
+public:
+    typedef std::function<void(ByteReader&, T&)> Decoder;
+
+    StreamReader(int sockfd, const struct sockaddr_in& peer, uint32_t stream_id, uint32_t window,
+                 Decoder decode)
+        : StreamReaderBase(sockfd, peer, stream_id, window), decode_(decode) {}
+
+    // Next item; false at the end of the stream (check complete() for errors)
+    bool read(T& item) {
+        while (remaining_ == 0) {
+            if (last_seen_ || !nextChunk()) return false;
+        }
+        decode_(reader_, item);
+        remaining_--;
+        return true;
     }
+
+private:
+    Decoder decode_;
 };
 #endif // IPC_SOCKET_BASE_DEFINED
 
@@ -1675,113 +3774,445 @@ private:
     // Message queue for RPC responses
     struct QueuedMessage {
         uint32_t msg_id;
+        uint8_t wire_flags;  // Encoding of the payload (WireFlag bits)
         std::vector<uint8_t> data;
     };
     std::queue<QueuedMessage> rpc_response_queue_;
     std::mutex queue_mutex_;
     std::condition_variable queue_cv_;
 
+    // Optional worker pool for callbacks (null = run inline on the listener thread)
+    std::unique_ptr<CallbackDispatcher> dispatcher_;
+
+    // Optional dedicated socket for server-pushed callbacks (-1 = shared socket)
+    int callback_sockfd_;
+    std::thread callback_thread_;
+
+    // Busy-poll mode: callers spin on the socket for their own response
+    bool busy_poll_;
+
+    // Encoding of outgoing requests (WireFlag bits accepted by the server)
+    uint8_t wire_flags_;
+    size_t compress_threshold_;  // With WIRE_LZ: requests larger than this are compressed
+
+    // Deliver callbacks with @lazy parameters to their ...Lazy overloads
+    bool lazy_callbacks_;
+
 public:
-    TypeTestServiceClient() : listening_(false) {}
+    TypeTestServiceClient() : listening_(false), callback_sockfd_(-1), busy_poll_(false), wire_flags_(0), compress_threshold_(WIRE_LZ_THRESHOLD), lazy_callbacks_(false) {}
 
     ~TypeTestServiceClient() {
         stopListening();
+        if (sockfd_ >= 0) {
+            // Let the server drop this client and its callback route now rather than on timeout
+            ByteBuffer bye;
+            bye.writeMsgId(MSG_CTRL_BYE);
+            uint8_t frame[FRAME_MAX_BYTES];
+            size_t frame_size = encodeFrame(bye, FRAME_MAX_BYTES, frame);
+            sendto(sockfd_, frame, frame_size, 0, (struct sockaddr*)&addr_, sizeof(addr_));
+        }
+        if (callback_sockfd_ >= 0) {
+            close(callback_sockfd_);
+        }
+    }
+
+    // Run callbacks on `threads` dispatcher threads instead of the listener thread.
+    // Callbacks for the same partition (see @partition in the IDL, otherwise the
+    // callback type) keep their order. Pass 0 to run callbacks inline again.
+    void setCallbackDispatcher(size_t threads) {
+        bool was_listening = listening_;
+        stopListening();
+        dispatcher_.reset(threads > 0 ? new CallbackDispatcher(threads, thread_options_, &placement_failures_) : nullptr);
+        if (was_listening) startListening();
     }
 
-    // Connect to server
-    bool connect(const std::string& host, uint16_t port) {
-        sockfd_ = socket(AF_INET, SOCK_STREAM, 0);
+    // Deliver callbacks whose parameters are @lazy structs to their ...Lazy overloads,
+    // which decode each field on first access, instead of the fully decoded ones
+    void setLazyCallbacks(bool enable) {
+        bool was_listening = listening_;
+        stopListening();
+        lazy_callbacks_ = enable;
+        if (was_listening) startListening();
+    }
+
+    // Setup UDP client
+    // With separate_callback_channel, callbacks arrive on a second socket and
+    // thread so RPC responses are never queued behind callback traffic.
+    bool connect(const std::string& host, uint16_t port, bool separate_callback_channel = false) {
+        sockfd_ = socket(AF_INET, SOCK_DGRAM, 0);  // UDP socket
         if (sockfd_ < 0) {
             return false;
         }
 
+        // Set receive timeout
+        struct timeval tv;
+        tv.tv_sec = 5;
+        tv.tv_usec = 0;
+        setsockopt(sockfd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
         addr_.sin_family = AF_INET;
         addr_.sin_port = htons(port);
         inet_pton(AF_INET, host.c_str(), &addr_.sin_addr);
 
-        if (::connect(sockfd_, (struct sockaddr*)&addr_, sizeof(addr_)) < 0) {
-            close(sockfd_);
-            sockfd_ = -1;
-            return false;
-        }
-
         connected_ = true;
         
+        if (separate_callback_channel) {
+            openCallbackChannel();  // Falls back to the shared socket on failure
+        }
+        
         // Auto-start listener thread for message reception
         startListening();
         
         return true;
     }
 
+    // True if callbacks are delivered on their own socket
+    bool hasCallbackChannel() const { return callback_sockfd_ >= 0; }
+
+    // Low-latency mode: the calling thread spins on a non-blocking recv() for its
+    // own response instead of waiting for the listener thread. The listener stops
+    // reading the RPC socket; callbacks arriving there are handled while a call
+    // spins or from pollCallbacks(), so pair this with a callback channel.
+    // busy_poll_usec > 0 also sets SO_BUSY_POLL on the socket (may need privileges).
+    void setBusyPoll(bool enable, int busy_poll_usec = 0) {
+        bool was_listening = listening_;
+        stopListening();
+        {
+            std::lock_guard<std::mutex> lock(send_mutex_);
+            busy_poll_ = enable;
+        }
+#ifdef SO_BUSY_POLL
+        if (enable && busy_poll_usec > 0 && sockfd_ >= 0) {
+            setsockopt(sockfd_, SOL_SOCKET, SO_BUSY_POLL, &busy_poll_usec, sizeof(busy_poll_usec));
+        }
+#endif
+        if (was_listening) startListening();
+    }
+
+    // Ask the server for a wire encoding (WireFlag bits, e.g. WIRE_COMPACT); requests
+    // then use whatever subset it accepts. Returns the flags in effect, 0 if the
+    // server declined or predates negotiation (after the usual 5 s timeout).
+    uint8_t negotiateWireFlags(uint8_t wanted) {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        wire_flags_ = 0;
+        uint8_t hello[9] = {0, 0, 0, 5};
+        hello[4] = (MSG_CTRL_HELLO >> 24) & 0xFF;
+        hello[5] = (MSG_CTRL_HELLO >> 16) & 0xFF;
+        hello[6] = (MSG_CTRL_HELLO >> 8) & 0xFF;
+        hello[7] = MSG_CTRL_HELLO & 0xFF;
+        hello[8] = wanted & WIRE_SUPPORTED;
+        if (sendData(hello, sizeof(hello)) < 0) return 0;
+
+        QueuedMessage ack;
+        if (!waitForResponse(MSG_CTRL_HELLO_ACK, ack) || ack.data.size() < 5) return 0;
+        wire_flags_ = ack.data[4] & hello[8];
+        return wire_flags_;
+    }
+
+    uint8_t wireFlags() const { return wire_flags_; }
+
+    // Requests above this many bytes are compressed once WIRE_LZ is negotiated
+    void setCompressionThreshold(size_t bytes) { compress_threshold_ = bytes; }
+
+    // Busy-poll mode: handle callbacks already waiting on the RPC socket
+    void pollCallbacks() {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        uint8_t recv_buffer[65536];
+        ssize_t received;
+        while ((received = recv(sockfd_, recv_buffer, sizeof(recv_buffer), MSG_DONTWAIT)) > 0) {
+            handleDatagram(recv_buffer, received);
+        }
+    }
+
     // Start async listening for broadcast messages
     void startListening() {
         if (listening_ || !connected_) return;
         listening_ = true;
-        listener_thread_ = std::thread([this]() {
-            listenLoop();
-        });
+        if (!busy_poll_) {
+            listener_thread_ = spawnThread("rx", [this]() {
+                listenLoop();
+            });
+        }
+        if (callback_sockfd_ >= 0) {
+            callback_thread_ = spawnThread("cbrx", [this]() {
+                callbackLoop();
+            });
+        }
     }
 
-    // Stop async listening
+    // Stop async listening (returns as soon as the listener threads exit)
     void stopListening() {
         listening_ = false;
+        wake();
         if (listener_thread_.joinable()) {
             listener_thread_.join();
         }
+        if (callback_thread_.joinable()) {
+            callback_thread_.join();
+        }
+        resetWake();
+    }
+
+private:
+    // Ask the server, on the RPC socket, for the one-time token that proves this
+    // client owns the RPC address it registers a callback channel for
+    bool requestChannelToken(uint64_t& token) {
+        ByteBuffer request;
+        request.writeMsgId(MSG_CTRL_CALLBACK_TOKEN_REQ);
+        uint8_t frame[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(request, FRAME_MAX_BYTES, frame);
+        for (int attempt = 0; attempt < 3; attempt++) {
+            if (sendto(sockfd_, frame, frame_size, 0, (struct sockaddr*)&addr_, sizeof(addr_)) < 0) {
+                return false;
+            }
+            struct pollfd pfd;
+            pfd.fd = sockfd_;
+            pfd.events = POLLIN;
+            if (poll(&pfd, 1, 1000) <= 0) continue;
+            uint8_t reply[64];
+            ssize_t received = recv(sockfd_, reply, sizeof(reply), 0);
+            if (received == 16) {
+                ByteReader reader(reply + 4, 12);
+                if (reader.readMsgId() == MSG_CTRL_CALLBACK_TOKEN) {
+                    token = reader.readUint64();
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Open a second socket for callbacks and register it with the server.
+    // The registration carries the RPC socket's port, and the token issued to
+    // that socket, so the server can route this client's callbacks to the new socket.
+    bool openCallbackChannel() {
+        // Bind the RPC socket now so its port is known before the first request
+        struct sockaddr_in local_addr;
+        memset(&local_addr, 0, sizeof(local_addr));
+        local_addr.sin_family = AF_INET;
+        local_addr.sin_addr.s_addr = INADDR_ANY;
+        local_addr.sin_port = 0;
+        socklen_t local_len = sizeof(local_addr);
+        if (bind(sockfd_, (struct sockaddr*)&local_addr, sizeof(local_addr)) < 0 ||
+            getsockname(sockfd_, (struct sockaddr*)&local_addr, &local_len) < 0) {
+            return false;
+        }
+
+        uint64_t token;
+        if (!requestChannelToken(token)) return false;
+
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0) return false;
+
+        struct timeval tv;
+        tv.tv_sec = 1;
+        tv.tv_usec = 0;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+        ByteBuffer buffer;
+        buffer.writeUint32(MSG_CTRL_CALLBACK_CHANNEL_REQ);
+        buffer.writeUint16(ntohs(local_addr.sin_port));
+        buffer.writeUint64(token);
+
+        uint32_t msg_size = buffer.size();
+        uint8_t send_buffer[64];
+        send_buffer[0] = (msg_size >> 24) & 0xFF;
+        send_buffer[1] = (msg_size >> 16) & 0xFF;
+        send_buffer[2] = (msg_size >> 8) & 0xFF;
+        send_buffer[3] = msg_size & 0xFF;
+        memcpy(send_buffer + 4, buffer.data(), msg_size);
+
+        // UDP may drop the registration; retry a few times before giving up
+        for (int attempt = 0; attempt < 3; attempt++) {
+            if (sendto(fd, send_buffer, msg_size + 4, 0, (struct sockaddr*)&addr_, sizeof(addr_)) < 0) {
+                break;
+            }
+            uint8_t recv_buffer[64];
+            ssize_t received = recv(fd, recv_buffer, sizeof(recv_buffer), 0);
+            if (received == 8) {
+                ByteReader reader(recv_buffer + 4, 4);
+                if (reader.readUint32() == MSG_CTRL_CALLBACK_CHANNEL_ACK) {
+                    callback_sockfd_ = fd;
+                    return true;
+                }
+            }
+        }
+
+        close(fd);
+        return false;
     }
 
-private:
     void listenLoop() {
         while (listening_ && connected_) {
-            // Set recv timeout to allow periodic checking of listening_ flag
-            struct timeval tv;
-            tv.tv_sec = 1;
-            tv.tv_usec = 0;
-            setsockopt(sockfd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            // Sleep in poll() until data arrives or stopListening() wakes us
+            if (!waitReadable(sockfd_)) break;
 
-            // Receive message size
-            uint32_t msg_size;
-            ssize_t received = recv(sockfd_, &msg_size, sizeof(msg_size), 0);
+            // Receive complete UDP datagram (size + data)
+            uint8_t recv_buffer[65536];
+            struct sockaddr_in from_addr;
+            socklen_t from_len = sizeof(from_addr);
+            ssize_t received = recvfrom(sockfd_, recv_buffer, sizeof(recv_buffer), 0,
+                                        (struct sockaddr*)&from_addr, &from_len);
 
             if (received <= 0) {
                 if (errno == EAGAIN || errno == EWOULDBLOCK) {
                     continue; // Timeout, continue listening
                 }
-                break; // Connection closed or error
+                break; // Error
             }
 
-            // Receive message data
+            handleDatagram(recv_buffer, received);
+        }
+    }
+
+    // Receives on the dedicated callback socket (see connect())
+    void callbackLoop() {
+        while (listening_ && connected_) {
+            if (!waitReadable(callback_sockfd_)) break;
+
             uint8_t recv_buffer[65536];
-            ssize_t recv_size = recv(sockfd_, recv_buffer, msg_size, 0);
-            if (recv_size < 0 || recv_size != msg_size) {
+            ssize_t received = recv(callback_sockfd_, recv_buffer, sizeof(recv_buffer), 0);
+            if (received <= 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    continue;
+                }
                 break;
             }
 
-            // Parse message ID
-            if (msg_size < 4) continue;
-            uint32_t msg_id = (static_cast<uint32_t>(recv_buffer[0]) << 24) |
-                              (static_cast<uint32_t>(recv_buffer[1]) << 16) |
-                              (static_cast<uint32_t>(recv_buffer[2]) << 8) |
-                              static_cast<uint32_t>(recv_buffer[3]);
+            handleDatagram(recv_buffer, received);
+        }
+    }
+
+    // Split a datagram into payload, message ID and wire flags; false if malformed
+    static bool parseDatagram(const uint8_t* recv_buffer, ssize_t received, const uint8_t*& data,
+                              uint32_t& msg_size, uint32_t& msg_id, uint8_t& wire_flags) {
+        // Parse message: flags(1) + size(3), next bytes = data
+        if (received < 8) return false;  // At least flags/size(4) + msg_id(4)
+        
+        wire_flags = recv_buffer[0];
+        msg_size = (static_cast<uint32_t>(recv_buffer[1]) << 16) |
+                   (static_cast<uint32_t>(recv_buffer[2]) << 8) |
+                   static_cast<uint32_t>(recv_buffer[3]);
+
+        // Verify size matches
+        if (received != msg_size + 4) return false;
+
+        // Parse message ID from data part (compressed payloads stay valid until the
+        // next datagram is parsed on this thread)
+        data = recv_buffer + 4;
+        static thread_local std::vector<uint8_t> inflated;
+        if (!inflateFrame(wire_flags, data, msg_size, inflated)) return false;
+        msg_id = (static_cast<uint32_t>(data[0]) << 24) |
+                 (static_cast<uint32_t>(data[1]) << 16) |
+                 (static_cast<uint32_t>(data[2]) << 8) |
+                 static_cast<uint32_t>(data[3]);
+        return true;
+    }
+
+    void handleDatagram(const uint8_t* recv_buffer, ssize_t received) {
+        const uint8_t* data;
+        uint32_t msg_size, msg_id;
+        uint8_t wire_flags;
+        if (!parseDatagram(recv_buffer, received, data, msg_size, msg_id, wire_flags)) return;
+
+        // Check if this is a callback message (REQ) or RPC response (RESP)
+        bool is_callback = isCallbackMessage(msg_id);
+
+        if (is_callback) {
+            // Handle callback directly; a malformed callback is dropped
+            try {
+                handleBroadcastMessage(msg_id, data, msg_size, wire_flags);
+            } catch (const std::exception&) {
+            }
+        } else {
+            // Queue RPC response for RPC method to retrieve
+            QueuedMessage msg;
+            msg.msg_id = msg_id;
+            msg.wire_flags = wire_flags;
+            msg.data.assign(data, data + msg_size);
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex_);
+                rpc_response_queue_.push(msg);
+            }
+            queue_cv_.notify_one();
+        }
+    }
 
-            // Check if this is a callback message (REQ) or RPC response (RESP)
-            bool is_callback = isCallbackMessage(msg_id);
+    // True if msg answers expected_msg_id and, for stream_id != 0, belongs to that
+    // stream (stream chunks and credit carry the stream ID right after the msg_id)
+    static bool matchesResponse(const QueuedMessage& msg, uint32_t expected_msg_id, uint32_t stream_id) {
+        if (msg.msg_id != expected_msg_id) return false;
+        if (stream_id == 0) return true;
+        try {
+            ByteReader reader(msg.data.data(), msg.data.size(), msg.wire_flags);
+            reader.readMsgId();
+            return reader.readUint32() == stream_id;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
 
-            if (is_callback) {
-                // Handle callback directly
-                handleBroadcastMessage(msg_id, recv_buffer, recv_size);
+    // Remove the first queued message matching; false if there is none (queue_mutex_ held)
+    bool takeQueued(uint32_t expected_msg_id, uint32_t stream_id, QueuedMessage& response_msg) {
+        std::queue<QueuedMessage> temp_queue;
+        bool found = false;
+        while (!rpc_response_queue_.empty()) {
+            if (!found && matchesResponse(rpc_response_queue_.front(), expected_msg_id, stream_id)) {
+                response_msg = std::move(rpc_response_queue_.front());
+                found = true;
             } else {
-                // Queue RPC response for RPC method to retrieve
-                QueuedMessage msg;
-                msg.msg_id = msg_id;
-                msg.data.assign(recv_buffer, recv_buffer + recv_size);
-                {
-                    std::lock_guard<std::mutex> lock(queue_mutex_);
-                    rpc_response_queue_.push(msg);
-                }
-                queue_cv_.notify_one();
+                temp_queue.push(std::move(rpc_response_queue_.front()));
+            }
+            rpc_response_queue_.pop();
+        }
+        rpc_response_queue_.swap(temp_queue);
+        return found;
+    }
+
+    // Wait up to 5 seconds for the response with the given message ID (and stream ID,
+    // unless 0); messages for other calls stay queued for them
+    bool waitForResponse(uint32_t expected_msg_id, QueuedMessage& response_msg, uint32_t stream_id = 0) {
+        if (busy_poll_) {
+            return spinForResponse(expected_msg_id, response_msg, stream_id);
+        }
+
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        return queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
+            return takeQueued(expected_msg_id, stream_id, response_msg);
+        });
+    }
+
+    // Busy-poll mode: spin on a non-blocking recv() on the calling thread.
+    // Callbacks received meanwhile are handled; stale responses are dropped.
+    bool spinForResponse(uint32_t expected_msg_id, QueuedMessage& response_msg, uint32_t stream_id) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        uint8_t recv_buffer[65536];
+        while (std::chrono::steady_clock::now() < deadline) {
+            ssize_t received = recv(sockfd_, recv_buffer, sizeof(recv_buffer), MSG_DONTWAIT);
+            if (received < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+                return false;
+            }
+
+            const uint8_t* data;
+            uint32_t msg_size, msg_id;
+            uint8_t wire_flags;
+            if (!parseDatagram(recv_buffer, received, data, msg_size, msg_id, wire_flags)) continue;
+            if (isCallbackMessage(msg_id)) {
+                handleBroadcastMessage(msg_id, data, msg_size, wire_flags);
+                continue;
+            }
+            if (msg_id != expected_msg_id) continue;
+            QueuedMessage msg;
+            msg.msg_id = msg_id;
+            msg.wire_flags = wire_flags;
+            msg.data.assign(data, data + msg_size);
+            if (matchesResponse(msg, expected_msg_id, stream_id)) {
+                response_msg = std::move(msg);
+                return true;
             }
         }
+        return false;
     }
 
     bool isCallbackMessage(uint32_t msg_id) {
@@ -1798,38 +4229,56 @@ private:
         }
     }
 
-    void handleBroadcastMessage(uint32_t msg_id, const uint8_t* data, size_t size) {
-        ByteReader reader(data, size);
+    // Pushes arrive in the encoding this client negotiated (carried in the frame)
+    void handleBroadcastMessage(uint32_t msg_id, const uint8_t* data, size_t size, uint8_t wire_flags) {
+        ByteReader reader(data, size, wire_flags);
         
         switch (msg_id) {
             case MSG_ONINTEGERUPDATE_REQ: {
-                onIntegerUpdateRequest request;
-                request.deserialize(reader);
-                onIntegerUpdate(request.i8, request.u8, request.i32, request.i64);
+                std::shared_ptr<onIntegerUpdateRequest> request = std::make_shared<onIntegerUpdateRequest>();
+                request->deserialize(reader);
+                dispatchCallback(MSG_ONINTEGERUPDATE_REQ, [this, request]() {
+                    onIntegerUpdate(request->i8, request->u8, request->i32, request->i64);
+                });
                 break;
             }
             case MSG_ONFLOATUPDATE_REQ: {
-                onFloatUpdateRequest request;
-                request.deserialize(reader);
-                onFloatUpdate(request.f, request.d);
+                std::shared_ptr<onFloatUpdateRequest> request = std::make_shared<onFloatUpdateRequest>();
+                request->deserialize(reader);
+                dispatchCallback(MSG_ONFLOATUPDATE_REQ, [this, request]() {
+                    onFloatUpdate(request->f, request->d);
+                });
                 break;
             }
             case MSG_ONSTRUCTUPDATE_REQ: {
-                onStructUpdateRequest request;
-                request.deserialize(reader);
-                onStructUpdate(request.data);
+                std::shared_ptr<onStructUpdateRequest> request = std::make_shared<onStructUpdateRequest>();
+                request->deserialize(reader);
+                dispatchCallback(MSG_ONSTRUCTUPDATE_REQ, [this, request]() {
+                    onStructUpdate(request->data);
+                });
                 break;
             }
             case MSG_ONVECTORUPDATE_REQ: {
-                onVectorUpdateRequest request;
-                request.deserialize(reader);
-                onVectorUpdate(request.seq, request.strseq);
+                std::shared_ptr<onVectorUpdateRequest> request = std::make_shared<onVectorUpdateRequest>();
+                request->deserialize(reader);
+                dispatchCallback(MSG_ONVECTORUPDATE_REQ, [this, request]() {
+                    onVectorUpdate(request->seq, request->strseq);
+                });
                 break;
             }
             case MSG_ONCOMPLEXUPDATE_REQ: {
-                onComplexUpdateRequest request;
-                request.deserialize(reader);
-                onComplexUpdate(request.data);
+                if (lazy_callbacks_) {
+                    std::shared_ptr<onComplexUpdateRequestLazy> lazy = std::make_shared<onComplexUpdateRequestLazy>(data, size, wire_flags);
+                    dispatchCallback(MSG_ONCOMPLEXUPDATE_REQ, [this, lazy]() {
+                        onComplexUpdateLazy(lazy->data);
+                    });
+                    break;
+                }
+                std::shared_ptr<onComplexUpdateRequest> request = std::make_shared<onComplexUpdateRequest>();
+                request->deserialize(reader);
+                dispatchCallback(MSG_ONCOMPLEXUPDATE_REQ, [this, request]() {
+                    onComplexUpdate(request->data);
+                });
                 break;
             }
             default:
@@ -1838,6 +4287,14 @@ private:
         }
     }
 
+    void dispatchCallback(size_t partition, std::function<void()> task) {
+        if (dispatcher_) {
+            dispatcher_->dispatch(partition, std::move(task));
+        } else {
+            task();
+        }
+    }
+
 protected:
     // Callback methods (marked with 'callback' keyword in IDL)
     virtual void onIntegerUpdate(int8_t i8, uint8_t u8, int32_t i32, int64_t i64) {
@@ -1850,21 +4307,27 @@ protected:
         std::cout << "[Client] 📢 Callback: onFloatUpdate" << std::endl;
     }
 
-    virtual void onStructUpdate(IntegerTypes data) {
+    virtual void onStructUpdate(const IntegerTypes& data) {
         // Override to handle onStructUpdate callback from server
         std::cout << "[Client] 📢 Callback: onStructUpdate" << std::endl;
     }
 
-    virtual void onVectorUpdate(std::vector<int32_t> seq, std::vector<std::string> strseq) {
+    virtual void onVectorUpdate(const std::vector<int32_t>& seq, const std::vector<std::string>& strseq) {
         // Override to handle onVectorUpdate callback from server
         std::cout << "[Client] 📢 Callback: onVectorUpdate" << std::endl;
     }
 
-    virtual void onComplexUpdate(ComplexData data) {
+    virtual void onComplexUpdate(const ComplexData& data) {
         // Override to handle onComplexUpdate callback from server
         std::cout << "[Client] 📢 Callback: onComplexUpdate" << std::endl;
     }
 
+    // onComplexUpdate after setLazyCallbacks(true): fields are decoded on first access
+    // and the arguments stay valid only until this returns
+    virtual void onComplexUpdateLazy(const ComplexDataLazy& data) {
+        std::cout << "[Client] 📢 Callback: onComplexUpdateLazy" << std::endl;
+    }
+
 public:
 
     int32_t testIntegers(int8_t i8, uint8_t u8, int16_t i16, uint16_t u16, int32_t i32, uint32_t u32, int64_t i64, uint64_t u64) {
@@ -1872,68 +4335,31 @@ public:
             return int32_t();
         }
 
-        // Prepare request
-        testIntegersRequest request;
-        request.i8 = i8;
-        request.u8 = u8;
-        request.i16 = i16;
-        request.u16 = u16;
-        request.i32 = i32;
-        request.u32 = u32;
-        request.i64 = i64;
-        request.u64 = u64;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
-            return int32_t();
-        }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTINTEGERS_REQ);
+        testIntegersRequest::serializeFields(buffer, i8, u8, i16, u16, i32, u32, i64, u64);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
             return int32_t();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTINTEGERS_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return int32_t(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_TESTINTEGERS_RESP, response_msg)) {
+            return int32_t(); // Timeout
         }
 
         testIntegersResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
         return response.return_value;
@@ -1944,62 +4370,31 @@ public:
             return double();
         }
 
-        // Prepare request
-        testFloatsRequest request;
-        request.f = f;
-        request.d = d;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
-            return double();
-        }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTFLOATS_REQ);
+        testFloatsRequest::serializeFields(buffer, f, d);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
             return double();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTFLOATS_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return double(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_TESTFLOATS_RESP, response_msg)) {
+            return double(); // Timeout
         }
 
         testFloatsResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
         return response.return_value;
@@ -2010,62 +4405,31 @@ public:
             return bool();
         }
 
-        // Prepare request
-        testCharAndBoolRequest request;
-        request.c = c;
-        request.b = b;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
-            return bool();
-        }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTCHARANDBOOL_REQ);
+        testCharAndBoolRequest::serializeFields(buffer, c, b);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
             return bool();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTCHARANDBOOL_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return bool(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_TESTCHARANDBOOL_RESP, response_msg)) {
+            return bool(); // Timeout
         }
 
         testCharAndBoolResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
         return response.return_value;
@@ -2076,64 +4440,34 @@ public:
             return std::string();
         }
 
-        // Prepare request
-        testStringRequest request;
-        request.str = str;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
-            return std::string();
-        }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTSTRING_REQ);
+        testStringRequest::serializeFields(buffer, str);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
             return std::string();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTSTRING_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return std::string(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_TESTSTRING_RESP, response_msg)) {
+            return std::string(); // Timeout
         }
 
         testStringResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
-        return response.return_value;
+        return std::move(response.return_value);
     }
 
     Priority testEnum(Priority p, Status s) {
@@ -2141,907 +4475,669 @@ public:
             return Priority();
         }
 
-        // Prepare request
-        testEnumRequest request;
-        request.p = p;
-        request.s = s;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
-            return Priority();
-        }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTENUM_REQ);
+        testEnumRequest::serializeFields(buffer, p, s);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
             return Priority();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTENUM_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return Priority(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_TESTENUM_RESP, response_msg)) {
+            return Priority(); // Timeout
         }
 
         testEnumResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
         return response.return_value;
     }
 
-    IntegerTypes testStruct(IntegerTypes data) {
+    IntegerTypes testStruct(const IntegerTypes& data) {
         if (!connected_) {
             return IntegerTypes();
         }
 
-        // Prepare request
-        testStructRequest request;
-        request.data = data;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
-            return IntegerTypes();
-        }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTSTRUCT_REQ);
+        testStructRequest::serializeFields(buffer, data);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
             return IntegerTypes();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTSTRUCT_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return IntegerTypes(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_TESTSTRUCT_RESP, response_msg)) {
+            return IntegerTypes(); // Timeout
         }
 
         testStructResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
-        return response.return_value;
+        return std::move(response.return_value);
     }
 
-    NestedData testNestedStruct(NestedData data) {
+    NestedData testNestedStruct(const NestedData& data) {
         if (!connected_) {
             return NestedData();
         }
 
-        // Prepare request
-        testNestedStructRequest request;
-        request.data = data;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
-            return NestedData();
-        }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTNESTEDSTRUCT_REQ);
+        testNestedStructRequest::serializeFields(buffer, data);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
             return NestedData();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTNESTEDSTRUCT_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return NestedData(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_TESTNESTEDSTRUCT_RESP, response_msg)) {
+            return NestedData(); // Timeout
         }
 
         testNestedStructResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
-        return response.return_value;
+        return std::move(response.return_value);
     }
 
-    std::vector<int32_t> testInt32Vector(std::vector<int32_t> seq) {
+    std::vector<int32_t> testInt32Vector(const std::vector<int32_t>& seq) {
         if (!connected_) {
             return std::vector<int32_t>();
         }
 
-        // Prepare request
-        testInt32VectorRequest request;
-        request.seq = seq;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
-            return std::vector<int32_t>();
-        }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTINT32VECTOR_REQ);
+        testInt32VectorRequest::serializeFields(buffer, seq);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
             return std::vector<int32_t>();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTINT32VECTOR_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return std::vector<int32_t>(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_TESTINT32VECTOR_RESP, response_msg)) {
+            return std::vector<int32_t>(); // Timeout
         }
 
         testInt32VectorResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
-        return response.return_value;
+        return std::move(response.return_value);
     }
 
-    std::vector<uint64_t> testUInt64Vector(std::vector<uint64_t> seq) {
+    std::vector<uint64_t> testUInt64Vector(const std::vector<uint64_t>& seq) {
         if (!connected_) {
             return std::vector<uint64_t>();
         }
 
-        // Prepare request
-        testUInt64VectorRequest request;
-        request.seq = seq;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTUINT64VECTOR_REQ);
+        testUInt64VectorRequest::serializeFields(buffer, seq);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
             return std::vector<uint64_t>();
         }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
-            return std::vector<uint64_t>();
+
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
+        QueuedMessage response_msg;
+        if (!waitForResponse(MSG_TESTUINT64VECTOR_RESP, response_msg)) {
+            return std::vector<uint64_t>(); // Timeout
+        }
+
+        testUInt64VectorResponse response;
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
+        response.deserialize(reader);
+
+        return std::move(response.return_value);
+    }
+
+    std::vector<float> testFloatVector(const std::vector<float>& seq) {
+        if (!connected_) {
+            return std::vector<float>();
+        }
+
+        // Serialize and send request via UDP (thread-safe)
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTFLOATVECTOR_REQ);
+        testFloatVectorRequest::serializeFields(buffer, seq);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
+            return std::vector<float>();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTUINT64VECTOR_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return std::vector<uint64_t>(); // Timeout
-            }
+        if (!waitForResponse(MSG_TESTFLOATVECTOR_RESP, response_msg)) {
+            return std::vector<float>(); // Timeout
+        }
+
+        testFloatVectorResponse response;
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
+        response.deserialize(reader);
+
+        return std::move(response.return_value);
+    }
+
+    std::vector<double> testDoubleVector(const std::vector<double>& seq) {
+        if (!connected_) {
+            return std::vector<double>();
+        }
+
+        // Serialize and send request via UDP (thread-safe)
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTDOUBLEVECTOR_REQ);
+        testDoubleVectorRequest::serializeFields(buffer, seq);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
+            return std::vector<double>();
+        }
+
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
+        QueuedMessage response_msg;
+        if (!waitForResponse(MSG_TESTDOUBLEVECTOR_RESP, response_msg)) {
+            return std::vector<double>(); // Timeout
+        }
+
+        testDoubleVectorResponse response;
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
+        response.deserialize(reader);
+
+        return std::move(response.return_value);
+    }
+
+    std::vector<std::string> testStringVector(const std::vector<std::string>& seq) {
+        if (!connected_) {
+            return std::vector<std::string>();
+        }
+
+        // Serialize and send request via UDP (thread-safe)
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTSTRINGVECTOR_REQ);
+        testStringVectorRequest::serializeFields(buffer, seq);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
+            return std::vector<std::string>();
+        }
+
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
+        QueuedMessage response_msg;
+        if (!waitForResponse(MSG_TESTSTRINGVECTOR_RESP, response_msg)) {
+            return std::vector<std::string>(); // Timeout
+        }
+
+        testStringVectorResponse response;
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
+        response.deserialize(reader);
+
+        return std::move(response.return_value);
+    }
+
+    std::vector<bool> testBoolVector(const std::vector<bool>& seq) {
+        if (!connected_) {
+            return std::vector<bool>();
+        }
+
+        // Serialize and send request via UDP (thread-safe)
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTBOOLVECTOR_REQ);
+        testBoolVectorRequest::serializeFields(buffer, seq);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
+            return std::vector<bool>();
+        }
 
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
+        QueuedMessage response_msg;
+        if (!waitForResponse(MSG_TESTBOOLVECTOR_RESP, response_msg)) {
+            return std::vector<bool>(); // Timeout
         }
 
-        testUInt64VectorResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        testBoolVectorResponse response;
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
-        return response.return_value;
+        return std::move(response.return_value);
     }
 
-    std::vector<float> testFloatVector(std::vector<float> seq) {
+    std::vector<Priority> testEnumVector(const std::vector<Priority>& seq) {
         if (!connected_) {
-            return std::vector<float>();
+            return std::vector<Priority>();
         }
 
-        // Prepare request
-        testFloatVectorRequest request;
-        request.seq = seq;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
-            return std::vector<float>();
-        }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
-            return std::vector<float>();
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTENUMVECTOR_REQ);
+        testEnumVectorRequest::serializeFields(buffer, seq);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
+            return std::vector<Priority>();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTFLOATVECTOR_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return std::vector<float>(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_TESTENUMVECTOR_RESP, response_msg)) {
+            return std::vector<Priority>(); // Timeout
         }
 
-        testFloatVectorResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        testEnumVectorResponse response;
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
-        return response.return_value;
+        return std::move(response.return_value);
     }
 
-    std::vector<double> testDoubleVector(std::vector<double> seq) {
+    std::vector<IntegerTypes> testStructVector(const std::vector<IntegerTypes>& seq) {
         if (!connected_) {
-            return std::vector<double>();
+            return std::vector<IntegerTypes>();
         }
 
-        // Prepare request
-        testDoubleVectorRequest request;
-        request.seq = seq;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
-            return std::vector<double>();
-        }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
-            return std::vector<double>();
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTSTRUCTVECTOR_REQ);
+        testStructVectorRequest::serializeFields(buffer, seq);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
+            return std::vector<IntegerTypes>();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTDOUBLEVECTOR_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return std::vector<double>(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_TESTSTRUCTVECTOR_RESP, response_msg)) {
+            return std::vector<IntegerTypes>(); // Timeout
         }
 
-        testDoubleVectorResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        testStructVectorResponse response;
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
-        return response.return_value;
+        return std::move(response.return_value);
     }
 
-    std::vector<std::string> testStringVector(std::vector<std::string> seq) {
+    std::vector<NestedData> testNestedStructVector(const std::vector<NestedData>& seq) {
         if (!connected_) {
-            return std::vector<std::string>();
+            return std::vector<NestedData>();
         }
 
-        // Prepare request
-        testStringVectorRequest request;
-        request.seq = seq;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
-            return std::vector<std::string>();
-        }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
-            return std::vector<std::string>();
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTNESTEDSTRUCTVECTOR_REQ);
+        testNestedStructVectorRequest::serializeFields(buffer, seq);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
+            return std::vector<NestedData>();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTSTRINGVECTOR_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return std::vector<std::string>(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_TESTNESTEDSTRUCTVECTOR_RESP, response_msg)) {
+            return std::vector<NestedData>(); // Timeout
         }
 
-        testStringVectorResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        testNestedStructVectorResponse response;
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
-        return response.return_value;
+        return std::move(response.return_value);
     }
 
-    std::vector<bool> testBoolVector(std::vector<bool> seq) {
+    BoundedSequence<int32_t, 16> testBoundedVector(const BoundedSequence<int32_t, 16>& seq, const BoundedSequence<std::string, 4>& tags) {
         if (!connected_) {
-            return std::vector<bool>();
+            return BoundedSequence<int32_t, 16>();
         }
 
-        // Prepare request
-        testBoolVectorRequest request;
-        request.seq = seq;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
-            return std::vector<bool>();
-        }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
-            return std::vector<bool>();
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTBOUNDEDVECTOR_REQ);
+        testBoundedVectorRequest::serializeFields(buffer, seq, tags);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
+            return BoundedSequence<int32_t, 16>();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTBOOLVECTOR_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return std::vector<bool>(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_TESTBOUNDEDVECTOR_RESP, response_msg)) {
+            return BoundedSequence<int32_t, 16>(); // Timeout
         }
 
-        testBoolVectorResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        testBoundedVectorResponse response;
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
-        return response.return_value;
+        return std::move(response.return_value);
     }
 
-    std::vector<Priority> testEnumVector(std::vector<Priority> seq) {
+    SensorFrame testFixedArrays(const SensorFrame& frame, const std::array<int32_t, 4>& weights, std::array<std::string, 2>& labels) {
         if (!connected_) {
-            return std::vector<Priority>();
+            return SensorFrame();
         }
 
-        // Prepare request
-        testEnumVectorRequest request;
-        request.seq = seq;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
-            return std::vector<Priority>();
-        }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
-            return std::vector<Priority>();
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTFIXEDARRAYS_REQ);
+        testFixedArraysRequest::serializeFields(buffer, frame, weights);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
+            return SensorFrame();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTENUMVECTOR_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return std::vector<Priority>(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_TESTFIXEDARRAYS_RESP, response_msg)) {
+            return SensorFrame(); // Timeout
         }
 
-        testEnumVectorResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        testFixedArraysResponse response;
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
-        return response.return_value;
+        labels = std::move(response.labels);
+        return std::move(response.return_value);
     }
 
-    std::vector<IntegerTypes> testStructVector(std::vector<IntegerTypes> seq) {
+    std::unordered_map<std::string, std::vector<int32_t>> testMap(const std::unordered_map<std::string, std::vector<int32_t>>& groups, std::unordered_map<Priority, IntegerTypes>& records) {
         if (!connected_) {
-            return std::vector<IntegerTypes>();
+            return std::unordered_map<std::string, std::vector<int32_t>>();
         }
 
-        // Prepare request
-        testStructVectorRequest request;
-        request.seq = seq;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
-            return std::vector<IntegerTypes>();
-        }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
-            return std::vector<IntegerTypes>();
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTMAP_REQ);
+        testMapRequest::serializeFields(buffer, groups, records);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
+            return std::unordered_map<std::string, std::vector<int32_t>>();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTSTRUCTVECTOR_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return std::vector<IntegerTypes>(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_TESTMAP_RESP, response_msg)) {
+            return std::unordered_map<std::string, std::vector<int32_t>>(); // Timeout
         }
 
-        testStructVectorResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        testMapResponse response;
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
-        return response.return_value;
+        records = std::move(response.records);
+        return std::move(response.return_value);
     }
 
-    std::vector<NestedData> testNestedStructVector(std::vector<NestedData> seq) {
+    int64_t testMapKeys(const std::unordered_map<Color, int64_t>& colors, const std::unordered_map<std::string, int64_t>& counts) {
         if (!connected_) {
-            return std::vector<NestedData>();
+            return int64_t();
         }
 
-        // Prepare request
-        testNestedStructVectorRequest request;
-        request.seq = seq;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
-            return std::vector<NestedData>();
-        }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
-            return std::vector<NestedData>();
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTMAPKEYS_REQ);
+        testMapKeysRequest::serializeFields(buffer, colors, counts);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
+            return int64_t();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTNESTEDSTRUCTVECTOR_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return std::vector<NestedData>(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_TESTMAPKEYS_RESP, response_msg)) {
+            return int64_t(); // Timeout
         }
 
-        testNestedStructVectorResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        testMapKeysResponse response;
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
         return response.return_value;
     }
 
-    ComplexData testComplexData(ComplexData data) {
+    ComplexData testComplexData(const ComplexData& data) {
         if (!connected_) {
             return ComplexData();
         }
 
-        // Prepare request
-        testComplexDataRequest request;
-        request.data = data;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
-            return ComplexData();
-        }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTCOMPLEXDATA_REQ);
+        testComplexDataRequest::serializeFields(buffer, data);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
             return ComplexData();
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTCOMPLEXDATA_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return ComplexData(); // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_TESTCOMPLEXDATA_RESP, response_msg)) {
+            return ComplexData(); // Timeout
         }
 
         testComplexDataResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
-        return response.return_value;
+        return std::move(response.return_value);
     }
 
-    bool testOutParams(int32_t input, int8_t& o_i8, uint8_t& o_u8, int16_t& o_i16, uint16_t& o_u16, int32_t& o_i32, uint32_t& o_u32, int64_t& o_i64, uint64_t& o_u64, float& o_f, double& o_d, char& o_c, bool& o_b, std::string& o_str, Priority& o_p) {
+    // On-demand variant: on_result sees the result with only its offset table read;
+    // each field is decoded on first access from the received datagram, so the
+    // result is valid only until on_result returns. False on timeout.
+    bool testComplexDataLazy(const ComplexData& data, std::function<void(const ComplexDataLazy&)> on_result) {
         if (!connected_) {
             return false;
         }
 
-        // Prepare request
-        testOutParamsRequest request;
-        request.input = input;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTCOMPLEXDATA_REQ);
+        testComplexDataRequest::serializeFields(buffer, data);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
+            return false;
+        }
+
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
+        QueuedMessage response_msg;
+        if (!waitForResponse(MSG_TESTCOMPLEXDATA_RESP, response_msg)) {
+            return false; // Timeout
+        }
+
+        // Same layout as testComplexDataResponse: msg_id, status, return_value
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
+        reader.readMsgId();
+        reader.readInt32();
+        ComplexDataLazy result;
+        result.deserialize(reader);
+        on_result(result);
+        return true;
+    }
+
+    bool testOutParams(int32_t input, int8_t& o_i8, uint8_t& o_u8, int16_t& o_i16, uint16_t& o_u16, int32_t& o_i32, uint32_t& o_u32, int64_t& o_i64, uint64_t& o_u64, float& o_f, double& o_d, char& o_c, bool& o_b, std::string& o_str, Priority& o_p) {
+        if (!connected_) {
             return false;
         }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
+
+        // Serialize and send request via UDP (thread-safe)
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTOUTPARAMS_REQ);
+        testOutParamsRequest::serializeFields(buffer, input);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
             return false;
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTOUTPARAMS_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return false; // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_TESTOUTPARAMS_RESP, response_msg)) {
+            return false; // Timeout
         }
 
         testOutParamsResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
         o_i8 = response.o_i8;
@@ -3056,7 +5152,7 @@ public:
         o_d = response.o_d;
         o_c = response.o_c;
         o_b = response.o_b;
-        o_str = response.o_str;
+        o_str = std::move(response.o_str);
         o_p = response.o_p;
         return response.status == 0;
     }
@@ -3066,68 +5162,38 @@ public:
             return false;
         }
 
-        // Prepare request
-        testOutVectorsRequest request;
-        request.count = count;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
-            return false;
-        }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTOUTVECTORS_REQ);
+        testOutVectorsRequest::serializeFields(buffer, count);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
             return false;
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTOUTVECTORS_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return false; // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_TESTOUTVECTORS_RESP, response_msg)) {
+            return false; // Timeout
         }
 
         testOutVectorsResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
-        o_i32seq = response.o_i32seq;
-        o_fseq = response.o_fseq;
-        o_strseq = response.o_strseq;
-        o_pseq = response.o_pseq;
-        o_structseq = response.o_structseq;
+        o_i32seq = std::move(response.o_i32seq);
+        o_fseq = std::move(response.o_fseq);
+        o_strseq = std::move(response.o_strseq);
+        o_pseq = std::move(response.o_pseq);
+        o_structseq = std::move(response.o_structseq);
         return response.status == 0;
     }
 
@@ -3136,70 +5202,37 @@ public:
             return false;
         }
 
-        // Prepare request
-        testInOutParamsRequest request;
-        request.value = value;
-        request.str = str;
-        request.data = data;
-        request.seq = seq;
-
-        // Serialize and send request (thread-safe)
+        // Serialize and send request via UDP (thread-safe)
         std::lock_guard<std::mutex> lock(send_mutex_);
-        ByteBuffer buffer;
-        request.serialize(buffer);
-        // Send message size first
-        uint32_t msg_size = buffer.size();
-        if (sendData(&msg_size, sizeof(msg_size)) < 0) {
-            return false;
-        }
-        // Send message data
-        if (sendData(buffer.data(), buffer.size()) < 0) {
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(wire_flags_);
+        buffer.writeMsgId(MSG_TESTINOUTPARAMS_REQ);
+        testInOutParamsRequest::serializeFields(buffer, value, str, data, seq);
+        
+        // Prepare UDP datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send complete datagram
+        if (frame_size == 0 || sendData(send_buffer, frame_size) < 0) {
             return false;
         }
 
-        // Wait for response from queue (listener thread will queue it)
-        uint32_t expected_msg_id = MSG_TESTINOUTPARAMS_RESP;
+        // Wait for response (queued by the listener thread, or polled in busy-poll mode)
         QueuedMessage response_msg;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // Wait up to 5 seconds for response
-            if (!queue_cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
-                // Check if expected response is in queue
-                std::queue<QueuedMessage> temp_queue = rpc_response_queue_;
-                while (!temp_queue.empty()) {
-                    if (temp_queue.front().msg_id == expected_msg_id) {
-                        return true;
-                    }
-                    temp_queue.pop();
-                }
-                return false;
-            })) {
-                return false; // Timeout
-            }
-
-            // Find and remove the response message from queue
-            std::queue<QueuedMessage> temp_queue;
-            bool found = false;
-            while (!rpc_response_queue_.empty()) {
-                if (rpc_response_queue_.front().msg_id == expected_msg_id && !found) {
-                    response_msg = rpc_response_queue_.front();
-                    found = true;
-                } else {
-                    temp_queue.push(rpc_response_queue_.front());
-                }
-                rpc_response_queue_.pop();
-            }
-            rpc_response_queue_ = temp_queue;
+        if (!waitForResponse(MSG_TESTINOUTPARAMS_RESP, response_msg)) {
+            return false; // Timeout
         }
 
         testInOutParamsResponse response;
-        ByteReader reader(response_msg.data.data(), response_msg.data.size());
+        ByteReader reader(response_msg.data.data(), response_msg.data.size(), response_msg.wire_flags);
         response.deserialize(reader);
 
         value = response.value;
-        str = response.str;
-        data = response.data;
-        seq = response.seq;
+        str = std::move(response.str);
+        data = std::move(response.data);
+        seq = std::move(response.seq);
         return response.status == 0;
     }
 
@@ -3208,794 +5241,1070 @@ public:
 // Server Interface for TypeTestService
 class TypeTestServiceServer : public SocketBase {
 private:
-    int listen_fd_;
+    int sockfd_;  // UDP socket
     bool running_;
-    std::vector<int> client_fds_;
+    std::map<std::string, struct sockaddr_in> clients_;  // Track clients by address
+    std::map<std::string, struct sockaddr_in> callback_routes_;  // Client key -> dedicated callback socket
+    std::map<std::string, std::chrono::steady_clock::time_point> client_seen_;  // Last request per client
+    std::map<std::string, uint8_t> client_wire_flags_;  // Encodings each client agreed to in MSG_CTRL_HELLO
     mutable std::mutex clients_mutex_;
-    std::vector<std::thread> client_threads_;
+
+    // Callback channel registration: a token is issued to the client's RPC socket and
+    // must come back with CALLBACK_CHANNEL_REQ, so only the owner of an RPC address
+    // can route its callbacks elsewhere
+    struct ChannelToken {
+        uint64_t value;
+        std::chrono::steady_clock::time_point issued;
+    };
+    std::map<std::string, ChannelToken> channel_tokens_;  // RPC client key -> pending token
+    std::mt19937_64 token_rng_;
+    std::chrono::seconds client_timeout_;  // Idle clients are forgotten after this (0 = never)
+    std::chrono::steady_clock::time_point last_sweep_;
+    static const size_t kMaxPendingTokens = 1024;
+
+    // Wire encodings offered to clients, and the encoding of the request being
+    // handled on the run() thread (responses are sent back in the same encoding)
+    uint8_t accepted_wire_flags_;
+    uint8_t request_wire_flags_;
+    size_t compress_threshold_;       // With WIRE_LZ: responses larger than this are compressed
+    std::vector<uint8_t> inflated_;   // Decompressed request being handled (run() thread)
+
+    // Frames of the callback being broadcast, one per wire encoding in use; kept
+    // between broadcasts so their storage is reused (under clients_mutex_)
+    struct PushFrame {
+        uint8_t flags;
+        size_t size;
+        std::vector<uint8_t> bytes;
+    };
+    std::vector<PushFrame> push_frames_;
 
 public:
-    TypeTestServiceServer() : listen_fd_(-1), running_(false) {}
+    TypeTestServiceServer() : sockfd_(-1), running_(false), token_rng_(std::random_device()()), client_timeout_(0), accepted_wire_flags_(WIRE_SUPPORTED), request_wire_flags_(0), compress_threshold_(WIRE_LZ_THRESHOLD) {}
 
     ~TypeTestServiceServer() {
         stop();
     }
 
-    // Start server
+    // Start UDP server
     bool start(uint16_t port) {
-        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
-        if (listen_fd_ < 0) {
+        sockfd_ = socket(AF_INET, SOCK_DGRAM, 0);  // UDP socket
+        if (sockfd_ < 0) {
             return false;
         }
 
         int opt = 1;
-        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        setsockopt(sockfd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
 
         addr_.sin_family = AF_INET;
         addr_.sin_addr.s_addr = INADDR_ANY;
         addr_.sin_port = htons(port);
 
-        if (bind(listen_fd_, (struct sockaddr*)&addr_, sizeof(addr_)) < 0) {
-            close(listen_fd_);
-            listen_fd_ = -1;
-            return false;
-        }
-
-        if (listen(listen_fd_, 10) < 0) {
-            close(listen_fd_);
-            listen_fd_ = -1;
+        if (bind(sockfd_, (struct sockaddr*)&addr_, sizeof(addr_)) < 0) {
+            close(sockfd_);
+            sockfd_ = -1;
             return false;
         }
 
+        resetWake();
         running_ = true;
         return true;
     }
 
     void stop() {
         running_ = false;
+        wake();  // Unblock run() immediately
         
-        // Close all client connections
-        {
-            std::lock_guard<std::mutex> lock(clients_mutex_);
-            for (int fd : client_fds_) {
-                close(fd);
-            }
-            client_fds_.clear();
-        }
-        
-        if (listen_fd_ >= 0) {
-            close(listen_fd_);
-            listen_fd_ = -1;
+        if (sockfd_ >= 0) {
+            close(sockfd_);
+            sockfd_ = -1;
         }
         
-        // Wait for all client threads to finish
-        for (auto& thread : client_threads_) {
-            if (thread.joinable()) {
-                thread.join();
-            }
-        }
-        client_threads_.clear();
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        clients_.clear();
+        callback_routes_.clear();
+        client_seen_.clear();
+        client_wire_flags_.clear();
+        channel_tokens_.clear();
     }
 
-    // Main server loop
-    void run() {
-        while (running_) {
-            struct sockaddr_in client_addr;
-            socklen_t addr_len = sizeof(client_addr);
-            int client_fd = accept(listen_fd_, (struct sockaddr*)&client_addr, &addr_len);
+    // Main server loop - receive UDP datagrams
+    // The calling thread takes on the configured ThreadOptions
+    void run() {
+        thread_options_.applyOrReport("srv", &placement_failures_);
+        while (running_) {
+            if (!waitReadable(sockfd_)) break;
+
+            uint8_t recv_buffer[65536];
+            struct sockaddr_in client_addr;
+            socklen_t addr_len = sizeof(client_addr);
+            
+            ssize_t received = recvfrom(sockfd_, recv_buffer, sizeof(recv_buffer), 0,
+                                       (struct sockaddr*)&client_addr, &addr_len);
+
+            if (received <= 0) {
+                if (errno == EINTR && running_) continue;
+                break;
+            }
+
+            // Parse: flags(1) + size(3), rest = data
+            if (received < 8) continue;
+            
+            uint8_t wire_flags = recv_buffer[0];
+            uint32_t msg_size = (static_cast<uint32_t>(recv_buffer[1]) << 16) |
+                                (static_cast<uint32_t>(recv_buffer[2]) << 8) |
+                                static_cast<uint32_t>(recv_buffer[3]);
+
+            if (received != msg_size + 4) continue;
 
-            if (client_fd < 0) {
-                if (running_) {
-                    continue;
-                } else {
-                    break;
-                }
-            }
+            const uint8_t* data = recv_buffer + 4;
+            if (!inflateFrame(wire_flags, data, msg_size, inflated_)) continue;
+            if (handleControlMessage(&client_addr, data, msg_size)) continue;
 
-            // Add client to list
+            // Register client address
             {
                 std::lock_guard<std::mutex> lock(clients_mutex_);
-                client_fds_.push_back(client_fd);
+                touchClient(clientKey(client_addr), client_addr);
             }
 
-            // Handle client in a new thread
-            client_threads_.emplace_back([this, client_fd]() {
-                handleClient(client_fd);
-                
-                // Remove client from list
-                {
-                    std::lock_guard<std::mutex> lock(clients_mutex_);
-                    auto it = std::find(client_fds_.begin(), client_fds_.end(), client_fd);
-                    if (it != client_fds_.end()) {
-                        client_fds_.erase(it);
-                    }
-                }
-                
-                close(client_fd);
-                onClientDisconnected(client_fd);
-            });
+            request_wire_flags_ = wire_flags;
+            try {
+                handleClientRequest(&client_addr, data, msg_size);
+            } catch (const std::exception&) {
+                // Malformed request (count beyond the datagram, truncated field): drop it
+            }
         }
     }
 
-    // Broadcast message to all connected clients (with serialization)
-    // exclude_fd: optionally exclude one client from broadcast (e.g., the sender)
+    // Broadcast message to all known clients (with serialization)
     template<typename T>
-    void broadcast(const T& message, int exclude_fd = -1) {
+    bool broadcast(const T& message) {
+        return broadcastEncoded([&message](ByteBuffer& buffer) { message.serialize(buffer); });
+    }
+
+    // Broadcast whatever encode(buffer) writes (msg_id first), framed like every other
+    // message in the encoding each client negotiated. Returns false and sends nothing
+    // if a frame exceeds one datagram
+    template<typename Encode>
+    bool broadcastEncoded(Encode encode) {
         std::lock_guard<std::mutex> lock(clients_mutex_);
         
-        // Serialize message once
-        ByteBuffer buffer;
-        message.serialize(buffer);
-        uint32_t msg_size = buffer.size();
+        // Serialize message once per wire encoding in use
+        size_t frame_count = 0;
+        for (const auto& pair : clients_) {
+            uint8_t flags = clientWireFlags(pair.first);
+            if (findPushFrame(flags, frame_count)) continue;
+            if (frame_count == push_frames_.size()) push_frames_.emplace_back();
+            PushFrame& frame = push_frames_[frame_count++];
+            PooledByteBuffer pooled;
+            ByteBuffer& buffer = *pooled;
+            buffer.setWireFlags(flags);
+            encode(buffer);
+            
+            // Prepare datagram: flags(1) + size(3) + data
+            frame.flags = flags;
+            frame.bytes.resize(FRAME_MAX_BYTES);
+            frame.size = encodeFrame(buffer, compress_threshold_, frame.bytes.data());
+            if (frame.size == 0 || frame.size > UDP_MAX_PAYLOAD) return false;
+        }
         
-        // Send to all clients except excluded one
-        for (int fd : client_fds_) {
-            if (fd == exclude_fd) continue; // Skip the excluded client
-            // Send message size
-            send(fd, &msg_size, sizeof(msg_size), 0);
-            // Send message data
-            send(fd, buffer.data(), buffer.size(), 0);
+        // Send to all known clients (on their callback socket if they registered one)
+        for (const auto& pair : clients_) {
+            const PushFrame* frame = findPushFrame(clientWireFlags(pair.first), frame_count);
+            auto route = callback_routes_.find(pair.first);
+            const struct sockaddr_in& dest = route != callback_routes_.end() ? route->second : pair.second;
+            sendto(sockfd_, frame->bytes.data(), frame->size, 0,
+                   (struct sockaddr*)&dest, sizeof(dest));
         }
+        return true;
+    }
+
+    // Restrict the wire encodings clients may negotiate (WireFlag bits)
+    void setAcceptedWireFlags(uint8_t flags) {
+        accepted_wire_flags_ = flags & WIRE_SUPPORTED;
+    }
+
+    // Responses above this many bytes are compressed for clients that negotiated WIRE_LZ
+    void setCompressionThreshold(size_t bytes) { compress_threshold_ = bytes; }
+
+    // Clients that send nothing for this long are forgotten along with their callback
+    // route; any request registers them again. The default 0 keeps them until they
+    // disconnect. Only requests count as activity, so a client that just listens for
+    // pushes is dropped once the timeout passes
+    void setClientTimeout(std::chrono::seconds timeout) {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        client_timeout_ = timeout;
     }
 
-    // Get number of connected clients
+    // Get number of known clients
     size_t getClientCount() {
         std::lock_guard<std::mutex> lock(clients_mutex_);
-        return client_fds_.size();
+        return clients_.size();
     }
 
 private:
-    void handleClient(int client_fd) {
-        onClientConnected(client_fd);
-        
-        while (running_) {
-            // Receive message size
-            uint32_t msg_size;
-            ssize_t received = recv(client_fd, &msg_size, sizeof(msg_size), 0);
-            
-            if (received <= 0) {
-                // Client disconnected or error
-                break;
+    static std::string clientKey(const struct sockaddr_in& addr) {
+        char client_key[64];
+        sprintf(client_key, "%s:%d", inet_ntoa(addr.sin_addr), ntohs(addr.sin_port));
+        return client_key;
+    }
+
+    // Record a request from a client and, at most once a second, drop expired
+    // channel tokens and clients idle for longer than client_timeout_
+    // (caller holds clients_mutex_)
+    void touchClient(const std::string& key, const struct sockaddr_in& addr) {
+        auto now = std::chrono::steady_clock::now();
+        clients_[key] = addr;
+        client_seen_[key] = now;
+        if (now - last_sweep_ < std::chrono::seconds(1)) return;
+        last_sweep_ = now;
+        for (auto it = channel_tokens_.begin(); it != channel_tokens_.end();) {
+            if (now - it->second.issued > std::chrono::seconds(10)) it = channel_tokens_.erase(it);
+            else ++it;
+        }
+        if (client_timeout_.count() == 0) return;
+        std::vector<std::string> idle;
+        for (const auto& seen : client_seen_) {
+            if (now - seen.second > client_timeout_) idle.push_back(seen.first);
+        }
+        for (const auto& idle_key : idle) dropClient(idle_key);
+    }
+
+    // Encoding a client agreed to in MSG_CTRL_HELLO, 0 if it never negotiated
+    // (caller holds clients_mutex_)
+    uint8_t clientWireFlags(const std::string& key) const {
+        auto it = client_wire_flags_.find(key);
+        return it != client_wire_flags_.end() ? it->second : 0;
+    }
+
+    // The first count entries of push_frames_ hold the frames of the current broadcast
+    const PushFrame* findPushFrame(uint8_t flags, size_t count) const {
+        for (size_t i = 0; i < count; i++) {
+            if (push_frames_[i].flags == flags) return &push_frames_[i];
+        }
+        return nullptr;
+    }
+
+    // Forget a client and its callback route (caller holds clients_mutex_)
+    void dropClient(const std::string& key) {
+        clients_.erase(key);
+        callback_routes_.erase(key);
+        client_seen_.erase(key);
+        client_wire_flags_.erase(key);
+        channel_tokens_.erase(key);
+    }
+
+    // Send a control message built in buffer to addr
+    void sendControl(const ByteBuffer& buffer, const struct sockaddr_in* addr) {
+        uint8_t frame[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, FRAME_MAX_BYTES, frame);
+        sendto(sockfd_, frame, frame_size, 0, (const struct sockaddr*)addr, sizeof(*addr));
+    }
+
+    // Runtime control messages; returns false for regular IDL requests
+    bool handleControlMessage(struct sockaddr_in* from_addr, const uint8_t* data, size_t data_size) {
+        ByteReader reader(data, data_size);
+        uint32_t msg_id = reader.readMsgId();
+        if (msg_id == MSG_CTRL_HELLO) {
+            if (!reader.canRead(1)) return true;
+            uint8_t ack[9] = {0, 0, 0, 5};
+            ack[4] = (MSG_CTRL_HELLO_ACK >> 24) & 0xFF;
+            ack[5] = (MSG_CTRL_HELLO_ACK >> 16) & 0xFF;
+            ack[6] = (MSG_CTRL_HELLO_ACK >> 8) & 0xFF;
+            ack[7] = MSG_CTRL_HELLO_ACK & 0xFF;
+            ack[8] = reader.readUint8() & accepted_wire_flags_;
+            {
+                // Callbacks pushed to this client use the same encoding
+                std::lock_guard<std::mutex> lock(clients_mutex_);
+                if (ack[8]) client_wire_flags_[clientKey(*from_addr)] = ack[8];
+                else client_wire_flags_.erase(clientKey(*from_addr));
             }
-
-            // Peek message ID from the data (will be consumed by handler)
-            uint8_t peek_buffer[65536];
-            ssize_t peeked = recv(client_fd, peek_buffer, 4, MSG_PEEK);
-            if (peeked < 4) {
-                break;
+            sendto(sockfd_, ack, sizeof(ack), 0, (struct sockaddr*)from_addr, sizeof(*from_addr));
+            return true;
+        }
+        if (msg_id == MSG_CTRL_CALLBACK_TOKEN_REQ) {
+            // Answered on the RPC socket it came from: only that socket's owner sees the token
+            ByteBuffer reply;
+            reply.writeMsgId(MSG_CTRL_CALLBACK_TOKEN);
+            {
+                std::lock_guard<std::mutex> lock(clients_mutex_);
+                std::string key = clientKey(*from_addr);
+                if (channel_tokens_.size() >= kMaxPendingTokens && !channel_tokens_.count(key)) return true;
+                ChannelToken token = {token_rng_(), std::chrono::steady_clock::now()};
+                channel_tokens_[key] = token;
+                reply.writeUint64(token.value);
             }
+            sendControl(reply, from_addr);
+            return true;
+        }
+        if (msg_id == MSG_CTRL_BYE) {
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            dropClient(clientKey(*from_addr));
+            return true;
+        }
+        if (msg_id != MSG_CTRL_CALLBACK_CHANNEL_REQ) return false;
+        if (!reader.canRead(10)) return true;
+
+        // The client announces its RPC socket port from its callback socket, with the
+        // token the server issued to that RPC socket; anything else is ignored
+        struct sockaddr_in rpc_addr = *from_addr;
+        rpc_addr.sin_port = htons(reader.readUint16());
+        uint64_t token = reader.readUint64();
+        {
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            std::string key = clientKey(rpc_addr);
+            auto issued = channel_tokens_.find(key);
+            if (issued == channel_tokens_.end() || issued->second.value != token) return true;
+            channel_tokens_.erase(issued);
+            touchClient(key, rpc_addr);
+            callback_routes_[key] = *from_addr;
+        }
+
+        uint8_t ack[8] = {0, 0, 0, 4};
+        ack[4] = (MSG_CTRL_CALLBACK_CHANNEL_ACK >> 24) & 0xFF;
+        ack[5] = (MSG_CTRL_CALLBACK_CHANNEL_ACK >> 16) & 0xFF;
+        ack[6] = (MSG_CTRL_CALLBACK_CHANNEL_ACK >> 8) & 0xFF;
+        ack[7] = MSG_CTRL_CALLBACK_CHANNEL_ACK & 0xFF;
+        sendto(sockfd_, ack, sizeof(ack), 0, (struct sockaddr*)from_addr, sizeof(*from_addr));
+        return true;
+    }
 
-            uint32_t msg_id = (static_cast<uint32_t>(peek_buffer[0]) << 24) |
-                              (static_cast<uint32_t>(peek_buffer[1]) << 16) |
-                              (static_cast<uint32_t>(peek_buffer[2]) << 8) |
-                              static_cast<uint32_t>(peek_buffer[3]);
+    void handleClientRequest(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
+        // Parse message ID from data
+        if (data_size < 4) return;
+        
+        uint32_t msg_id = (static_cast<uint32_t>(data[0]) << 24) |
+                          (static_cast<uint32_t>(data[1]) << 16) |
+                          (static_cast<uint32_t>(data[2]) << 8) |
+                          static_cast<uint32_t>(data[3]);
 
-            switch (msg_id) {
+        switch (msg_id) {
                 case MSG_TESTINTEGERS_REQ:
-                    handle_testIntegers(client_fd, msg_size);
+                    handle_testIntegers(client_addr, data, data_size);
                     break;
                 case MSG_TESTFLOATS_REQ:
-                    handle_testFloats(client_fd, msg_size);
+                    handle_testFloats(client_addr, data, data_size);
                     break;
                 case MSG_TESTCHARANDBOOL_REQ:
-                    handle_testCharAndBool(client_fd, msg_size);
+                    handle_testCharAndBool(client_addr, data, data_size);
                     break;
                 case MSG_TESTSTRING_REQ:
-                    handle_testString(client_fd, msg_size);
+                    handle_testString(client_addr, data, data_size);
                     break;
                 case MSG_TESTENUM_REQ:
-                    handle_testEnum(client_fd, msg_size);
+                    handle_testEnum(client_addr, data, data_size);
                     break;
                 case MSG_TESTSTRUCT_REQ:
-                    handle_testStruct(client_fd, msg_size);
+                    handle_testStruct(client_addr, data, data_size);
                     break;
                 case MSG_TESTNESTEDSTRUCT_REQ:
-                    handle_testNestedStruct(client_fd, msg_size);
+                    handle_testNestedStruct(client_addr, data, data_size);
                     break;
                 case MSG_TESTINT32VECTOR_REQ:
-                    handle_testInt32Vector(client_fd, msg_size);
+                    handle_testInt32Vector(client_addr, data, data_size);
                     break;
                 case MSG_TESTUINT64VECTOR_REQ:
-                    handle_testUInt64Vector(client_fd, msg_size);
+                    handle_testUInt64Vector(client_addr, data, data_size);
                     break;
                 case MSG_TESTFLOATVECTOR_REQ:
-                    handle_testFloatVector(client_fd, msg_size);
+                    handle_testFloatVector(client_addr, data, data_size);
                     break;
                 case MSG_TESTDOUBLEVECTOR_REQ:
-                    handle_testDoubleVector(client_fd, msg_size);
+                    handle_testDoubleVector(client_addr, data, data_size);
                     break;
                 case MSG_TESTSTRINGVECTOR_REQ:
-                    handle_testStringVector(client_fd, msg_size);
+                    handle_testStringVector(client_addr, data, data_size);
                     break;
                 case MSG_TESTBOOLVECTOR_REQ:
-                    handle_testBoolVector(client_fd, msg_size);
+                    handle_testBoolVector(client_addr, data, data_size);
                     break;
                 case MSG_TESTENUMVECTOR_REQ:
-                    handle_testEnumVector(client_fd, msg_size);
+                    handle_testEnumVector(client_addr, data, data_size);
                     break;
                 case MSG_TESTSTRUCTVECTOR_REQ:
-                    handle_testStructVector(client_fd, msg_size);
+                    handle_testStructVector(client_addr, data, data_size);
                     break;
                 case MSG_TESTNESTEDSTRUCTVECTOR_REQ:
-                    handle_testNestedStructVector(client_fd, msg_size);
+                    handle_testNestedStructVector(client_addr, data, data_size);
+                    break;
+                case MSG_TESTBOUNDEDVECTOR_REQ:
+                    handle_testBoundedVector(client_addr, data, data_size);
+                    break;
+                case MSG_TESTFIXEDARRAYS_REQ:
+                    handle_testFixedArrays(client_addr, data, data_size);
+                    break;
+                case MSG_TESTMAP_REQ:
+                    handle_testMap(client_addr, data, data_size);
+                    break;
+                case MSG_TESTMAPKEYS_REQ:
+                    handle_testMapKeys(client_addr, data, data_size);
                     break;
                 case MSG_TESTCOMPLEXDATA_REQ:
-                    handle_testComplexData(client_fd, msg_size);
+                    handle_testComplexData(client_addr, data, data_size);
                     break;
                 case MSG_TESTOUTPARAMS_REQ:
-                    handle_testOutParams(client_fd, msg_size);
+                    handle_testOutParams(client_addr, data, data_size);
                     break;
                 case MSG_TESTOUTVECTORS_REQ:
-                    handle_testOutVectors(client_fd, msg_size);
+                    handle_testOutVectors(client_addr, data, data_size);
                     break;
                 case MSG_TESTINOUTPARAMS_REQ:
-                    handle_testInOutParams(client_fd, msg_size);
+                    handle_testInOutParams(client_addr, data, data_size);
                     break;
                 default:
-                    // Unknown message, consume the data
-                    {
-                        uint8_t discard[65536];
-                        recv(client_fd, discard, msg_size, 0);
-                    }
                     break;
             }
-        }
     }
 
-    void handle_testIntegers(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
-        }
-
+    void handle_testIntegers(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testIntegersRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testIntegersResponse response;
         response.return_value = ontestIntegers(request.i8, request.u8, request.i16, request.u16, request.i32, request.u32, request.i64, request.u64);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
-    }
-
-    void handle_testFloats(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
         }
+    }
 
+    void handle_testFloats(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testFloatsRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testFloatsResponse response;
         response.return_value = ontestFloats(request.f, request.d);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
-    }
-
-    void handle_testCharAndBool(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
         }
+    }
 
+    void handle_testCharAndBool(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testCharAndBoolRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testCharAndBoolResponse response;
         response.return_value = ontestCharAndBool(request.c, request.b);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
-    }
-
-    void handle_testString(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
         }
+    }
 
+    void handle_testString(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testStringRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testStringResponse response;
         response.return_value = ontestString(request.str);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
-    }
-
-    void handle_testEnum(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
         }
+    }
 
+    void handle_testEnum(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testEnumRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testEnumResponse response;
         response.return_value = ontestEnum(request.p, request.s);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
-    }
-
-    void handle_testStruct(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
         }
+    }
 
+    void handle_testStruct(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testStructRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testStructResponse response;
         response.return_value = ontestStruct(request.data);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
-    }
-
-    void handle_testNestedStruct(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
         }
+    }
 
+    void handle_testNestedStruct(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testNestedStructRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testNestedStructResponse response;
         response.return_value = ontestNestedStruct(request.data);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
-    }
-
-    void handle_testInt32Vector(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
         }
+    }
 
+    void handle_testInt32Vector(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testInt32VectorRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testInt32VectorResponse response;
         response.return_value = ontestInt32Vector(request.seq);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
-    }
-
-    void handle_testUInt64Vector(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
         }
+    }
 
+    void handle_testUInt64Vector(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testUInt64VectorRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testUInt64VectorResponse response;
         response.return_value = ontestUInt64Vector(request.seq);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
-    }
-
-    void handle_testFloatVector(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
         }
+    }
 
+    void handle_testFloatVector(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testFloatVectorRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testFloatVectorResponse response;
         response.return_value = ontestFloatVector(request.seq);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
-    }
-
-    void handle_testDoubleVector(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
         }
+    }
 
+    void handle_testDoubleVector(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testDoubleVectorRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testDoubleVectorResponse response;
         response.return_value = ontestDoubleVector(request.seq);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
-    }
-
-    void handle_testStringVector(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
         }
+    }
 
+    void handle_testStringVector(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testStringVectorRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testStringVectorResponse response;
         response.return_value = ontestStringVector(request.seq);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
-    }
-
-    void handle_testBoolVector(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
         }
+    }
 
+    void handle_testBoolVector(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testBoolVectorRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testBoolVectorResponse response;
         response.return_value = ontestBoolVector(request.seq);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
-    }
-
-    void handle_testEnumVector(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
         }
+    }
 
+    void handle_testEnumVector(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testEnumVectorRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testEnumVectorResponse response;
         response.return_value = ontestEnumVector(request.seq);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
-    }
-
-    void handle_testStructVector(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
         }
+    }
 
+    void handle_testStructVector(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testStructVectorRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testStructVectorResponse response;
         response.return_value = ontestStructVector(request.seq);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
-    }
-
-    void handle_testNestedStructVector(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
         }
+    }
 
+    void handle_testNestedStructVector(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testNestedStructVectorRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testNestedStructVectorResponse response;
         response.return_value = ontestNestedStructVector(request.seq);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
+        }
     }
 
-    void handle_testComplexData(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
+    void handle_testBoundedVector(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
+        testBoundedVectorRequest request;
+        ByteReader reader(data, data_size, request_wire_flags_);
+        request.deserialize(reader);
+
+        testBoundedVectorResponse response;
+        response.return_value = ontestBoundedVector(request.seq, request.tags);
+
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
+        response.serialize(buffer);
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
+        }
+    }
+
+    void handle_testFixedArrays(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
+        testFixedArraysRequest request;
+        ByteReader reader(data, data_size, request_wire_flags_);
+        request.deserialize(reader);
+
+        testFixedArraysResponse response;
+        response.return_value = ontestFixedArrays(request.frame, request.weights, response.labels);
+
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
+        response.serialize(buffer);
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
+        }
+    }
+
+    void handle_testMap(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
+        testMapRequest request;
+        ByteReader reader(data, data_size, request_wire_flags_);
+        request.deserialize(reader);
+
+        testMapResponse response;
+        response.records = std::move(request.records);
+        response.return_value = ontestMap(request.groups, response.records);
+
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
+        response.serialize(buffer);
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
+        }
+    }
+
+    void handle_testMapKeys(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
+        testMapKeysRequest request;
+        ByteReader reader(data, data_size, request_wire_flags_);
+        request.deserialize(reader);
+
+        testMapKeysResponse response;
+        response.return_value = ontestMapKeys(request.colors, request.counts);
+
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
+        response.serialize(buffer);
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
         }
+    }
 
+    void handle_testComplexData(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testComplexDataRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testComplexDataResponse response;
         response.return_value = ontestComplexData(request.data);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
-    }
-
-    void handle_testOutParams(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
         }
+    }
 
+    void handle_testOutParams(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testOutParamsRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testOutParamsResponse response;
         ontestOutParams(request.input, response.o_i8, response.o_u8, response.o_i16, response.o_u16, response.o_i32, response.o_u32, response.o_i64, response.o_u64, response.o_f, response.o_d, response.o_c, response.o_b, response.o_str, response.o_p);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
-    }
-
-    void handle_testOutVectors(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
         }
+    }
 
+    void handle_testOutVectors(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testOutVectorsRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testOutVectorsResponse response;
         ontestOutVectors(request.count, response.o_i32seq, response.o_fseq, response.o_strseq, response.o_pseq, response.o_structseq);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
-    }
-
-    void handle_testInOutParams(int client_fd, uint32_t msg_size) {
-        // Receive request data (size already read by handleClient)
-        uint8_t recv_buffer[65536];
-        ssize_t recv_size = recv(client_fd, recv_buffer, msg_size, 0);
-        if (recv_size < 0 || recv_size != msg_size) {
-            return;
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
         }
+    }
 
+    void handle_testInOutParams(struct sockaddr_in* client_addr, const uint8_t* data, size_t data_size) {
         testInOutParamsRequest request;
-        ByteReader reader(recv_buffer, recv_size);
+        ByteReader reader(data, data_size, request_wire_flags_);
         request.deserialize(reader);
 
         testInOutParamsResponse response;
         response.value = request.value;
-        response.str = request.str;
-        response.data = request.data;
-        response.seq = request.seq;
+        response.str = std::move(request.str);
+        response.data = std::move(request.data);
+        response.seq = std::move(request.seq);
         ontestInOutParams(response.value, response.str, response.data, response.seq);
 
-        // Serialize and send response
-        ByteBuffer buffer;
+        // Serialize and send response via UDP
+        PooledByteBuffer pooled;
+        ByteBuffer& buffer = *pooled;
+        buffer.setWireFlags(request_wire_flags_);
         response.serialize(buffer);
-        // Send response size first
-        uint32_t resp_size = buffer.size();
-        send(client_fd, &resp_size, sizeof(resp_size), 0);
-        // Send response data
-        send(client_fd, buffer.data(), buffer.size(), 0);
+        
+        // Prepare datagram: flags(1) + size(3) + data (compressed if negotiated and large)
+        uint8_t send_buffer[FRAME_MAX_BYTES];
+        size_t frame_size = encodeFrame(buffer, compress_threshold_, send_buffer);
+        
+        // Send response datagram to client
+        if (frame_size > 0) {
+            sendto(sockfd_, send_buffer, frame_size, 0,
+                   (struct sockaddr*)client_addr, sizeof(*client_addr));
+        }
     }
 
 public:
     // Callback push methods (send callbacks to clients)
-    void push_onIntegerUpdate(int8_t i8, uint8_t u8, int32_t i32, int64_t i64, int exclude_fd = -1) {
-        // Prepare callback request
-        onIntegerUpdateRequest request;
-        request.i8 = i8;
-        request.u8 = u8;
-        request.i32 = i32;
-        request.i64 = i64;
-
-        // Broadcast callback to all clients
-        broadcast(request, exclude_fd);
+    // False if the callback does not fit in one datagram (nothing is sent)
+    bool push_onIntegerUpdate(int8_t i8, uint8_t u8, int32_t i32, int64_t i64) {
+        // Broadcast callback to all known clients via UDP, serialized straight from the arguments
+        return broadcastEncoded([&](ByteBuffer& buffer) {
+            buffer.writeMsgId(MSG_ONINTEGERUPDATE_REQ);
+            onIntegerUpdateRequest::serializeFields(buffer, i8, u8, i32, i64);
+        });
     }
 
-    void push_onFloatUpdate(float f, double d, int exclude_fd = -1) {
-        // Prepare callback request
-        onFloatUpdateRequest request;
-        request.f = f;
-        request.d = d;
-
-        // Broadcast callback to all clients
-        broadcast(request, exclude_fd);
+    // False if the callback does not fit in one datagram (nothing is sent)
+    bool push_onFloatUpdate(float f, double d) {
+        // Broadcast callback to all known clients via UDP, serialized straight from the arguments
+        return broadcastEncoded([&](ByteBuffer& buffer) {
+            buffer.writeMsgId(MSG_ONFLOATUPDATE_REQ);
+            onFloatUpdateRequest::serializeFields(buffer, f, d);
+        });
     }
 
-    void push_onStructUpdate(IntegerTypes data, int exclude_fd = -1) {
-        // Prepare callback request
-        onStructUpdateRequest request;
-        request.data = data;
-
-        // Broadcast callback to all clients
-        broadcast(request, exclude_fd);
+    // False if the callback does not fit in one datagram (nothing is sent)
+    bool push_onStructUpdate(const IntegerTypes& data) {
+        // Broadcast callback to all known clients via UDP, serialized straight from the arguments
+        return broadcastEncoded([&](ByteBuffer& buffer) {
+            buffer.writeMsgId(MSG_ONSTRUCTUPDATE_REQ);
+            onStructUpdateRequest::serializeFields(buffer, data);
+        });
     }
 
-    void push_onVectorUpdate(std::vector<int32_t> seq, std::vector<std::string> strseq, int exclude_fd = -1) {
-        // Prepare callback request
-        onVectorUpdateRequest request;
-        request.seq = seq;
-        request.strseq = strseq;
-
-        // Broadcast callback to all clients
-        broadcast(request, exclude_fd);
+    // False if the callback does not fit in one datagram (nothing is sent)
+    bool push_onVectorUpdate(const std::vector<int32_t>& seq, const std::vector<std::string>& strseq) {
+        // Broadcast callback to all known clients via UDP, serialized straight from the arguments
+        return broadcastEncoded([&](ByteBuffer& buffer) {
+            buffer.writeMsgId(MSG_ONVECTORUPDATE_REQ);
+            onVectorUpdateRequest::serializeFields(buffer, seq, strseq);
+        });
     }
 
-    void push_onComplexUpdate(ComplexData data, int exclude_fd = -1) {
-        // Prepare callback request
-        onComplexUpdateRequest request;
-        request.data = data;
-
-        // Broadcast callback to all clients
-        broadcast(request, exclude_fd);
+    // False if the callback does not fit in one datagram (nothing is sent)
+    bool push_onComplexUpdate(const ComplexData& data) {
+        // Broadcast callback to all known clients via UDP, serialized straight from the arguments
+        return broadcastEncoded([&](ByteBuffer& buffer) {
+            buffer.writeMsgId(MSG_ONCOMPLEXUPDATE_REQ);
+            onComplexUpdateRequest::serializeFields(buffer, data);
+        });
     }
 
 protected:
@@ -4005,30 +6314,26 @@ protected:
     virtual bool ontestCharAndBool(char c, bool b) = 0;
     virtual std::string ontestString(const std::string& str) = 0;
     virtual Priority ontestEnum(Priority p, Status s) = 0;
-    virtual IntegerTypes ontestStruct(IntegerTypes data) = 0;
-    virtual NestedData ontestNestedStruct(NestedData data) = 0;
-    virtual std::vector<int32_t> ontestInt32Vector(std::vector<int32_t> seq) = 0;
-    virtual std::vector<uint64_t> ontestUInt64Vector(std::vector<uint64_t> seq) = 0;
-    virtual std::vector<float> ontestFloatVector(std::vector<float> seq) = 0;
-    virtual std::vector<double> ontestDoubleVector(std::vector<double> seq) = 0;
-    virtual std::vector<std::string> ontestStringVector(std::vector<std::string> seq) = 0;
-    virtual std::vector<bool> ontestBoolVector(std::vector<bool> seq) = 0;
-    virtual std::vector<Priority> ontestEnumVector(std::vector<Priority> seq) = 0;
-    virtual std::vector<IntegerTypes> ontestStructVector(std::vector<IntegerTypes> seq) = 0;
-    virtual std::vector<NestedData> ontestNestedStructVector(std::vector<NestedData> seq) = 0;
-    virtual ComplexData ontestComplexData(ComplexData data) = 0;
+    virtual IntegerTypes ontestStruct(const IntegerTypes& data) = 0;
+    virtual NestedData ontestNestedStruct(const NestedData& data) = 0;
+    virtual std::vector<int32_t> ontestInt32Vector(const std::vector<int32_t>& seq) = 0;
+    virtual std::vector<uint64_t> ontestUInt64Vector(const std::vector<uint64_t>& seq) = 0;
+    virtual std::vector<float> ontestFloatVector(const std::vector<float>& seq) = 0;
+    virtual std::vector<double> ontestDoubleVector(const std::vector<double>& seq) = 0;
+    virtual std::vector<std::string> ontestStringVector(const std::vector<std::string>& seq) = 0;
+    virtual std::vector<bool> ontestBoolVector(const std::vector<bool>& seq) = 0;
+    virtual std::vector<Priority> ontestEnumVector(const std::vector<Priority>& seq) = 0;
+    virtual std::vector<IntegerTypes> ontestStructVector(const std::vector<IntegerTypes>& seq) = 0;
+    virtual std::vector<NestedData> ontestNestedStructVector(const std::vector<NestedData>& seq) = 0;
+    virtual BoundedSequence<int32_t, 16> ontestBoundedVector(const BoundedSequence<int32_t, 16>& seq, const BoundedSequence<std::string, 4>& tags) = 0;
+    virtual SensorFrame ontestFixedArrays(const SensorFrame& frame, const std::array<int32_t, 4>& weights, std::array<std::string, 2>& labels) = 0;
+    virtual std::unordered_map<std::string, std::vector<int32_t>> ontestMap(const std::unordered_map<std::string, std::vector<int32_t>>& groups, std::unordered_map<Priority, IntegerTypes>& records) = 0;
+    virtual int64_t ontestMapKeys(const std::unordered_map<Color, int64_t>& colors, const std::unordered_map<std::string, int64_t>& counts) = 0;
+    virtual ComplexData ontestComplexData(const ComplexData& data) = 0;
     virtual void ontestOutParams(int32_t input, int8_t& o_i8, uint8_t& o_u8, int16_t& o_i16, uint16_t& o_u16, int32_t& o_i32, uint32_t& o_u32, int64_t& o_i64, uint64_t& o_u64, float& o_f, double& o_d, char& o_c, bool& o_b, std::string& o_str, Priority& o_p) = 0;
     virtual void ontestOutVectors(int32_t count, std::vector<int32_t>& o_i32seq, std::vector<float>& o_fseq, std::vector<std::string>& o_strseq, std::vector<Priority>& o_pseq, std::vector<IntegerTypes>& o_structseq) = 0;
     virtual void ontestInOutParams(int32_t& value, std::string& str, IntegerTypes& data, std::vector<int32_t>& seq) = 0;
 
-    // Optional callbacks for client connection events
-    virtual void onClientConnected(int client_fd) {
-        // Override this to handle client connection
-    }
-
-    virtual void onClientDisconnected(int client_fd) {
-        // Override this to handle client disconnection
-    }
 };
 
 } // namespace ipc
@@ -0,0 +1,88 @@
+// Example server implementation for KeyValueStore
+#include "keyvaluestore_socket.hpp"
+#include <iostream>
+
+using namespace ipc;
+
+class MyKeyValueStoreServer : public ipc::KeyValueStoreServer {
+protected:
+    bool onset(const std::pmr::string& key, const std::pmr::string& value) override {
+        // TODO: Implement set
+        std::cout << "set called" << std::endl;
+        return bool();
+    }
+
+    std::string onget(const std::pmr::string& key) override {
+        // TODO: Implement get
+        std::cout << "get called" << std::endl;
+        return "result";
+    }
+
+    bool onremove(const std::pmr::string& key) override {
+        // TODO: Implement remove
+        std::cout << "remove called" << std::endl;
+        return bool();
+    }
+
+    bool onexists(const std::pmr::string& key) override {
+        // TODO: Implement exists
+        std::cout << "exists called" << std::endl;
+        return bool();
+    }
+
+    int64_t oncount() override {
+        // TODO: Implement count
+        std::cout << "count called" << std::endl;
+        return int64_t();
+    }
+
+    void onclear() override {
+        // TODO: Implement clear
+        std::cout << "clear called" << std::endl;
+    }
+
+    int64_t onbatchSet(const std::pmr::vector<KeyValue>& items) override {
+        // TODO: Implement batchSet
+        std::cout << "batchSet called" << std::endl;
+        return int64_t();
+    }
+
+    void onbatchGet(const std::pmr::vector<std::pmr::string>& keys, std::vector<std::string>& values, std::vector<OperationStatus>& status) override {
+        // TODO: Implement batchGet
+        std::cout << "batchGet called" << std::endl;
+    }
+
+    std::unordered_map<std::string, std::string> onbatchGetMap(const std::pmr::vector<std::pmr::string>& keys) override {
+        // TODO: Implement batchGetMap
+        std::cout << "batchGetMap called" << std::endl;
+        return std::unordered_map<std::string, std::string>();
+    }
+
+    void onscan(const std::string& prefix, StreamWriter<KeyValue>& writer) override {
+        // TODO: Implement scan
+        std::cout << "scan called" << std::endl;
+        // writer.write(item) for each result; returns false once the client is gone
+    }
+
+    int64_t onload(StreamReader<KeyValue>& items) override {
+        // TODO: Implement load
+        std::cout << "load called" << std::endl;
+        // KeyValue item; while (items.read(item)) { ... }
+        return int64_t();
+    }
+
+};
+
+int main() {
+    MyKeyValueStoreServer server;
+
+    if (!server.start(8888)) {
+        std::cerr << "Failed to start server" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Server started on port 8888" << std::endl;
+    server.run();
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+// 请求内存池 (--pmr-arena) 测试客户端
+// 构建: g++ -std=c++17 -Wall -O2 -pthread -o test_pmr_client test_pmr_client.cpp
+#include <iostream>
+#include <cstring>
+#include <string>
+#include "keyvaluestore_socket.hpp"
+
+using namespace ipc;
+
+// 测试结果统计
+int total_tests = 0;
+int passed_tests = 0;
+
+#define TEST_START(name) \
+    do { \
+        std::cout << "\n[测试 " << (++total_tests) << "] " << name << " ... "; \
+    } while(0)
+
+#define TEST_PASS() \
+    do { \
+        std::cout << "✅ 通过" << std::endl; \
+        passed_tests++; \
+    } while(0)
+
+#define TEST_FAIL(msg) \
+    do { \
+        std::cout << "❌ 失败: " << msg << std::endl; \
+    } while(0)
+
+// 超过请求内存池 64 KiB 内联缓冲区的一批键，迫使内存池向上游申请溢出块
+static std::vector<std::string> makeKeys(size_t count) {
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < count; i++) keys.push_back("pmr-key-with-a-longer-name-" + std::to_string(100000 + i));
+    return keys;
+}
+
+// 用法: test_pmr_client [--compact] [--native] [--dict] [--lz] [--sparse]
+//   参数含义同 test_all_types_client
+int main(int argc, char** argv) {
+    std::cout << "=== 请求内存池测试客户端 ===" << std::endl;
+    std::cout << "连接到服务器 localhost:8890" << std::endl;
+
+    KeyValueStoreClient client;
+    if (!client.connect("127.0.0.1", 8890)) {
+        std::cerr << "连接服务器失败" << std::endl;
+        return 1;
+    }
+
+    uint8_t wanted = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--compact") == 0) wanted |= WIRE_COMPACT;
+        if (strcmp(argv[i], "--native") == 0) wanted |= WIRE_NATIVE_LE;
+        if (strcmp(argv[i], "--dict") == 0) wanted |= WIRE_STRING_DICT;
+        if (strcmp(argv[i], "--lz") == 0) wanted |= WIRE_LZ;
+        if (strcmp(argv[i], "--sparse") == 0) wanted |= WIRE_SPARSE;
+    }
+    if (wanted) {
+        uint8_t flags = client.negotiateWireFlags(wanted);
+        if (flags != wanted) {
+            std::cerr << "服务器未接受请求的编码" << std::endl;
+            return 1;
+        }
+        if (flags & WIRE_LZ) client.setCompressionThreshold(64);
+    }
+
+    std::vector<std::string> keys = makeKeys(1500);
+    // batchGetMap 的响应同时带回键和值，用较少的键保持在一个数据报内
+    std::vector<std::string> map_keys(keys.begin(), keys.begin() + 500);
+
+    // ========== 测试1: set/get 往返 ==========
+    TEST_START("set/get 往返 (服务端复制内存池中的参数)");
+    try {
+        client.set("pmr_key", "pmr_value");
+        client.set("other_key", std::string(200, 'o'));
+        std::string value = client.get("pmr_key");
+        if (value == "pmr_value") TEST_PASS();
+        else TEST_FAIL("返回值不正确: " + value);
+    } catch (const std::exception& e) {
+        TEST_FAIL(e.what());
+    }
+
+    // ========== 测试2: 大批量 batchSet/batchGet 往返 ==========
+    TEST_START("大批量 batchSet/batchGet 往返");
+    try {
+        // 分批写入，单个请求不超过一个数据报
+        for (size_t start = 0; start < keys.size(); start += 500) {
+            std::vector<KeyValue> items;
+            for (size_t i = start; i < start + 500 && i < keys.size(); i++) {
+                KeyValue item;
+                item.key = keys[i];
+                item.value = "v" + std::to_string(i);
+                items.push_back(std::move(item));
+            }
+            client.batchSet(items);
+        }
+        std::vector<std::string> values;
+        std::vector<OperationStatus> status;
+        bool ok = client.batchGet(keys, values, status);
+        bool same = ok && values.size() == keys.size();
+        for (size_t i = 0; same && i < values.size(); i++) {
+            same = values[i] == "v" + std::to_string(i) && status[i] == OperationStatus::SUCCESS;
+        }
+        if (same) TEST_PASS();
+        else TEST_FAIL("返回 " + std::to_string(values.size()) + " 个值, 期望 " + std::to_string(keys.size()));
+    } catch (const std::exception& e) {
+        TEST_FAIL(e.what());
+    }
+
+    // ========== 测试3: 预热后重复请求不再向上游申请内存 ==========
+    TEST_START("重复大请求的上游分配次数不增长");
+    try {
+        std::vector<std::string> values;
+        std::vector<OperationStatus> status;
+        // 预热: 内存池在首个大请求后保留溢出块
+        for (int i = 0; i < 3; i++) {
+            values.clear();
+            status.clear();
+            client.batchGet(keys, values, status);
+            client.batchGetMap(map_keys);
+        }
+        std::string before = client.get("#upstream");
+        for (int i = 0; i < 50; i++) {
+            values.clear();
+            status.clear();
+            client.batchGet(keys, values, status);
+            client.batchGetMap(map_keys);
+            client.get("pmr_key");
+        }
+        std::string after = client.get("#upstream");
+        if (before == after) TEST_PASS();
+        else TEST_FAIL("上游分配次数从 " + before + " 增长到 " + after);
+    } catch (const std::exception& e) {
+        TEST_FAIL(e.what());
+    }
+
+    // ========== 测试4: 内存池回收后的请求内容不串扰 ==========
+    TEST_START("内存池复用后参数内容正确");
+    try {
+        std::string value = client.get("pmr_key");
+        std::string other = client.get("other_key");
+        if (value == "pmr_value" && other == std::string(200, 'o')) TEST_PASS();
+        else TEST_FAIL("返回值不正确: " + value);
+    } catch (const std::exception& e) {
+        TEST_FAIL(e.what());
+    }
+
+    // ========== 总结 ==========
+    std::cout << "\n" << std::string(60, '=') << std::endl;
+    std::cout << "测试完成！" << std::endl;
+    std::cout << "总测试数: " << total_tests << std::endl;
+    std::cout << "通过: " << passed_tests << " ✅" << std::endl;
+    std::cout << "失败: " << (total_tests - passed_tests) << " ❌" << std::endl;
+    std::cout << std::string(60, '=') << std::endl;
+
+    return (passed_tests == total_tests) ? 0 : 1;
+}
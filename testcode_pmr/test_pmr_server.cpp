@@ -0,0 +1,152 @@
+// 请求内存池 (--pmr-arena) 测试服务端
+// 构建: g++ -std=c++17 -Wall -O2 -pthread -o test_pmr_server test_pmr_server.cpp
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include "keyvaluestore_socket.hpp"
+
+using namespace ipc;
+
+// 统计经过默认资源 (请求内存池的上游) 的分配次数
+class CountingResource : public std::pmr::memory_resource {
+public:
+    size_t allocations() const { return allocations_.load(); }
+
+private:
+    std::atomic<size_t> allocations_{0};
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        allocations_++;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+static CountingResource upstream;
+
+class PmrTestServiceImpl : public KeyValueStoreServer {
+private:
+    // 参数分配在请求内存池中，处理函数返回后即被回收，存储时必须复制
+    std::map<std::string, std::string, std::less<>> store_;
+    std::mutex store_mutex_;
+
+public:
+    bool onset(const std::pmr::string& key, const std::pmr::string& value) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        store_[std::string(key)] = std::string(value);
+        return true;
+    }
+
+    // "#upstream" 返回上游分配次数，供客户端检查重复请求是否仍向上游申请内存
+    std::string onget(const std::pmr::string& key) override {
+        if (key == "#upstream") return std::to_string(upstream.allocations());
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        auto it = store_.find(std::string_view(key));
+        return it != store_.end() ? it->second : "";
+    }
+
+    bool onremove(const std::pmr::string& key) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        auto it = store_.find(std::string_view(key));
+        if (it == store_.end()) return false;
+        store_.erase(it);
+        return true;
+    }
+
+    bool onexists(const std::pmr::string& key) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        return store_.find(std::string_view(key)) != store_.end();
+    }
+
+    int64_t oncount() override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        return store_.size();
+    }
+
+    void onclear() override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        store_.clear();
+    }
+
+    int64_t onbatchSet(const std::pmr::vector<KeyValue>& items) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        for (const auto& item : items) store_[std::string(item.key)] = std::string(item.value);
+        return items.size();
+    }
+
+    void onbatchGet(const std::pmr::vector<std::pmr::string>& keys, std::vector<std::string>& values,
+                    std::vector<OperationStatus>& status) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        for (const auto& key : keys) {
+            auto it = store_.find(std::string_view(key));
+            values.push_back(it != store_.end() ? it->second : "");
+            status.push_back(it != store_.end() ? OperationStatus::SUCCESS : OperationStatus::KEY_NOT_FOUND);
+        }
+    }
+
+    std::unordered_map<std::string, std::string> onbatchGetMap(const std::pmr::vector<std::pmr::string>& keys) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        std::unordered_map<std::string, std::string> found;
+        for (const auto& key : keys) {
+            auto it = store_.find(std::string_view(key));
+            if (it != store_.end()) found[it->first] = it->second;
+        }
+        return found;
+    }
+
+    void onscan(const std::string& prefix, StreamWriter<KeyValue>& writer) override {
+        std::vector<KeyValue> matches;
+        {
+            std::lock_guard<std::mutex> lock(store_mutex_);
+            for (const auto& pair : store_) {
+                if (pair.first.compare(0, prefix.size(), prefix) != 0) continue;
+                KeyValue item;
+                item.key = pair.first;
+                item.value = pair.second;
+                matches.push_back(std::move(item));
+            }
+        }
+        for (const auto& item : matches) {
+            if (!writer.write(item)) return;
+        }
+    }
+
+    int64_t onload(StreamReader<KeyValue>& items) override {
+        int64_t loaded = 0;
+        KeyValue item;
+        while (items.read(item)) {
+            std::lock_guard<std::mutex> lock(store_mutex_);
+            store_[std::string(item.key)] = std::string(item.value);
+            loaded++;
+        }
+        return loaded;
+    }
+};
+
+int main() {
+    std::cout << "=== 请求内存池测试服务端 ===" << std::endl;
+    std::cout << "监听端口: 8890" << std::endl;
+
+    // 必须在构造服务端之前安装：请求内存池在构造时记下默认资源作为上游
+    std::pmr::set_default_resource(&upstream);
+
+    PmrTestServiceImpl server;
+    if (!server.start(8890)) {
+        std::cerr << "启动服务器失败" << std::endl;
+        return 1;
+    }
+
+    std::cout << "服务器运行中，按Ctrl+C退出..." << std::endl;
+    server.run();
+    return 0;
+}
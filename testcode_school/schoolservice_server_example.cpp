@@ -6,13 +6,13 @@ using namespace ipc;
 
 class MySchoolServiceServer : public ipc::SchoolServiceServer {
 protected:
-    OperationStatus onaddStudent(StudentDetails student) override {
+    OperationStatus onaddStudent(const StudentDetails& student) override {
         // TODO: Implement addStudent
         std::cout << "addStudent called" << std::endl;
         return OperationStatus();
     }
 
-    OperationStatus onaddTeacher(TeacherDetails teacher) override {
+    OperationStatus onaddTeacher(const TeacherDetails& teacher) override {
         // TODO: Implement addTeacher
         std::cout << "addTeacher called" << std::endl;
         return OperationStatus();
@@ -24,7 +24,7 @@ protected:
         return PersonInfo();
     }
 
-    bool onupdatePersonInfo(const std::string& personId, PersonInfo info) override {
+    bool onupdatePersonInfo(const std::string& personId, const PersonInfo& info) override {
         // TODO: Implement updatePersonInfo
         std::cout << "updatePersonInfo called" << std::endl;
         return bool();
@@ -36,27 +36,27 @@ protected:
         return bool();
     }
 
-    int64_t onbatchAddStudents(std::vector<StudentDetails> students) override {
+    int64_t onbatchAddStudents(const std::vector<StudentDetails>& students) override {
         // TODO: Implement batchAddStudents
         std::cout << "batchAddStudents called" << std::endl;
         return int64_t();
     }
 
-    void onbatchQueryPersons(std::vector<std::string> personIds, std::vector<PersonInfo>& infos, std::vector<OperationStatus>& status) override {
+    void onbatchQueryPersons(const std::vector<std::string>& personIds, std::vector<PersonInfo>& infos, std::vector<OperationStatus>& status) override {
         // TODO: Implement batchQueryPersons
         std::cout << "batchQueryPersons called" << std::endl;
     }
 
-    OperationStatus onaddCourse(Course course) override {
+    OperationStatus onaddCourse(const Course& course) override {
         // TODO: Implement addCourse
         std::cout << "addCourse called" << std::endl;
         return OperationStatus();
     }
 
-    std::vector<Course> ongetAllCourses() override {
+    CourseSeq ongetAllCourses() override {
         // TODO: Implement getAllCourses
         std::cout << "getAllCourses called" << std::endl;
-        return std::vector<Course>();
+        return CourseSeq();
     }
 
     bool onenrollCourse(const std::string& studentId, const std::string& courseId) override {
@@ -71,24 +71,31 @@ protected:
         return bool();
     }
 
-    bool onsubmitGrade(Grade grade) override {
+    bool onsubmitGrade(const Grade& grade) override {
         // TODO: Implement submitGrade
         std::cout << "submitGrade called" << std::endl;
         return bool();
     }
 
-    std::vector<Grade> ongetStudentGrades(const std::string& studentId) override {
+    GradeSeq ongetStudentGrades(const std::string& studentId) override {
         // TODO: Implement getStudentGrades
         std::cout << "getStudentGrades called" << std::endl;
-        return std::vector<Grade>();
+        return GradeSeq();
     }
 
-    int64_t onbatchSubmitGrades(std::vector<Grade> grades) override {
+    int64_t onbatchSubmitGrades(const GradeSeq& grades) override {
         // TODO: Implement batchSubmitGrades
         std::cout << "batchSubmitGrades called" << std::endl;
         return int64_t();
     }
 
+    int64_t onuploadGrades(StreamReader<Grade>& grades) override {
+        // TODO: Implement uploadGrades
+        std::cout << "uploadGrades called" << std::endl;
+        // Grade item; while (grades.read(item)) { ... }
+        return int64_t();
+    }
+
     std::vector<PersonInfo> onqueryByType(PersonType personType) override {
         // TODO: Implement queryByType
         std::cout << "queryByType called" << std::endl;
@@ -107,6 +114,24 @@ protected:
         return std::vector<PersonInfo>();
     }
 
+    void onstreamAllCourses(StreamWriter<Course>& writer) override {
+        // TODO: Implement streamAllCourses
+        std::cout << "streamAllCourses called" << std::endl;
+        // writer.write(item) for each result; returns false once the client is gone
+    }
+
+    void onstreamByType(PersonType personType, StreamWriter<PersonInfo>& writer) override {
+        // TODO: Implement streamByType
+        std::cout << "streamByType called" << std::endl;
+        // writer.write(item) for each result; returns false once the client is gone
+    }
+
+    void onstreamSearchPersons(const std::string& keyword, StreamWriter<PersonInfo>& writer) override {
+        // TODO: Implement streamSearchPersons
+        std::cout << "streamSearchPersons called" << std::endl;
+        // writer.write(item) for each result; returns false once the client is gone
+    }
+
     int64_t ongetTotalCount() override {
         // TODO: Implement getTotalCount
         std::cout << "getTotalCount called" << std::endl;
@@ -0,0 +1,172 @@
+// 视图解码 (--view-decode) 测试客户端
+// 构建: g++ -std=c++17 -Wall -O2 -pthread -o test_view_client test_view_client.cpp
+#include <iostream>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include "keyvaluestore_socket.hpp"
+
+using namespace ipc;
+
+// 测试结果统计
+int total_tests = 0;
+int passed_tests = 0;
+
+#define TEST_START(name) \
+    do { \
+        std::cout << "\n[测试 " << (++total_tests) << "] " << name << " ... "; \
+    } while(0)
+
+#define TEST_PASS() \
+    do { \
+        std::cout << "✅ 通过" << std::endl; \
+        passed_tests++; \
+    } while(0)
+
+#define TEST_FAIL(msg) \
+    do { \
+        std::cout << "❌ 失败: " << msg << std::endl; \
+    } while(0)
+
+// 用法: test_view_client [--compact] [--native] [--dict] [--lz] [--sparse]
+//   参数含义同 test_all_types_client；--dict 下额外检查重复字符串的视图指向同一段缓冲区
+int main(int argc, char** argv) {
+    std::cout << "=== 视图解码测试客户端 ===" << std::endl;
+    std::cout << "连接到服务器 localhost:8889" << std::endl;
+
+    KeyValueStoreClient client;
+    if (!client.connect("127.0.0.1", 8889)) {
+        std::cerr << "连接服务器失败" << std::endl;
+        return 1;
+    }
+
+    uint8_t wanted = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--compact") == 0) wanted |= WIRE_COMPACT;
+        if (strcmp(argv[i], "--native") == 0) wanted |= WIRE_NATIVE_LE;
+        if (strcmp(argv[i], "--dict") == 0) wanted |= WIRE_STRING_DICT;
+        if (strcmp(argv[i], "--lz") == 0) wanted |= WIRE_LZ;
+        if (strcmp(argv[i], "--sparse") == 0) wanted |= WIRE_SPARSE;
+    }
+    bool dict = false;
+    if (wanted) {
+        uint8_t flags = client.negotiateWireFlags(wanted);
+        if (flags != wanted) {
+            std::cerr << "服务器未接受请求的编码" << std::endl;
+            return 1;
+        }
+        if (flags & WIRE_LZ) client.setCompressionThreshold(64);
+        dict = (flags & WIRE_STRING_DICT) != 0;
+    }
+
+    // ========== 测试1: getView 往返 ==========
+    TEST_START("getView 往返 (视图在回调内有效)");
+    try {
+        client.set("view_key", "view_value");
+        std::string copied;
+        bool ok = client.getView("view_key", [&](const getResponseView& response) {
+            copied = std::string(response.return_value);
+        });
+        if (ok && copied == "view_value") TEST_PASS();
+        else TEST_FAIL("返回值不正确: " + copied);
+    } catch (const std::exception& e) {
+        TEST_FAIL(e.what());
+    }
+
+    // ========== 测试2: 服务端复制视图参数 ==========
+    TEST_START("服务端存储的值在后续请求后仍然正确");
+    try {
+        client.set("first_key", "first_value");
+        client.set("second_key", std::string(200, 's'));
+        std::string first = client.get("first_key");
+        if (first == "first_value") TEST_PASS();
+        else TEST_FAIL("返回值不正确: " + first);
+    } catch (const std::exception& e) {
+        TEST_FAIL(e.what());
+    }
+
+    // ========== 测试3: 重复字符串 (字符串字典回引) ==========
+    TEST_START("batchGetView 重复字符串");
+    try {
+        client.set("repeat_key", "repeat_value");
+        client.set("other_key", "other_value");
+        std::vector<std::string> keys = {"repeat_key", "repeat_key", "other_key", "repeat_key"};
+        std::vector<std::string> copies;
+        bool shared = false;
+        bool distinct = true;
+        bool ok = client.batchGetView(keys, [&](const batchGetResponseView& response) {
+            for (std::string_view value : response.values) copies.emplace_back(value);
+            if (response.values.size() == 4) {
+                // 回引指向首次出现的字面量，所以三个 "repeat_value" 共用同一段缓冲区
+                shared = response.values[0].data() == response.values[1].data() &&
+                         response.values[0].data() == response.values[3].data();
+                distinct = response.values[0].data() != response.values[1].data();
+            }
+        });
+        std::string server_shared = client.get("#shared");
+        std::vector<std::string> expected = {"repeat_value", "repeat_value", "other_value", "repeat_value"};
+        if (!ok || copies != expected) TEST_FAIL("返回值不正确");
+        else if (dict && !shared) TEST_FAIL("字典回引没有指向首次出现的字符串");
+        else if (!dict && !distinct) TEST_FAIL("非字典模式下视图不应共用缓冲区");
+        else if (server_shared != (dict ? "2" : "0")) TEST_FAIL("服务端共用计数不正确: " + server_shared);
+        else TEST_PASS();
+    } catch (const std::exception& e) {
+        TEST_FAIL(e.what());
+    }
+
+    // ========== 测试4: 大字符串 (LZ 模式下指向解压缓冲区) ==========
+    TEST_START("getView 大字符串");
+    try {
+        std::string big;
+        for (int i = 0; i < 300; i++) big += "chunk" + std::to_string(i % 10);
+        client.set("big_key", big);
+        size_t size = 0;
+        bool same = false;
+        bool ok = client.getView("big_key", [&](const getResponseView& response) {
+            size = response.return_value.size();
+            same = response.return_value == big;
+        });
+        if (ok && same) TEST_PASS();
+        else TEST_FAIL("大小 " + std::to_string(size) + ", 期望 " + std::to_string(big.size()));
+    } catch (const std::exception& e) {
+        TEST_FAIL(e.what());
+    }
+
+    // ========== 测试5: 回调内复制的字符串在后续调用后仍然有效 ==========
+    TEST_START("回调内复制的字符串不受后续调用影响");
+    try {
+        std::string kept;
+        client.getView("repeat_key", [&](const getResponseView& response) {
+            kept = std::string(response.return_value);
+        });
+        // 后续调用复用接收缓冲区；复制的内容不应改变
+        for (int i = 0; i < 5; i++) client.getView("other_key", [](const getResponseView&) {});
+        if (kept == "repeat_value") TEST_PASS();
+        else TEST_FAIL("返回值不正确: " + kept);
+    } catch (const std::exception& e) {
+        TEST_FAIL(e.what());
+    }
+
+    // ========== 测试6: 不存在的键 ==========
+    TEST_START("getView 空字符串");
+    try {
+        bool empty = false;
+        bool ok = client.getView("missing_key", [&](const getResponseView& response) {
+            empty = response.return_value.empty();
+        });
+        if (ok && empty) TEST_PASS();
+        else TEST_FAIL("应返回空字符串");
+    } catch (const std::exception& e) {
+        TEST_FAIL(e.what());
+    }
+
+    // ========== 总结 ==========
+    std::cout << "\n" << std::string(60, '=') << std::endl;
+    std::cout << "测试完成！" << std::endl;
+    std::cout << "总测试数: " << total_tests << std::endl;
+    std::cout << "通过: " << passed_tests << " ✅" << std::endl;
+    std::cout << "失败: " << (total_tests - passed_tests) << " ❌" << std::endl;
+    std::cout << std::string(60, '=') << std::endl;
+
+    return (passed_tests == total_tests) ? 0 : 1;
+}
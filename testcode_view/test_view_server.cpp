@@ -0,0 +1,131 @@
+// 视图解码 (--view-decode) 测试服务端
+// 构建: g++ -std=c++17 -Wall -O2 -pthread -o test_view_server test_view_server.cpp
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include "keyvaluestore_socket.hpp"
+
+using namespace ipc;
+
+class ViewTestServiceImpl : public KeyValueStoreServer {
+private:
+    // 字符串参数是指向接收缓冲区的视图，处理函数返回后即失效，存储时必须复制
+    std::map<std::string, std::string, std::less<>> store_;
+    std::mutex store_mutex_;
+    int shared_keys_ = 0;  // 最近一次 batchGet 中与前面相同的键共用同一段缓冲区的个数
+
+public:
+    bool onset(std::string_view key, std::string_view value) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        std::cout << "set: " << key << " (" << value.size() << " 字节)" << std::endl;
+        store_[std::string(key)] = std::string(value);
+        return true;
+    }
+
+    // "#shared" 返回最近一次 batchGet 的共用计数，供客户端检查服务端看到的视图
+    std::string onget(std::string_view key) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        if (key == "#shared") return std::to_string(shared_keys_);
+        auto it = store_.find(key);
+        return it != store_.end() ? it->second : "";
+    }
+
+    bool onremove(std::string_view key) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        auto it = store_.find(key);
+        if (it == store_.end()) return false;
+        store_.erase(it);
+        return true;
+    }
+
+    bool onexists(std::string_view key) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        return store_.find(key) != store_.end();
+    }
+
+    int64_t oncount() override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        return store_.size();
+    }
+
+    void onclear() override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        store_.clear();
+    }
+
+    int64_t onbatchSet(const std::vector<KeyValue>& items) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        for (const auto& item : items) store_[item.key] = item.value;
+        return items.size();
+    }
+
+    // 字符串字典模式下重复的键是对首次出现的回引，视图应指向同一段缓冲区
+    void onbatchGet(const std::vector<std::string_view>& keys, std::vector<std::string>& values,
+                    std::vector<OperationStatus>& status) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        shared_keys_ = 0;
+        for (size_t i = 0; i < keys.size(); i++) {
+            for (size_t j = 0; j < i; j++) {
+                if (keys[j] == keys[i]) {
+                    if (keys[j].data() == keys[i].data()) shared_keys_++;
+                    break;
+                }
+            }
+            auto it = store_.find(keys[i]);
+            values.push_back(it != store_.end() ? it->second : "");
+            status.push_back(it != store_.end() ? OperationStatus::SUCCESS : OperationStatus::KEY_NOT_FOUND);
+        }
+        std::cout << "batchGet: " << keys.size() << " 个键, 共用缓冲区 " << shared_keys_ << " 个" << std::endl;
+    }
+
+    std::unordered_map<std::string, std::string> onbatchGetMap(const std::vector<std::string_view>& keys) override {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        std::unordered_map<std::string, std::string> found;
+        for (const auto& key : keys) {
+            auto it = store_.find(key);
+            if (it != store_.end()) found[it->first] = it->second;
+        }
+        return found;
+    }
+
+    void onscan(const std::string& prefix, StreamWriter<KeyValue>& writer) override {
+        std::vector<KeyValue> matches;
+        {
+            std::lock_guard<std::mutex> lock(store_mutex_);
+            for (const auto& pair : store_) {
+                if (pair.first.compare(0, prefix.size(), prefix) == 0) matches.push_back(KeyValue{pair.first, pair.second});
+            }
+        }
+        for (const auto& item : matches) {
+            if (!writer.write(item)) return;
+        }
+    }
+
+    int64_t onload(StreamReader<KeyValue>& items) override {
+        int64_t loaded = 0;
+        KeyValue item;
+        while (items.read(item)) {
+            std::lock_guard<std::mutex> lock(store_mutex_);
+            store_[item.key] = item.value;
+            loaded++;
+        }
+        return loaded;
+    }
+};
+
+int main() {
+    std::cout << "=== 视图解码测试服务端 ===" << std::endl;
+    std::cout << "监听端口: 8889" << std::endl;
+
+    ViewTestServiceImpl server;
+    if (!server.start(8889)) {
+        std::cerr << "启动服务器失败" << std::endl;
+        return 1;
+    }
+
+    std::cout << "服务器运行中，按Ctrl+C退出..." << std::endl;
+    server.run();
+    return 0;
+}